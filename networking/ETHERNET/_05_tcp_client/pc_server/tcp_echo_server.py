@@ -10,27 +10,137 @@ This script creates a simple TCP echo server that:
 
 Usage:
     python3 tcp_echo_server.py
+    python3 tcp_echo_server.py --bench
+    python3 tcp_echo_server.py --keep-alive
 
 TCP clients will connect to this server and send messages.
 This server will echo them back.
 
+Benchmark (--bench):
+    Serves the board in CLIENT_MODE_BENCHMARK. The board opens each test
+    with a 16-byte hello (magic "ZBEN", test, message size, duration - big
+    endian) and this server answers:
+      upload    read for the duration, then report bytes received
+      download  stream to the board for the duration, then close
+      pingpong  echo every message until the board closes
+    The board measures RTT and prints the report.
+
+Keep-alive (--keep-alive):
+    Echoes everything until the board closes, instead of closing after the
+    first message. Needed by CLIENT_MODE_PERSISTENT, which pipelines many
+    messages over one connection (connect-per-message clients work too).
+
 Exit: Press Ctrl+C to stop the server
 """
 
+import argparse
 import socket
+import struct
 import sys
+import time
+
+# Server configuration
+HOST = '0.0.0.0'  # Listen on all interfaces
+PORT = 4242       # Must match SERVER_PORT in Example 5
+BUFFER_SIZE = 1024
+
+# Benchmark protocol (must match src/tcp_bench.h)
+BENCH_MAGIC = 0x5A42454E
+BENCH_UPLOAD, BENCH_DOWNLOAD, BENCH_PINGPONG = 1, 2, 3
+BENCH_HELLO = struct.Struct('!IIII')    # magic, test, msg_size, duration_ms
+BENCH_RESULT = struct.Struct('!IIII')   # magic, elapsed_ms, bytes_hi, bytes_lo
+
+
+def recv_exact(sock, size):
+    """Receive exactly size bytes, None if the peer closed first"""
+    data = bytearray()
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return bytes(data)
+
+
+def bench_client(client_socket):
+    """Run the benchmark requested by one connected board"""
+    client_socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    hello = recv_exact(client_socket, BENCH_HELLO.size)
+    if hello is None:
+        print("[BENCH] client closed before hello")
+        return
+    magic, test, size, duration_ms = BENCH_HELLO.unpack(hello)
+    if magic != BENCH_MAGIC:
+        print("[BENCH] invalid hello")
+        return
+
+    if test == BENCH_UPLOAD:
+        received = 0
+        start = last = time.monotonic()
+        deadline = start + duration_ms / 1000
+        while time.monotonic() < deadline:
+            client_socket.settimeout(max(deadline - time.monotonic(), 0.001))
+            try:
+                chunk = client_socket.recv(65536)
+            except socket.timeout:
+                break
+            if not chunk:
+                return
+            received += len(chunk)
+            last = time.monotonic()
+        client_socket.settimeout(None)
+        elapsed_ms = int((last - start) * 1000)
+        client_socket.sendall(BENCH_RESULT.pack(BENCH_MAGIC, elapsed_ms,
+                                                received >> 32, received & 0xFFFFFFFF))
+        print(f"[BENCH] upload: {received} bytes in {elapsed_ms} ms")
+        # Drain until the board closes, so a sender blocked in send() can finish
+        while client_socket.recv(65536):
+            pass
 
-def main():
-    # Server configuration
-    HOST = '0.0.0.0'  # Listen on all interfaces
-    PORT = 4242       # Must match SERVER_PORT in Example 5
-    BUFFER_SIZE = 1024
+    elif test == BENCH_DOWNLOAD:
+        payload = b'\xa5' * size
+        sent = 0
+        deadline = time.monotonic() + duration_ms / 1000
+        while time.monotonic() < deadline:
+            client_socket.sendall(payload)
+            sent += size
+        print(f"[BENCH] download: {sent} bytes in {duration_ms} ms")
+
+    elif test == BENCH_PINGPONG:
+        round_trips = 0
+        while True:
+            message = recv_exact(client_socket, size)
+            if message is None:
+                break
+            client_socket.sendall(message)
+            round_trips += 1
+        print(f"[BENCH] ping-pong: {round_trips} round trips of {size} bytes")
+
+    else:
+        print(f"[BENCH] unknown test {test}")
+
+
+def echo_until_closed(client_socket):
+    """Echo every chunk back until the client closes"""
+    client_socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    received = 0
+    while True:
+        data = client_socket.recv(BUFFER_SIZE)
+        if not data:
+            break
+        client_socket.sendall(data)
+        received += len(data)
+    return received
+
+
+def main(bench_mode=False, keep_alive=False):
 
     # Create socket
     try:
         server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
         server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
-        print(f"[INFO] TCP Echo Server")
+        print(f"[INFO] TCP {'Benchmark' if bench_mode else 'Echo'} Server")
         print(f"[INFO] Binding to {HOST}:{PORT}...")
         
         server_socket.bind((HOST, PORT))
@@ -50,6 +160,18 @@ def main():
                 client_socket, client_address = server_socket.accept()
                 print(f"[CONNECTED] Client connected from {client_address[0]}:{client_address[1]}")
 
+                if bench_mode:
+                    bench_client(client_socket)
+                    client_socket.close()
+                    print(f"[DISCONNECTED] Client disconnected\n")
+                    continue
+
+                if keep_alive:
+                    received = echo_until_closed(client_socket)
+                    client_socket.close()
+                    print(f"[DISCONNECTED] Client disconnected, {received} bytes echoed\n")
+                    continue
+
                 # Receive data
                 data = client_socket.recv(BUFFER_SIZE)
                 if data:
@@ -76,4 +198,13 @@ def main():
         sys.exit(0)
 
 if __name__ == '__main__':
-    main()
+    parser = argparse.ArgumentParser(description="TCP echo/benchmark server for the Zephyr TCP client")
+    parser.add_argument('--port', type=int, default=PORT, help="listening port")
+    parser.add_argument('--bench', action='store_true',
+                        help="serve CLIENT_MODE_BENCHMARK instead of echoing")
+    parser.add_argument('--keep-alive', action='store_true',
+                        help="echo until the client closes (CLIENT_MODE_PERSISTENT)")
+    args = parser.parse_args()
+
+    PORT = args.port
+    main(args.bench, args.keep_alive)
@@ -0,0 +1,123 @@
+/**
+ * Fixed-size latency histogram with log-linear buckets
+ *
+ * Recording a sample is a couple of shifts and one increment, so it can be
+ * used on the measurement hot path without disturbing the result.
+ */
+
+#include <zephyr/kernel.h>
+
+#include <string.h>
+
+#include "bench_hist.h"
+
+/**
+ * Map a value to its bucket
+ */
+static uint32_t bucket_index(uint32_t value)
+{
+    uint32_t msb;
+
+    if (value < BENCH_HIST_LINEAR)
+    {
+        return value;
+    }
+
+    // msb >= 4 here; the next 3 bits below it select the sub-bucket
+    msb = find_msb_set(value) - 1;
+
+    return BENCH_HIST_LINEAR + (msb - 4) * BENCH_HIST_SUB +
+           ((value >> (msb - 3)) & (BENCH_HIST_SUB - 1));
+}
+
+/**
+ * Largest value that maps to a bucket
+ */
+static uint32_t bucket_upper(uint32_t index)
+{
+    uint32_t msb;
+    uint32_t sub;
+
+    if (index < BENCH_HIST_LINEAR)
+    {
+        return index;
+    }
+
+    msb = (index - BENCH_HIST_LINEAR) / BENCH_HIST_SUB + 4;
+    sub = (index - BENCH_HIST_LINEAR) % BENCH_HIST_SUB;
+
+    return ((BENCH_HIST_SUB + sub) << (msb - 3)) + (1U << (msb - 3)) - 1;
+}
+
+void bench_hist_reset(struct bench_hist *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min_us = UINT32_MAX;
+}
+
+void bench_hist_record(struct bench_hist *hist, uint32_t value_us)
+{
+    hist->buckets[bucket_index(value_us)]++;
+    hist->count++;
+    hist->sum_us += value_us;
+    hist->min_us = MIN(hist->min_us, value_us);
+    hist->max_us = MAX(hist->max_us, value_us);
+}
+
+uint32_t bench_hist_percentile(const struct bench_hist *hist, uint32_t per_mille)
+{
+    uint64_t target;
+    uint64_t seen = 0;
+    uint32_t i;
+
+    if (hist->count == 0)
+    {
+        return 0;
+    }
+
+    // Rank of the sample we are looking for (rounded up, at least 1)
+    target = ((uint64_t)hist->count * per_mille + 999) / 1000;
+    if (target == 0)
+    {
+        target = 1;
+    }
+
+    for (i = 0; i < BENCH_HIST_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+        if (seen >= target)
+        {
+            // Never report more than the largest sample actually seen
+            return MIN(bucket_upper(i), hist->max_us);
+        }
+    }
+
+    return hist->max_us;
+}
+
+void bench_hist_print(const struct bench_hist *hist, const char *title)
+{
+    uint32_t i;
+
+    if (hist->count == 0)
+    {
+        printk("%s: no samples\n", title);
+        return;
+    }
+
+    printk("%s: %u samples, min %u us, avg %u us, max %u us\n",
+           title, hist->count, hist->min_us,
+           (uint32_t)(hist->sum_us / hist->count), hist->max_us);
+    printk("  p50 %u us, p99 %u us, p999 %u us\n",
+           bench_hist_percentile(hist, 500),
+           bench_hist_percentile(hist, 990),
+           bench_hist_percentile(hist, 999));
+
+    for (i = 0; i < BENCH_HIST_BUCKETS; i++)
+    {
+        if (hist->buckets[i] > 0)
+        {
+            printk("  <= %8u us: %u\n", bucket_upper(i), hist->buckets[i]);
+        }
+    }
+}
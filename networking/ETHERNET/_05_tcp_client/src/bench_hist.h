@@ -0,0 +1,47 @@
+/*
+ * Fixed-size latency histogram with log-linear buckets
+ */
+
+#ifndef BENCH_HIST_H
+#define BENCH_HIST_H
+
+#include <stdint.h>
+
+/*
+ * Values below 16 us get one bucket each. Above that every power of two is
+ * split into 8 sub-buckets, so a reported percentile is at most 12.5 %
+ * above the real value. 240 buckets (16 + 28 * 8) cover up to 2^32 us, and
+ * a histogram takes 980 bytes of RAM (960 for the uint32_t buckets).
+ */
+#define BENCH_HIST_LINEAR   16
+#define BENCH_HIST_SUB      8
+#define BENCH_HIST_BUCKETS  (BENCH_HIST_LINEAR + (32 - 4) * BENCH_HIST_SUB)
+
+struct bench_hist
+{
+    uint32_t buckets[BENCH_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+};
+
+/** @brief Clear all samples */
+void bench_hist_reset(struct bench_hist *hist);
+
+/** @brief Record one sample in microseconds - O(1), no allocation */
+void bench_hist_record(struct bench_hist *hist, uint32_t value_us);
+
+/**
+ *  @brief Get a percentile
+ *
+ *  @param per_mille Percentile in 1/1000 (500 = p50, 990 = p99, 999 = p99.9)
+ *
+ *  @return Upper bound of the bucket holding the percentile, in microseconds
+ */
+uint32_t bench_hist_percentile(const struct bench_hist *hist, uint32_t per_mille);
+
+/** @brief Print p50/p99/p999 and every non-empty bucket */
+void bench_hist_print(const struct bench_hist *hist, const char *title);
+
+#endif /* BENCH_HIST_H */
@@ -0,0 +1,321 @@
+/**
+ * Framed echo client and frame codec self-test
+ *
+ * frame_client_run() sends frames of varying size in bursts of
+ * FRAMED_BURST and rebuilds the echoed frames with a frame_decoder, no
+ * matter how the echo is split into segments.
+ *
+ * frame_selftest_run() needs no server, it exercises the codec alone:
+ * 1. Fuzz: FRAME_TEST_FRAMES frames of random length are fed to the
+ *    decoder in random-sized chunks (frames split across chunks and
+ *    several frames waiting in the ring), every payload is checked
+ * 2. A length prefix above FRAME_MAX_PAYLOAD must give -EMSGSIZE
+ * 3. Throughput: fixed-size frames decoded for FRAME_TEST_TPUT_MS
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/unistd.h>
+#include <zephyr/random/random.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "frame_codec.h"
+#include "frame_client.h"
+
+/* Decoder ring: two maximum frames, so a full frame fits behind a partial one */
+#define FRAME_RING_SIZE (2 * (FRAME_HDR_SIZE + FRAME_MAX_PAYLOAD))
+
+static struct frame_decoder decoder;
+static uint8_t decoder_ring[FRAME_RING_SIZE];
+static uint8_t decoder_scratch[FRAME_MAX_PAYLOAD];
+
+/* One encoded frame (header + payload) */
+static uint8_t frame_buf[FRAME_HDR_SIZE + FRAME_MAX_PAYLOAD];
+
+/**
+ * Payload byte i of frame number seq - easy to check on the other side
+ */
+static inline uint8_t pattern(uint32_t seq, uint32_t i)
+{
+    return (uint8_t)(seq * 7 + i);
+}
+
+static void fill_payload(uint8_t *payload, uint32_t seq, uint16_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        payload[i] = pattern(seq, i);
+    }
+}
+
+static bool check_payload(const struct frame *frame, uint32_t seq, uint16_t len)
+{
+    uint32_t i;
+
+    if (frame->len != len)
+    {
+        return false;
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        if (frame->data[i] != pattern(seq, i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Payload length of frame number seq, 0 to FRAME_MAX_PAYLOAD
+ */
+static inline uint16_t frame_len(uint32_t seq)
+{
+    return (uint16_t)((seq * 37) % (FRAME_MAX_PAYLOAD + 1));
+}
+
+int frame_client_run(const struct sockaddr_in *server)
+{
+    struct frame frame;
+    uint32_t sent = 0;
+    uint32_t echoed = 0;
+    uint32_t mismatches = 0;
+    uint64_t bytes = 0;
+    int64_t start;
+    uint32_t elapsed_ms;
+    int optval = 1;
+    int fd;
+    int ret = 0;
+
+    frame_decoder_init(&decoder, decoder_ring, sizeof(decoder_ring), decoder_scratch);
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        printk("Failed to create socket: %d\n", -errno);
+        return -errno;
+    }
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+    if (connect(fd, (const struct sockaddr *)server, sizeof(*server)) < 0)
+    {
+        ret = -errno;
+        printk("Connection failed: %d\n", ret);
+        close(fd);
+        return ret;
+    }
+
+    start = k_uptime_get();
+    while (echoed < FRAMED_COUNT && ret >= 0)
+    {
+        // Send a burst, header and payload of each frame in one sendmsg()
+        while (sent < FRAMED_COUNT && sent - echoed < FRAMED_BURST && ret >= 0)
+        {
+            fill_payload(frame_buf, sent, frame_len(sent));
+            ret = frame_send(fd, frame_buf, frame_len(sent));
+            sent++;
+        }
+
+        // Read until every frame of the burst is back
+        while (echoed < sent && ret >= 0)
+        {
+            ret = frame_decoder_next(&decoder, &frame);
+            if (ret == 0)
+            {
+                ret = frame_decoder_recv(&decoder, fd, 0);
+                ret = (ret == 0) ? -ECONNRESET : ret;
+                continue;
+            }
+            if (ret < 0)
+            {
+                break;
+            }
+
+            if (!check_payload(&frame, echoed, frame_len(echoed)))
+            {
+                mismatches++;
+            }
+            bytes += frame.len;
+            echoed++;
+            frame_decoder_release(&decoder);
+        }
+    }
+    elapsed_ms = MAX((uint32_t)(k_uptime_get() - start), 1);
+
+    close(fd);
+
+    if (ret < 0)
+    {
+        printk("Framed client failed after %u frames: %d\n", echoed, ret);
+    }
+
+    printk("Framed: %u frames (%u bytes) in %u ms = %u frames/s, %u mismatches\n",
+           echoed, (uint32_t)bytes, elapsed_ms, echoed * 1000 / elapsed_ms, mismatches);
+    printk("Decoder: %u zero-copy, %u wrapped (copied)\n",
+           decoder.frames - decoder.wrapped, decoder.wrapped);
+
+    return (ret < 0) ? ret : (mismatches ? -EIO : 0);
+}
+
+/**
+ * Decode every complete frame in the ring and check it
+ *
+ * @return Frames decoded, -EIO on a wrong frame
+ */
+static int drain_and_check(uint32_t *next_seq)
+{
+    struct frame frame;
+    int count = 0;
+    int ret;
+
+    while ((ret = frame_decoder_next(&decoder, &frame)) == 1)
+    {
+        if (!check_payload(&frame, *next_seq, frame_len(*next_seq)))
+        {
+            printk("Self-test: frame %u corrupted\n", *next_seq);
+            return -EIO;
+        }
+
+        frame_decoder_release(&decoder);
+        (*next_seq)++;
+        count++;
+    }
+
+    return (ret < 0) ? -EIO : count;
+}
+
+/**
+ * Fuzz: random frame lengths, random chunk boundaries
+ */
+static int selftest_fuzz(void)
+{
+    uint32_t enc_seq = 0;
+    uint32_t dec_seq = 0;
+    uint32_t enc_len = 0;
+    uint32_t enc_off = 0;
+    uint32_t chunk;
+    uint32_t taken;
+
+    frame_decoder_init(&decoder, decoder_ring, sizeof(decoder_ring), decoder_scratch);
+
+    while (dec_seq < FRAME_TEST_FRAMES)
+    {
+        // Encode the next frame once the previous one is fully written
+        if (enc_off == enc_len && enc_seq < FRAME_TEST_FRAMES)
+        {
+            sys_put_be16(frame_len(enc_seq), frame_buf);
+            fill_payload(frame_buf + FRAME_HDR_SIZE, enc_seq, frame_len(enc_seq));
+            enc_len = FRAME_HDR_SIZE + frame_len(enc_seq);
+            enc_off = 0;
+            enc_seq++;
+        }
+
+        // Feed a random piece: may end inside a header or a payload
+        chunk = sys_rand32_get() % 300 + 1;
+        chunk = MIN(chunk, enc_len - enc_off);
+        taken = frame_decoder_write(&decoder, frame_buf + enc_off, chunk);
+        enc_off += taken;
+
+        // Drain only now and then, so several frames queue up in the ring
+        if (taken < chunk || (sys_rand32_get() & 1) || enc_seq == FRAME_TEST_FRAMES)
+        {
+            if (drain_and_check(&dec_seq) < 0)
+            {
+                return -EIO;
+            }
+        }
+    }
+
+    printk("Self-test fuzz: %u frames OK, %u zero-copy, %u wrapped\n",
+           dec_seq, decoder.frames - decoder.wrapped, decoder.wrapped);
+
+    return 0;
+}
+
+/**
+ * An out-of-range length prefix must be rejected, not waited for
+ */
+static int selftest_oversize(void)
+{
+    struct frame frame;
+    uint8_t hdr[FRAME_HDR_SIZE];
+
+    frame_decoder_init(&decoder, decoder_ring, sizeof(decoder_ring), decoder_scratch);
+    sys_put_be16(FRAME_MAX_PAYLOAD + 1, hdr);
+    frame_decoder_write(&decoder, hdr, sizeof(hdr));
+
+    if (frame_decoder_next(&decoder, &frame) != -EMSGSIZE)
+    {
+        printk("Self-test: oversized frame not rejected\n");
+        return -EIO;
+    }
+
+    return 0;
+}
+
+/**
+ * Throughput: write as many whole fixed-size frames as fit, decode them all
+ */
+static void selftest_throughput(void)
+{
+    uint32_t frame_size = FRAME_HDR_SIZE + FRAME_TEST_TPUT_SIZE;
+    uint32_t seq = 0;
+    uint64_t bytes = 0;
+    int64_t start;
+    uint32_t elapsed_ms;
+    struct frame frame;
+    uint32_t mb_x100;
+
+    frame_decoder_init(&decoder, decoder_ring, sizeof(decoder_ring), decoder_scratch);
+    sys_put_be16(FRAME_TEST_TPUT_SIZE, frame_buf);
+    fill_payload(frame_buf + FRAME_HDR_SIZE, 0, FRAME_TEST_TPUT_SIZE);
+
+    start = k_uptime_get();
+    while (k_uptime_get() - start < FRAME_TEST_TPUT_MS)
+    {
+        while (ring_buf_space_get(&decoder.ring) >= frame_size)
+        {
+            frame_decoder_write(&decoder, frame_buf, frame_size);
+        }
+
+        while (frame_decoder_next(&decoder, &frame) == 1)
+        {
+            bytes += frame.len;
+            seq++;
+            frame_decoder_release(&decoder);
+        }
+    }
+    elapsed_ms = MAX((uint32_t)(k_uptime_get() - start), 1);
+    mb_x100 = (uint32_t)(bytes * 1000 / elapsed_ms * 100 / (1024 * 1024));
+
+    printk("Self-test throughput: %u-byte frames, %u frames/s, %u.%02u MB/s, %u%% zero-copy\n",
+           FRAME_TEST_TPUT_SIZE, (uint32_t)((uint64_t)seq * 1000 / elapsed_ms),
+           mb_x100 / 100, mb_x100 % 100,
+           seq ? (seq - decoder.wrapped) * 100 / seq : 0);
+}
+
+int frame_selftest_run(void)
+{
+    printk("Frame codec self-test: max payload %d, ring %d bytes\n",
+           FRAME_MAX_PAYLOAD, FRAME_RING_SIZE);
+
+    if (selftest_fuzz() < 0 || selftest_oversize() < 0)
+    {
+        printk("Self-test FAILED\n");
+        return -EIO;
+    }
+
+    selftest_throughput();
+    printk("Self-test PASSED\n");
+
+    return 0;
+}
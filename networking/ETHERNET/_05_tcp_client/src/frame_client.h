@@ -0,0 +1,43 @@
+/*
+ * Framed echo client and frame codec self-test
+ */
+
+#ifndef FRAME_CLIENT_H
+#define FRAME_CLIENT_H
+
+#include <zephyr/net/socket.h>
+
+/* Framed client: frames sent per run, and frames sent before reading the
+ * echoes back (so several frames share segments on the way) */
+#define FRAMED_COUNT 1000
+#define FRAMED_BURST 4
+
+/* Self-test: frames pushed through the decoder in random-sized chunks */
+#define FRAME_TEST_FRAMES 20000
+
+/* Self-test: payload size and duration of the decode throughput run */
+#define FRAME_TEST_TPUT_SIZE 256
+#define FRAME_TEST_TPUT_MS 2000
+
+/**
+ *  @brief Send FRAMED_COUNT frames of varying size and check every echo
+ *
+ *  Works against any echo server (tcp_echo_server.py --keep-alive) or
+ *  _06_tcp_server in SERVER_MODE_FRAMED.
+ *
+ *  @return 0 when every echo matched, negative errno otherwise
+ */
+int frame_client_run(const struct sockaddr_in *server);
+
+/**
+ *  @brief Fuzz and throughput test of the codec, no network needed
+ *
+ *  Random frame sizes are split and coalesced at random chunk boundaries,
+ *  every decoded frame is checked, and an oversized length prefix must be
+ *  rejected. Then decode throughput is measured for fixed-size frames.
+ *
+ *  @return 0 on success, -EIO on the first failed check
+ */
+int frame_selftest_run(void);
+
+#endif /* FRAME_CLIENT_H */
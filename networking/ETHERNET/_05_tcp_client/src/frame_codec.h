@@ -0,0 +1,114 @@
+/*
+ * Length-prefixed frame codec for TCP streams
+ *
+ * Wire format: 2-byte big-endian payload length, then the payload. The
+ * same format is used by _05_tcp_client, _06_tcp_server and their Python
+ * tools (--framed).
+ */
+
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/net/socket.h>
+
+#include <stdbool.h>
+
+/* Length prefix in front of every payload */
+#define FRAME_HDR_SIZE 2
+
+/* Largest payload accepted by the decoder (the prefix allows up to 65535) */
+#ifndef FRAME_MAX_PAYLOAD
+#define FRAME_MAX_PAYLOAD 1024
+#endif
+
+/* A decoded frame. data points into the decoder ring (zero copy) or, when
+ * the frame wraps around the end of the ring, into the scratch buffer. */
+struct frame
+{
+    const uint8_t *data;
+    uint16_t len;
+    bool copied;                /* Frame wrapped and was copied to scratch */
+};
+
+/* Incremental decoder: bytes go in as they arrive, whole frames come out */
+struct frame_decoder
+{
+    struct ring_buf ring;       /* Received bytes not yet consumed */
+    uint8_t *scratch;           /* FRAME_MAX_PAYLOAD bytes for wrapped frames */
+    uint32_t held;              /* Bytes of the frame handed out, freed on release */
+    uint32_t frames;            /* Frames decoded */
+    uint32_t wrapped;           /* Frames that had to be copied to scratch */
+    uint32_t bytes;             /* Payload bytes decoded */
+};
+
+/* Header and payload of an outgoing frame, ready for one sendmsg() */
+struct frame_tx
+{
+    uint8_t hdr[FRAME_HDR_SIZE];
+    struct iovec iov[2];        /* [0] header, [1] payload (not copied) */
+};
+
+/**
+ *  @brief Initialize an empty decoder on caller-provided storage
+ *
+ *  @param ring_size Ring bytes, at least FRAME_HDR_SIZE + FRAME_MAX_PAYLOAD
+ *                   so that any valid frame fits
+ *  @param scratch   FRAME_MAX_PAYLOAD bytes
+ *
+ *  @return 0, or -EINVAL when the ring cannot hold a full frame
+ */
+int frame_decoder_init(struct frame_decoder *dec, uint8_t *ring_storage, uint32_t ring_size,
+                       uint8_t *scratch);
+
+/**
+ *  @brief Receive from a socket straight into the ring (no extra copy)
+ *
+ *  @return Bytes received, 0 when the peer closed, -ENOBUFS when the ring
+ *          is full (consume frames first), other negative errno on error
+ */
+int frame_decoder_recv(struct frame_decoder *dec, int fd, int flags);
+
+/**
+ *  @brief Append bytes from another source (e.g. a test stream)
+ *
+ *  @return Bytes taken (less than len when the ring is full)
+ */
+uint32_t frame_decoder_write(struct frame_decoder *dec, const uint8_t *data, uint32_t len);
+
+/**
+ *  @brief Get the next complete frame
+ *
+ *  A frame stored contiguously in the ring is returned in place. It stays
+ *  valid until frame_decoder_release(), which must be called before the
+ *  next frame_decoder_next() or frame_decoder_recv().
+ *
+ *  @return 1 with a frame, 0 when more bytes are needed, -EMSGSIZE when
+ *          the length prefix exceeds FRAME_MAX_PAYLOAD (the stream is out
+ *          of sync and should be closed)
+ */
+int frame_decoder_next(struct frame_decoder *dec, struct frame *frame);
+
+/**
+ *  @brief Give the space of the last frame back to the ring
+ */
+void frame_decoder_release(struct frame_decoder *dec);
+
+/**
+ *  @brief Build the header and the two-entry iovec of an outgoing frame
+ *
+ *  The payload is referenced, not copied, and must stay valid until sent.
+ */
+void frame_encode(struct frame_tx *tx, const uint8_t *payload, uint16_t len);
+
+/**
+ *  @brief Send one frame with sendmsg(), header and payload together
+ *
+ *  Blocking socket: short writes are retried until the frame is out.
+ *
+ *  @return 0 on success, negative errno on error
+ */
+int frame_send(int fd, const uint8_t *payload, uint16_t len);
+
+#endif /* FRAME_CODEC_H */
@@ -11,8 +11,16 @@
  * 5. Receive response from server
  * 6. Close connection gracefully
  *
+ * Set CLIENT_MODE to CLIENT_MODE_BENCHMARK to run an iperf-style benchmark
+ * instead (upload / download / ping-pong, see tcp_bench_client.c), or to
+ * CLIENT_MODE_PERSISTENT to compare connect-per-message against one
+ * persistent, pipelined connection (see tcp_conn.c). CLIENT_MODE_FRAMED
+ * sends length-prefixed frames and rebuilds the echoes however the stream
+ * was split, and CLIENT_MODE_FRAME_TEST runs the frame codec self-test
+ * (see frame_codec.c and frame_client.c).
+ *
  * Board Support: Any Zephyr board with Ethernet and networking support
- * Tested on: STM32H573I-DK, Nordic nRF52, QEMU, and others
+ * Tested on: STM32H573I-DK, Nordic nRF52, QEMU, native_sim and others
  */
 
 
@@ -28,14 +36,42 @@
 #include <string.h>
 #include <errno.h>
 
+#include "tcp_bench.h"
+#include "tx_queue.h"
+#include "tcp_conn.h"
+#include "frame_client.h"
+
 
 
 // ============================================================================
 // TCP SERVER CONFIGURATION - Customize these values for your setup
 // ============================================================================
 #define SERVER_PORT 4242                   // TCP server port
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+#define SERVER_ADDR "127.0.0.1"            // native_sim uses the host stack
+#else
 #define SERVER_ADDR "192.168.1.1"          // TCP server IP address
+#endif
 #define SEND_DATA "Hello from Zephyr!"     // Message to send
+#define SEND_TIMEOUT_MS 5000               // Give up if the server does not take the data
+
+// ============================================================================
+// CLIENT MODE - Single message (didactic) or benchmark
+// ============================================================================
+#define CLIENT_MODE_SINGLE_MESSAGE 0       // Send SEND_DATA once, print the echo
+#define CLIENT_MODE_BENCHMARK 1            // Run the benchmark configured below
+#define CLIENT_MODE_PERSISTENT 2           // Connect-per-message vs persistent connection
+#define CLIENT_MODE_FRAMED 3               // Length-prefixed frames, echoes checked
+#define CLIENT_MODE_FRAME_TEST 4           // Frame codec fuzz/throughput test, no server
+#define CLIENT_MODE CLIENT_MODE_SINGLE_MESSAGE
+
+#define BENCH_TEST BENCH_TEST_PINGPONG     // BENCH_TEST_UPLOAD / _DOWNLOAD / _PINGPONG
+#define BENCH_MSG_SIZE 64                  // Bytes per message (<= BENCH_MAX_MSG_SIZE)
+#define BENCH_DURATION_MS 10000            // Test duration
+
+#define PERSIST_REQUESTS 500               // Messages sent by each of the two runs
+#define PERSIST_PIPELINE 4                 // Requests in flight (<= TCP_CONN_MAX_INFLIGHT)
+#define PERSIST_TIMEOUT_MS 30000           // Give up on a run after this long
 
 // ============================================================================
 // BOARD IP CONFIGURATION - Customize these values for your network
@@ -48,13 +84,11 @@
 // INTERNAL CONSTANTS - Do not modify
 // ============================================================================
 #define RECV_BUF_SIZE 1024
+#define TX_QUEUE_SIZE 1024
 
 // Event callback structure - used to listen for IP address changes
 static struct net_mgmt_event_callback mgmt_cb;
 
-// Socket descriptor (global so we can use it in callbacks)
-static int tcp_socket = -1;
-
 /**
  * Assign static IP address to interface
  *
@@ -132,6 +166,14 @@ static void ip_event_handler(struct net_mgmt_event_callback *cb,
     }
 }
 
+#if CLIENT_MODE == CLIENT_MODE_SINGLE_MESSAGE
+// Socket descriptor (global so we can use it in callbacks)
+static int tcp_socket = -1;
+
+// Transmit queue - short writes are kept here instead of being lost
+static struct tx_queue send_queue;
+static uint8_t send_queue_buf[TX_QUEUE_SIZE];
+
 /**
  * Create and connect a TCP socket to the server
  *
@@ -147,6 +189,7 @@ static void tcp_connect_and_send(void)
 {
     struct sockaddr_in server_addr;
     char recv_buffer[RECV_BUF_SIZE];
+    int sent;
     int ret;
 
     printk("Creating TCP socket...\n");
@@ -209,12 +252,23 @@ static void tcp_connect_and_send(void)
     }
     printk("Connected to server!\n");
 
-    // Send data to the server
+    // Send data to the server: whatever send() does not take right away
+    // is queued and pushed out as soon as the socket is writable again
     printk("Sending: '%s'\n", SEND_DATA);
-    ret = send(tcp_socket, SEND_DATA, sizeof(SEND_DATA) - 1, 0);
+    tx_queue_init(&send_queue, send_queue_buf, sizeof(send_queue_buf),
+                  TX_QUEUE_SIZE, TX_QUEUE_SIZE / 2);
+
+    sent = tx_queue_send(&send_queue, tcp_socket, (const uint8_t *)SEND_DATA,
+                         sizeof(SEND_DATA) - 1);
+    ret = sent;
+    if (sent >= 0)
+    {
+        ret = tx_queue_drain(&send_queue, tcp_socket, SEND_TIMEOUT_MS);
+        ret = (ret < 0) ? ret : sent + ret;
+    }
     if (ret < 0)
     {
-        printk("Send failed: %d\n", -errno);
+        printk("Send failed: %d\n", ret);
         close(tcp_socket);
         tcp_socket = -1;
         return;
@@ -243,6 +297,203 @@ static void tcp_connect_and_send(void)
     tcp_socket = -1;
     printk("Connection closed\n");
 }
+#endif
+
+#if CLIENT_MODE == CLIENT_MODE_BENCHMARK
+/**
+ * Run the benchmark configured with the BENCH_* defines
+ */
+static void run_benchmark(void)
+{
+    struct sockaddr_in server_addr;
+    struct bench_params params = {
+        .test = BENCH_TEST,
+        .msg_size = BENCH_MSG_SIZE,
+        .duration_ms = BENCH_DURATION_MS,
+    };
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(SERVER_PORT);
+    inet_pton(AF_INET, SERVER_ADDR, &server_addr.sin_addr);
+
+    printk("Benchmark server: %s:%d\n", SERVER_ADDR, SERVER_PORT);
+    tcp_bench_client_run(&server_addr, &params);
+}
+#endif
+
+#if CLIENT_MODE == CLIENT_MODE_FRAMED
+/**
+ * Send length-prefixed frames and check every echoed frame
+ */
+static void run_framed(void)
+{
+    struct sockaddr_in server_addr;
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(SERVER_PORT);
+    inet_pton(AF_INET, SERVER_ADDR, &server_addr.sin_addr);
+
+    printk("Framed client: %s:%d\n", SERVER_ADDR, SERVER_PORT);
+    frame_client_run(&server_addr);
+}
+#endif
+
+#if CLIENT_MODE == CLIENT_MODE_PERSISTENT
+// Persistent mode state (static, the connection holds ~3 KB of buffers)
+static struct tcp_conn persist_conn;
+static struct bench_hist per_msg_hist;
+static uint32_t persist_mismatches;
+
+/**
+ * Print requests per second for one run
+ */
+static void print_req_rate(const char *label, uint32_t requests, uint32_t elapsed_ms)
+{
+    if (elapsed_ms == 0)
+    {
+        elapsed_ms = 1;
+    }
+
+    printk("%s: %u requests in %u ms = %u req/s\n",
+           label, requests, elapsed_ms, requests * 1000 / elapsed_ms);
+}
+
+/**
+ * Send one message on a fresh connection and wait for the whole echo
+ *
+ * This is what tcp_connect_and_send() does, without the printk() calls.
+ */
+static int send_on_new_connection(const struct sockaddr_in *server)
+{
+    char echo[sizeof(SEND_DATA) - 1];
+    size_t got = 0;
+    int optval = 1;
+    int fd;
+    int ret;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+    ret = connect(fd, (const struct sockaddr *)server, sizeof(*server));
+    if (ret == 0)
+    {
+        ret = send(fd, SEND_DATA, sizeof(echo), 0);
+    }
+
+    while (ret >= 0 && got < sizeof(echo))
+    {
+        ret = recv(fd, echo + got, sizeof(echo) - got, 0);
+        if (ret == 0)
+        {
+            errno = ECONNRESET;
+            ret = -1;
+        }
+        got += (ret > 0) ? ret : 0;
+    }
+
+    ret = (ret < 0) ? -errno : 0;
+    close(fd);
+
+    return ret;
+}
+
+/**
+ * Check every echo of the persistent run against what was sent
+ */
+static void persist_response(struct tcp_conn *conn, int status,
+                             const uint8_t *resp, uint32_t len, void *user_data)
+{
+    ARG_UNUSED(conn);
+    ARG_UNUSED(user_data);
+
+    if (status == 0 && memcmp(resp, SEND_DATA, len) != 0)
+    {
+        persist_mismatches++;
+    }
+}
+
+/**
+ * Send PERSIST_REQUESTS messages twice: one connection per message, then
+ * one persistent connection with PERSIST_PIPELINE requests in flight
+ */
+static void run_persistent(void)
+{
+    struct sockaddr_in server_addr;
+    struct tcp_conn *conn = &persist_conn;
+    uint32_t submitted = 0;
+    uint32_t done = 0;
+    uint32_t failures = 0;
+    int64_t start;
+    int64_t deadline;
+    uint32_t t0;
+    int ret;
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(SERVER_PORT);
+    inet_pton(AF_INET, SERVER_ADDR, &server_addr.sin_addr);
+
+    printk("Persistent connection test: %s:%d, %d requests\n",
+           SERVER_ADDR, SERVER_PORT, PERSIST_REQUESTS);
+
+    // 1. Baseline: socket/connect/send/recv/close for every message
+    bench_hist_reset(&per_msg_hist);
+    start = k_uptime_get();
+    deadline = start + PERSIST_TIMEOUT_MS;
+    while (done < PERSIST_REQUESTS && k_uptime_get() < deadline)
+    {
+        t0 = k_cycle_get_32();
+        ret = send_on_new_connection(&server_addr);
+        if (ret < 0)
+        {
+            failures++;
+        }
+        else
+        {
+            bench_hist_record(&per_msg_hist, k_cyc_to_us_floor32(k_cycle_get_32() - t0));
+        }
+        done++;
+    }
+
+    print_req_rate("Connect per message", done - failures, (uint32_t)(k_uptime_get() - start));
+    printk("  %u handshakes, %u failed\n", done, failures);
+    bench_hist_print(&per_msg_hist, "Latency");
+
+    // 2. One connection, requests pipelined, responses matched in order
+    tcp_conn_init(conn, &server_addr);
+    start = k_uptime_get();
+    deadline = start + PERSIST_TIMEOUT_MS;
+    while (conn->stats.completed + conn->stats.failed < PERSIST_REQUESTS &&
+           k_uptime_get() < deadline)
+    {
+        while (submitted < PERSIST_REQUESTS && tcp_conn_inflight(conn) < PERSIST_PIPELINE)
+        {
+            if (tcp_conn_request(conn, (const uint8_t *)SEND_DATA, sizeof(SEND_DATA) - 1,
+                                 sizeof(SEND_DATA) - 1, persist_response, NULL) < 0)
+            {
+                break;
+            }
+            submitted++;
+        }
+
+        tcp_conn_process(conn, 100);
+    }
+    tcp_conn_close(conn);
+
+    print_req_rate("Persistent", conn->stats.completed, (uint32_t)(k_uptime_get() - start));
+    tcp_conn_print_stats(conn, "Persistent");
+    printk("Handshakes avoided: %u, echo mismatches: %u\n",
+           conn->stats.completed - MIN(conn->stats.handshakes, conn->stats.completed),
+           persist_mismatches);
+}
+#endif
 
 int main(void)
 {
@@ -270,8 +521,22 @@ int main(void)
     // Wait a moment for the IP to be fully assigned
     k_sleep(K_SECONDS(1));
 
+#if CLIENT_MODE == CLIENT_MODE_BENCHMARK
+    // Run the iperf-style benchmark against the server
+    run_benchmark();
+#elif CLIENT_MODE == CLIENT_MODE_PERSISTENT
+    // Compare connect-per-message with one pipelined connection
+    run_persistent();
+#elif CLIENT_MODE == CLIENT_MODE_FRAMED
+    // Echo length-prefixed frames of varying size
+    run_framed();
+#elif CLIENT_MODE == CLIENT_MODE_FRAME_TEST
+    // Codec only: split/coalesced streams, oversized frames, throughput
+    frame_selftest_run();
+#else
     // Attempt to connect to TCP server
     tcp_connect_and_send();
+#endif
 
     // Keep the system running
     printk("Waiting...\n");
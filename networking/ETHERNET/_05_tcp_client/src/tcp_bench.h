@@ -0,0 +1,74 @@
+/*
+ * iperf-style TCP benchmark - wire protocol and client API
+ *
+ * The same protocol is spoken by _06_tcp_server (benchmark mode) and by the
+ * Python tools in pc_server/ and _06_tcp_server/pc_client/.
+ */
+
+#ifndef TCP_BENCH_H
+#define TCP_BENCH_H
+
+#include <stdint.h>
+#include <zephyr/net/socket.h>
+
+/* First word of every control message ("ZBEN") */
+#define BENCH_MAGIC 0x5A42454EUL
+
+/* Benchmark tests */
+#define BENCH_TEST_UPLOAD    1   /* Bulk stream client -> server */
+#define BENCH_TEST_DOWNLOAD  2   /* Bulk stream server -> client */
+#define BENCH_TEST_PINGPONG  3   /* Client sends a message, server echoes it, RTT measured */
+
+/**
+ * Sent by the client right after connect(), all fields in network byte order
+ */
+struct bench_hello
+{
+    uint32_t magic;         /* BENCH_MAGIC */
+    uint32_t test;          /* BENCH_TEST_* */
+    uint32_t msg_size;      /* Bytes per message / write */
+    uint32_t duration_ms;   /* Test duration */
+};
+
+/**
+ * Sent by the server at the end of an upload test, network byte order
+ */
+struct bench_result
+{
+    uint32_t magic;         /* BENCH_MAGIC */
+    uint32_t elapsed_ms;    /* Receive time measured by the server */
+    uint32_t bytes_hi;      /* Bytes received by the server (upper 32 bits) */
+    uint32_t bytes_lo;      /* Bytes received by the server (lower 32 bits) */
+};
+
+/* Benchmark parameters (host byte order) */
+struct bench_params
+{
+    uint32_t test;          /* BENCH_TEST_* */
+    uint32_t msg_size;      /* Bytes per message, <= BENCH_MAX_MSG_SIZE */
+    uint32_t duration_ms;   /* Test duration */
+};
+
+/* Largest message the device client can send or receive */
+#define BENCH_MAX_MSG_SIZE 4096
+
+/* Upload: transmit queue between the producer loop and the socket. The
+ * producer pauses at the high watermark and resumes at the low one. */
+#define BENCH_TXQ_SIZE (2 * BENCH_MAX_MSG_SIZE)
+#define BENCH_TXQ_HIGH_WM (BENCH_TXQ_SIZE * 3 / 4)
+#define BENCH_TXQ_LOW_WM (BENCH_TXQ_SIZE / 4)
+
+/* Upload: time allowed to flush the queue after the test */
+#define BENCH_DRAIN_TIMEOUT_MS 5000
+
+/**
+ *  @brief Run one benchmark against a server and print the report
+ *
+ *  @param server Server address (IPv4)
+ *  @param params Test, message size and duration
+ *
+ *  @return 0 on success, negative errno on failure
+ */
+int tcp_bench_client_run(const struct sockaddr_in *server, const struct bench_params *params);
+
+#endif /* TCP_BENCH_H */
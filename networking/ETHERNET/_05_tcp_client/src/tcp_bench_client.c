@@ -0,0 +1,334 @@
+/**
+ * iperf-style TCP benchmark client (benchmark mode)
+ *
+ * Connects to a benchmark server (pc_server/tcp_echo_server.py --bench or
+ * _06_tcp_server in benchmark mode), announces the test with a bench_hello
+ * and then runs one of:
+ * - Upload:    stream msg_size writes for duration_ms through a non-blocking
+ *              transmit queue, server reports what it got
+ * - Download:  server streams for duration_ms and closes, client counts
+ * - Ping-pong: send msg_size bytes, wait for the echo, record the RTT
+ *
+ * Results are printed once at the end: MB/s, messages/s and, for ping-pong,
+ * p50/p99/p999 RTT plus the RTT histogram. Nothing is logged per message.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/arpa/inet.h>
+#include <zephyr/posix/unistd.h>
+#include <zephyr/posix/poll.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "tcp_bench.h"
+#include "bench_hist.h"
+#include "tx_queue.h"
+
+/* Message buffer shared by all tests (one benchmark runs at a time) */
+static uint8_t bench_buf[BENCH_MAX_MSG_SIZE];
+
+/* RTT histogram for ping-pong (kept static, ~1 KB) */
+static struct bench_hist rtt_hist;
+
+/* Upload transmit queue */
+static struct tx_queue upload_queue;
+static uint8_t upload_queue_buf[BENCH_TXQ_SIZE];
+
+static const char *const test_names[] = {
+    [BENCH_TEST_UPLOAD] = "upload",
+    [BENCH_TEST_DOWNLOAD] = "download",
+    [BENCH_TEST_PINGPONG] = "ping-pong",
+};
+
+/**
+ * Send a whole buffer, retrying on short writes
+ */
+static int send_all(int fd, const uint8_t *data, size_t len)
+{
+    int ret;
+
+    while (len > 0)
+    {
+        ret = send(fd, data, len, 0);
+        if (ret < 0)
+        {
+            return -errno;
+        }
+
+        data += ret;
+        len -= ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Receive exactly len bytes (TCP may split or merge segments)
+ */
+static int recv_all(int fd, uint8_t *data, size_t len)
+{
+    int ret;
+
+    while (len > 0)
+    {
+        ret = recv(fd, data, len, 0);
+        if (ret < 0)
+        {
+            return -errno;
+        }
+
+        if (ret == 0)
+        {
+            return -ECONNRESET;
+        }
+
+        data += ret;
+        len -= ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Print throughput as MB/s and messages/s with two decimals
+ */
+static void print_rate(const char *label, uint64_t bytes, uint32_t msg_size, uint32_t elapsed_ms)
+{
+    uint64_t bytes_per_s;
+    uint32_t mb_x100;
+
+    if (elapsed_ms == 0)
+    {
+        elapsed_ms = 1;
+    }
+
+    bytes_per_s = bytes * 1000 / elapsed_ms;
+    mb_x100 = (uint32_t)(bytes_per_s * 100 / (1024 * 1024));
+
+    printk("%s: %u bytes in %u ms = %u.%02u MB/s, %u msg/s\n",
+           label, (uint32_t)bytes, elapsed_ms, mb_x100 / 100, mb_x100 % 100,
+           (uint32_t)(bytes_per_s / msg_size));
+}
+
+/**
+ * Upload: stream to the server until the deadline, then read its report
+ *
+ * The producer never blocks in send(): messages go through the transmit
+ * queue, and when the server reads slower than we produce the queue hits
+ * its high watermark and the producer waits for POLLOUT instead.
+ */
+static int bench_upload(int fd, const struct bench_params *params)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+    struct tx_queue *txq = &upload_queue;
+    struct bench_result result;
+    int64_t start = k_uptime_get();
+    int64_t deadline = start + params->duration_ms;
+    int64_t now;
+    uint64_t bytes = 0;
+    int ret;
+
+    tx_queue_init(txq, upload_queue_buf, sizeof(upload_queue_buf),
+                  BENCH_TXQ_HIGH_WM, BENCH_TXQ_LOW_WM);
+
+    while ((now = k_uptime_get()) < deadline)
+    {
+        if (tx_queue_throttled(txq) || tx_queue_space(txq) < params->msg_size)
+        {
+            // Server is the bottleneck: wait until the socket takes more
+            if (poll(&pfd, 1, (int)(deadline - now)) < 0)
+            {
+                return -errno;
+            }
+
+            ret = tx_queue_flush(txq, fd);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            continue;
+        }
+
+        ret = tx_queue_send(txq, fd, bench_buf, params->msg_size);
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        bytes += params->msg_size;
+    }
+
+    ret = tx_queue_drain(txq, fd, BENCH_DRAIN_TIMEOUT_MS);
+    if (ret < 0)
+    {
+        printk("Transmit queue not drained (%d)\n", ret);
+    }
+
+    print_rate("Upload (sent)", bytes, params->msg_size, (uint32_t)(k_uptime_get() - start));
+    printk("Tx queue: peak %u of %d bytes, %u stalls, %u ms stalled, %u drops\n",
+           txq->peak, BENCH_TXQ_SIZE, txq->stalls, tx_queue_stall_ms(txq), txq->drops);
+
+    // The server stops reading after duration_ms and sends what it counted
+    ret = recv_all(fd, (uint8_t *)&result, sizeof(result));
+    if (ret < 0 || ntohl(result.magic) != BENCH_MAGIC)
+    {
+        printk("No result from server (%d)\n", ret);
+        return (ret < 0) ? ret : -EPROTO;
+    }
+
+    bytes = ((uint64_t)ntohl(result.bytes_hi) << 32) | ntohl(result.bytes_lo);
+    print_rate("Upload (received by server)", bytes, params->msg_size, ntohl(result.elapsed_ms));
+
+    return 0;
+}
+
+/**
+ * Download: count bytes until the server closes the connection
+ */
+static int bench_download(int fd, const struct bench_params *params)
+{
+    int64_t start = 0;
+    uint64_t bytes = 0;
+    int ret;
+
+    while (1)
+    {
+        ret = recv(fd, bench_buf, sizeof(bench_buf), 0);
+        if (ret < 0)
+        {
+            return -errno;
+        }
+
+        if (ret == 0)
+        {
+            break;
+        }
+
+        // Start the clock at the first byte so connection setup is not counted
+        if (bytes == 0)
+        {
+            start = k_uptime_get();
+        }
+
+        bytes += ret;
+    }
+
+    print_rate("Download", bytes, params->msg_size, (uint32_t)(k_uptime_get() - start));
+
+    return 0;
+}
+
+/**
+ * Ping-pong: one message in flight, RTT of every round trip recorded
+ */
+static int bench_pingpong(int fd, const struct bench_params *params)
+{
+    int64_t start = k_uptime_get();
+    int64_t deadline = start + params->duration_ms;
+    uint64_t bytes = 0;
+    uint32_t t0;
+    int ret;
+
+    bench_hist_reset(&rtt_hist);
+
+    while (k_uptime_get() < deadline)
+    {
+        t0 = k_cycle_get_32();
+
+        ret = send_all(fd, bench_buf, params->msg_size);
+        if (ret == 0)
+        {
+            ret = recv_all(fd, bench_buf, params->msg_size);
+        }
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        bench_hist_record(&rtt_hist, k_cyc_to_us_floor32(k_cycle_get_32() - t0));
+        bytes += params->msg_size;
+    }
+
+    print_rate("Ping-pong", bytes, params->msg_size, (uint32_t)(k_uptime_get() - start));
+    bench_hist_print(&rtt_hist, "RTT");
+
+    return 0;
+}
+
+int tcp_bench_client_run(const struct sockaddr_in *server, const struct bench_params *params)
+{
+    struct bench_hello hello;
+    int optval = 1;
+    int fd;
+    int ret;
+    size_t i;
+
+    if (params->msg_size == 0 || params->msg_size > BENCH_MAX_MSG_SIZE ||
+        params->test < BENCH_TEST_UPLOAD || params->test > BENCH_TEST_PINGPONG)
+    {
+        printk("Invalid benchmark parameters\n");
+        return -EINVAL;
+    }
+
+    printk("Benchmark: %s, %u-byte messages, %u ms\n",
+           test_names[params->test], params->msg_size, params->duration_ms);
+
+    // Recognizable payload pattern (handy in a packet capture)
+    for (i = 0; i < sizeof(bench_buf); i++)
+    {
+        bench_buf[i] = (uint8_t)i;
+    }
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        printk("Failed to create socket: %d\n", -errno);
+        return -errno;
+    }
+
+    // Ping-pong measures latency - every message must leave immediately
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+    ret = connect(fd, (const struct sockaddr *)server, sizeof(*server));
+    if (ret < 0)
+    {
+        ret = -errno;
+        printk("Connection failed: %d\n", ret);
+        close(fd);
+        return ret;
+    }
+
+    hello.magic = htonl(BENCH_MAGIC);
+    hello.test = htonl(params->test);
+    hello.msg_size = htonl(params->msg_size);
+    hello.duration_ms = htonl(params->duration_ms);
+
+    ret = send_all(fd, (const uint8_t *)&hello, sizeof(hello));
+    if (ret == 0)
+    {
+        switch (params->test)
+        {
+        case BENCH_TEST_UPLOAD:
+            ret = bench_upload(fd, params);
+            break;
+        case BENCH_TEST_DOWNLOAD:
+            ret = bench_download(fd, params);
+            break;
+        default:
+            ret = bench_pingpong(fd, params);
+            break;
+        }
+    }
+
+    if (ret < 0)
+    {
+        printk("Benchmark failed: %d\n", ret);
+    }
+
+    close(fd);
+
+    return ret;
+}
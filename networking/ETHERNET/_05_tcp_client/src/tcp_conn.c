@@ -0,0 +1,320 @@
+/**
+ * Persistent TCP client connection with reconnect backoff and pipelining
+ *
+ * Opening a socket per message costs a full TCP handshake (one RTT plus
+ * the SYN processing on both sides) before any data moves. A tcp_conn
+ * keeps one socket open for many requests instead:
+ * - Requests go out through a non-blocking transmit queue without waiting
+ *   for older responses, up to TCP_CONN_MAX_INFLIGHT at a time
+ * - Responses are matched to requests in FIFO order (TCP keeps the order),
+ *   the caller says how many response bytes complete each request
+ * - When the connection drops, pending requests fail with their callback
+ *   and the next connect() waits for an exponential backoff with jitter
+ *
+ * The backoff is only reset once a response arrives on the new connection,
+ * so a server that accepts and immediately closes does not cause a tight
+ * reconnect loop.
+ *
+ * A tcp_conn is not thread safe, one thread owns it.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/unistd.h>
+#include <zephyr/posix/poll.h>
+#include <zephyr/random/random.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "tcp_conn.h"
+
+/**
+ * Pick the time of the next connect() attempt and double the backoff
+ */
+static void schedule_retry(struct tcp_conn *conn)
+{
+    uint32_t half = conn->backoff_ms / 2;
+    uint32_t delay = half + sys_rand32_get() % (half + 1);
+
+    conn->next_attempt_ms = k_uptime_get() + delay;
+    conn->backoff_ms = MIN(conn->backoff_ms * 2, TCP_CONN_BACKOFF_MAX_MS);
+}
+
+/**
+ * Complete every pending request with an error
+ */
+static void fail_inflight(struct tcp_conn *conn, int err)
+{
+    struct tcp_conn_req *req;
+
+    while (conn->count > 0)
+    {
+        req = &conn->inflight[conn->head];
+        conn->head = (conn->head + 1) % TCP_CONN_MAX_INFLIGHT;
+        conn->count--;
+        conn->stats.failed++;
+
+        if (req->cb)
+        {
+            req->cb(conn, err, NULL, 0, req->user_data);
+        }
+    }
+}
+
+/**
+ * Close the socket after an error and schedule the reconnect
+ */
+static void conn_drop(struct tcp_conn *conn, int err)
+{
+    close(conn->fd);
+    conn->fd = -1;
+    conn->rx_len = 0;
+    conn->stats.reconnects++;
+
+    fail_inflight(conn, err);
+    schedule_retry(conn);
+}
+
+/**
+ * Open the socket if the backoff delay has passed
+ */
+static int conn_connect(struct tcp_conn *conn)
+{
+    int optval = 1;
+    uint32_t t0;
+    int ret;
+
+    if (k_uptime_get() < conn->next_attempt_ms)
+    {
+        return -ENOTCONN;
+    }
+
+    conn->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (conn->fd < 0)
+    {
+        ret = -errno;
+        schedule_retry(conn);
+        return ret;
+    }
+
+    // Pipelined requests are small: send each one right away
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+    t0 = k_cycle_get_32();
+    ret = connect(conn->fd, (const struct sockaddr *)&conn->server, sizeof(conn->server));
+    if (ret < 0)
+    {
+        ret = -errno;
+        close(conn->fd);
+        conn->fd = -1;
+        conn->stats.connect_failures++;
+        schedule_retry(conn);
+        return ret;
+    }
+
+    conn->stats.handshakes++;
+    conn->stats.handshake_us += k_cyc_to_us_floor32(k_cycle_get_32() - t0);
+
+    tx_queue_init(&conn->txq, conn->txq_buf, sizeof(conn->txq_buf),
+                  TCP_CONN_TXQ_SIZE, TCP_CONN_TXQ_SIZE / 2);
+    conn->rx_len = 0;
+
+    return 0;
+}
+
+/**
+ * Hand complete responses to their requests, oldest first
+ */
+static int complete_responses(struct tcp_conn *conn)
+{
+    struct tcp_conn_req *req;
+    uint32_t offset = 0;
+    int completed = 0;
+
+    while (conn->count > 0)
+    {
+        req = &conn->inflight[conn->head];
+        if (conn->rx_len - offset < req->resp_len)
+        {
+            break;
+        }
+
+        conn->head = (conn->head + 1) % TCP_CONN_MAX_INFLIGHT;
+        conn->count--;
+        conn->stats.completed++;
+        bench_hist_record(&conn->latency, k_cyc_to_us_floor32(k_cycle_get_32() - req->t0));
+
+        if (req->cb)
+        {
+            req->cb(conn, 0, conn->rx_buf + offset, req->resp_len, req->user_data);
+        }
+
+        offset += req->resp_len;
+        completed++;
+    }
+
+    if (completed > 0)
+    {
+        // The connection works: the next failure starts from a short delay
+        conn->backoff_ms = TCP_CONN_BACKOFF_MIN_MS;
+    }
+
+    // Keep the start of the next (partial) response at the buffer start
+    if (offset > 0)
+    {
+        memmove(conn->rx_buf, conn->rx_buf + offset, conn->rx_len - offset);
+        conn->rx_len -= offset;
+    }
+
+    return completed;
+}
+
+void tcp_conn_init(struct tcp_conn *conn, const struct sockaddr_in *server)
+{
+    memset(conn, 0, sizeof(*conn));
+    conn->server = *server;
+    conn->fd = -1;
+    conn->backoff_ms = TCP_CONN_BACKOFF_MIN_MS;
+    conn->next_attempt_ms = 0;
+    bench_hist_reset(&conn->latency);
+}
+
+int tcp_conn_request(struct tcp_conn *conn, const uint8_t *data, uint32_t len,
+                     uint32_t resp_len, tcp_conn_cb_t cb, void *user_data)
+{
+    struct tcp_conn_req *req;
+    int ret;
+
+    if (len == 0 || len > TCP_CONN_MAX_MSG || resp_len == 0 || resp_len > TCP_CONN_MAX_MSG)
+    {
+        return -EINVAL;
+    }
+
+    if (conn->fd < 0)
+    {
+        ret = conn_connect(conn);
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+
+    if (conn->count == TCP_CONN_MAX_INFLIGHT || tx_queue_throttled(&conn->txq) ||
+        tx_queue_space(&conn->txq) < len)
+    {
+        return -EBUSY;
+    }
+
+    ret = tx_queue_send(&conn->txq, conn->fd, data, len);
+    if (ret < 0)
+    {
+        conn_drop(conn, ret);
+        return ret;
+    }
+
+    req = &conn->inflight[(conn->head + conn->count) % TCP_CONN_MAX_INFLIGHT];
+    req->resp_len = resp_len;
+    req->t0 = k_cycle_get_32();
+    req->cb = cb;
+    req->user_data = user_data;
+    conn->count++;
+
+    return 0;
+}
+
+int tcp_conn_process(struct tcp_conn *conn, int timeout_ms)
+{
+    struct pollfd pfd;
+    int64_t wait_ms;
+    int ret;
+
+    if (conn->fd < 0)
+    {
+        // Disconnected: sleep until the backoff allows the next attempt
+        wait_ms = conn->next_attempt_ms - k_uptime_get();
+        if (wait_ms > 0)
+        {
+            k_sleep(K_MSEC(MIN(wait_ms, timeout_ms)));
+        }
+
+        // A failed attempt is not an error for the caller, it is retried
+        conn_connect(conn);
+        return 0;
+    }
+
+    pfd.fd = conn->fd;
+    pfd.events = POLLIN;
+    if (tx_queue_len(&conn->txq) > 0)
+    {
+        pfd.events |= POLLOUT;
+    }
+
+    ret = poll(&pfd, 1, timeout_ms);
+    if (ret <= 0)
+    {
+        return (ret < 0) ? -errno : 0;
+    }
+
+    if (pfd.revents & POLLOUT)
+    {
+        ret = tx_queue_flush(&conn->txq, conn->fd);
+        if (ret < 0)
+        {
+            conn_drop(conn, ret);
+            return 0;
+        }
+    }
+
+    if (pfd.revents & (POLLIN | POLLERR | POLLHUP))
+    {
+        ret = recv(conn->fd, conn->rx_buf + conn->rx_len,
+                   sizeof(conn->rx_buf) - conn->rx_len, MSG_DONTWAIT);
+        if (ret == 0 || (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            conn_drop(conn, (ret == 0) ? -ECONNRESET : -errno);
+            return 0;
+        }
+
+        if (ret > 0)
+        {
+            conn->rx_len += ret;
+        }
+
+        ret = complete_responses(conn);
+
+        // Bytes nobody asked for: the stream is out of sync
+        if (conn->count == 0 && conn->rx_len > 0)
+        {
+            conn_drop(conn, -EPROTO);
+        }
+
+        return ret;
+    }
+
+    return 0;
+}
+
+void tcp_conn_close(struct tcp_conn *conn)
+{
+    if (conn->fd >= 0)
+    {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+
+    conn->rx_len = 0;
+    fail_inflight(conn, -ECONNABORTED);
+}
+
+void tcp_conn_print_stats(struct tcp_conn *conn, const char *title)
+{
+    struct tcp_conn_stats *stats = &conn->stats;
+
+    printk("%s: %u requests completed, %u failed\n", title, stats->completed, stats->failed);
+    printk("  %u handshakes (avg %u us), %u connect failures, %u reconnects\n",
+           stats->handshakes, stats->handshakes ? stats->handshake_us / stats->handshakes : 0,
+           stats->connect_failures, stats->reconnects);
+    bench_hist_print(&conn->latency, "Latency");
+}
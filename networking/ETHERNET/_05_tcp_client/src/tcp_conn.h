@@ -0,0 +1,147 @@
+/*
+ * Persistent TCP client connection with reconnect backoff and pipelining
+ */
+
+#ifndef TCP_CONN_H
+#define TCP_CONN_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+
+#include <stdint.h>
+
+#include "tx_queue.h"
+#include "bench_hist.h"
+
+/* Requests sent but not answered yet (FIFO, responses come back in order) */
+#define TCP_CONN_MAX_INFLIGHT 8
+
+/* Largest request / response handled by one connection */
+#define TCP_CONN_MAX_MSG 256
+
+/* Transmit queue: room for a full pipeline of requests */
+#define TCP_CONN_TXQ_SIZE (TCP_CONN_MAX_INFLIGHT * TCP_CONN_MAX_MSG)
+
+/* Reconnect backoff: first delay, doubled after every failed attempt up to
+ * the maximum. The actual wait is picked at random in [delay/2, delay] so a
+ * fleet of boards does not reconnect in lockstep after a server restart. */
+#define TCP_CONN_BACKOFF_MIN_MS 250
+#define TCP_CONN_BACKOFF_MAX_MS 8000
+
+struct tcp_conn;
+
+/**
+ *  @brief Called once per request, in submission order
+ *
+ *  @param status 0 with the response, or negative errno when the connection
+ *                dropped before the response arrived (resp is NULL)
+ */
+typedef void (*tcp_conn_cb_t)(struct tcp_conn *conn, int status,
+                              const uint8_t *resp, uint32_t len, void *user_data);
+
+/* One request waiting for its response */
+struct tcp_conn_req
+{
+    uint32_t resp_len;          /* Response bytes that complete the request */
+    uint32_t t0;                /* k_cycle_get_32() when submitted */
+    tcp_conn_cb_t cb;
+    void *user_data;
+};
+
+struct tcp_conn_stats
+{
+    uint32_t handshakes;        /* Successful connect() calls */
+    uint32_t connect_failures;  /* Failed connect() calls */
+    uint32_t reconnects;        /* Connections lost after being established */
+    uint32_t completed;         /* Requests answered */
+    uint32_t failed;            /* Requests lost with a dropped connection */
+    uint32_t handshake_us;      /* Time spent in successful connect() calls */
+};
+
+struct tcp_conn
+{
+    struct sockaddr_in server;
+    int fd;                     /* -1 while disconnected */
+
+    /* Reconnect backoff */
+    uint32_t backoff_ms;        /* Delay before the next attempt */
+    int64_t next_attempt_ms;    /* Uptime of the next connect() attempt */
+
+    /* Outgoing requests */
+    struct tx_queue txq;
+    uint8_t txq_buf[TCP_CONN_TXQ_SIZE];
+
+    /* Pipeline: ring of requests in flight, oldest at head */
+    struct tcp_conn_req inflight[TCP_CONN_MAX_INFLIGHT];
+    uint8_t head;
+    uint8_t count;
+
+    /* Response bytes received but not yet matched to a request */
+    uint8_t rx_buf[TCP_CONN_MAX_MSG];
+    uint32_t rx_len;
+
+    struct tcp_conn_stats stats;
+    struct bench_hist latency;  /* Submit to response, microseconds */
+};
+
+/**
+ *  @brief Initialize a disconnected connection to a server
+ *
+ *  Nothing is sent until the first request, the first connect() happens in
+ *  tcp_conn_request() or tcp_conn_process().
+ */
+void tcp_conn_init(struct tcp_conn *conn, const struct sockaddr_in *server);
+
+/**
+ *  @brief Queue a request and send it without waiting for older responses
+ *
+ *  Connects first when the connection is down and the backoff delay has
+ *  passed. The request is either fully queued or refused.
+ *
+ *  @param resp_len Response bytes expected for this request
+ *
+ *  @return 0 when queued, -EBUSY when TCP_CONN_MAX_INFLIGHT requests are
+ *          pending or the transmit queue is throttled, -ENOTCONN while
+ *          waiting for the next reconnect attempt, other negative errno
+ */
+int tcp_conn_request(struct tcp_conn *conn, const uint8_t *data, uint32_t len,
+                     uint32_t resp_len, tcp_conn_cb_t cb, void *user_data);
+
+/**
+ *  @brief Wait up to timeout_ms for socket activity and handle it
+ *
+ *  Flushes queued requests, reads responses and completes requests in FIFO
+ *  order. While disconnected, sleeps until the next reconnect attempt (at
+ *  most timeout_ms) and tries it.
+ *
+ *  @return Requests completed by this call, negative errno on error
+ */
+int tcp_conn_process(struct tcp_conn *conn, int timeout_ms);
+
+/**
+ *  @brief Fail the pending requests and close the socket
+ */
+void tcp_conn_close(struct tcp_conn *conn);
+
+/**
+ *  @brief Print handshakes, reconnects, requests and the latency histogram
+ */
+void tcp_conn_print_stats(struct tcp_conn *conn, const char *title);
+
+/**
+ *  @brief Requests waiting for their response
+ */
+static inline uint32_t tcp_conn_inflight(const struct tcp_conn *conn)
+{
+    return conn->count;
+}
+
+/**
+ *  @brief True while a socket is open
+ */
+static inline bool tcp_conn_is_connected(const struct tcp_conn *conn)
+{
+    return conn->fd >= 0;
+}
+
+#endif /* TCP_CONN_H */
@@ -0,0 +1,193 @@
+/**
+ * Non-blocking per-connection transmit queue with backpressure
+ *
+ * A blocking send() to a slow reader stalls the thread that calls it, and
+ * a short write silently loses the tail of the data if it is ignored.
+ * The transmit queue fixes both:
+ * - Every send() uses MSG_DONTWAIT, so the caller never blocks
+ * - A short write or EAGAIN leaves the rest in a ring buffer, which is
+ *   drained on POLLOUT with tx_queue_flush()
+ * - Filling up to high_wm sets "throttled": the producer stops reading or
+ *   generating data for that peer until the queue falls back to low_wm
+ *   (hysteresis, so it does not toggle on every packet)
+ * - A write that does not fit is refused as a whole and counted as a drop,
+ *   a stream is never cut in the middle of a write
+ *
+ * Counters: peak queued bytes, number of stalls, time spent throttled and
+ * drops. The queue itself is not thread safe, one thread owns it at a time.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/poll.h>
+
+#include <errno.h>
+
+#include "tx_queue.h"
+
+/**
+ * Update the throttle state after the fill level changed
+ */
+static void update_watermarks(struct tx_queue *q)
+{
+    uint32_t len = tx_queue_len(q);
+
+    q->peak = MAX(q->peak, len);
+
+    if (!q->throttled && len >= q->high_wm)
+    {
+        q->throttled = true;
+        q->stalls++;
+        q->stall_start_ms = k_uptime_get();
+    }
+    else if (q->throttled && len <= q->low_wm)
+    {
+        q->throttled = false;
+        q->stall_ms += (uint32_t)(k_uptime_get() - q->stall_start_ms);
+    }
+}
+
+void tx_queue_init(struct tx_queue *q, uint8_t *storage, uint32_t size,
+                   uint32_t high_wm, uint32_t low_wm)
+{
+    ring_buf_init(&q->ring, size, storage);
+    q->high_wm = MIN(high_wm, size);
+    q->low_wm = MIN(low_wm, q->high_wm - 1);
+    q->throttled = false;
+    q->stall_start_ms = 0;
+    q->peak = 0;
+    q->stalls = 0;
+    q->stall_ms = 0;
+    q->drops = 0;
+    q->dropped_bytes = 0;
+}
+
+int tx_queue_flush(struct tx_queue *q, int fd)
+{
+    uint8_t *data;
+    uint32_t len;
+    int total = 0;
+    int sent;
+
+    // Send from the ring in place, one contiguous chunk at a time
+    while ((len = ring_buf_get_claim(&q->ring, &data, ring_buf_capacity_get(&q->ring))) > 0)
+    {
+        sent = send(fd, data, len, MSG_DONTWAIT);
+        if (sent < 0)
+        {
+            ring_buf_get_finish(&q->ring, 0);
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                return -errno;
+            }
+            break;
+        }
+
+        ring_buf_get_finish(&q->ring, sent);
+        total += sent;
+
+        if ((uint32_t)sent < len)
+        {
+            // Socket buffer full, the rest waits for POLLOUT
+            break;
+        }
+    }
+
+    update_watermarks(q);
+
+    return total;
+}
+
+int tx_queue_send(struct tx_queue *q, int fd, const uint8_t *data, uint32_t len)
+{
+    int sent;
+
+    // Refuse up front so a write is either fully delivered or not at all
+    if (len > tx_queue_space(q))
+    {
+        // Only a producer that ignores the watermarks gets here
+        q->drops++;
+        q->dropped_bytes += len;
+        return -ENOBUFS;
+    }
+
+    if (!ring_buf_is_empty(&q->ring))
+    {
+        // Keep the byte order: queue behind the older data, then flush
+        ring_buf_put(&q->ring, data, len);
+        return tx_queue_flush(q, fd);
+    }
+
+    // Fast path: nothing queued, hand the data to the socket directly (no copy)
+    sent = send(fd, data, len, MSG_DONTWAIT);
+    if (sent < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            return -errno;
+        }
+        sent = 0;
+    }
+
+    if ((uint32_t)sent < len)
+    {
+        // Short write or EAGAIN: the rest waits for POLLOUT
+        ring_buf_put(&q->ring, data + sent, len - sent);
+        update_watermarks(q);
+    }
+
+    return sent;
+}
+
+int tx_queue_drain(struct tx_queue *q, int fd, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+    int64_t deadline = k_uptime_get() + timeout_ms;
+    int64_t now;
+    int total = 0;
+    int ret;
+
+    while (!ring_buf_is_empty(&q->ring))
+    {
+        now = k_uptime_get();
+        if (now >= deadline)
+        {
+            return -ETIMEDOUT;
+        }
+
+        ret = poll(&pfd, 1, (int)(deadline - now));
+        if (ret < 0)
+        {
+            return -errno;
+        }
+
+        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))
+        {
+            return -ECONNRESET;
+        }
+
+        ret = tx_queue_flush(q, fd);
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        total += ret;
+    }
+
+    return total;
+}
+
+uint32_t tx_queue_stall_ms(const struct tx_queue *q)
+{
+    uint32_t total = q->stall_ms;
+
+    if (q->throttled)
+    {
+        total += (uint32_t)(k_uptime_get() - q->stall_start_ms);
+    }
+
+    return total;
+}
@@ -0,0 +1,100 @@
+/*
+ * Non-blocking per-connection transmit queue with backpressure
+ */
+
+#ifndef TX_QUEUE_H
+#define TX_QUEUE_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#include <stdbool.h>
+
+/* Bytes accepted for a peer but not yet taken by the socket */
+struct tx_queue
+{
+    struct ring_buf ring;       /* Queued bytes, oldest first */
+    uint32_t high_wm;           /* Throttle the producer at this fill level */
+    uint32_t low_wm;            /* Release the producer at this fill level */
+    bool throttled;             /* Above high_wm and not yet back to low_wm */
+    int64_t stall_start_ms;     /* When the current throttle began */
+    uint32_t peak;              /* Highest fill level seen */
+    uint32_t stalls;            /* Times the high watermark was reached */
+    uint32_t stall_ms;          /* Time spent throttled (finished stalls) */
+    uint32_t drops;             /* Writes refused because they did not fit */
+    uint32_t dropped_bytes;     /* Bytes of those writes */
+};
+
+/**
+ *  @brief Initialize an empty queue on caller-provided storage
+ *
+ *  @param high_wm Fill level that throttles the producer (<= size)
+ *  @param low_wm  Fill level that releases it again (< high_wm)
+ */
+void tx_queue_init(struct tx_queue *q, uint8_t *storage, uint32_t size,
+                   uint32_t high_wm, uint32_t low_wm);
+
+/**
+ *  @brief Send data, queueing whatever the socket does not take now
+ *
+ *  When the queue is empty the data goes straight to send() (no copy), and
+ *  only the part left by a short write or EAGAIN is queued. Otherwise the
+ *  data is queued behind the older bytes and the queue is flushed. Never
+ *  blocks, even on a blocking socket.
+ *
+ *  A write larger than tx_queue_space() is refused as a whole.
+ *
+ *  @return Bytes handed to the socket by this call (the rest is queued),
+ *          -ENOBUFS when the write did not fit (nothing sent, counted as a
+ *          drop), other negative errno on socket error
+ */
+int tx_queue_send(struct tx_queue *q, int fd, const uint8_t *data, uint32_t len);
+
+/**
+ *  @brief Send as much queued data as the socket takes now (on POLLOUT)
+ *
+ *  @return Bytes handed to the socket (data may still be queued),
+ *          negative errno on error
+ */
+int tx_queue_flush(struct tx_queue *q, int fd);
+
+/**
+ *  @brief Wait with poll() until the queue is empty
+ *
+ *  For simple blocking loops that still want short writes handled.
+ *
+ *  @return Bytes handed to the socket once the queue is empty,
+ *          -ETIMEDOUT after timeout_ms, other negative errno on error
+ */
+int tx_queue_drain(struct tx_queue *q, int fd, int timeout_ms);
+
+/**
+ *  @brief Total time the producer was throttled, current stall included
+ */
+uint32_t tx_queue_stall_ms(const struct tx_queue *q);
+
+/**
+ *  @brief Bytes waiting in the queue
+ */
+static inline uint32_t tx_queue_len(struct tx_queue *q)
+{
+    return ring_buf_size_get(&q->ring);
+}
+
+/**
+ *  @brief Free room in the queue (largest write that cannot be dropped)
+ */
+static inline uint32_t tx_queue_space(struct tx_queue *q)
+{
+    return ring_buf_space_get(&q->ring);
+}
+
+/**
+ *  @brief True while the producer should stop generating data
+ */
+static inline bool tx_queue_throttled(const struct tx_queue *q)
+{
+    return q->throttled;
+}
+
+#endif /* TX_QUEUE_H */
@@ -10,6 +10,31 @@ This script creates a simple TCP client that:
 
 Usage:
     python3 tcp_client.py
+    python3 tcp_client.py --load 1,2,4,8 [--duration 10] [--size 512]
+    python3 tcp_client.py --bench pingpong|upload|download [--duration 10] [--size 64]
+    python3 tcp_client.py --framed [--duration 10] [--size 1024]
+
+Benchmark (--bench):
+    Talks to the server in SERVER_MODE_BENCHMARK. A 16-byte hello
+    (magic "ZBEN", test, message size, duration - big endian) selects:
+      upload    stream to the board, the board reports what it received
+      download  the board streams to us until the duration expires
+      pingpong  one message in flight, RTT of every round trip recorded
+    Prints MB/s, messages/s and p50/p99/p999 RTT with a histogram.
+
+Load test (--load):
+    Opens N concurrent connections, each one sending SIZE-byte blocks and
+    waiting for the full echo before sending the next. Runs once per value
+    in the list and prints the aggregate throughput for each N, so a
+    server that serializes clients (sequential mode) shows a flat line
+    and the poll() server shows throughput growing with N.
+
+Framed (--framed):
+    Talks to the server in SERVER_MODE_FRAMED. Frames are a 2-byte big
+    endian length plus payload (see src/frame_codec.h). Random-sized frames
+    are glued together and cut at random points before sending, so the
+    board sees frames split across segments and several frames in one
+    segment. Every echoed frame is checked, frames/s are printed.
 
 Configuration:
     SERVER_IP - Server IP address (default: 192.168.1.100)
@@ -17,10 +42,25 @@ Configuration:
     MESSAGES - List of test messages to send
 """
 
+import argparse
+import math
+import random
 import socket
+import struct
 import sys
+import threading
 import time
 
+# Benchmark protocol (must match src/tcp_bench.h)
+BENCH_MAGIC = 0x5A42454E
+BENCH_TESTS = {'upload': 1, 'download': 2, 'pingpong': 3}
+BENCH_HELLO = struct.Struct('!IIII')    # magic, test, msg_size, duration_ms
+BENCH_RESULT = struct.Struct('!IIII')   # magic, elapsed_ms, bytes_hi, bytes_lo
+
+# Frame format (must match src/frame_codec.h)
+FRAME_HDR = struct.Struct('!H')         # payload length
+FRAME_MAX_PAYLOAD = 1024
+
 # Configuration
 SERVER_IP = '192.168.1.100'
 SERVER_PORT = 5555
@@ -33,6 +73,212 @@ MESSAGES = [
     b'Zephyr TCP Echo',
 ]
 
+def recv_exact(sock, size):
+    """Receive exactly size bytes (TCP may split the echo in several segments)"""
+    data = bytearray()
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("server closed connection")
+        data += chunk
+    return bytes(data)
+
+
+def load_worker(host, port, size, deadline, start, results, index):
+    """One load-test client: send a block, wait for its echo, repeat"""
+    payload = bytes((index + i) & 0xFF for i in range(size))
+    echoed = 0
+    error = None
+
+    try:
+        sock = socket.create_connection((host, port), timeout=10)
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        start.wait()
+        while time.monotonic() < deadline[0]:
+            sock.sendall(payload)
+            if recv_exact(sock, size) != payload:
+                raise ValueError("echo mismatch")
+            echoed += size
+        sock.close()
+    except Exception as e:
+        error = str(e)
+
+    results[index] = (echoed, error)
+
+
+def run_load(host, port, clients, duration, size):
+    """Run one load-test round with the given number of clients"""
+    results = [None] * clients
+    deadline = [0.0]
+    start = threading.Event()
+    threads = [
+        threading.Thread(target=load_worker,
+                         args=(host, port, size, deadline, start, results, i))
+        for i in range(clients)
+    ]
+
+    for t in threads:
+        t.start()
+
+    # Let every client finish connecting before the clock starts
+    time.sleep(0.5)
+    t0 = time.monotonic()
+    deadline[0] = t0 + duration
+    start.set()
+
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - t0
+
+    total = sum(r[0] for r in results)
+    errors = [r[1] for r in results if r[1]]
+    per_client = [r[0] / elapsed / 1024 for r in results]
+
+    print(f"[LOAD] clients={clients:<3} "
+          f"total={total / elapsed / 1024:8.1f} KB/s  "
+          f"min/max per client={min(per_client):7.1f}/{max(per_client):7.1f} KB/s  "
+          f"errors={len(errors)}")
+    for e in errors:
+        print(f"[LOAD]   error: {e}")
+
+
+def load_test(args):
+    print(f"[INFO] Load test against {args.host}:{args.port}")
+    print(f"[INFO] {args.duration}s per round, {args.size}-byte blocks\n")
+
+    for clients in [int(n) for n in args.load.split(',')]:
+        run_load(args.host, args.port, clients, args.duration, args.size)
+        # Give the server time to close the previous round's sockets
+        time.sleep(1)
+
+
+def print_rate(label, nbytes, size, elapsed):
+    """Print throughput as MB/s and messages/s"""
+    elapsed = max(elapsed, 1e-6)
+    print(f"[BENCH] {label}: {nbytes} bytes in {elapsed * 1000:.0f} ms = "
+          f"{nbytes / elapsed / (1024 * 1024):.2f} MB/s, {nbytes / size / elapsed:.0f} msg/s")
+
+
+def percentile(samples, p):
+    """Nearest-rank percentile of a sorted list"""
+    return samples[max(0, math.ceil(len(samples) * p) - 1)]
+
+
+def print_rtt(samples_us):
+    """Print RTT percentiles and a power-of-two histogram"""
+    if not samples_us:
+        print("[BENCH] RTT: no samples")
+        return
+
+    samples_us.sort()
+    print(f"[BENCH] RTT: {len(samples_us)} samples, min {samples_us[0]:.0f} us, "
+          f"avg {sum(samples_us) / len(samples_us):.0f} us, max {samples_us[-1]:.0f} us")
+    print(f"[BENCH]   p50 {percentile(samples_us, 0.50):.0f} us, "
+          f"p99 {percentile(samples_us, 0.99):.0f} us, "
+          f"p999 {percentile(samples_us, 0.999):.0f} us")
+
+    buckets = {}
+    for value in samples_us:
+        upper = 1 << max(0, math.ceil(math.log2(max(value, 1))))
+        buckets[upper] = buckets.get(upper, 0) + 1
+    for upper in sorted(buckets):
+        print(f"[BENCH]   <= {upper:8d} us: {buckets[upper]}")
+
+
+def bench(args):
+    """Run one benchmark against the board in SERVER_MODE_BENCHMARK"""
+    test = BENCH_TESTS[args.bench]
+    payload = bytes(i & 0xFF for i in range(args.size))
+
+    print(f"[INFO] Benchmark {args.bench} against {args.host}:{args.port}, "
+          f"{args.size}-byte messages, {args.duration}s\n")
+
+    sock = socket.create_connection((args.host, args.port), timeout=args.duration + 10)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    sock.sendall(BENCH_HELLO.pack(BENCH_MAGIC, test, args.size, int(args.duration * 1000)))
+
+    if args.bench == 'upload':
+        sent = 0
+        t0 = time.monotonic()
+        deadline = t0 + args.duration
+        while time.monotonic() < deadline:
+            sock.sendall(payload)
+            sent += args.size
+        print_rate("upload (sent)", sent, args.size, time.monotonic() - t0)
+
+        magic, elapsed_ms, hi, lo = BENCH_RESULT.unpack(recv_exact(sock, BENCH_RESULT.size))
+        if magic != BENCH_MAGIC:
+            raise ValueError("bad result from server")
+        print_rate("upload (received by board)", (hi << 32) | lo, args.size, elapsed_ms / 1000)
+
+    elif args.bench == 'download':
+        received = 0
+        t0 = None
+        while True:
+            chunk = sock.recv(65536)
+            if not chunk:
+                break
+            if t0 is None:
+                t0 = time.monotonic()
+            received += len(chunk)
+        print_rate("download", received, args.size, time.monotonic() - (t0 or time.monotonic()))
+
+    else:
+        samples = []
+        t0 = time.monotonic()
+        deadline = t0 + args.duration
+        while time.monotonic() < deadline:
+            start = time.perf_counter()
+            sock.sendall(payload)
+            recv_exact(sock, args.size)
+            samples.append((time.perf_counter() - start) * 1e6)
+        print_rate("ping-pong", len(samples) * args.size, args.size, time.monotonic() - t0)
+        print_rtt(samples)
+
+    sock.close()
+
+
+def framed(args):
+    """Send random-sized frames cut at random points, check every echo"""
+    rng = random.Random(1)
+    max_size = min(args.size, FRAME_MAX_PAYLOAD)
+
+    print(f"[INFO] Framed echo against {args.host}:{args.port}, "
+          f"payloads 0..{max_size} bytes, {args.duration}s\n")
+
+    sock = socket.create_connection((args.host, args.port), timeout=10)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    frames = 0
+    nbytes = 0
+    t0 = time.monotonic()
+    deadline = t0 + args.duration
+    while time.monotonic() < deadline:
+        # A batch of frames, sent in pieces that ignore frame boundaries
+        batch = []
+        for _ in range(rng.randint(1, 8)):
+            size = rng.randint(0, max_size)
+            batch.append(bytes((frames + len(batch) + i) & 0xFF for i in range(size)))
+        stream = b''.join(FRAME_HDR.pack(len(p)) + p for p in batch)
+        pos = 0
+        while pos < len(stream):
+            cut = rng.randint(1, 600)
+            sock.sendall(stream[pos:pos + cut])
+            pos += cut
+
+        for payload in batch:
+            (length,) = FRAME_HDR.unpack(recv_exact(sock, FRAME_HDR.size))
+            if recv_exact(sock, length) != payload:
+                raise ValueError(f"frame {frames} echo mismatch")
+            frames += 1
+            nbytes += length
+
+    elapsed = time.monotonic() - t0
+    sock.close()
+    print(f"[FRAMED] {frames} frames ({nbytes} payload bytes) in {elapsed * 1000:.0f} ms = "
+          f"{frames / elapsed:.0f} frames/s, all echoes verified")
+
+
 def main():
     # Create socket
     try:
@@ -96,4 +342,33 @@ def main():
         sys.exit(1)
 
 if __name__ == '__main__':
-    main()
+    parser = argparse.ArgumentParser(description="TCP client for the Zephyr TCP server")
+    parser.add_argument('--host', default=SERVER_IP, help="server IP address")
+    parser.add_argument('--port', type=int, default=SERVER_PORT, help="server port")
+    parser.add_argument('--load', metavar='N[,N...]',
+                        help="run a load test with N concurrent clients per round")
+    parser.add_argument('--bench', choices=sorted(BENCH_TESTS),
+                        help="run a benchmark against SERVER_MODE_BENCHMARK")
+    parser.add_argument('--framed', action='store_true',
+                        help="send length-prefixed frames to SERVER_MODE_FRAMED")
+    parser.add_argument('--duration', type=float, default=10,
+                        help="seconds per load round / benchmark")
+    parser.add_argument('--size', type=int, default=None,
+                        help="bytes per echo block (512) / benchmark message (64) / "
+                             "largest frame payload (1024)")
+    args = parser.parse_args()
+
+    SERVER_IP = args.host
+    SERVER_PORT = args.port
+
+    if args.bench:
+        args.size = args.size or 64
+        bench(args)
+    elif args.framed:
+        args.size = args.size or FRAME_MAX_PAYLOAD
+        framed(args)
+    elif args.load:
+        args.size = args.size or 512
+        load_test(args)
+    else:
+        main()
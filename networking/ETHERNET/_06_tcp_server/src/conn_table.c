@@ -0,0 +1,134 @@
+/**
+ * Slab-allocated connection context table
+ *
+ * Every connection lives in one fixed-size struct conn_ctx taken from a
+ * K_MEM_SLAB of MAX_CONNECTIONS blocks:
+ * - Allocation and release are O(1) (slab free list + doubly linked list)
+ * - No heap: the RAM for all connections is reserved at link time and is
+ *   exactly MAX_CONNECTIONS * sizeof(struct conn_ctx)
+ * - Live contexts are kept on a list so the "conn list" shell command can
+ *   print them with their byte and transmit queue counters
+ *
+ * Alloc/free run on the server thread, the shell runs on its own thread,
+ * so the list is protected by a mutex. Counters are plain 32-bit values
+ * updated by the owner of the connection and only read by the shell.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/dlist.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/arpa/inet.h>
+#include <zephyr/posix/unistd.h>
+
+#include <string.h>
+
+#include "tcp_server_config.h"
+#include "conn_table.h"
+
+/* Context storage - the only memory connections ever use */
+K_MEM_SLAB_DEFINE_STATIC(conn_slab, sizeof(struct conn_ctx), MAX_CONNECTIONS, 4);
+
+/* Live connections, oldest first */
+static sys_dlist_t conn_list = SYS_DLIST_STATIC_INIT(&conn_list);
+static K_MUTEX_DEFINE(conn_lock);
+
+static uint32_t next_id;
+
+struct conn_ctx *conn_alloc(int fd, const struct sockaddr_in *addr)
+{
+    struct conn_ctx *ctx;
+
+    if (k_mem_slab_alloc(&conn_slab, (void **)&ctx, K_NO_WAIT) != 0)
+    {
+        return NULL;
+    }
+
+    ctx->fd = fd;
+    ctx->addr = *addr;
+    ring_buf_init(&ctx->rx, sizeof(ctx->rx_data), ctx->rx_data);
+    tx_queue_init(&ctx->tx, ctx->tx_data, sizeof(ctx->tx_data), CONN_TX_HIGH_WM, CONN_TX_LOW_WM);
+    ctx->connected_ms = k_uptime_get();
+    ctx->last_rx_ms = ctx->connected_ms;
+    ctx->last_tx_ms = ctx->connected_ms;
+    ctx->bytes_in = 0;
+    ctx->bytes_out = 0;
+
+    k_mutex_lock(&conn_lock, K_FOREVER);
+    ctx->id = next_id++;
+    sys_dlist_append(&conn_list, &ctx->node);
+    k_mutex_unlock(&conn_lock);
+
+    return ctx;
+}
+
+void conn_free(struct conn_ctx *ctx)
+{
+    close(ctx->fd);
+
+    k_mutex_lock(&conn_lock, K_FOREVER);
+    sys_dlist_remove(&ctx->node);
+    ctx->fd = -1;
+    k_mutex_unlock(&conn_lock);
+
+    k_mem_slab_free(&conn_slab, ctx);
+}
+
+uint32_t conn_count(void)
+{
+    return k_mem_slab_num_used_get(&conn_slab);
+}
+
+#if defined(CONFIG_SHELL)
+/**
+ * "conn list" - one line per live connection plus the memory budget
+ */
+static int cmd_conn_list(const struct shell *sh, size_t argc, char **argv)
+{
+    char client_ip[INET_ADDRSTRLEN];
+    struct conn_ctx *ctx;
+    int64_t now = k_uptime_get();
+    int64_t last;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%4s %-21s %3s %7s %7s %10s %10s %5s %5s %8s %5s",
+                "id", "peer", "fd", "age s", "idle s", "bytes in", "bytes out", "rx q", "tx q",
+                "stall ms", "drops");
+
+    k_mutex_lock(&conn_lock, K_FOREVER);
+
+    SYS_DLIST_FOR_EACH_CONTAINER(&conn_list, ctx, node)
+    {
+        inet_ntop(AF_INET, &ctx->addr.sin_addr, client_ip, sizeof(client_ip));
+        last = MAX(ctx->last_rx_ms, ctx->last_tx_ms);
+
+        shell_print(sh, "%4u %15s:%-5u %3d %7u %7u %10u %10u %5u %5u %8u %5u",
+                    ctx->id, client_ip, ntohs(ctx->addr.sin_port), ctx->fd,
+                    (uint32_t)((now - ctx->connected_ms) / 1000),
+                    (uint32_t)((now - last) / 1000),
+                    ctx->bytes_in, ctx->bytes_out,
+                    ring_buf_size_get(&ctx->rx), tx_queue_len(&ctx->tx),
+                    tx_queue_stall_ms(&ctx->tx), ctx->tx.drops);
+    }
+
+    k_mutex_unlock(&conn_lock);
+
+    shell_print(sh, "%u of %d contexts in use (peak %u), %u bytes each, %u bytes reserved",
+                k_mem_slab_num_used_get(&conn_slab), MAX_CONNECTIONS,
+                k_mem_slab_max_used_get(&conn_slab), (uint32_t)sizeof(struct conn_ctx),
+                (uint32_t)(MAX_CONNECTIONS * sizeof(struct conn_ctx)));
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_conn_cmds,
+    SHELL_CMD(list, NULL, "List live connections with bytes in/out.", cmd_conn_list),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(conn, &sub_conn_cmds, "TCP server connection table", NULL);
+#endif /* CONFIG_SHELL */
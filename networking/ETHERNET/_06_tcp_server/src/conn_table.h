@@ -0,0 +1,73 @@
+/*
+ * Slab-allocated connection context table
+ */
+
+#ifndef CONN_TABLE_H
+#define CONN_TABLE_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/dlist.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/net/socket.h>
+
+#include "tcp_server_config.h"
+#include "tx_queue.h"
+
+/* Everything the server keeps about one client, one fixed-size slab block each */
+struct conn_ctx
+{
+    sys_dnode_t node;                   /* Link in the live connection list */
+    uint32_t id;                        /* Connection number since boot */
+    int fd;                             /* Client socket */
+    struct sockaddr_in addr;            /* Peer address */
+    struct ring_buf rx;                 /* Received, not yet processed */
+    struct tx_queue tx;                 /* Processed, not yet taken by the socket */
+    int64_t connected_ms;               /* k_uptime_get() at accept() */
+    int64_t last_rx_ms;                 /* Last time data arrived */
+    int64_t last_tx_ms;                 /* Last time data left */
+    uint32_t bytes_in;                  /* Total bytes received */
+    uint32_t bytes_out;                 /* Total bytes sent */
+    uint8_t rx_data[CONN_RX_RING_SIZE]; /* Storage behind rx */
+    uint8_t tx_data[CONN_TX_RING_SIZE]; /* Storage behind tx */
+};
+
+/**
+ *  @brief Take a context from the slab and add it to the live list
+ *
+ *  @param fd   Accepted client socket (not closed on failure)
+ *  @param addr Peer address from accept()
+ *
+ *  @return Initialized context with empty rings, NULL when all
+ *          MAX_CONNECTIONS contexts are in use. Never blocks.
+ */
+struct conn_ctx *conn_alloc(int fd, const struct sockaddr_in *addr);
+
+/**
+ *  @brief Close the socket and give the context back to the slab
+ */
+void conn_free(struct conn_ctx *ctx);
+
+/**
+ *  @brief Number of contexts currently in use
+ */
+uint32_t conn_count(void);
+
+/**
+ *  @brief Account bytes received on a connection
+ */
+static inline void conn_account_rx(struct conn_ctx *ctx, uint32_t bytes)
+{
+    ctx->bytes_in += bytes;
+    ctx->last_rx_ms = k_uptime_get();
+}
+
+/**
+ *  @brief Account bytes sent on a connection
+ */
+static inline void conn_account_tx(struct conn_ctx *ctx, uint32_t bytes)
+{
+    ctx->bytes_out += bytes;
+    ctx->last_tx_ms = k_uptime_get();
+}
+
+#endif /* CONN_TABLE_H */
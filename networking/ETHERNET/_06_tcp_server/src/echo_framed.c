@@ -0,0 +1,92 @@
+/**
+ * Length-prefixed frame echo handler (framed mode)
+ *
+ * The sequential handler echoes whatever one recv() returns, which only
+ * works while every recv() happens to hold exactly one message. Here the
+ * client sends frames (2-byte length + payload, see frame_codec.c) and
+ * the server echoes frame by frame:
+ * 1. recv() goes straight into the decoder ring
+ * 2. Every complete frame is taken from the ring, in place unless it
+ *    wraps around the ring end
+ * 3. The frame is sent back with one sendmsg() (header + payload iovec)
+ *    directly from the ring, then its space is released
+ *
+ * A frame split over several segments is echoed once it is complete, and
+ * several frames arriving in one segment are echoed one by one. A length
+ * above FRAME_MAX_PAYLOAD closes the connection.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/unistd.h>
+
+#include <errno.h>
+
+#include "tcp_server_config.h"
+#include "echo_stats.h"
+#include "frame_codec.h"
+#include "echo_framed.h"
+
+/* Decoder storage, one client at a time in this mode */
+static struct frame_decoder decoder;
+static uint8_t decoder_ring[FRAME_RING_SIZE];
+static uint8_t decoder_scratch[FRAME_MAX_PAYLOAD];
+
+BUILD_ASSERT(FRAME_RING_SIZE >= FRAME_HDR_SIZE + FRAME_MAX_PAYLOAD,
+             "FRAME_RING_SIZE must hold one maximum frame");
+
+void echo_framed_serve(int client_socket)
+{
+    struct echo_stats stats = { 0 };
+    struct frame frame;
+    int optval = 1;
+    int ret;
+
+    // Each echoed frame should leave right away
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+    frame_decoder_init(&decoder, decoder_ring, sizeof(decoder_ring), decoder_scratch);
+    stats.start_ms = k_uptime_get();
+
+    while (1)
+    {
+        ret = frame_decoder_recv(&decoder, client_socket, 0);
+        stats.rx_calls++;
+        if (ret <= 0)
+        {
+            if (ret < 0)
+            {
+                printk("Receive failed: %d\n", ret);
+            }
+            break;
+        }
+        stats.copied += ret;
+
+        // Echo every frame that is complete now, partial ones stay in the ring
+        while ((ret = frame_decoder_next(&decoder, &frame)) == 1)
+        {
+            ret = frame_send(client_socket, frame.data, frame.len);
+            stats.tx_calls++;
+            frame_decoder_release(&decoder);
+            if (ret < 0)
+            {
+                break;
+            }
+
+            stats.bytes += FRAME_HDR_SIZE + frame.len;
+            stats.copied += FRAME_HDR_SIZE + frame.len + (frame.copied ? frame.len : 0);
+        }
+
+        if (ret < 0)
+        {
+            printk("%s: %d\n", (ret == -EMSGSIZE) ? "Oversized frame" : "Send failed", ret);
+            break;
+        }
+    }
+
+    close(client_socket);
+
+    echo_stats_print("framed", &stats);
+    printk("[framed] %u frames, %u wrapped (copied)\n", decoder.frames, decoder.wrapped);
+}
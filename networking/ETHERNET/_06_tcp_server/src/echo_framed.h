@@ -0,0 +1,15 @@
+/*
+ * Length-prefixed frame echo handler
+ */
+
+#ifndef ECHO_FRAMED_H
+#define ECHO_FRAMED_H
+
+/**
+ *  @brief Echo every length-prefixed frame of a client back as one frame
+ *
+ *  @param client_socket Connected client socket, closed before returning
+ */
+void echo_framed_serve(int client_socket);
+
+#endif /* ECHO_FRAMED_H */
@@ -0,0 +1,48 @@
+/*
+ * Per-connection echo statistics shared by the server modes
+ */
+
+#ifndef ECHO_STATS_H
+#define ECHO_STATS_H
+
+#include <zephyr/kernel.h>
+
+/* Counters collected while echoing one connection */
+struct echo_stats
+{
+    int64_t start_ms;       /* k_uptime_get() when the client connected */
+    uint32_t bytes;         /* Bytes echoed back */
+    uint32_t copied;        /* Bytes copied by the CPU (socket layer + application) */
+    uint32_t rx_calls;      /* recv()/recvmsg() calls */
+    uint32_t tx_calls;      /* send()/sendmsg() calls */
+};
+
+/**
+ *  @brief Print a one-line summary when a connection ends
+ *
+ *  Copies per byte counts every pass over the payload: the socket layer
+ *  copy into the receive buffer, the copy back out on send, and any
+ *  application copy or formatting (e.g. printk of the data).
+ */
+static inline void echo_stats_print(const char *tag, const struct echo_stats *stats)
+{
+    uint32_t elapsed_ms = (uint32_t)(k_uptime_get() - stats->start_ms);
+    uint32_t copies_x100 = 0;
+
+    if (elapsed_ms == 0)
+    {
+        elapsed_ms = 1;
+    }
+
+    if (stats->bytes > 0)
+    {
+        copies_x100 = (uint32_t)((uint64_t)stats->copied * 100 / stats->bytes);
+    }
+
+    printk("[%s] %u bytes in %u ms = %u B/s, %u rx / %u tx calls, %u.%02u copies/byte\n",
+           tag, stats->bytes, elapsed_ms,
+           (uint32_t)((uint64_t)stats->bytes * 1000 / elapsed_ms),
+           stats->rx_calls, stats->tx_calls, copies_x100 / 100, copies_x100 % 100);
+}
+
+#endif /* ECHO_STATS_H */
@@ -0,0 +1,210 @@
+/**
+ * Zero-copy scatter/gather echo handler (zero-copy mode)
+ *
+ * Instead of one flat stack buffer, the connection owns a chain of
+ * ZC_FRAGS_PER_CHAIN net_buf fragments taken from a NET_BUF_POOL:
+ * 1. One iovec points at the free room of each fragment
+ * 2. recvmsg() scatters the incoming bytes across the fragments
+ * 3. net_buf_add() commits the received length (no data moves)
+ * 4. sendmsg() gathers the same fragments straight back to the peer
+ * 5. Short writes are consumed with net_buf_pull() and retried
+ *
+ * The payload is never copied, null-terminated or formatted by the
+ * application, and nothing is logged per packet. Statistics are printed
+ * once when the client disconnects.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net_buf.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/unistd.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "tcp_server_config.h"
+#include "echo_stats.h"
+#include "echo_zero_copy.h"
+
+/* Fragment pool - one chain is taken per connection and reused for every packet */
+NET_BUF_POOL_FIXED_DEFINE(zc_pool, ZC_POOL_COUNT, ZC_FRAG_SIZE, 0, NULL);
+
+/**
+ * Take ZC_FRAGS_PER_CHAIN fragments from the pool and chain them
+ */
+static struct net_buf *chain_alloc(void)
+{
+    struct net_buf *chain = NULL;
+    struct net_buf *frag;
+    int i;
+
+    for (i = 0; i < ZC_FRAGS_PER_CHAIN; i++)
+    {
+        frag = net_buf_alloc(&zc_pool, K_NO_WAIT);
+        if (!frag)
+        {
+            if (chain)
+            {
+                net_buf_unref(chain);
+            }
+            return NULL;
+        }
+
+        chain = net_buf_frag_add(chain, frag);
+    }
+
+    return chain;
+}
+
+/**
+ * Receive directly into the free room of every fragment
+ *
+ * Returns bytes received, 0 when the peer closed, negative on error
+ */
+static int chain_recv(int fd, struct net_buf *chain, struct echo_stats *stats)
+{
+    struct iovec iov[ZC_FRAGS_PER_CHAIN];
+    struct msghdr msg = { 0 };
+    struct net_buf *frag;
+    size_t remaining;
+    size_t len;
+    int received;
+    int n = 0;
+
+    // Empty every fragment and point one iovec at each one
+    for (frag = chain; frag; frag = frag->frags)
+    {
+        // net_buf_reset() asserts the fragment is unlinked, only the data
+        // pointers are reset here and the chain stays as it is
+        net_buf_simple_reset(&frag->b);
+        iov[n].iov_base = net_buf_tail(frag);
+        iov[n].iov_len = net_buf_tailroom(frag);
+        n++;
+    }
+
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+
+    received = recvmsg(fd, &msg, 0);
+    stats->rx_calls++;
+    if (received <= 0)
+    {
+        return (received < 0) ? -errno : 0;
+    }
+
+    stats->copied += received;
+
+    // Commit the received bytes fragment by fragment (only lengths change)
+    remaining = received;
+    for (frag = chain; frag && remaining > 0; frag = frag->frags)
+    {
+        len = MIN(remaining, net_buf_tailroom(frag));
+        net_buf_add(frag, len);
+        remaining -= len;
+    }
+
+    return received;
+}
+
+/**
+ * Gather every non-empty fragment back to the peer
+ *
+ * Returns 0 once the whole chain was sent, negative on error
+ */
+static int chain_send(int fd, struct net_buf *chain, struct echo_stats *stats)
+{
+    struct iovec iov[ZC_FRAGS_PER_CHAIN];
+    struct msghdr msg = { 0 };
+    struct net_buf *frag;
+    size_t len;
+    int sent;
+    int n;
+
+    while (1)
+    {
+        n = 0;
+        for (frag = chain; frag; frag = frag->frags)
+        {
+            if (frag->len > 0)
+            {
+                iov[n].iov_base = frag->data;
+                iov[n].iov_len = frag->len;
+                n++;
+            }
+        }
+
+        if (n == 0)
+        {
+            return 0;
+        }
+
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+
+        sent = sendmsg(fd, &msg, 0);
+        stats->tx_calls++;
+        if (sent < 0)
+        {
+            return -errno;
+        }
+
+        stats->copied += sent;
+        stats->bytes += sent;
+
+        // Short write: drop what was sent and send the rest
+        for (frag = chain; frag && sent > 0; frag = frag->frags)
+        {
+            len = MIN((size_t)sent, frag->len);
+            net_buf_pull(frag, len);
+            sent -= len;
+        }
+    }
+}
+
+void echo_zero_copy_serve(int client_socket)
+{
+    struct echo_stats stats = { 0 };
+    struct net_buf *chain;
+    int optval = 1;
+    int ret;
+
+    // Echo replies are small writes - don't let Nagle hold them back
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+    chain = chain_alloc();
+    if (!chain)
+    {
+        printk("Zero-copy: no free fragments, dropping client\n");
+        close(client_socket);
+        return;
+    }
+
+    stats.start_ms = k_uptime_get();
+
+    while (1)
+    {
+        ret = chain_recv(client_socket, chain, &stats);
+        if (ret <= 0)
+        {
+            if (ret < 0)
+            {
+                printk("Receive failed: %d\n", ret);
+            }
+            break;
+        }
+
+        ret = chain_send(client_socket, chain, &stats);
+        if (ret < 0)
+        {
+            printk("Send failed: %d\n", ret);
+            break;
+        }
+    }
+
+    // Unref the head releases every fragment back to the pool
+    net_buf_unref(chain);
+    close(client_socket);
+
+    echo_stats_print("zero-copy", &stats);
+}
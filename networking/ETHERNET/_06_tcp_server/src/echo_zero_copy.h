@@ -0,0 +1,15 @@
+/*
+ * Zero-copy scatter/gather echo handler
+ */
+
+#ifndef ECHO_ZERO_COPY_H
+#define ECHO_ZERO_COPY_H
+
+/**
+ *  @brief Echo a connected client with recvmsg()/sendmsg() on net_buf fragments
+ *
+ *  @param client_socket Connected client socket, closed before returning
+ */
+void echo_zero_copy_serve(int client_socket);
+
+#endif /* ECHO_ZERO_COPY_H */
@@ -0,0 +1,196 @@
+/**
+ * Length-prefixed frame codec for TCP streams
+ *
+ * TCP is a byte stream: one recv() may return half a message or three
+ * messages glued together, depending on how the segments were split or
+ * coalesced on the way. Every message is therefore sent as a frame, a
+ * 2-byte big-endian length followed by the payload, and the receiver
+ * rebuilds the frames incrementally:
+ * - recv() writes straight into the free room of a ring buffer
+ * - frame_decoder_next() peeks the length prefix and returns the frame
+ *   once all of its bytes are in the ring
+ * - A frame stored contiguously is returned in place (zero copy). Only a
+ *   frame that wraps around the end of the ring is copied to a scratch
+ *   buffer, and the ring restarts at offset 0 whenever it runs empty, so
+ *   with request/response traffic wrapping is rare
+ *
+ * On transmit, frame_encode() puts the 2-byte header and the payload in
+ * a two-entry iovec, so one sendmsg() sends the whole frame without
+ * copying the payload into a header+payload buffer first.
+ *
+ * A decoder is not thread safe, one thread owns it.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+
+#include <errno.h>
+
+#include "frame_codec.h"
+
+int frame_decoder_init(struct frame_decoder *dec, uint8_t *ring_storage, uint32_t ring_size,
+                       uint8_t *scratch)
+{
+    if (ring_size < FRAME_HDR_SIZE + FRAME_MAX_PAYLOAD)
+    {
+        return -EINVAL;
+    }
+
+    ring_buf_init(&dec->ring, ring_size, ring_storage);
+    dec->scratch = scratch;
+    dec->held = 0;
+    dec->frames = 0;
+    dec->wrapped = 0;
+    dec->bytes = 0;
+
+    return 0;
+}
+
+int frame_decoder_recv(struct frame_decoder *dec, int fd, int flags)
+{
+    uint8_t *data;
+    uint32_t space;
+    int ret;
+
+    // Receive into the contiguous free room at the ring's write position
+    space = ring_buf_put_claim(&dec->ring, &data, ring_buf_capacity_get(&dec->ring));
+    if (space == 0)
+    {
+        ring_buf_put_finish(&dec->ring, 0);
+        return -ENOBUFS;
+    }
+
+    ret = recv(fd, data, space, flags);
+    if (ret < 0)
+    {
+        ret = -errno;
+        ring_buf_put_finish(&dec->ring, 0);
+        return ret;
+    }
+
+    ring_buf_put_finish(&dec->ring, ret);
+
+    return ret;
+}
+
+uint32_t frame_decoder_write(struct frame_decoder *dec, const uint8_t *data, uint32_t len)
+{
+    return ring_buf_put(&dec->ring, data, len);
+}
+
+int frame_decoder_next(struct frame_decoder *dec, struct frame *frame)
+{
+    uint8_t hdr[FRAME_HDR_SIZE];
+    uint8_t *data;
+    uint32_t total;
+    uint16_t len;
+
+    // The header itself may wrap, peek copies it out either way
+    if (ring_buf_peek(&dec->ring, hdr, FRAME_HDR_SIZE) < FRAME_HDR_SIZE)
+    {
+        return 0;
+    }
+
+    len = sys_get_be16(hdr);
+    if (len > FRAME_MAX_PAYLOAD)
+    {
+        return -EMSGSIZE;
+    }
+
+    total = FRAME_HDR_SIZE + len;
+    if (ring_buf_size_get(&dec->ring) < total)
+    {
+        return 0;
+    }
+
+    frame->len = len;
+    dec->frames++;
+    dec->bytes += len;
+
+    if (ring_buf_get_claim(&dec->ring, &data, total) == total)
+    {
+        // Contiguous: hand out the bytes in place, freed on release
+        frame->data = data + FRAME_HDR_SIZE;
+        frame->copied = false;
+        dec->held = total;
+        return 1;
+    }
+
+    // Wraps around the end of the ring: copy the payload out
+    ring_buf_get_finish(&dec->ring, 0);
+    ring_buf_get(&dec->ring, NULL, FRAME_HDR_SIZE);
+    ring_buf_get(&dec->ring, dec->scratch, len);
+    frame->data = dec->scratch;
+    frame->copied = true;
+    dec->held = 0;
+    dec->wrapped++;
+
+    return 1;
+}
+
+void frame_decoder_release(struct frame_decoder *dec)
+{
+    if (dec->held > 0)
+    {
+        ring_buf_get_finish(&dec->ring, dec->held);
+        dec->held = 0;
+    }
+
+    // Restart at offset 0 when empty, so the next frames do not wrap
+    if (ring_buf_is_empty(&dec->ring))
+    {
+        ring_buf_reset(&dec->ring);
+    }
+}
+
+void frame_encode(struct frame_tx *tx, const uint8_t *payload, uint16_t len)
+{
+    sys_put_be16(len, tx->hdr);
+
+    tx->iov[0].iov_base = tx->hdr;
+    tx->iov[0].iov_len = FRAME_HDR_SIZE;
+    tx->iov[1].iov_base = (void *)payload;
+    tx->iov[1].iov_len = len;
+}
+
+int frame_send(int fd, const uint8_t *payload, uint16_t len)
+{
+    struct frame_tx tx;
+    struct msghdr msg = { 0 };
+    size_t left = FRAME_HDR_SIZE + len;
+    size_t done;
+    int ret;
+
+    frame_encode(&tx, payload, len);
+    msg.msg_iov = tx.iov;
+    msg.msg_iovlen = 2;
+
+    while (1)
+    {
+        ret = sendmsg(fd, &msg, 0);
+        if (ret < 0)
+        {
+            return -errno;
+        }
+
+        left -= ret;
+        if (left == 0)
+        {
+            return 0;
+        }
+
+        // Short write: skip what was sent and retry with the rest
+        done = ret;
+        while (msg.msg_iovlen > 0 && done >= msg.msg_iov->iov_len)
+        {
+            done -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + done;
+        msg.msg_iov->iov_len -= done;
+    }
+}
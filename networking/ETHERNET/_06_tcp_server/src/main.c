@@ -1,7 +1,14 @@
 /**
- * Example 6: Generic TCP Server with Static IP (Simple Sequenced)
+ * Example 6: Generic TCP Server with Static IP
  *
- * Demonstrates a simple TCP server implementation - accepts one client at a time
+ * Demonstrates a TCP echo server implementation. The server mode is selected
+ * with SERVER_MODE in tcp_server_config.h:
+ * - SERVER_MODE_SEQUENTIAL: accepts one client at a time (steps below)
+ * - SERVER_MODE_POLL:       one thread, poll() loop, many clients at once
+ * - SERVER_MODE_WORKERS:    poll() dispatcher + pool of k_work_q worker threads
+ * - SERVER_MODE_ZERO_COPY:  sequential, recvmsg()/sendmsg() on net_buf fragments
+ * - SERVER_MODE_BENCHMARK:  sequential, iperf-style upload/download/ping-pong server
+ * - SERVER_MODE_FRAMED:     sequential, echo of length-prefixed frames
  *
  * TCP Server Lifecycle:
  * 1. Assign static IP address to network interface
@@ -31,13 +38,16 @@
 #include <string.h>
 #include <errno.h>
 
+#include "tcp_server_config.h"
+#include "conn_table.h"
+#include "tcp_server_poll.h"
+#include "tcp_server_workers.h"
+#include "echo_zero_copy.h"
+#include "echo_stats.h"
+#include "tcp_bench.h"
+#include "echo_framed.h"
 
 
-// ============================================================================
-// TCP SERVER CONFIGURATION - Customize these values for your setup
-// ============================================================================
-#define SERVER_PORT 5555                   // TCP server listening port
-#define BACKLOG 1                          // Maximum clients in queue
 
 // ============================================================================
 // BOARD IP CONFIGURATION - Customize these values for your network
@@ -46,12 +56,6 @@
 #define BOARD_IP_ADDR htonl((192UL << 24) | (168UL << 16) | (1UL << 8) | 100UL)
 #define BOARD_IP_MASK 24                   // Netmask: /24 (255.255.255.0)
 
-// ============================================================================
-// INTERNAL CONSTANTS - Do not modify
-// ============================================================================
-#define RECV_BUF_SIZE 1024
-#define LISTEN_QUEUE_SIZE 1
-
 // Event callback structure - used to listen for IP address changes
 static struct net_mgmt_event_callback mgmt_cb;
 
@@ -135,6 +139,8 @@ static void ip_event_handler(struct net_mgmt_event_callback *cb,
     }
 }
 
+#if SERVER_MODE == SERVER_MODE_SEQUENTIAL || SERVER_MODE == SERVER_MODE_ZERO_COPY || \
+    SERVER_MODE == SERVER_MODE_BENCHMARK || SERVER_MODE == SERVER_MODE_FRAMED
 /**
  * Echo handler - receives data from client and sends it back
  *
@@ -142,9 +148,6 @@ static void ip_event_handler(struct net_mgmt_event_callback *cb,
  */
 static void handle_client(int client_socket, struct sockaddr_in *client_addr)
 {
-    char recv_buffer[RECV_BUF_SIZE];
-    int received;
-    int sent;
     char client_ip[INET_ADDRSTRLEN];
 
     // Convert client IP to string for logging
@@ -152,11 +155,38 @@ static void handle_client(int client_socket, struct sockaddr_in *client_addr)
 
     printk("Client connected: %s:%d\n", client_ip, ntohs(client_addr->sin_port));
 
+#if SERVER_MODE == SERVER_MODE_ZERO_COPY
+    // Scatter/gather echo on net_buf fragments, no per-packet logging
+    echo_zero_copy_serve(client_socket);
+#elif SERVER_MODE == SERVER_MODE_BENCHMARK
+    // Test selected by the client's hello, one summary line per test
+    tcp_bench_serve(client_socket);
+#elif SERVER_MODE == SERVER_MODE_FRAMED
+    // One echoed frame per received frame, however the stream was segmented
+    echo_framed_serve(client_socket);
+#else
+    char recv_buffer[RECV_BUF_SIZE];
+    struct echo_stats stats = { .start_ms = k_uptime_get() };
+    struct conn_ctx *ctx;
+    int received;
+    int sent;
+    int ret;
+
+    // Register the client in the connection table ("conn list" in the shell)
+    ctx = conn_alloc(client_socket, client_addr);
+    if (!ctx)
+    {
+        printk("Connection table full, dropping client\n");
+        close(client_socket);
+        return;
+    }
+
     // Echo loop - receive data and send it back
     while (1)
     {
         // Receive data from client
         received = recv(client_socket, recv_buffer, RECV_BUF_SIZE - 1, 0);
+        stats.rx_calls++;
 
         if (received < 0)
         {
@@ -173,36 +203,78 @@ static void handle_client(int client_socket, struct sockaddr_in *client_addr)
 
         // Null-terminate the received data for logging
         recv_buffer[received] = '\0';
+        conn_account_rx(ctx, received);
 
         printk("Received (%d bytes): '%s'\n", received, recv_buffer);
 
-        // Send data back to client (echo)
-        sent = send(client_socket, recv_buffer, received, 0);
+        // Send data back to client (echo) - a short write is queued, not lost
+        sent = tx_queue_send(&ctx->tx, client_socket, recv_buffer, received);
+        stats.tx_calls++;
+        if (sent >= 0 && tx_queue_len(&ctx->tx) > 0)
+        {
+            // Slow reader: wait (bounded) until the rest of the echo is out
+            ret = tx_queue_drain(&ctx->tx, client_socket, SEND_TIMEOUT_MS);
+            sent = (ret < 0) ? ret : sent + ret;
+        }
         if (sent < 0)
         {
-            printk("Send failed: %d\n", -errno);
+            printk("Send failed: %d\n", sent);
             break;
         }
 
+        // recv() copy + printk formatting pass + send() copy
+        stats.copied += 2 * received + sent;
+        stats.bytes += sent;
+        conn_account_tx(ctx, sent);
+
         printk("Echoed (%d bytes) back to client\n", sent);
     }
 
-    // Close client connection
-    close(client_socket);
+    // Close client connection and release its context
+    conn_free(ctx);
     printk("Client socket closed\n");
+
+    echo_stats_print("sequential", &stats);
+#endif
 }
 
+/**
+ * Sequential accept loop - accept a client, serve it until it leaves, repeat
+ */
+static void run_sequential_server(int listen_socket)
+{
+    struct sockaddr_in client_addr;
+    socklen_t client_addr_len;
+    int client_socket;
+
+    // Accept and handle clients (infinite loop)
+    while (1)
+    {
+        // Accept incoming client connection
+        client_addr_len = sizeof(client_addr);
+        client_socket = accept(listen_socket, (struct sockaddr *)&client_addr, &client_addr_len);
+
+        if (client_socket < 0)
+        {
+            printk("Failed to accept connection: %d\n", -errno);
+            continue;
+        }
+
+        // Handle the connected client
+        handle_client(client_socket, &client_addr);
+    }
+}
+#endif /* SERVER_MODE_SEQUENTIAL || SERVER_MODE_ZERO_COPY || SERVER_MODE_BENCHMARK || SERVER_MODE_FRAMED */
+
 /**
  * Create and start TCP server
  *
- * This function sets up the server socket, binds to port, and accepts clients
+ * This function sets up the server socket, binds to port, and hands it to
+ * the server mode selected in tcp_server_config.h
  */
 static void start_tcp_server(void)
 {
     struct sockaddr_in server_addr;
-    struct sockaddr_in client_addr;
-    socklen_t client_addr_len;
-    int client_socket;
     int ret;
     int optval;
 
@@ -253,24 +325,16 @@ static void start_tcp_server(void)
     }
     printk("Server listening on 0.0.0.0:%d\n", SERVER_PORT);
 
-    // Accept and handle clients (infinite loop)
-    while (1)
-    {
-        // Accept incoming client connection
-        client_addr_len = sizeof(client_addr);
-        client_socket = accept(server_socket, (struct sockaddr *)&client_addr, &client_addr_len);
-
-        if (client_socket < 0)
-        {
-            printk("Failed to accept connection: %d\n", -errno);
-            continue;
-        }
-
-        // Handle the connected client
-        handle_client(client_socket, &client_addr);
-    }
+    // Hand the listening socket to the selected server mode
+#if SERVER_MODE == SERVER_MODE_POLL
+    tcp_server_poll_run(server_socket);
+#elif SERVER_MODE == SERVER_MODE_WORKERS
+    tcp_server_workers_run(server_socket);
+#else
+    run_sequential_server(server_socket);
+#endif
 
-    // Note: This code will never be reached (infinite loop above)
+    // Note: Only reached if the server loop fails
     close(server_socket);
 }
 
@@ -0,0 +1,50 @@
+/*
+ * iperf-style TCP benchmark - wire protocol and server API
+ *
+ * The same protocol is spoken by _05_tcp_client (benchmark mode) and by the
+ * Python tools in pc_client/ and _05_tcp_client/pc_server/.
+ */
+
+#ifndef TCP_BENCH_H
+#define TCP_BENCH_H
+
+#include <stdint.h>
+
+/* First word of every control message ("ZBEN") */
+#define BENCH_MAGIC 0x5A42454EUL
+
+/* Benchmark tests */
+#define BENCH_TEST_UPLOAD    1   /* Bulk stream client -> server */
+#define BENCH_TEST_DOWNLOAD  2   /* Bulk stream server -> client */
+#define BENCH_TEST_PINGPONG  3   /* Client sends a message, server echoes it, RTT measured */
+
+/**
+ * Sent by the client right after connect(), all fields in network byte order
+ */
+struct bench_hello
+{
+    uint32_t magic;         /* BENCH_MAGIC */
+    uint32_t test;          /* BENCH_TEST_* */
+    uint32_t msg_size;      /* Bytes per message / write */
+    uint32_t duration_ms;   /* Test duration */
+};
+
+/**
+ * Sent by the server at the end of an upload test, network byte order
+ */
+struct bench_result
+{
+    uint32_t magic;         /* BENCH_MAGIC */
+    uint32_t elapsed_ms;    /* Receive time measured by the server */
+    uint32_t bytes_hi;      /* Bytes received by the server (upper 32 bits) */
+    uint32_t bytes_lo;      /* Bytes received by the server (lower 32 bits) */
+};
+
+/**
+ *  @brief Run the benchmark requested by a connected client
+ *
+ *  @param client_socket Connected client socket, closed before returning
+ */
+void tcp_bench_serve(int client_socket);
+
+#endif /* TCP_BENCH_H */
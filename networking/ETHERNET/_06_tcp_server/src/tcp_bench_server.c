@@ -0,0 +1,219 @@
+/**
+ * iperf-style TCP benchmark server (benchmark mode)
+ *
+ * Each client starts with a bench_hello telling the server what to do:
+ * - Upload:    read and discard for duration_ms, then send a bench_result
+ *              with the bytes counted by the server
+ * - Download:  stream msg_size writes for duration_ms, then close
+ * - Ping-pong: echo every msg_size message until the client closes
+ *
+ * The client (_05_tcp_client in benchmark mode or pc_client/tcp_client.py
+ * --bench) measures RTT and prints the report. The server prints one
+ * summary line per test and nothing per message.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/arpa/inet.h>
+#include <zephyr/posix/unistd.h>
+#include <zephyr/posix/poll.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "tcp_server_config.h"
+#include "tcp_bench.h"
+
+/* Message buffer (one benchmark client at a time) */
+static uint8_t bench_buf[BENCH_MAX_MSG_SIZE];
+
+/**
+ * Send a whole buffer, retrying on short writes
+ */
+static int send_all(int fd, const uint8_t *data, size_t len)
+{
+    int ret;
+
+    while (len > 0)
+    {
+        ret = send(fd, data, len, 0);
+        if (ret < 0)
+        {
+            return -errno;
+        }
+
+        data += ret;
+        len -= ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Receive exactly len bytes (TCP may split or merge segments)
+ */
+static int recv_all(int fd, uint8_t *data, size_t len)
+{
+    int ret;
+
+    while (len > 0)
+    {
+        ret = recv(fd, data, len, 0);
+        if (ret < 0)
+        {
+            return -errno;
+        }
+
+        if (ret == 0)
+        {
+            return -ECONNRESET;
+        }
+
+        data += ret;
+        len -= ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Upload: count everything received before the deadline, report it back
+ */
+static void bench_upload(int fd, uint32_t duration_ms)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    struct bench_result result;
+    int64_t start = k_uptime_get();
+    int64_t deadline = start + duration_ms;
+    int64_t last = start;
+    int64_t now;
+    uint64_t bytes = 0;
+    int ret;
+
+    // poll() with a timeout so we stop on time even if the client goes quiet
+    while ((now = k_uptime_get()) < deadline)
+    {
+        ret = poll(&pfd, 1, (int)(deadline - now));
+        if (ret <= 0)
+        {
+            continue;
+        }
+
+        ret = recv(fd, bench_buf, sizeof(bench_buf), 0);
+        if (ret <= 0)
+        {
+            return;
+        }
+
+        bytes += ret;
+        last = k_uptime_get();
+    }
+
+    result.magic = htonl(BENCH_MAGIC);
+    result.elapsed_ms = htonl((uint32_t)(last - start));
+    result.bytes_hi = htonl((uint32_t)(bytes >> 32));
+    result.bytes_lo = htonl((uint32_t)bytes);
+    send_all(fd, (const uint8_t *)&result, sizeof(result));
+
+    printk("[bench] upload: %u bytes in %u ms\n", (uint32_t)bytes, (uint32_t)(last - start));
+
+    // Drain until the client closes, so a sender blocked in send() can finish
+    while (recv(fd, bench_buf, sizeof(bench_buf), 0) > 0)
+    {
+    }
+}
+
+/**
+ * Download: stream to the client until the deadline
+ */
+static void bench_download(int fd, uint32_t msg_size, uint32_t duration_ms)
+{
+    int64_t start = k_uptime_get();
+    int64_t deadline = start + duration_ms;
+    uint64_t bytes = 0;
+
+    memset(bench_buf, 0xA5, msg_size);
+
+    while (k_uptime_get() < deadline)
+    {
+        if (send_all(fd, bench_buf, msg_size) < 0)
+        {
+            break;
+        }
+
+        bytes += msg_size;
+    }
+
+    printk("[bench] download: %u bytes in %u ms\n",
+           (uint32_t)bytes, (uint32_t)(k_uptime_get() - start));
+}
+
+/**
+ * Ping-pong: echo one message at a time until the client closes
+ */
+static void bench_pingpong(int fd, uint32_t msg_size)
+{
+    uint32_t round_trips = 0;
+
+    while (recv_all(fd, bench_buf, msg_size) == 0)
+    {
+        if (send_all(fd, bench_buf, msg_size) < 0)
+        {
+            break;
+        }
+
+        round_trips++;
+    }
+
+    printk("[bench] ping-pong: %u round trips of %u bytes\n", round_trips, msg_size);
+}
+
+void tcp_bench_serve(int client_socket)
+{
+    struct bench_hello hello;
+    uint32_t test;
+    uint32_t msg_size;
+    uint32_t duration_ms;
+    int optval = 1;
+
+    // Ping-pong replies must leave immediately
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+    if (recv_all(client_socket, (uint8_t *)&hello, sizeof(hello)) < 0 ||
+        ntohl(hello.magic) != BENCH_MAGIC)
+    {
+        printk("[bench] missing or invalid hello, closing\n");
+        close(client_socket);
+        return;
+    }
+
+    test = ntohl(hello.test);
+    msg_size = ntohl(hello.msg_size);
+    duration_ms = ntohl(hello.duration_ms);
+
+    if (msg_size == 0 || msg_size > BENCH_MAX_MSG_SIZE)
+    {
+        printk("[bench] message size %u not supported (max %d)\n", msg_size, BENCH_MAX_MSG_SIZE);
+        close(client_socket);
+        return;
+    }
+
+    switch (test)
+    {
+    case BENCH_TEST_UPLOAD:
+        bench_upload(client_socket, duration_ms);
+        break;
+    case BENCH_TEST_DOWNLOAD:
+        bench_download(client_socket, msg_size, duration_ms);
+        break;
+    case BENCH_TEST_PINGPONG:
+        bench_pingpong(client_socket, msg_size);
+        break;
+    default:
+        printk("[bench] unknown test %u\n", test);
+        break;
+    }
+
+    close(client_socket);
+}
@@ -0,0 +1,76 @@
+/*
+ * TCP Server Application Configuration
+ * Hardcoded values - no Kconfig needed
+ */
+
+#ifndef TCP_SERVER_CONFIG_H
+#define TCP_SERVER_CONFIG_H
+
+/* Server modes (select one with SERVER_MODE below) */
+#define SERVER_MODE_SEQUENTIAL 0   /* One client at a time, blocking I/O */
+#define SERVER_MODE_POLL       1   /* One thread, poll() loop, many clients */
+#define SERVER_MODE_WORKERS    2   /* poll() dispatcher + pool of k_work_q threads */
+#define SERVER_MODE_ZERO_COPY  3   /* Sequential, recvmsg/sendmsg on net_buf fragments */
+#define SERVER_MODE_BENCHMARK  4   /* Sequential, iperf-style benchmark server */
+#define SERVER_MODE_FRAMED     5   /* Sequential, echo of length-prefixed frames */
+
+/* Active server mode */
+#define SERVER_MODE SERVER_MODE_POLL
+
+/* TCP server listening port */
+#define SERVER_PORT 5555
+
+/* Pending connections the stack keeps while the server is busy */
+#define LISTEN_QUEUE_SIZE 4
+
+/* Receive buffer size (sequential mode, <= CONN_TX_RING_SIZE) */
+#define RECV_BUF_SIZE 1024
+
+/* Sequential mode: drop a client that leaves its echo unread this long */
+#define SEND_TIMEOUT_MS 5000
+
+/* Connection table: contexts in the slab, i.e. maximum simultaneous clients.
+ * RAM used is MAX_CONNECTIONS * sizeof(struct conn_ctx), see "conn list" */
+#define MAX_CONNECTIONS 8
+
+/* Connection table: receive and transmit ring per connection */
+#define CONN_RX_RING_SIZE 1024
+#define CONN_TX_RING_SIZE 1024
+
+/* Transmit queue watermarks: a client whose unsent data reaches HIGH is no
+ * longer read from until the queue drains back to LOW */
+#define CONN_TX_HIGH_WM (CONN_TX_RING_SIZE * 3 / 4)
+#define CONN_TX_LOW_WM (CONN_TX_RING_SIZE / 4)
+
+/* Poll/worker modes: print one line per connect/disconnect (no per-packet logging) */
+#define POLL_LOG_CONNECTIONS 1
+
+/* Worker mode: number of worker threads, each one owning a k_work_q */
+#define WORKER_COUNT 2
+
+/* Worker mode: stack size and priority of each worker thread */
+#define WORKER_STACK_SIZE 2048
+#define WORKER_PRIORITY 5
+
+/* Worker mode: CRC32 passes over each received block to simulate a
+ * CPU-heavy request handler (0 = plain echo) */
+#define WORKER_CRC_ROUNDS 0
+
+/* Zero-copy mode: net_buf fragments received/sent per recvmsg()/sendmsg() */
+#define ZC_FRAGS_PER_CHAIN 4
+
+/* Zero-copy mode: size of each net_buf fragment */
+#define ZC_FRAG_SIZE 256
+
+/* Zero-copy mode: fragments in the pool (one chain per connection) */
+#define ZC_POOL_COUNT ZC_FRAGS_PER_CHAIN
+
+/* Benchmark mode: largest message a client may request */
+#define BENCH_MAX_MSG_SIZE 4096
+
+/* Framed mode: decoder ring, at least one maximum frame (FRAME_MAX_PAYLOAD
+ * in frame_codec.h plus its 2-byte header). Two frames let a complete
+ * frame arrive behind a partial one without waiting. */
+#define FRAME_RING_SIZE 2048
+
+#endif /* TCP_SERVER_CONFIG_H */
@@ -0,0 +1,353 @@
+/**
+ * Event-driven TCP echo server (poll mode)
+ *
+ * One thread serves up to MAX_CONNECTIONS clients at the same time:
+ * 1. Listening and client sockets are switched to non-blocking mode
+ * 2. poll() waits on all of them at once
+ * 3. Listener readable  -> accept every pending client
+ * 4. Client readable    -> recv() into that client's rx ring
+ * 5. Echo step          -> send() straight from the rx ring through the
+ *                          connection's transmit queue (tx_queue.c)
+ * 6. Client writable    -> send() whatever is still in the transmit queue
+ *
+ * Each connection is a context from the slab-backed connection table
+ * (conn_table.c) with its own rings, so a slow client never blocks the
+ * others. While the table is full the listener is left out of poll(), and
+ * new clients wait in the listen queue until a context frees up.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/arpa/inet.h>
+#include <zephyr/posix/unistd.h>
+#include <zephyr/posix/fcntl.h>
+#include <zephyr/posix/poll.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "tcp_server_config.h"
+#include "conn_table.h"
+#include "tcp_server_poll.h"
+
+/* Slot 0 is the listener, slot i + 1 belongs to conns[i] (NULL when free) */
+static struct pollfd fds[MAX_CONNECTIONS + 1];
+static struct conn_ctx *conns[MAX_CONNECTIONS];
+
+/**
+ * Switch a socket to non-blocking mode
+ */
+static int set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    if (flags < 0)
+    {
+        return -errno;
+    }
+
+    if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        return -errno;
+    }
+
+    return 0;
+}
+
+/**
+ * Release a connection slot, its context and its socket
+ */
+static void conn_close(int slot)
+{
+    struct conn_ctx *ctx = conns[slot];
+
+#if POLL_LOG_CONNECTIONS
+    char client_ip[INET_ADDRSTRLEN];
+
+    inet_ntop(AF_INET, &ctx->addr.sin_addr, client_ip, sizeof(client_ip));
+    printk("Client %s:%d disconnected (%u bytes in, %u bytes out, %u ms stalled, %u active)\n",
+           client_ip, ntohs(ctx->addr.sin_port), ctx->bytes_in, ctx->bytes_out,
+           tx_queue_stall_ms(&ctx->tx), conn_count() - 1);
+#endif
+
+    conn_free(ctx);
+    conns[slot] = NULL;
+}
+
+/**
+ * Accept every pending client until the listen queue is empty
+ * or the connection table is full
+ */
+static void accept_clients(int listen_socket)
+{
+    struct sockaddr_in client_addr;
+    socklen_t client_addr_len;
+    int client_socket;
+    int optval = 1;
+    int i;
+
+    while (conn_count() < MAX_CONNECTIONS)
+    {
+        client_addr_len = sizeof(client_addr);
+        client_socket = accept(listen_socket, (struct sockaddr *)&client_addr, &client_addr_len);
+
+        if (client_socket < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                printk("Failed to accept connection: %d\n", -errno);
+            }
+            return;
+        }
+
+        if (set_nonblocking(client_socket) < 0)
+        {
+            printk("Failed to set client non-blocking: %d\n", -errno);
+            close(client_socket);
+            continue;
+        }
+
+        // Echo replies are small writes - don't let Nagle hold them back
+        setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+        // Find a free slot (one always exists, checked by the loop condition)
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (conns[i] == NULL)
+            {
+                break;
+            }
+        }
+
+        conns[i] = conn_alloc(client_socket, &client_addr);
+        if (!conns[i])
+        {
+            close(client_socket);
+            return;
+        }
+
+#if POLL_LOG_CONNECTIONS
+        char client_ip[INET_ADDRSTRLEN];
+
+        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, sizeof(client_ip));
+        printk("Client %s:%d connected (%u active)\n",
+               client_ip, ntohs(client_addr.sin_port), conn_count());
+#endif
+    }
+}
+
+/**
+ * Send as much of the transmit queue as the socket accepts right now
+ *
+ * Returns 0 on success (even if data is still queued), negative on error
+ */
+static int conn_write(struct conn_ctx *ctx)
+{
+    int sent;
+
+    sent = tx_queue_flush(&ctx->tx, ctx->fd);
+    if (sent < 0)
+    {
+        return sent;
+    }
+
+    conn_account_tx(ctx, sent);
+
+    return 0;
+}
+
+/**
+ * Receive available data straight into the free room of the rx ring
+ *
+ * Returns 0 on success, negative on error or when the peer closed
+ */
+static int conn_read(struct conn_ctx *ctx)
+{
+    uint8_t *data;
+    uint32_t room;
+    int received;
+
+    room = ring_buf_put_claim(&ctx->rx, &data, ring_buf_capacity_get(&ctx->rx));
+    if (room == 0)
+    {
+        return 0;
+    }
+
+    received = recv(ctx->fd, data, room, 0);
+    if (received < 0)
+    {
+        ring_buf_put_finish(&ctx->rx, 0);
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return 0;
+        }
+        return -errno;
+    }
+
+    if (received == 0)
+    {
+        // Client closed connection
+        ring_buf_put_finish(&ctx->rx, 0);
+        return -ECONNRESET;
+    }
+
+    ring_buf_put_finish(&ctx->rx, received);
+    conn_account_rx(ctx, received);
+
+    return 0;
+}
+
+/**
+ * Echo "processing": send the rx ring back through the transmit queue
+ *
+ * The data is sent straight from the rx ring; only what the socket does
+ * not take right away is copied into the transmit queue. Stops while the
+ * queue is above its high watermark (slow reader).
+ *
+ * Returns 0 on success, negative on error
+ */
+static int conn_process(struct conn_ctx *ctx)
+{
+    uint8_t *data;
+    uint32_t len;
+    int sent;
+
+    while (!tx_queue_throttled(&ctx->tx))
+    {
+        // Never take more than the queue can hold, so nothing is dropped
+        len = ring_buf_get_claim(&ctx->rx, &data, tx_queue_space(&ctx->tx));
+        if (len == 0)
+        {
+            break;
+        }
+
+        sent = tx_queue_send(&ctx->tx, ctx->fd, data, len);
+        if (sent < 0)
+        {
+            ring_buf_get_finish(&ctx->rx, 0);
+            return sent;
+        }
+
+        ring_buf_get_finish(&ctx->rx, len);
+        conn_account_tx(ctx, sent);
+    }
+
+    return 0;
+}
+
+/**
+ * Rebuild the poll set from the connection table
+ *
+ * A connection waits for POLLOUT while its transmit queue holds data and
+ * for POLLIN while its rx ring has room and the queue is not throttled.
+ * A client that does not read its echo is simply no longer read from:
+ * TCP flow control then slows that client down, and nobody else.
+ */
+static void build_poll_set(void)
+{
+    struct conn_ctx *ctx;
+    int i;
+
+    // Stop accepting while full - clients wait in the listen queue
+    fds[0].events = (conn_count() < MAX_CONNECTIONS) ? POLLIN : 0;
+
+    for (i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        ctx = conns[i];
+
+        fds[i + 1].fd = ctx ? ctx->fd : -1;
+        fds[i + 1].events = 0;
+        fds[i + 1].revents = 0;
+
+        if (ctx)
+        {
+            if (ring_buf_space_get(&ctx->rx) > 0 && !tx_queue_throttled(&ctx->tx))
+            {
+                fds[i + 1].events |= POLLIN;
+            }
+            if (tx_queue_len(&ctx->tx) > 0)
+            {
+                fds[i + 1].events |= POLLOUT;
+            }
+        }
+    }
+}
+
+void tcp_server_poll_run(int listen_socket)
+{
+    struct conn_ctx *ctx;
+    short revents;
+    int ret;
+    int i;
+
+    printk("Poll mode: up to %d clients, %u bytes context each (%d rx + %d tx ring)\n",
+           MAX_CONNECTIONS, (uint32_t)sizeof(struct conn_ctx),
+           CONN_RX_RING_SIZE, CONN_TX_RING_SIZE);
+
+    if (set_nonblocking(listen_socket) < 0)
+    {
+        printk("Failed to set listener non-blocking: %d\n", -errno);
+        return;
+    }
+
+    fds[0].fd = listen_socket;
+
+    while (1)
+    {
+        build_poll_set();
+
+        ret = poll(fds, MAX_CONNECTIONS + 1, -1);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            printk("poll() failed: %d\n", -errno);
+            return;
+        }
+
+        // Service existing clients first, then accept new ones
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            ctx = conns[i];
+            revents = fds[i + 1].revents;
+
+            if (!ctx || revents == 0)
+            {
+                continue;
+            }
+
+            if (revents & POLLOUT)
+            {
+                ret = conn_write(ctx);
+            }
+            else if (revents & POLLIN)
+            {
+                ret = conn_read(ctx);
+            }
+            else
+            {
+                // Error or hang-up without data to read
+                ret = -ECONNRESET;
+            }
+
+            // Data that waited for room in the queue or just arrived
+            if (ret == 0)
+            {
+                ret = conn_process(ctx);
+            }
+
+            if (ret < 0)
+            {
+                conn_close(i);
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            accept_clients(listen_socket);
+        }
+    }
+}
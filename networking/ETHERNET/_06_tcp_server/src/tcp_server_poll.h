@@ -0,0 +1,17 @@
+/*
+ * Event-driven TCP echo server (poll mode)
+ */
+
+#ifndef TCP_SERVER_POLL_H
+#define TCP_SERVER_POLL_H
+
+/**
+ *  @brief Serve many clients from one thread using a poll() loop
+ *
+ *  @param listen_socket Bound and listening TCP socket
+ *
+ *  Never returns unless poll() itself fails.
+ */
+void tcp_server_poll_run(int listen_socket);
+
+#endif /* TCP_SERVER_POLL_H */
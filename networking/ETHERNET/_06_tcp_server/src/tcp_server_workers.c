@@ -0,0 +1,438 @@
+/**
+ * Worker-pool TCP echo server (worker mode)
+ *
+ * The main thread only waits for events, the real work runs on a fixed pool
+ * of WORKER_COUNT threads, each one owning its own k_work_q:
+ * 1. Every accepted client is pinned to the least loaded worker
+ * 2. The dispatcher poll()s the listener and all idle clients
+ * 3. Client readable -> its k_work item is submitted to its worker's queue
+ *    and the client leaves the poll set while the worker owns it
+ * 4. The worker receives into the connection's rx ring, processes (optional
+ *    CRC32 load) and echoes one block, then hands the client back through
+ *    an eventfd
+ * 5. Echoes go through the connection's non-blocking transmit queue: a slow
+ *    reader never blocks a worker, it is polled for POLLOUT instead and not
+ *    read from while its queue is above the high watermark
+ *
+ * Connection contexts (socket, rings, counters) come from the slab-backed
+ * connection table in conn_table.c, this file only adds the worker state.
+ *
+ * A slow request only occupies the worker that runs it: clients pinned to
+ * other workers keep being served, and on SMP targets workers run in parallel.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/sys/eventfd.h>
+#include <zephyr/posix/arpa/inet.h>
+#include <zephyr/posix/unistd.h>
+#include <zephyr/posix/fcntl.h>
+#include <zephyr/posix/poll.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "tcp_server_config.h"
+#include "conn_table.h"
+#include "tcp_server_workers.h"
+
+/* Connection states, owner in brackets */
+enum conn_state
+{
+    CONN_FREE,      /* Slot unused [dispatcher] */
+    CONN_IDLE,      /* Waiting for data in the poll set [dispatcher] */
+    CONN_BUSY,      /* Queued on or running in a worker [worker] */
+    CONN_CLOSING,   /* Worker saw EOF/error, dispatcher must close [dispatcher] */
+};
+
+/* One worker thread with its own work queue */
+struct worker
+{
+    struct k_work_q queue;
+    int connections;            /* Clients pinned to this worker */
+    uint32_t requests;          /* Blocks processed, for workers_report() */
+    uint32_t bytes;             /* Bytes echoed, for workers_report() */
+};
+
+/* Worker-side state of one connection slot */
+struct worker_conn
+{
+    struct k_work work;                 /* Submitted when the socket is readable */
+    struct worker *worker;              /* Worker this client is pinned to */
+    atomic_t state;                     /* enum conn_state */
+    struct conn_ctx *ctx;               /* Socket, rings and counters (NULL when free) */
+};
+
+K_THREAD_STACK_ARRAY_DEFINE(worker_stacks, WORKER_COUNT, WORKER_STACK_SIZE);
+
+static struct worker workers[WORKER_COUNT];
+static struct worker_conn conns[MAX_CONNECTIONS];
+
+/* Workers signal "connection handed back" on this eventfd */
+static int wake_fd = -1;
+
+/* Slot 0 is the listener, slot 1 the eventfd, slot i + 2 belongs to conns[i] */
+static struct pollfd fds[MAX_CONNECTIONS + 2];
+
+/**
+ * Simulated CPU-heavy request processing
+ */
+static void process_block(const uint8_t *data, size_t len)
+{
+#if WORKER_CRC_ROUNDS > 0
+    volatile uint32_t crc = 0;
+
+    for (int i = 0; i < WORKER_CRC_ROUNDS; i++)
+    {
+        crc = crc32_ieee_update(crc, data, len);
+    }
+#else
+    ARG_UNUSED(data);
+    ARG_UNUSED(len);
+#endif
+}
+
+/**
+ * Work handler - runs on the worker thread the connection is pinned to
+ *
+ * Serves one block and hands the connection back to the dispatcher.
+ * The block is received into the rx ring and echoed from there in place.
+ */
+static void conn_work_handler(struct k_work *work)
+{
+    struct worker_conn *conn = CONTAINER_OF(work, struct worker_conn, work);
+    struct conn_ctx *ctx = conn->ctx;
+    uint8_t *data;
+    uint32_t room;
+    int received;
+    int sent;
+    int ret = 0;
+
+    // First push out what a slow reader left in the transmit queue
+    sent = tx_queue_flush(&ctx->tx, ctx->fd);
+    if (sent < 0)
+    {
+        ret = sent;
+    }
+    else
+    {
+        conn_account_tx(ctx, sent);
+    }
+
+    // Read a new block only while the client keeps up with its echo
+    if (ret == 0 && !tx_queue_throttled(&ctx->tx))
+    {
+        // The ring is empty between blocks: claim its contiguous free room,
+        // but never more than the transmit queue could hold
+        room = ring_buf_put_claim(&ctx->rx, &data, tx_queue_space(&ctx->tx));
+
+        received = recv(ctx->fd, data, room, MSG_DONTWAIT);
+        ring_buf_put_finish(&ctx->rx, (received > 0) ? received : 0);
+
+        if (received > 0)
+        {
+            conn_account_rx(ctx, received);
+            process_block(data, received);
+
+            // Never blocks: what the socket does not take now is queued
+            sent = tx_queue_send(&ctx->tx, ctx->fd, data, received);
+            if (sent < 0)
+            {
+                ret = sent;
+            }
+            else
+            {
+                conn_account_tx(ctx, sent);
+                conn->worker->requests++;
+                conn->worker->bytes += received;
+            }
+
+            ring_buf_get_claim(&ctx->rx, &data, received);
+            ring_buf_get_finish(&ctx->rx, received);
+        }
+        else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            // Client closed connection or socket error
+            ret = -ECONNRESET;
+        }
+    }
+
+    atomic_set(&conn->state, (ret < 0) ? CONN_CLOSING : CONN_IDLE);
+
+    // Wake the dispatcher so it puts the socket back in the poll set
+    eventfd_write(wake_fd, 1);
+}
+
+/**
+ * Start the worker threads
+ */
+static void workers_start(void)
+{
+    struct k_work_queue_config cfg = { 0 };
+    static char names[WORKER_COUNT][sizeof("tcp_worker_00")];
+    int i;
+
+    for (i = 0; i < WORKER_COUNT; i++)
+    {
+        snprintk(names[i], sizeof(names[i]), "tcp_worker_%d", i);
+        cfg.name = names[i];
+
+        k_work_queue_init(&workers[i].queue);
+        k_work_queue_start(&workers[i].queue, worker_stacks[i],
+                           K_THREAD_STACK_SIZEOF(worker_stacks[i]),
+                           WORKER_PRIORITY, &cfg);
+    }
+}
+
+/**
+ * Blocks and bytes each worker served so far, shows how evenly the
+ * clients were spread over the pool
+ */
+static void workers_report(void)
+{
+    int i;
+
+    for (i = 0; i < WORKER_COUNT; i++)
+    {
+        printk("Worker %d: %u blocks, %u bytes echoed\n",
+               i, workers[i].requests, workers[i].bytes);
+    }
+}
+
+/**
+ * Pick the worker with the fewest pinned connections
+ */
+static struct worker *least_loaded_worker(void)
+{
+    struct worker *best = &workers[0];
+    int i;
+
+    for (i = 1; i < WORKER_COUNT; i++)
+    {
+        if (workers[i].connections < best->connections)
+        {
+            best = &workers[i];
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Close a connection handed back by its worker and free the slot
+ */
+static void conn_close(struct worker_conn *conn)
+{
+#if POLL_LOG_CONNECTIONS
+    char client_ip[INET_ADDRSTRLEN];
+
+    inet_ntop(AF_INET, &conn->ctx->addr.sin_addr, client_ip, sizeof(client_ip));
+    printk("Client %s:%d disconnected from worker %d (%u bytes echoed, %u ms stalled, %u active)\n",
+           client_ip, ntohs(conn->ctx->addr.sin_port), (int)(conn->worker - workers),
+           conn->ctx->bytes_out, tx_queue_stall_ms(&conn->ctx->tx), conn_count() - 1);
+#endif
+
+    conn_free(conn->ctx);
+    conn->ctx = NULL;
+    conn->worker->connections--;
+    atomic_set(&conn->state, CONN_FREE);
+
+    // Last client gone (end of a test run): show the load of every worker
+    if (conn_count() == 0)
+    {
+        workers_report();
+    }
+}
+
+/**
+ * Accept every pending client and pin it to a worker
+ */
+static void accept_clients(int listen_socket)
+{
+    struct sockaddr_in client_addr;
+    socklen_t client_addr_len;
+    struct worker_conn *conn;
+    int client_socket;
+    int optval = 1;
+    int i;
+
+    while (conn_count() < MAX_CONNECTIONS)
+    {
+        client_addr_len = sizeof(client_addr);
+        client_socket = accept(listen_socket, (struct sockaddr *)&client_addr, &client_addr_len);
+
+        if (client_socket < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                printk("Failed to accept connection: %d\n", -errno);
+            }
+            return;
+        }
+
+        // Echo replies are small writes - don't let Nagle hold them back
+        setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+        // Find a free slot (one always exists, checked by the loop condition)
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (atomic_get(&conns[i].state) == CONN_FREE)
+            {
+                break;
+            }
+        }
+
+        conn = &conns[i];
+        conn->ctx = conn_alloc(client_socket, &client_addr);
+        if (!conn->ctx)
+        {
+            close(client_socket);
+            return;
+        }
+
+        conn->worker = least_loaded_worker();
+        conn->worker->connections++;
+        atomic_set(&conn->state, CONN_IDLE);
+
+#if POLL_LOG_CONNECTIONS
+        char client_ip[INET_ADDRSTRLEN];
+
+        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, sizeof(client_ip));
+        printk("Client %s:%d connected to worker %d (%u active)\n",
+               client_ip, ntohs(client_addr.sin_port), (int)(conn->worker - workers),
+               conn_count());
+#endif
+    }
+}
+
+/**
+ * Close every connection its worker gave up on
+ */
+static void reap_connections(void)
+{
+    eventfd_t value;
+    int i;
+
+    // Clear the wake-up counter
+    eventfd_read(wake_fd, &value);
+
+    for (i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        if (atomic_get(&conns[i].state) == CONN_CLOSING)
+        {
+            conn_close(&conns[i]);
+        }
+    }
+}
+
+void tcp_server_workers_run(int listen_socket)
+{
+    struct worker_conn *conn;
+    struct conn_ctx *ctx;
+    int flags;
+    int ret;
+    int i;
+
+    printk("Worker mode: %d workers, up to %d clients, %u bytes context each\n",
+           WORKER_COUNT, MAX_CONNECTIONS, (uint32_t)sizeof(struct conn_ctx));
+
+    // Accept must not block, the dispatcher only calls it when poll() says so
+    flags = fcntl(listen_socket, F_GETFL, 0);
+    if (flags < 0 || fcntl(listen_socket, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        printk("Failed to set listener non-blocking: %d\n", -errno);
+        return;
+    }
+
+    wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (wake_fd < 0)
+    {
+        printk("Failed to create eventfd: %d\n", -errno);
+        return;
+    }
+
+    // Work items are initialized once: the handler of a closed connection
+    // may still be returning when its slot is reused
+    for (i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        conns[i].ctx = NULL;
+        k_work_init(&conns[i].work, conn_work_handler);
+        atomic_set(&conns[i].state, CONN_FREE);
+    }
+
+    workers_start();
+
+    fds[0].fd = listen_socket;
+    fds[1].fd = wake_fd;
+    fds[1].events = POLLIN;
+
+    while (1)
+    {
+        // Stop accepting while full - clients wait in the listen queue
+        fds[0].events = (conn_count() < MAX_CONNECTIONS) ? POLLIN : 0;
+
+        // Only idle connections are polled, busy ones belong to a worker
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            fds[i + 2].fd = -1;
+            fds[i + 2].events = 0;
+            fds[i + 2].revents = 0;
+
+            if (atomic_get(&conns[i].state) != CONN_IDLE)
+            {
+                continue;
+            }
+
+            ctx = conns[i].ctx;
+            fds[i + 2].fd = ctx->fd;
+
+            if (!tx_queue_throttled(&ctx->tx))
+            {
+                fds[i + 2].events |= POLLIN;
+            }
+            if (tx_queue_len(&ctx->tx) > 0)
+            {
+                fds[i + 2].events |= POLLOUT;
+            }
+        }
+
+        ret = poll(fds, MAX_CONNECTIONS + 2, -1);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            printk("poll() failed: %d\n", -errno);
+            return;
+        }
+
+        // Dispatch readable/writable clients to their workers
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            conn = &conns[i];
+
+            if (fds[i + 2].fd < 0 || fds[i + 2].revents == 0)
+            {
+                continue;
+            }
+
+            // EOF and errors are also detected by the worker's recv()
+            atomic_set(&conn->state, CONN_BUSY);
+            k_work_submit_to_queue(&conn->worker->queue, &conn->work);
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            reap_connections();
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            accept_clients(listen_socket);
+        }
+    }
+}
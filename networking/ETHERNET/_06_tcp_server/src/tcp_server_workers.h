@@ -0,0 +1,17 @@
+/*
+ * Worker-pool TCP echo server (worker mode)
+ */
+
+#ifndef TCP_SERVER_WORKERS_H
+#define TCP_SERVER_WORKERS_H
+
+/**
+ *  @brief Accept clients and dispatch their I/O onto a pool of work queues
+ *
+ *  @param listen_socket Bound and listening TCP socket
+ *
+ *  Never returns unless the dispatcher itself fails.
+ */
+void tcp_server_workers_run(int listen_socket);
+
+#endif /* TCP_SERVER_WORKERS_H */
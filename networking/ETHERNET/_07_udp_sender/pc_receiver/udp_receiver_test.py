@@ -10,6 +10,20 @@ This script:
 
 Usage:
     python udp_receiver_test.py
+    python udp_receiver_test.py --stats
+    python udp_receiver_test.py --telemetry
+
+Stats (--stats):
+    For the board's SENDER_MODE_STREAM. Prints one line per second with the
+    datagrams and bytes received instead of one line per datagram, which
+    could not keep up with thousands of packets per second.
+
+Telemetry (--telemetry):
+    Also for SENDER_MODE_STREAM. Decodes the 16-byte telemetry header
+    (src/telemetry.h) of every datagram and prints, once per second, loss,
+    duplicates, reordering (count and max depth) and the RFC 3550
+    interarrival jitter. Same analysis as _08_udp_receiver in
+    RECEIVER_MODE_TELEMETRY.
 
 Expected output:
     [INFO] Starting UDP server on 0.0.0.0:4242
@@ -19,16 +33,160 @@ Expected output:
          Data: Hello from Zephyr UDP! [packet #0]
 """
 
+import argparse
 import socket
+import struct
 import sys
+import time
 
 HOST = '0.0.0.0'  # Listen on all interfaces
 PORT = 4242
 
+# Telemetry header: magic "ZT", version, flags, sequence, send time (us)
+TELEM_HDR = struct.Struct('!HBBIQ')
+TELEM_MAGIC = 0x5A54
+TELEM_VERSION = 1
+
+
+def print_each(sock):
+    """One line per datagram (periodic mode)"""
+    while True:
+        data, addr = sock.recvfrom(2048)
+        print(f"[RX] From {addr[0]}:{addr[1]} - {len(data)} bytes")
+        print(f"     Data: {data.decode('utf-8', errors='replace')}")
+
+
+def print_stats(sock):
+    """One line per second with the receive rate (stream mode)"""
+    total = 0
+    count = 0
+    nbytes = 0
+    start = last = time.monotonic()
+    sock.settimeout(0.2)
+    while True:
+        try:
+            data, _ = sock.recvfrom(2048)
+            count += 1
+            nbytes += len(data)
+        except socket.timeout:
+            pass
+
+        now = time.monotonic()
+        if now - last >= 1.0:
+            total += count
+            print(f"[STATS] {count / (now - last):8.0f} pkt/s  "
+                  f"{nbytes / (now - last) / 1024:8.1f} KB/s  "
+                  f"total {total} in {now - start:.0f} s", flush=True)
+            count = 0
+            nbytes = 0
+            last = now
+
+
+class TelemetryStats:
+    """Loss, duplicates, reordering and jitter of one telemetry stream"""
+
+    def __init__(self):
+        self.first = None           # First sequence number
+        self.highest = None         # Highest sequence number
+        self.seen = set()           # Sequence numbers received
+        self.received = 0
+        self.duplicates = 0
+        self.reordered = 0
+        self.max_reorder = 0
+        self.invalid = 0
+        self.jitter = 0.0           # RFC 3550 interarrival jitter, us
+        self.max_d = 0.0
+        self.last_transit = None
+
+    def process(self, data, arrival_us):
+        if len(data) < TELEM_HDR.size:
+            self.invalid += 1
+            return
+        magic, version, _, seq, send_us = TELEM_HDR.unpack_from(data)
+        if magic != TELEM_MAGIC or version != TELEM_VERSION:
+            self.invalid += 1
+            return
+
+        self.received += 1
+
+        # RFC 3550 6.4.1: J += (|D| - J) / 16, D from two transit times
+        transit = arrival_us - send_us
+        if self.last_transit is not None:
+            d = abs(transit - self.last_transit)
+            self.max_d = max(self.max_d, d)
+            self.jitter += (d - self.jitter) / 16
+        self.last_transit = transit
+
+        if seq in self.seen:
+            self.duplicates += 1
+            return
+        self.seen.add(seq)
+
+        if self.first is None:
+            self.first = self.highest = seq
+        elif seq > self.highest:
+            self.highest = seq
+        else:
+            self.reordered += 1
+            self.max_reorder = max(self.max_reorder, self.highest - seq)
+            self.first = min(self.first, seq)
+
+    def report(self, title):
+        expected = self.highest - self.first + 1 if self.first is not None else 0
+        lost = max(expected - len(self.seen), 0)
+        loss = 100.0 * lost / expected if expected else 0.0
+        print(f"[{title}] {self.received} received, {expected} expected, "
+              f"loss {lost} ({loss:.2f}%), {self.duplicates} dup, "
+              f"{self.reordered} reordered (max depth {self.max_reorder}), "
+              f"jitter {self.jitter:.0f} us (max |D| {self.max_d:.0f} us), "
+              f"{self.invalid} invalid", flush=True)
+
+
+def print_telemetry(sock):
+    """Telemetry analysis once per second, final report when the stream stops"""
+    stats = TelemetryStats()
+    last_received = 0
+    last = time.monotonic()
+    sock.settimeout(0.2)
+    while True:
+        try:
+            data, _ = sock.recvfrom(2048)
+            stats.process(data, time.monotonic_ns() // 1000)
+        except socket.timeout:
+            pass
+
+        now = time.monotonic()
+        if now - last < 1.0:
+            continue
+        last = now
+
+        if stats.received == 0:
+            continue
+        if stats.received == last_received:
+            stats.report("FINAL")
+            stats = TelemetryStats()
+            last_received = 0
+            continue
+        stats.report("TELEM")
+        last_received = stats.received
+
+
+parser = argparse.ArgumentParser(description="UDP receiver for the Zephyr UDP sender")
+parser.add_argument('--port', type=int, default=PORT, help="UDP port to listen on")
+parser.add_argument('--stats', action='store_true',
+                    help="print the receive rate once per second (SENDER_MODE_STREAM)")
+parser.add_argument('--telemetry', action='store_true',
+                    help="analyze loss, reordering and jitter of the telemetry stream")
+args = parser.parse_args()
+
+PORT = args.port
+
 print(f"[INFO] Starting UDP server on {HOST}:{PORT}", flush=True)
 
 sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
 sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+# Room for bursts of the stream mode while Python is busy printing
+sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 * 1024 * 1024)
 
 try:
     sock.bind((HOST, PORT))
@@ -40,10 +198,12 @@ except Exception as e:
 print(f"[INFO] Listening... (Ctrl+C to stop)", flush=True)
 
 try:
-    while True:
-        data, addr = sock.recvfrom(1024)
-        print(f"[RX] From {addr[0]}:{addr[1]} - {len(data)} bytes")
-        print(f"     Data: {data.decode('utf-8', errors='replace')}")
+    if args.telemetry:
+        print_telemetry(sock)
+    elif args.stats:
+        print_stats(sock)
+    else:
+        print_each(sock)
 except KeyboardInterrupt:
     print("\n[INFO] Shutting down")
 finally:
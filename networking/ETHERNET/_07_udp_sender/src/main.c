@@ -16,6 +16,8 @@
  * - Lower overhead
  * - No guaranteed delivery (fire and forget)
  *
+ * Set SENDER_MODE to SENDER_MODE_STREAM to send at a configured packet
+ * rate instead, paced by a k_timer and a token bucket (see udp_stream.c).
  */
 
 
@@ -31,16 +33,35 @@
 #include <string.h>
 #include <errno.h>
 
+#include "udp_stream.h"
 
 
 // ============================================================================
 // UDP SERVER CONFIGURATION - Customize these values for your setup
 // ============================================================================
 #define SERVER_PORT 4242                   // UDP server port
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+#define SERVER_ADDR "127.0.0.1"            // native_sim uses the host stack
+#else
 #define SERVER_ADDR "192.168.1.1"          // PC host IP
+#endif
 #define SEND_DATA "Hello from Zephyr UDP!" // Message to send
 #define SEND_INTERVAL_MS 2000              // Send every 2 seconds
 
+// ============================================================================
+// SENDER MODE - Periodic (didactic) or paced stream
+// ============================================================================
+#define SENDER_MODE_PERIODIC 0             // 10 packets, SEND_INTERVAL_MS apart
+#define SENDER_MODE_STREAM 1               // Paced stream configured below
+#define SENDER_MODE SENDER_MODE_PERIODIC
+
+#define STREAM_RATE_PPS 5000               // Target datagrams per second
+#define STREAM_BURST_MAX 64                // Token bucket depth (datagrams per wakeup)
+#define STREAM_TICK_MS 1                   // Pacer k_timer period
+#define STREAM_PAYLOAD_SIZE 64             // Bytes per datagram, header included (16..1400)
+#define STREAM_DURATION_MS 10000           // Stream length (0 = forever)
+#define STREAM_REPORT_MS 1000              // Progress line interval
+
 // ============================================================================
 // BOARD IP CONFIGURATION - Customize these values for your network
 // ============================================================================
@@ -153,6 +174,19 @@ static void udp_send_packets(void)
     }
 	printk("UDP socket connected!\n");
 
+#if SENDER_MODE == SENDER_MODE_STREAM
+    struct udp_stream_params params = {
+        .rate_pps = STREAM_RATE_PPS,
+        .burst_max = STREAM_BURST_MAX,
+        .tick_ms = STREAM_TICK_MS,
+        .payload_size = STREAM_PAYLOAD_SIZE,
+        .duration_ms = STREAM_DURATION_MS,
+        .report_ms = STREAM_REPORT_MS,
+    };
+
+    // Paced stream, no per-packet logging
+    udp_stream_run(udp_socket, &params);
+#else
     // Send packets periodically
 	printk("Starting UDP send loop (every %dms)...\n", SEND_INTERVAL_MS);
 
@@ -175,6 +209,7 @@ static void udp_send_packets(void)
         // Wait before sending next packet
         k_msleep(SEND_INTERVAL_MS);
     }
+#endif
 
     // Close the socket
     close(udp_socket);
@@ -0,0 +1,105 @@
+/*
+ * Sequenced UDP telemetry - datagram header
+ *
+ * Every telemetry datagram starts with this 16-byte header, followed by
+ * the payload. The same layout is used by _07_udp_sender (stream mode),
+ * _08_udp_receiver (telemetry mode) and the Python tools (--telemetry).
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* First field of every header ("ZT") */
+#define TELEM_MAGIC 0x5A54
+#define TELEM_VERSION 1
+
+/* Flags: the datagram asks every receiver for a delivery report. Its seq
+ * is the number of datagrams published before it, it is not counted */
+#define TELEM_FLAG_REPORT 0x01
+
+/**
+ * Datagram header, all fields in network byte order
+ *
+ * send_us is the sender's own clock (microseconds since its boot). The
+ * receiver never compares it with its own clock directly, only the
+ * difference between two datagrams, so the clocks need no sync.
+ */
+struct telem_hdr
+{
+    uint16_t magic;         /* TELEM_MAGIC */
+    uint8_t version;        /* TELEM_VERSION */
+    uint8_t flags;          /* TELEM_FLAG_*, 0 for stream datagrams */
+    uint32_t seq;           /* Datagram number, +1 per datagram */
+    uint32_t send_us_hi;    /* Send time, upper 32 bits */
+    uint32_t send_us_lo;    /* Send time, lower 32 bits */
+};
+
+BUILD_ASSERT(sizeof(struct telem_hdr) == 16, "telem_hdr must be 16 bytes on the wire");
+
+/**
+ *  @brief Fill the constant fields once
+ */
+static inline void telem_hdr_init(struct telem_hdr *hdr)
+{
+    hdr->magic = htons(TELEM_MAGIC);
+    hdr->version = TELEM_VERSION;
+    hdr->flags = 0;
+    hdr->seq = 0;
+    hdr->send_us_hi = 0;
+    hdr->send_us_lo = 0;
+}
+
+/**
+ *  @brief Patch sequence number and send time just before sending
+ */
+static inline void telem_hdr_stamp(struct telem_hdr *hdr, uint32_t seq, uint64_t send_us)
+{
+    hdr->seq = htonl(seq);
+    hdr->send_us_hi = htonl((uint32_t)(send_us >> 32));
+    hdr->send_us_lo = htonl((uint32_t)send_us);
+}
+
+/**
+ *  @brief Check a received datagram and extract its header fields
+ *
+ *  @return true for a telemetry datagram of a known version
+ */
+static inline bool telem_hdr_parse(const void *data, size_t len, uint32_t *seq, uint64_t *send_us)
+{
+    struct telem_hdr hdr;
+
+    if (len < sizeof(hdr))
+    {
+        return false;
+    }
+
+    // Receive buffers need not be aligned for the 32-bit fields
+    memcpy(&hdr, data, sizeof(hdr));
+    if (ntohs(hdr.magic) != TELEM_MAGIC || hdr.version != TELEM_VERSION)
+    {
+        return false;
+    }
+
+    *seq = ntohl(hdr.seq);
+    *send_us = ((uint64_t)ntohl(hdr.send_us_hi) << 32) | ntohl(hdr.send_us_lo);
+
+    return true;
+}
+
+/**
+ *  @brief Flags of a datagram telem_hdr_parse() accepted
+ */
+static inline uint8_t telem_hdr_flags(const void *data)
+{
+    return ((const uint8_t *)data)[offsetof(struct telem_hdr, flags)];
+}
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,192 @@
+/**
+ * High-rate paced UDP stream (stream mode)
+ *
+ * The periodic loop formats every datagram with snprintf(), measures it
+ * with strlen() and sleeps between sends, which caps it at a few packets
+ * per second. The stream mode sends at a configured rate instead:
+ * - The datagram is built once: a telemetry header (telemetry.h) and the
+ *   payload. Only the sequence number and the send timestamp change, and
+ *   they are patched in place, so there is no formatting and no length
+ *   computation per packet
+ * - A periodic k_timer wakes the sender every tick_ms
+ * - A token bucket converts elapsed time into datagrams: rate_pps tokens
+ *   per second, at most burst_max kept. Every wakeup sends as many
+ *   datagrams as there are whole tokens, so a late wakeup catches up and
+ *   the average rate does not depend on the tick granularity
+ * - Tokens are computed from the cycle counter (no drift from rounding)
+ *   and a send() that finds the socket full ends the burst, the tokens are
+ *   kept for the next wakeup
+ *
+ * Nothing is logged per packet. A progress line is printed every
+ * report_ms and the achieved rate is compared with the target at the end.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "udp_stream.h"
+#include "telemetry.h"
+
+/* Tokens are counted in millionths of a datagram */
+#define TOKEN_SCALE 1000000ULL
+
+BUILD_ASSERT(UDP_STREAM_MIN_SIZE == sizeof(struct telem_hdr),
+             "UDP_STREAM_MIN_SIZE must match the telemetry header");
+
+/* The datagram, built once and patched in place */
+static uint8_t packet[UDP_STREAM_MAX_SIZE] __aligned(4);
+static struct telem_hdr *const packet_hdr = (struct telem_hdr *)packet;
+
+/* Wakes the sender every tick */
+static struct k_timer stream_timer;
+
+/* Counters of one run */
+struct stream_stats
+{
+    uint32_t sent;              /* Datagrams sent */
+    uint32_t wakeups;           /* Timer wakeups */
+    uint32_t max_burst;         /* Most datagrams sent in one wakeup */
+    uint32_t stalls;            /* Bursts cut short by a full socket */
+    uint32_t late_ticks;        /* Timer expiries missed by the sender */
+    uint32_t capped;            /* Wakeups where the bucket overflowed */
+};
+
+/**
+ * Build the datagram: telemetry header, then a recognizable payload
+ */
+static void packet_init(uint32_t size)
+{
+    uint32_t i;
+
+    telem_hdr_init(packet_hdr);
+
+    for (i = sizeof(struct telem_hdr); i < size; i++)
+    {
+        packet[i] = 'a' + (i % 26);
+    }
+}
+
+/**
+ * Print rate as an integer and a percentage of the target
+ */
+static void print_rate(const char *label, uint32_t sent, uint32_t elapsed_ms,
+                       const struct udp_stream_params *params)
+{
+    uint32_t rate;
+
+    elapsed_ms = MAX(elapsed_ms, 1);
+    rate = (uint32_t)((uint64_t)sent * 1000 / elapsed_ms);
+
+    printk("%s: %u datagrams in %u ms = %u pkt/s (target %u, %u%%), %u KB/s\n",
+           label, sent, elapsed_ms, rate, params->rate_pps,
+           (uint32_t)((uint64_t)rate * 100 / MAX(params->rate_pps, 1)),
+           (uint32_t)((uint64_t)rate * params->payload_size / 1024));
+}
+
+int udp_stream_run(int fd, const struct udp_stream_params *params)
+{
+    struct stream_stats stats = { 0 };
+    uint64_t bucket_max = params->burst_max * TOKEN_SCALE;
+    uint64_t tokens = 0;
+    uint64_t last_cyc;
+    uint64_t now_cyc;
+    int64_t start_ms;
+    int64_t report_ms;
+    uint32_t report_sent = 0;
+    uint32_t expiries;
+    uint32_t burst;
+    uint32_t n;
+    int ret = 0;
+
+    if (params->payload_size < UDP_STREAM_MIN_SIZE || params->payload_size > UDP_STREAM_MAX_SIZE ||
+        params->rate_pps == 0 || params->burst_max == 0 || params->tick_ms == 0)
+    {
+        printk("Invalid stream parameters\n");
+        return -EINVAL;
+    }
+
+    packet_init(params->payload_size);
+
+    printk("Stream: %u pkt/s target, %u-byte datagrams, %u ms tick, burst <= %u\n",
+           params->rate_pps, params->payload_size, params->tick_ms, params->burst_max);
+
+    k_timer_init(&stream_timer, NULL, NULL);
+    k_timer_start(&stream_timer, K_MSEC(params->tick_ms), K_MSEC(params->tick_ms));
+
+    start_ms = k_uptime_get();
+    report_ms = start_ms;
+    last_cyc = k_cycle_get_64();
+
+    while (params->duration_ms == 0 || k_uptime_get() - start_ms < params->duration_ms)
+    {
+        // Sleep until the next tick, more than one expiry means we were late
+        expiries = k_timer_status_sync(&stream_timer);
+        stats.wakeups++;
+        stats.late_ticks += (expiries > 1) ? expiries - 1 : 0;
+
+        // Refill: elapsed microseconds times the rate, capped at the bucket depth
+        now_cyc = k_cycle_get_64();
+        tokens += k_cyc_to_us_floor64(now_cyc - last_cyc) * params->rate_pps;
+        last_cyc = now_cyc;
+        if (tokens > bucket_max)
+        {
+            tokens = bucket_max;
+            stats.capped++;
+        }
+
+        // Spend every whole token
+        burst = (uint32_t)(tokens / TOKEN_SCALE);
+        for (n = 0; n < burst; n++)
+        {
+            telem_hdr_stamp(packet_hdr, stats.sent + n, k_cyc_to_us_floor64(k_cycle_get_64()));
+
+            ret = send(fd, packet, params->payload_size, MSG_DONTWAIT);
+            if (ret < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS &&
+                    errno != ENOMEM)
+                {
+                    ret = -errno;
+                    goto out;
+                }
+
+                // Socket or net_buf pool full: keep the tokens for the next tick
+                stats.stalls++;
+                break;
+            }
+        }
+
+        ret = 0;
+        tokens -= n * TOKEN_SCALE;
+        stats.sent += n;
+        stats.max_burst = MAX(stats.max_burst, n);
+
+        if (params->report_ms > 0 && k_uptime_get() - report_ms >= params->report_ms)
+        {
+            print_rate("Stream", stats.sent - report_sent,
+                       (uint32_t)(k_uptime_get() - report_ms), params);
+            report_ms = k_uptime_get();
+            report_sent = stats.sent;
+        }
+    }
+
+out:
+    k_timer_stop(&stream_timer);
+
+    if (ret < 0)
+    {
+        printk("Send failed: %d\n", ret);
+    }
+
+    print_rate("Stream total", stats.sent, (uint32_t)(k_uptime_get() - start_ms), params);
+    printk("  %u wakeups, avg %u / max %u datagrams per wakeup\n",
+           stats.wakeups, stats.wakeups ? stats.sent / stats.wakeups : 0, stats.max_burst);
+    printk("  %u send stalls (socket full), %u late ticks, %u bucket overflows\n",
+           stats.stalls, stats.late_ticks, stats.capped);
+
+    return ret;
+}
@@ -0,0 +1,36 @@
+/*
+ * High-rate paced UDP stream (stream mode)
+ */
+
+#ifndef UDP_STREAM_H
+#define UDP_STREAM_H
+
+#include <stdint.h>
+
+/* Stream parameters */
+struct udp_stream_params
+{
+    uint32_t rate_pps;          /* Target datagrams per second */
+    uint32_t burst_max;         /* Token bucket depth: most datagrams per wakeup */
+    uint32_t tick_ms;           /* k_timer period that wakes the sender */
+    uint32_t payload_size;      /* Bytes per datagram (>= UDP_STREAM_MIN_SIZE) */
+    uint32_t duration_ms;       /* Stream length, 0 = forever */
+    uint32_t report_ms;         /* Progress line interval, 0 = final report only */
+};
+
+/* Smallest datagram: the telemetry header alone (see telemetry.h) */
+#define UDP_STREAM_MIN_SIZE 16
+
+/* Largest datagram the sender builds */
+#define UDP_STREAM_MAX_SIZE 1400
+
+/**
+ *  @brief Stream datagrams on a connected UDP socket at a paced rate
+ *
+ *  @param fd Connected UDP socket
+ *
+ *  @return 0 when the duration ended, negative errno on error
+ */
+int udp_stream_run(int fd, const struct udp_stream_params *params);
+
+#endif /* UDP_STREAM_H */
@@ -6,9 +6,28 @@ Sends UDP packets to STM32 board UDP receiver.
 
 Usage:
     python udp_sender_test.py
+    python udp_sender_test.py --telemetry --rate 2000 --count 20000
+    python udp_sender_test.py --telemetry --loss 1 --dup 0.5 --reorder 0.5
+    python udp_sender_test.py --telemetry --group 239.1.2.3 --rate 200 --count 1000
+
+Telemetry (--telemetry):
+    For the board's RECEIVER_MODE_TELEMETRY. Sends a paced stream of
+    datagrams with the 16-byte telemetry header (sequence number and send
+    time, see src/telemetry.h). --loss, --dup and --reorder drop, repeat or
+    delay a percentage of the datagrams on purpose, so the board's report
+    can be checked against known impairments.
+
+Fan-out (--telemetry --group ADDR):
+    For the board's RECEIVER_MODE_MULTICAST. Publishes the stream once to a
+    multicast group (or a broadcast address), then asks every board for a
+    delivery report and prints, per board, how many of the published
+    datagrams arrived. ADDR replaces --ip.
 """
 
+import argparse
+import random
 import socket
+import struct
 import time
 import sys
 
@@ -19,6 +38,17 @@ MESSAGE = "Hello from Python UDP!"
 NUM_PACKETS = 5
 INTERVAL_SECONDS = 2
 
+# Telemetry header: magic "ZT", version, flags, sequence, send time (us)
+TELEM_HDR = struct.Struct('!HBBIQ')
+TELEM_MAGIC = 0x5A54
+TELEM_VERSION = 1
+TELEM_FLAG_REPORT = 0x01
+
+# Delivery report of a board in multicast mode: magic "ZR", version, reserved,
+# published, delivered, duplicates, reordered
+MCAST_REPORT = struct.Struct('!HBBIIII')
+MCAST_REPORT_MAGIC = 0x5A52
+
 def send_udp_packets():
     """Send UDP packets to the receiver"""
     
@@ -59,5 +89,145 @@ def send_udp_packets():
         sock.close()
         sys.exit(0)
 
+def send_telemetry(args, sock=None):
+    """Paced telemetry stream with optional loss, duplication and reordering"""
+    padding = bytes(ord('a') + i % 26 for i in range(args.size - TELEM_HDR.size))
+    period = 1.0 / args.rate
+    held = []           # (release sequence, datagram) delayed for reordering
+    dropped = duplicated = delayed = 0
+
+    print(f"[INFO] Telemetry stream to {RECEIVER_IP}:{RECEIVER_PORT}: "
+          f"{args.count} x {args.size} bytes at {args.rate} pkt/s")
+    print(f"[INFO] Impairments: loss {args.loss}%, dup {args.dup}%, "
+          f"reorder {args.reorder}% (depth <= {args.depth})", flush=True)
+
+    own_sock = sock is None
+    if own_sock:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    start = time.monotonic()
+    for seq in range(args.count):
+        # Pace against the start time, so late sends catch up
+        delay = start + seq * period - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+
+        data = TELEM_HDR.pack(TELEM_MAGIC, TELEM_VERSION, 0, seq,
+                              time.monotonic_ns() // 1000) + padding
+
+        if random.uniform(0, 100) < args.loss:
+            dropped += 1
+        elif random.uniform(0, 100) < args.reorder:
+            held.append((seq + random.randint(1, args.depth), data))
+            delayed += 1
+        else:
+            sock.sendto(data, (RECEIVER_IP, RECEIVER_PORT))
+            if random.uniform(0, 100) < args.dup:
+                sock.sendto(data, (RECEIVER_IP, RECEIVER_PORT))
+                duplicated += 1
+
+        for item in [h for h in held if h[0] <= seq]:
+            sock.sendto(item[1], (RECEIVER_IP, RECEIVER_PORT))
+            held.remove(item)
+
+    for _, data in held:
+        sock.sendto(data, (RECEIVER_IP, RECEIVER_PORT))
+
+    elapsed = time.monotonic() - start
+    print("-" * 60)
+    print(f"[OK] Sent {args.count} in {elapsed:.1f} s ({args.count / elapsed:.0f} pkt/s): "
+          f"{dropped} dropped, {duplicated} duplicated, {delayed} reordered", flush=True)
+    if own_sock:
+        sock.close()
+
+
+def publish_group(args):
+    """Telemetry stream to a multicast/broadcast group, then collect delivery reports"""
+    family = socket.AF_INET6 if ':' in RECEIVER_IP else socket.AF_INET
+    sock = socket.socket(family, socket.SOCK_DGRAM)
+    if family == socket.AF_INET:
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, args.ttl)
+        if args.iface:
+            sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton(args.iface))
+    else:
+        sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_MULTICAST_HOPS, args.ttl)
+        if args.iface:
+            sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_MULTICAST_IF,
+                            socket.if_nametoindex(args.iface))
+
+    send_telemetry(args, sock)
+
+    # Report request: seq = datagrams published, each board replies once per request
+    request = TELEM_HDR.pack(TELEM_MAGIC, TELEM_VERSION, TELEM_FLAG_REPORT, args.count,
+                             time.monotonic_ns() // 1000)
+    reports = {}
+    sock.settimeout(0.1)
+    deadline = time.monotonic() + args.wait
+    next_request = 0.0
+    requests = 0
+    while time.monotonic() < deadline:
+        # Repeat the request a few times, in case one is lost
+        if requests < 3 and time.monotonic() >= next_request:
+            sock.sendto(request, (RECEIVER_IP, RECEIVER_PORT))
+            requests += 1
+            next_request = time.monotonic() + 0.3
+        try:
+            data, addr = sock.recvfrom(256)
+        except socket.timeout:
+            continue
+        if len(data) < MCAST_REPORT.size:
+            continue
+        magic, version, _, published, delivered, dup, reordered = MCAST_REPORT.unpack_from(data)
+        if magic == MCAST_REPORT_MAGIC and version == TELEM_VERSION and published == args.count:
+            reports[addr[0]] = (delivered, dup, reordered)
+    sock.close()
+
+    print("-" * 60)
+    print(f"[FANOUT] {len(reports)} node(s) replied for {RECEIVER_IP} "
+          f"({args.count} datagrams published once)")
+    total = 0
+    for node, (delivered, dup, reordered) in sorted(reports.items()):
+        total += delivered
+        print(f"  {node:<40} {delivered:>8}/{args.count} delivered "
+              f"({100.0 * delivered / max(args.count, 1):6.2f}%), {dup} dup, {reordered} reordered")
+    if reports:
+        print(f"[FANOUT] {total} deliveries from {args.count} sends "
+              f"(unicast would need {args.count * len(reports)} sends), "
+              f"average delivery {100.0 * total / (args.count * len(reports)):.2f}%", flush=True)
+
+
 if __name__ == "__main__":
-    send_udp_packets()
+    parser = argparse.ArgumentParser(description="UDP sender for the Zephyr UDP receiver")
+    parser.add_argument('--ip', default=RECEIVER_IP, help="receiver IP address")
+    parser.add_argument('--port', type=int, default=RECEIVER_PORT, help="receiver UDP port")
+    parser.add_argument('--telemetry', action='store_true',
+                        help="send a sequenced telemetry stream (RECEIVER_MODE_TELEMETRY)")
+    parser.add_argument('--rate', type=int, default=1000, help="telemetry datagrams per second")
+    parser.add_argument('--count', type=int, default=10000, help="telemetry datagrams to send")
+    parser.add_argument('--size', type=int, default=64,
+                        help="telemetry datagram size in bytes (16..256)")
+    parser.add_argument('--loss', type=float, default=0.0, help="percent of datagrams dropped")
+    parser.add_argument('--dup', type=float, default=0.0, help="percent of datagrams sent twice")
+    parser.add_argument('--reorder', type=float, default=0.0,
+                        help="percent of datagrams delayed behind later ones")
+    parser.add_argument('--depth', type=int, default=5,
+                        help="a delayed datagram is sent up to this many datagrams late")
+    parser.add_argument('--group', help="publish to this multicast or broadcast address "
+                        "and collect delivery reports (RECEIVER_MODE_MULTICAST)")
+    parser.add_argument('--ttl', type=int, default=1, help="multicast TTL / hop limit")
+    parser.add_argument('--iface', help="local IPv4 address (IPv6: interface name) to publish on")
+    parser.add_argument('--wait', type=float, default=2.0,
+                        help="seconds to collect delivery reports")
+    args = parser.parse_args()
+
+    RECEIVER_IP = args.group or args.ip
+    RECEIVER_PORT = args.port
+
+    if args.telemetry:
+        args.size = min(max(args.size, TELEM_HDR.size), 256)
+        if args.group:
+            publish_group(args)
+        else:
+            send_telemetry(args)
+    else:
+        send_udp_packets()
@@ -2,6 +2,22 @@
  * Example 8: UDP Receiver - Based on Nordic Pattern
  *
  * Simple UDP receiver that binds to a port and receives datagrams
+ *
+ * Set RECEIVER_MODE to RECEIVER_MODE_TELEMETRY to analyze a sequenced
+ * telemetry stream instead (loss, duplicates, reordering and jitter, see
+ * telemetry_rx.c), e.g. from Example 7 in stream mode.
+ *
+ * RECEIVER_MODE_SHARDED runs the same analysis behind several receive
+ * threads and a preallocated buffer pool (udp_shards.c), and reports
+ * packets/s and drops for comparison with the single-thread loop.
+ *
+ * RECEIVER_MODE_BATCH drains up to UDP_BATCH_MAX datagrams per wakeup
+ * (recvmmsg-style, udp_batch.c) and benchmarks calls and CPU per packet
+ * against the batch size.
+ *
+ * RECEIVER_MODE_MULTICAST joins multicast groups, accepts only datagrams
+ * for joined groups (and broadcast) and reports delivery to the publisher
+ * (udp_mcast.c).
  */
 
 #include <zephyr/kernel.h>
@@ -11,11 +27,16 @@
 #include <zephyr/net/socket.h>
 #include <zephyr/posix/arpa/inet.h>
 #include <zephyr/posix/unistd.h>
+#include <zephyr/posix/poll.h>
 
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
 
+#include "telemetry_rx.h"
+#include "udp_shards.h"
+#include "udp_batch.h"
+#include "udp_mcast.h"
 
 
 // ============================================================================
@@ -26,12 +47,29 @@
 #define BOARD_IP_MASK 24
 #define BUFFER_SIZE 256
 
+// ============================================================================
+// RECEIVER MODE - Print every datagram (didactic) or analyze telemetry
+// ============================================================================
+#define RECEIVER_MODE_PRINT 0              // printk() every datagram
+#define RECEIVER_MODE_TELEMETRY 1          // Loss/reorder/jitter report, no per-packet logging
+#define RECEIVER_MODE_SHARDED 2            // Telemetry on SHARD_COUNT threads + buffer pool (udp_shards.h)
+#define RECEIVER_MODE_BATCH 3              // Batch receive benchmark, 1..UDP_BATCH_MAX per wakeup (udp_batch.h)
+#define RECEIVER_MODE_MULTICAST 4          // Group join/leave, per-group filtering and reports (udp_mcast.h)
+#define RECEIVER_MODE RECEIVER_MODE_PRINT
+
+#define TELEM_REPORT_MS 1000               // Report interval while datagrams arrive
+
 // Event callback structure
 static struct net_mgmt_event_callback mgmt_cb;
 
-// Socket descriptor
+#if RECEIVER_MODE != RECEIVER_MODE_SHARDED && RECEIVER_MODE != RECEIVER_MODE_MULTICAST
+// Socket descriptor (the sharded and multicast modes open their own sockets)
 static int sock = -1;
+#endif
+
+#if RECEIVER_MODE == RECEIVER_MODE_PRINT || RECEIVER_MODE == RECEIVER_MODE_TELEMETRY
 static uint8_t recv_buf[BUFFER_SIZE];
+#endif
 
 /**
  * Assign static IP address to interface
@@ -75,46 +113,94 @@ static void ip_event_handler(struct net_mgmt_event_callback *cb,
 	printk("IPv4 address event received\n");
 }
 
+#if RECEIVER_MODE == RECEIVER_MODE_TELEMETRY
+// Counters of the current stream (~200 bytes with the duplicate bitmap)
+static struct telem_rx telem;
+
 /**
- * UDP Receive
+ * Telemetry receive loop
  *
- * Binds to a port and listens for incoming UDP packets
+ * Every datagram is timestamped on arrival and accounted, nothing is
+ * printed per packet. A report is printed every TELEM_REPORT_MS while the
+ * stream runs. A report interval without datagrams ends the stream: the
+ * final report is printed and the counters start over for the next one.
  */
-static void udp_receive(void)
+static void telemetry_receive(int fd)
 {
-    struct sockaddr_in addr;
-    struct sockaddr_in client_addr;
-    socklen_t client_addr_len = sizeof(client_addr);
-    char client_ip[NET_IPV4_ADDR_LEN];
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int64_t next_report = k_uptime_get() + TELEM_REPORT_MS;
+    uint32_t last_received = 0;
+    int64_t now;
     int received;
+    int ret;
 
-	printk("Creating UDP socket...\n");
+    telem_rx_reset(&telem);
 
-    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (sock < 0)
+    while (1)
     {
-		printk("Failed to create socket: errno %d, %s\n", errno, strerror(errno));
-        return;
-    }
-	printk("Socket created successfully\n");
+        now = k_uptime_get();
+        ret = poll(&pfd, 1, (int)MAX(next_report - now, 0));
+        if (ret < 0)
+        {
+            printk("Poll error: %d\n", errno);
+            break;
+        }
 
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(LOCAL_PORT);
-    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (ret > 0)
+        {
+            received = recv(fd, recv_buf, sizeof(recv_buf), 0);
+            if (received < 0)
+            {
+                printk("Socket error: %d\n", errno);
+                break;
+            }
+
+            telem_rx_process(&telem, recv_buf, received,
+                             (int64_t)k_cyc_to_us_floor64(k_cycle_get_64()));
+        }
 
-    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
-    {
-		printk("Failed to bind socket: errno %d, %s\n", errno, strerror(errno));
-        close(sock);
-        return;
+        if (k_uptime_get() < next_report)
+        {
+            continue;
+        }
+        next_report += TELEM_REPORT_MS;
+
+        if (telem.received == 0)
+        {
+            continue;
+        }
+
+        if (telem.received == last_received)
+        {
+            // Stream stopped: final report, then wait for the next stream
+            telem_rx_print(&telem, "Telemetry (final)");
+            telem_rx_reset(&telem);
+            last_received = 0;
+            continue;
+        }
+
+        printk("Single thread: %u pkt/s\n",
+               (telem.received - last_received) * 1000 / TELEM_REPORT_MS);
+        telem_rx_print(&telem, "Telemetry");
+        last_received = telem.received;
     }
-	printk("Socket bound to 0.0.0.0:%d\n", LOCAL_PORT);
-	printk("Listening for UDP packets...\n");
+}
+#endif
+
+#if RECEIVER_MODE == RECEIVER_MODE_PRINT
+/**
+ * Print loop - one printk() per datagram with the sender address
+ */
+static void print_receive(int fd)
+{
+    struct sockaddr_in client_addr;
+    socklen_t client_addr_len = sizeof(client_addr);
+    char client_ip[NET_IPV4_ADDR_LEN];
+    int received;
 
     while (1)
     {
-        received = recvfrom(sock, recv_buf, sizeof(recv_buf) - 1, 0,
+        received = recvfrom(fd, recv_buf, sizeof(recv_buf) - 1, 0,
                             (struct sockaddr *)&client_addr, &client_addr_len);
 
         if (received < 0)
@@ -138,8 +224,59 @@ static void udp_receive(void)
     			received, client_ip, ntohs(client_addr.sin_port));
     		printk("  Data: %s\n", (char *)recv_buf);
     }
+}
+#endif
+
+/**
+ * UDP Receive
+ *
+ * Binds to a port and listens for incoming UDP packets
+ */
+static void udp_receive(void)
+{
+#if RECEIVER_MODE == RECEIVER_MODE_SHARDED
+    // Opens its own sockets, one shared or one per shard
+    udp_shards_run(LOCAL_PORT);
+#elif RECEIVER_MODE == RECEIVER_MODE_MULTICAST
+    // Opens its own sockets, one per address family
+    udp_mcast_run(LOCAL_PORT);
+#else
+    struct sockaddr_in addr;
+
+	printk("Creating UDP socket...\n");
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0)
+    {
+		printk("Failed to create socket: errno %d, %s\n", errno, strerror(errno));
+        return;
+    }
+	printk("Socket created successfully\n");
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(LOCAL_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+		printk("Failed to bind socket: errno %d, %s\n", errno, strerror(errno));
+        close(sock);
+        return;
+    }
+	printk("Socket bound to 0.0.0.0:%d\n", LOCAL_PORT);
+	printk("Listening for UDP packets...\n");
+
+#if RECEIVER_MODE == RECEIVER_MODE_TELEMETRY
+    telemetry_receive(sock);
+#elif RECEIVER_MODE == RECEIVER_MODE_BATCH
+    udp_batch_bench_run(sock);
+#elif RECEIVER_MODE == RECEIVER_MODE_PRINT
+    print_receive(sock);
+#endif
 
     close(sock);
+#endif
 }
 
 int main(void)
@@ -0,0 +1,202 @@
+/**
+ * Sequenced UDP telemetry - receive-side loss, reorder and jitter analysis
+ *
+ * Each telemetry datagram carries a sequence number and the sender's send
+ * time (telemetry.h). From those two fields alone the receiver measures
+ * what the link does to the stream:
+ * - Loss: expected datagrams (first..highest sequence number) minus the
+ *   distinct ones received. A late datagram reduces the loss again
+ * - Duplicates: a bitmap of the last TELEM_WINDOW sequence numbers
+ * - Reordering: datagrams below the highest sequence number seen, and
+ *   the largest such distance (reorder depth, i.e. how many datagrams a
+ *   reorder buffer would need to hold)
+ * - Jitter: RFC 3550 interarrival jitter. The transit time (arrival minus
+ *   send time) contains the unknown clock offset, but the difference of
+ *   two transit times does not, so the clocks need no sync
+ *
+ * TELEM_RESTART_RUN datagrams in a row far below the highest sequence
+ * number mean the sender started over: the counters are reset.
+ *
+ * Processing is O(1) per datagram (a window jump clears at most
+ * TELEM_WINDOW bits) and uses no heap.
+ */
+
+#include <zephyr/kernel.h>
+
+#include <string.h>
+
+#include "telemetry.h"
+#include "telemetry_rx.h"
+
+BUILD_ASSERT((TELEM_WINDOW & (TELEM_WINDOW - 1)) == 0, "TELEM_WINDOW must be a power of two");
+
+static inline void seen_set(struct telem_rx *rx, uint32_t seq)
+{
+    seq &= TELEM_WINDOW - 1;
+    rx->seen[seq / 32] |= BIT(seq % 32);
+}
+
+static inline void seen_clear(struct telem_rx *rx, uint32_t seq)
+{
+    seq &= TELEM_WINDOW - 1;
+    rx->seen[seq / 32] &= ~BIT(seq % 32);
+}
+
+static inline bool seen_test(const struct telem_rx *rx, uint32_t seq)
+{
+    seq &= TELEM_WINDOW - 1;
+    return (rx->seen[seq / 32] & BIT(seq % 32)) != 0;
+}
+
+void telem_rx_reset(struct telem_rx *rx)
+{
+    memset(rx, 0, sizeof(*rx));
+}
+
+/**
+ * RFC 3550 section 6.4.1: J = J + (|D(i-1,i)| - J) / 16
+ */
+static void update_jitter(struct telem_rx *rx, uint64_t send_us, int64_t arrival_us)
+{
+    int64_t transit = arrival_us - (int64_t)send_us;
+    int64_t d;
+    int64_t gap;
+
+    if (rx->received > 1)
+    {
+        d = transit - rx->last_transit_us;
+        d = (d < 0) ? -d : d;
+        d = MIN(d, (int64_t)UINT32_MAX / 16);
+
+        rx->max_jitter_us = MAX(rx->max_jitter_us, (uint32_t)d);
+        // Same integer form as the RFC reference code, scaled by 16
+        rx->jitter_x16 += (uint32_t)d - ((rx->jitter_x16 + 8) >> 4);
+
+        gap = CLAMP(arrival_us - rx->last_arrival_us, 0, (int64_t)UINT32_MAX);
+        rx->max_gap_us = MAX(rx->max_gap_us, (uint32_t)gap);
+    }
+
+    rx->last_transit_us = transit;
+    rx->last_arrival_us = arrival_us;
+}
+
+bool telem_rx_process(struct telem_rx *rx, const void *data, size_t len, int64_t arrival_us)
+{
+    uint64_t send_us;
+    uint32_t seq;
+    uint32_t ahead;
+    uint32_t behind;
+    uint32_t restarts;
+    uint32_t s;
+
+    if (!telem_hdr_parse(data, len, &seq, &send_us))
+    {
+        rx->invalid++;
+        return false;
+    }
+
+    rx->received++;
+    update_jitter(rx, send_us, arrival_us);
+
+    if (!rx->started)
+    {
+        rx->started = true;
+        rx->first_seq = seq;
+        rx->highest_seq = seq;
+        rx->unique = 1;
+        seen_set(rx, seq);
+        return true;
+    }
+
+    ahead = seq - rx->highest_seq;
+    if (ahead != 0 && ahead < 0x80000000U)
+    {
+        // New highest: forget the sequence numbers that leave the window
+        if (ahead >= TELEM_WINDOW)
+        {
+            memset(rx->seen, 0, sizeof(rx->seen));
+        }
+        else
+        {
+            for (s = rx->highest_seq + 1; s != seq; s++)
+            {
+                seen_clear(rx, s);
+            }
+        }
+
+        rx->highest_seq = seq;
+        rx->unique++;
+        rx->too_old_run = 0;
+        seen_set(rx, seq);
+        return true;
+    }
+
+    // At or below the highest: duplicate or late
+    behind = rx->highest_seq - seq;
+    if (behind >= TELEM_WINDOW)
+    {
+        rx->too_old++;
+        if (++rx->too_old_run >= TELEM_RESTART_RUN)
+        {
+            // Sequence numbers went back for good: a new stream
+            restarts = rx->restarts + 1;
+            telem_rx_reset(rx);
+            rx->restarts = restarts;
+            return telem_rx_process(rx, data, len, arrival_us);
+        }
+        return true;
+    }
+    rx->too_old_run = 0;
+
+    if (seen_test(rx, seq))
+    {
+        rx->duplicates++;
+        return true;
+    }
+
+    seen_set(rx, seq);
+    rx->unique++;
+
+    // Older than the first datagram received: the stream started earlier,
+    // only the loss baseline moves back, it is not counted as reordered
+    if (seq - rx->first_seq >= 0x80000000U)
+    {
+        rx->first_seq = seq;
+        return true;
+    }
+
+    rx->reordered++;
+    rx->max_reorder = MAX(rx->max_reorder, behind);
+
+    return true;
+}
+
+uint32_t telem_rx_lost(const struct telem_rx *rx)
+{
+    uint32_t expected;
+
+    if (!rx->started)
+    {
+        return 0;
+    }
+
+    expected = rx->highest_seq - rx->first_seq + 1;
+
+    return (expected > rx->unique) ? expected - rx->unique : 0;
+}
+
+void telem_rx_print(const struct telem_rx *rx, const char *title)
+{
+    uint32_t expected = rx->started ? rx->highest_seq - rx->first_seq + 1 : 0;
+    uint32_t lost = telem_rx_lost(rx);
+    uint32_t loss_x100 = expected ? (uint32_t)((uint64_t)lost * 10000 / expected) : 0;
+
+    printk("%s: %u received, %u expected (seq %u..%u), %u invalid, %u restarts\n",
+           title, rx->received, expected, rx->first_seq, rx->highest_seq, rx->invalid,
+           rx->restarts);
+    printk("  loss %u (%u.%02u%%), %u duplicates, %u reordered (max depth %u), %u too old\n",
+           lost, loss_x100 / 100, loss_x100 % 100, rx->duplicates, rx->reordered,
+           rx->max_reorder, rx->too_old);
+    printk("  jitter %u us (max |D| %u us), longest gap %u us\n",
+           rx->jitter_x16 >> 4, rx->max_jitter_us, rx->max_gap_us);
+}
@@ -0,0 +1,72 @@
+/*
+ * Sequenced UDP telemetry - receive-side loss, reorder and jitter analysis
+ */
+
+#ifndef TELEMETRY_RX_H
+#define TELEMETRY_RX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* Sequence numbers remembered behind the highest one, for duplicate
+ * detection (power of two, one bit each) */
+#define TELEM_WINDOW 1024
+
+/* Consecutive datagrams older than the window that mean the sender has
+ * restarted its sequence numbers: the counters start over */
+#define TELEM_RESTART_RUN 16
+
+/* Counters of one telemetry stream */
+struct telem_rx
+{
+    bool started;               /* First datagram seen */
+    uint32_t first_seq;         /* Lowest sequence number of the stream */
+    uint32_t highest_seq;       /* Highest sequence number seen */
+    uint32_t received;          /* Datagrams received, duplicates included */
+    uint32_t unique;            /* Distinct sequence numbers received */
+    uint32_t duplicates;        /* Datagrams seen before (inside the window) */
+    uint32_t reordered;         /* Older than the highest seen, not below first_seq */
+    uint32_t max_reorder;       /* Largest distance below the highest seen */
+    uint32_t too_old;           /* Datagrams older than the window (not checked) */
+    uint32_t invalid;           /* Datagrams without a telemetry header */
+    uint32_t too_old_run;       /* Consecutive too_old datagrams */
+    uint32_t restarts;          /* Sender restarts detected (survives them) */
+
+    /* RFC 3550 interarrival jitter, in 1/16 us (J += (|D| - J) / 16) */
+    int64_t last_transit_us;    /* arrival - send of the previous datagram */
+    uint32_t jitter_x16;
+    uint32_t max_jitter_us;     /* Largest single |D| seen */
+
+    /* Arrival spacing */
+    int64_t last_arrival_us;
+    uint32_t max_gap_us;        /* Longest silence between two datagrams */
+
+    uint32_t seen[TELEM_WINDOW / 32];   /* Bitmap of recent sequence numbers */
+};
+
+/**
+ *  @brief Reset all counters (a new stream starts at the next datagram)
+ */
+void telem_rx_reset(struct telem_rx *rx);
+
+/**
+ *  @brief Account one received datagram
+ *
+ *  @param arrival_us Receive time on the local clock, microseconds
+ *
+ *  @return false when the datagram has no telemetry header
+ */
+bool telem_rx_process(struct telem_rx *rx, const void *data, size_t len, int64_t arrival_us);
+
+/**
+ *  @brief Datagrams never received so far (expected - distinct received)
+ */
+uint32_t telem_rx_lost(const struct telem_rx *rx);
+
+/**
+ *  @brief Print loss %, duplicates, reorder depth and jitter
+ */
+void telem_rx_print(const struct telem_rx *rx, const char *title);
+
+#endif /* TELEMETRY_RX_H */
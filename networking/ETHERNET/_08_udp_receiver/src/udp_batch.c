@@ -0,0 +1,243 @@
+/**
+ * Batch datagram receive (recvmmsg-style)
+ *
+ * The print loop pays for every datagram with one recvfrom() call and one
+ * inet_ntop() into a string. Zephyr has no recvmmsg(), so udp_batch_recv()
+ * builds the same thing on recvmsg():
+ * - An array of message headers (struct udp_batch_msg, the layout of
+ *   struct mmsghdr) is set up once, each one pointing at its own buffer
+ *   and source address slot
+ * - The first recvmsg() blocks, the following ones use MSG_DONTWAIT and
+ *   stop at the first EAGAIN or when the batch is full, so one wakeup
+ *   drains everything the stack has queued
+ * - Source addresses stay binary (struct sockaddr_in), they are only
+ *   formatted when BATCH_LOG_SOURCES is set
+ *
+ * Every call still crosses the socket layer (locking, fifo, net_pkt copy,
+ * and a real system call with CONFIG_USERSPACE or on the native_sim host),
+ * but the wakeups and the blocking waits are shared by the whole batch.
+ *
+ * udp_batch_bench_run() sweeps the batch size 1, 2, 4 .. UDP_BATCH_MAX on
+ * a live telemetry stream and prints, per size: packets/s, recvmsg() calls
+ * per packet, packets per wakeup, CPU time of the receiving thread per
+ * packet (CONFIG_SCHED_THREAD_USAGE) and the telemetry loss.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/arpa/inet.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "telemetry_rx.h"
+#include "udp_batch.h"
+
+/* Receive timeout, so a benchmark step ends on time without traffic */
+#define BATCH_RCVTIMEO_MS 200
+
+static struct udp_batch batch;
+static struct telem_rx telem;
+
+void udp_batch_init(struct udp_batch *batch)
+{
+    unsigned int i;
+
+    memset(batch, 0, sizeof(*batch));
+
+    for (i = 0; i < UDP_BATCH_MAX; i++)
+    {
+        batch->iov[i].iov_base = batch->buf[i];
+        batch->iov[i].iov_len = UDP_BATCH_BUF_SIZE;
+
+        batch->msgs[i].hdr.msg_name = &batch->addr[i];
+        batch->msgs[i].hdr.msg_iov = &batch->iov[i];
+        batch->msgs[i].hdr.msg_iovlen = 1;
+    }
+}
+
+int udp_batch_recv(int fd, struct udp_batch *batch, unsigned int vlen)
+{
+    struct msghdr *hdr;
+    unsigned int n;
+    int ret;
+
+    vlen = MIN(vlen, UDP_BATCH_MAX);
+
+    for (n = 0; n < vlen; n++)
+    {
+        hdr = &batch->msgs[n].hdr;
+        hdr->msg_namelen = sizeof(batch->addr[n]);
+        hdr->msg_flags = 0;
+
+        // Wait for the first datagram only, then take what is queued
+        ret = recvmsg(fd, hdr, (n == 0) ? 0 : MSG_DONTWAIT);
+        batch->calls++;
+
+        if (ret < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            return (n > 0) ? (int)n : -errno;
+        }
+
+        batch->msgs[n].len = ret;
+        if (hdr->msg_flags & MSG_TRUNC)
+        {
+            batch->truncated++;
+        }
+    }
+
+    return n;
+}
+
+/**
+ * CPU cycles used by the calling thread so far
+ */
+static uint64_t thread_cycles(void)
+{
+#ifdef CONFIG_SCHED_THREAD_USAGE
+    k_thread_runtime_stats_t stats;
+
+    k_thread_runtime_stats_get(k_current_get(), &stats);
+    return stats.execution_cycles;
+#else
+    return 0;
+#endif
+}
+
+#if BATCH_LOG_SOURCES
+static void log_batch(int n)
+{
+    char ip[INET_ADDRSTRLEN];
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        inet_ntop(AF_INET, &batch.addr[i].sin_addr, ip, sizeof(ip));
+        printk("  [%d/%d] %u bytes from %s:%d\n", i + 1, n, batch.msgs[i].len, ip,
+               ntohs(batch.addr[i].sin_port));
+    }
+}
+#endif
+
+/**
+ * Receive with one batch size for BATCH_STEP_MS and print its row
+ */
+static void bench_step(int fd, unsigned int vlen)
+{
+    uint32_t packets = 0;
+    uint32_t wakeups = 0;
+    uint32_t elapsed_ms;
+    uint32_t expected;
+    uint32_t loss_x100;
+    uint64_t cpu_ns;
+    uint64_t cyc0;
+    int64_t start;
+    int64_t now_us;
+    int n;
+    int i;
+
+    telem_rx_reset(&telem);
+    batch.calls = 0;
+
+    cyc0 = thread_cycles();
+    start = k_uptime_get();
+
+    while (k_uptime_get() - start < BATCH_STEP_MS)
+    {
+        n = udp_batch_recv(fd, &batch, vlen);
+        if (n < 0)
+        {
+            printk("Receive error: %d\n", n);
+            return;
+        }
+        if (n == 0)
+        {
+            continue;
+        }
+
+        // One timestamp per wakeup: the whole batch arrived by now
+        now_us = (int64_t)k_cyc_to_us_floor64(k_cycle_get_64());
+        for (i = 0; i < n; i++)
+        {
+            telem_rx_process(&telem, batch.buf[i], batch.msgs[i].len, now_us);
+        }
+
+#if BATCH_LOG_SOURCES
+        log_batch(n);
+#endif
+
+        packets += n;
+        wakeups++;
+    }
+
+    elapsed_ms = MAX((uint32_t)(k_uptime_get() - start), 1);
+    cpu_ns = k_cyc_to_ns_floor64(thread_cycles() - cyc0);
+
+    if (packets == 0)
+    {
+        printk("batch %2u: no traffic\n", vlen);
+        return;
+    }
+
+    expected = telem.started ? telem.highest_seq - telem.first_seq + 1 : 0;
+    loss_x100 = expected ? (uint32_t)((uint64_t)telem_rx_lost(&telem) * 10000 / expected) : 0;
+
+    printk("batch %2u: %6u pkt/s, %u.%02u calls/pkt, %3u.%u pkt/wakeup, %5u ns CPU/pkt, "
+           "loss %u.%02u%%\n",
+           vlen, (uint32_t)((uint64_t)packets * 1000 / elapsed_ms),
+           batch.calls / packets, (batch.calls % packets) * 100 / packets,
+           packets / wakeups, (packets % wakeups) * 10 / wakeups,
+           (uint32_t)(cpu_ns / packets), loss_x100 / 100, loss_x100 % 100);
+}
+
+void udp_batch_bench_run(int fd)
+{
+    struct timeval tv = {
+        .tv_sec = 0,
+        .tv_usec = BATCH_RCVTIMEO_MS * 1000,
+    };
+    unsigned int vlen;
+    int n;
+
+    udp_batch_init(&batch);
+
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0)
+    {
+        printk("SO_RCVTIMEO failed: %d\n", -errno);
+        return;
+    }
+
+    while (1)
+    {
+        printk("Batch benchmark: waiting for a telemetry stream...\n");
+        do
+        {
+            n = udp_batch_recv(fd, &batch, 1);
+        } while (n == 0);
+
+        if (n < 0)
+        {
+            printk("Receive error: %d\n", n);
+            return;
+        }
+
+        printk("Batch benchmark: %d ms per batch size, %u-byte buffers\n",
+               BATCH_STEP_MS, UDP_BATCH_BUF_SIZE);
+
+        for (vlen = 1; vlen <= UDP_BATCH_MAX; vlen *= 2)
+        {
+            bench_step(fd, vlen);
+        }
+
+        if (batch.truncated > 0)
+        {
+            printk("%u datagrams truncated to %u bytes\n", batch.truncated, UDP_BATCH_BUF_SIZE);
+            batch.truncated = 0;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * Batch datagram receive (recvmmsg-style) and batch size benchmark
+ */
+
+#ifndef UDP_BATCH_H
+#define UDP_BATCH_H
+
+#include <zephyr/net/socket.h>
+
+#include <stdint.h>
+
+/* Most datagrams drained per call, and bytes kept of each one */
+#define UDP_BATCH_MAX 32
+#define UDP_BATCH_BUF_SIZE 256
+
+/* Benchmark: time spent on each batch size */
+#define BATCH_STEP_MS 3000
+
+/* Print every datagram with its source address (formatted only here) */
+#define BATCH_LOG_SOURCES 0
+
+/* One received datagram, the layout of struct mmsghdr */
+struct udp_batch_msg
+{
+    struct msghdr hdr;          /* Buffer and source address of this slot */
+    unsigned int len;           /* Bytes received */
+};
+
+/* Message headers and storage for UDP_BATCH_MAX datagrams */
+struct udp_batch
+{
+    struct udp_batch_msg msgs[UDP_BATCH_MAX];
+    struct iovec iov[UDP_BATCH_MAX];
+    struct sockaddr_in addr[UDP_BATCH_MAX];     /* Binary source addresses */
+    uint8_t buf[UDP_BATCH_MAX][UDP_BATCH_BUF_SIZE];
+    uint32_t calls;             /* recvmsg() calls made, EAGAIN included */
+    uint32_t truncated;         /* Datagrams longer than UDP_BATCH_BUF_SIZE */
+};
+
+/**
+ *  @brief Point every message header at its buffer and address slot
+ */
+void udp_batch_init(struct udp_batch *batch);
+
+/**
+ *  @brief Receive up to vlen datagrams, like recvmmsg() with MSG_WAITFORONE
+ *
+ *  Blocks for the first datagram (up to the socket's SO_RCVTIMEO), then
+ *  takes whatever else is already queued without waiting.
+ *
+ *  @return Datagrams in batch->msgs[0..n-1], 0 on timeout, negative errno
+ */
+int udp_batch_recv(int fd, struct udp_batch *batch, unsigned int vlen);
+
+/**
+ *  @brief Measure calls and CPU per datagram for batch sizes 1..UDP_BATCH_MAX
+ *
+ *  Feed a steady telemetry stream (udp_sender_test.py --telemetry). Each
+ *  batch size runs for BATCH_STEP_MS, then one table row is printed. The
+ *  sweep repeats forever.
+ *
+ *  @param fd Bound UDP socket
+ */
+void udp_batch_bench_run(int fd);
+
+#endif /* UDP_BATCH_H */
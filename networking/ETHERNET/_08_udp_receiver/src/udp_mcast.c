@@ -0,0 +1,732 @@
+/**
+ * Multicast and broadcast group subscription (multicast mode)
+ *
+ * Configuration and time-sync datagrams go to every node. With unicast the
+ * publisher sends one copy per board; with multicast it sends one datagram
+ * to a group and the network delivers it to every board that joined:
+ * - Groups are joined and left with IP_ADD_MEMBERSHIP / IP_DROP_MEMBERSHIP
+ *   (IPV6_ADD_MEMBERSHIP / IPV6_DROP_MEMBERSHIP with CONFIG_NET_IPV6).
+ *   The stack then reports the membership with IGMP/MLD and programs the
+ *   Ethernet multicast filter. MCAST_GROUP_V4/V6 are joined at start,
+ *   others at run time with "mcast join <group>" from the shell
+ * - One socket per address family is bound to the port on the wildcard
+ *   address, so it receives every group, broadcast and unicast on that
+ *   port. IP_PKTINFO tells the destination address of each datagram, and
+ *   only datagrams for a joined group are accepted (broadcast and unicast
+ *   are accepted as pseudo-groups when enabled), the rest is filtered
+ * - Every group keeps its own counters and telemetry analysis. A telemetry
+ *   datagram with TELEM_FLAG_REPORT is a report request from the publisher:
+ *   it is answered, after a random delay, with a struct mcast_report sent
+ *   back to the publisher, which adds up the replies of all boards
+ *
+ * The group table is shared with the shell thread and protected by a mutex.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/arpa/inet.h>
+#include <zephyr/posix/unistd.h>
+#include <zephyr/posix/poll.h>
+#include <zephyr/random/random.h>
+#include <zephyr/shell/shell.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "telemetry.h"
+#include "telemetry_rx.h"
+#include "udp_mcast.h"
+
+/* Kinds of entries in the group table */
+enum group_kind
+{
+    GROUP_FREE,
+    GROUP_MCAST,        /* Joined multicast group */
+    GROUP_BROADCAST,    /* IPv4 broadcast, MCAST_ACCEPT_BROADCAST */
+    GROUP_UNICAST,      /* Datagrams to the board's own address, MCAST_ACCEPT_UNICAST */
+};
+
+/* One accepted destination with its counters */
+struct mcast_group
+{
+    uint8_t kind;                   /* enum group_kind */
+    sa_family_t family;
+    union
+    {
+        struct in_addr v4;
+        struct in6_addr v6;
+    } addr;
+    char name[INET6_ADDRSTRLEN];
+    uint32_t datagrams;             /* Datagrams accepted */
+    uint32_t last_printed;          /* datagrams at the last periodic print */
+    int64_t last_ms;                /* Last datagram, for the idle reset */
+    struct telem_rx telem;
+};
+
+static struct mcast_group groups[MCAST_MAX_GROUPS];
+static K_MUTEX_DEFINE(group_lock);
+
+/* Datagrams for a destination that is not in the table */
+static uint32_t filtered;
+
+/* One socket per address family, -1 when absent */
+static int fd4 = -1;
+static int fd6 = -1;
+
+static uint8_t rx_buf[512];
+static uint8_t ctrl_buf[64];
+
+/**
+ * Parse a group address, only multicast addresses are accepted
+ */
+static int parse_group(const char *str, struct mcast_group *g)
+{
+    if (inet_pton(AF_INET, str, &g->addr.v4) == 1)
+    {
+        // 224.0.0.0/4
+        if ((ntohl(g->addr.v4.s_addr) >> 28) != 0xE)
+        {
+            return -EINVAL;
+        }
+        g->family = AF_INET;
+        return 0;
+    }
+
+#if defined(CONFIG_NET_IPV6)
+    if (inet_pton(AF_INET6, str, &g->addr.v6) == 1)
+    {
+        // ff00::/8
+        if (g->addr.v6.s6_addr[0] != 0xff)
+        {
+            return -EINVAL;
+        }
+        g->family = AF_INET6;
+        return 0;
+    }
+#endif
+
+    return -EINVAL;
+}
+
+/**
+ * Join or leave a group on the socket of its address family
+ */
+static int group_membership(const struct mcast_group *g, bool join)
+{
+    int ret;
+
+    if (g->family == AF_INET)
+    {
+        struct ip_mreqn mreq = { 0 };
+
+        // Interface index 0: the default interface
+        mreq.imr_multiaddr = g->addr.v4;
+        ret = setsockopt(fd4, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+                         &mreq, sizeof(mreq));
+    }
+    else
+    {
+#if defined(CONFIG_NET_IPV6)
+        struct ipv6_mreq mreq = { 0 };
+
+        mreq.ipv6mr_multiaddr = g->addr.v6;
+        ret = setsockopt(fd6, IPPROTO_IPV6, join ? IPV6_ADD_MEMBERSHIP : IPV6_DROP_MEMBERSHIP,
+                         &mreq, sizeof(mreq));
+#else
+        ret = -1;
+        errno = EAFNOSUPPORT;
+#endif
+    }
+
+    return (ret < 0) ? -errno : 0;
+}
+
+/**
+ * Find a joined group by address (group_lock held)
+ */
+static struct mcast_group *find_group(const struct mcast_group *key)
+{
+    size_t size = (key->family == AF_INET) ? sizeof(key->addr.v4) : sizeof(key->addr.v6);
+    int i;
+
+    for (i = 0; i < MCAST_MAX_GROUPS; i++)
+    {
+        if (groups[i].kind == GROUP_MCAST && groups[i].family == key->family &&
+            memcmp(&groups[i].addr, &key->addr, size) == 0)
+        {
+            return &groups[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Take a free table entry (group_lock held)
+ */
+static struct mcast_group *alloc_group(void)
+{
+    int i;
+
+    for (i = 0; i < MCAST_MAX_GROUPS; i++)
+    {
+        if (groups[i].kind == GROUP_FREE)
+        {
+            memset(&groups[i], 0, sizeof(groups[i]));
+            return &groups[i];
+        }
+    }
+
+    return NULL;
+}
+
+int mcast_join(const char *group)
+{
+    struct mcast_group key;
+    struct mcast_group *g;
+    int ret;
+
+    ret = parse_group(group, &key);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if ((key.family == AF_INET ? fd4 : fd6) < 0)
+    {
+        return -ENOTCONN;
+    }
+
+    k_mutex_lock(&group_lock, K_FOREVER);
+
+    if (find_group(&key))
+    {
+        ret = -EALREADY;
+        goto out;
+    }
+
+    g = alloc_group();
+    if (!g)
+    {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    g->family = key.family;
+    g->addr = key.addr;
+
+    ret = group_membership(g, true);
+    if (ret == 0)
+    {
+        g->kind = GROUP_MCAST;
+        strncpy(g->name, group, sizeof(g->name) - 1);
+    }
+
+out:
+    k_mutex_unlock(&group_lock);
+
+    return ret;
+}
+
+int mcast_leave(const char *group)
+{
+    struct mcast_group key;
+    struct mcast_group *g;
+    int ret;
+
+    ret = parse_group(group, &key);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    k_mutex_lock(&group_lock, K_FOREVER);
+
+    g = find_group(&key);
+    if (!g)
+    {
+        ret = -ENOENT;
+    }
+    else
+    {
+        // Free the entry even if the stack already forgot the membership
+        ret = group_membership(g, false);
+        g->kind = GROUP_FREE;
+    }
+
+    k_mutex_unlock(&group_lock);
+
+    return ret;
+}
+
+/**
+ * Add a pseudo-group that needs no membership (broadcast, unicast)
+ */
+static void add_pseudo_group(uint8_t kind, const char *name)
+{
+    struct mcast_group *g;
+
+    k_mutex_lock(&group_lock, K_FOREVER);
+
+    g = alloc_group();
+    if (g)
+    {
+        g->kind = kind;
+        g->family = AF_INET;
+        strncpy(g->name, name, sizeof(g->name) - 1);
+    }
+
+    k_mutex_unlock(&group_lock);
+}
+
+/**
+ * Entry for the destination address of a datagram (group_lock held)
+ *
+ * @return NULL when the destination was not subscribed to
+ */
+static struct mcast_group *match_destination(sa_family_t family, const void *dst,
+                                             int ifindex)
+{
+    struct mcast_group key;
+    struct mcast_group *g;
+    uint8_t kind;
+    int i;
+
+    key.family = family;
+    memcpy(&key.addr, dst, (family == AF_INET) ? sizeof(key.addr.v4) : sizeof(key.addr.v6));
+
+    g = find_group(&key);
+    if (g)
+    {
+        return g;
+    }
+
+    if (family != AF_INET)
+    {
+        return NULL;
+    }
+
+    if ((ntohl(key.addr.v4.s_addr) >> 28) == 0xE)
+    {
+        // A group joined by another socket or left in the meantime
+        return NULL;
+    }
+
+    // Limited (255.255.255.255) or subnet-directed broadcast, else unicast
+    kind = GROUP_UNICAST;
+    if (key.addr.v4.s_addr == htonl(INADDR_BROADCAST))
+    {
+        kind = GROUP_BROADCAST;
+    }
+    else
+    {
+        struct net_if *iface = net_if_get_by_index(ifindex);
+
+        if (iface && net_ipv4_is_addr_bcast(iface, &key.addr.v4))
+        {
+            kind = GROUP_BROADCAST;
+        }
+    }
+
+    for (i = 0; i < MCAST_MAX_GROUPS; i++)
+    {
+        if (groups[i].kind == kind)
+        {
+            return &groups[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Destination address and interface from the IP_PKTINFO / IPV6_PKTINFO
+ * control message
+ *
+ * @return Pointer to the address inside the control buffer, NULL if absent
+ */
+static const void *packet_destination(struct msghdr *msg, int *ifindex)
+{
+    struct cmsghdr *cmsg;
+
+    for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg))
+    {
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO)
+        {
+            struct in_pktinfo *info = (struct in_pktinfo *)CMSG_DATA(cmsg);
+
+            *ifindex = info->ipi_ifindex;
+            return &info->ipi_addr;
+        }
+
+#if defined(CONFIG_NET_IPV6)
+        if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO)
+        {
+            struct in6_pktinfo *info = (struct in6_pktinfo *)CMSG_DATA(cmsg);
+
+            *ifindex = info->ipi6_ifindex;
+            return &info->ipi6_addr;
+        }
+#endif
+    }
+
+    return NULL;
+}
+
+/**
+ * Account one accepted datagram (group_lock held)
+ *
+ * @return true when it is a report request, report is then filled in
+ */
+static bool account(struct mcast_group *g, int len, struct mcast_report *report)
+{
+    int64_t now = k_uptime_get();
+    uint64_t send_us;
+    uint32_t seq;
+
+    // A new publication run after a pause starts from zero
+    if (now - g->last_ms > MCAST_IDLE_RESET_MS && g->telem.received > 0)
+    {
+        telem_rx_reset(&g->telem);
+    }
+    g->last_ms = now;
+    g->datagrams++;
+
+    if (telem_hdr_parse(rx_buf, len, &seq, &send_us) &&
+        (telem_hdr_flags(rx_buf) & TELEM_FLAG_REPORT))
+    {
+        report->magic = htons(MCAST_REPORT_MAGIC);
+        report->version = TELEM_VERSION;
+        report->reserved = 0;
+        report->published = htonl(seq);
+        report->delivered = htonl(g->telem.unique);
+        report->duplicates = htonl(g->telem.duplicates);
+        report->reordered = htonl(g->telem.reordered);
+        return true;
+    }
+
+    // Plain datagrams (configuration, time sync) count as telemetry "invalid"
+    telem_rx_process(&g->telem, rx_buf, len, (int64_t)k_cyc_to_us_floor64(k_cycle_get_64()));
+
+    return false;
+}
+
+/**
+ * Receive one datagram, filter it by destination and account it
+ */
+static void receive_one(int fd)
+{
+    static bool warned;
+    struct sockaddr_storage src;
+    struct mcast_report report;
+    struct mcast_group *g;
+    struct msghdr msg = { 0 };
+    struct iovec iov;
+    const void *dst;
+    int ifindex = 0;
+    bool reply = false;
+    int len;
+
+    iov.iov_base = rx_buf;
+    iov.iov_len = sizeof(rx_buf);
+    msg.msg_name = &src;
+    msg.msg_namelen = sizeof(src);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl_buf;
+    msg.msg_controllen = sizeof(ctrl_buf);
+
+    len = recvmsg(fd, &msg, 0);
+    if (len < 0)
+    {
+        printk("Socket error: %d\n", errno);
+        k_sleep(K_MSEC(100));
+        return;
+    }
+
+    dst = packet_destination(&msg, &ifindex);
+    if (!dst)
+    {
+        if (!warned)
+        {
+            printk("No destination address: enable CONFIG_NET_CONTEXT_RECV_PKTINFO\n");
+            warned = true;
+        }
+        filtered++;
+        return;
+    }
+
+    k_mutex_lock(&group_lock, K_FOREVER);
+
+    g = match_destination(fd == fd4 ? AF_INET : AF_INET6, dst, ifindex);
+    if (g)
+    {
+        reply = account(g, len, &report);
+    }
+    else
+    {
+        filtered++;
+    }
+
+    k_mutex_unlock(&group_lock);
+
+    if (reply)
+    {
+        // Spread the replies of many boards over MCAST_REPLY_JITTER_MS
+        k_sleep(K_MSEC(sys_rand32_get() % (MCAST_REPLY_JITTER_MS + 1)));
+        sendto(fd, &report, sizeof(report), 0, (struct sockaddr *)&src, msg.msg_namelen);
+    }
+}
+
+/**
+ * Print the counters of every group that received something new
+ */
+static void print_groups(void)
+{
+    struct mcast_group *g;
+    int i;
+
+    k_mutex_lock(&group_lock, K_FOREVER);
+
+    for (i = 0; i < MCAST_MAX_GROUPS; i++)
+    {
+        g = &groups[i];
+        if (g->kind == GROUP_FREE || g->datagrams == g->last_printed)
+        {
+            continue;
+        }
+
+        printk("Group %s: %u datagrams (+%u), %u filtered\n", g->name, g->datagrams,
+               g->datagrams - g->last_printed, filtered);
+        if (g->telem.received > 0)
+        {
+            telem_rx_print(&g->telem, "  Telemetry");
+        }
+        g->last_printed = g->datagrams;
+    }
+
+    k_mutex_unlock(&group_lock);
+}
+
+/**
+ * Wildcard-bound socket of one family that reports destination addresses
+ */
+static int open_socket(sa_family_t family, uint16_t port)
+{
+    struct sockaddr_storage addr = { 0 };
+    socklen_t addr_len;
+    int optval = 1;
+    int fd;
+
+    fd = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+
+    if (family == AF_INET)
+    {
+        struct sockaddr_in *sin = (struct sockaddr_in *)&addr;
+
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+        sin->sin_addr.s_addr = htonl(INADDR_ANY);
+        addr_len = sizeof(*sin);
+
+        setsockopt(fd, IPPROTO_IP, IP_PKTINFO, &optval, sizeof(optval));
+    }
+    else
+    {
+#if defined(CONFIG_NET_IPV6)
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&addr;
+
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(port);
+        sin6->sin6_addr = in6addr_any;
+        addr_len = sizeof(*sin6);
+
+        // The IPv4 socket owns the port for IPv4
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &optval, sizeof(optval));
+        setsockopt(fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &optval, sizeof(optval));
+#else
+        close(fd);
+        return -EAFNOSUPPORT;
+#endif
+    }
+
+    if (bind(fd, (struct sockaddr *)&addr, addr_len) < 0)
+    {
+        int ret = -errno;
+
+        close(fd);
+        return ret;
+    }
+
+    return fd;
+}
+
+void udp_mcast_run(uint16_t port)
+{
+    struct pollfd fds[2];
+    int64_t next_print;
+    int nfds = 0;
+    int ret;
+    int i;
+
+    fd4 = open_socket(AF_INET, port);
+    if (fd4 < 0)
+    {
+        printk("Failed to open IPv4 socket: %d\n", fd4);
+        return;
+    }
+    fds[nfds++].fd = fd4;
+
+#if defined(CONFIG_NET_IPV6)
+    fd6 = open_socket(AF_INET6, port);
+    if (fd6 < 0)
+    {
+        printk("Failed to open IPv6 socket: %d\n", fd6);
+    }
+    else
+    {
+        fds[nfds++].fd = fd6;
+    }
+#endif
+
+    if (MCAST_ACCEPT_BROADCAST)
+    {
+        add_pseudo_group(GROUP_BROADCAST, "broadcast");
+    }
+    if (MCAST_ACCEPT_UNICAST)
+    {
+        add_pseudo_group(GROUP_UNICAST, "unicast");
+    }
+
+    ret = mcast_join(MCAST_GROUP_V4);
+    printk("Join %s: %d\n", MCAST_GROUP_V4, ret);
+#if defined(CONFIG_NET_IPV6)
+    ret = mcast_join(MCAST_GROUP_V6);
+    printk("Join %s: %d\n", MCAST_GROUP_V6, ret);
+#endif
+
+    printk("Multicast mode: port %d, broadcast %s, unicast %s (shell: mcast join|leave|list)\n",
+           port, MCAST_ACCEPT_BROADCAST ? "accepted" : "filtered",
+           MCAST_ACCEPT_UNICAST ? "accepted" : "filtered");
+
+    next_print = k_uptime_get() + MCAST_REPORT_MS;
+
+    while (1)
+    {
+        for (i = 0; i < nfds; i++)
+        {
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+
+        ret = poll(fds, nfds, (int)MAX(next_print - k_uptime_get(), 0));
+        if (ret < 0)
+        {
+            printk("Poll error: %d\n", errno);
+            return;
+        }
+
+        for (i = 0; i < nfds; i++)
+        {
+            if (fds[i].revents & POLLIN)
+            {
+                receive_one(fds[i].fd);
+            }
+        }
+
+        if (k_uptime_get() >= next_print)
+        {
+            next_print += MCAST_REPORT_MS;
+            print_groups();
+        }
+    }
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_mcast_join(const struct shell *sh, size_t argc, char **argv)
+{
+    int ret;
+
+    ARG_UNUSED(argc);
+
+    ret = mcast_join(argv[1]);
+
+    if (ret < 0)
+    {
+        shell_error(sh, "Join %s failed: %d", argv[1], ret);
+        return ret;
+    }
+
+    shell_print(sh, "Joined %s", argv[1]);
+    return 0;
+}
+
+static int cmd_mcast_leave(const struct shell *sh, size_t argc, char **argv)
+{
+    int ret;
+
+    ARG_UNUSED(argc);
+
+    ret = mcast_leave(argv[1]);
+
+    if (ret < 0)
+    {
+        shell_error(sh, "Leave %s failed: %d", argv[1], ret);
+        return ret;
+    }
+
+    shell_print(sh, "Left %s", argv[1]);
+    return 0;
+}
+
+/**
+ * "mcast list" - one line per accepted destination
+ */
+static int cmd_mcast_list(const struct shell *sh, size_t argc, char **argv)
+{
+    struct mcast_group *g;
+    int i;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%-40s %10s %10s %6s %6s", "group", "datagrams", "delivered", "lost",
+                "dup");
+
+    k_mutex_lock(&group_lock, K_FOREVER);
+
+    for (i = 0; i < MCAST_MAX_GROUPS; i++)
+    {
+        g = &groups[i];
+        if (g->kind == GROUP_FREE)
+        {
+            continue;
+        }
+
+        shell_print(sh, "%-40s %10u %10u %6u %6u", g->name, g->datagrams, g->telem.unique,
+                    telem_rx_lost(&g->telem), g->telem.duplicates);
+    }
+
+    k_mutex_unlock(&group_lock);
+
+    shell_print(sh, "%u datagrams filtered (destination not subscribed)", filtered);
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_mcast_cmds,
+    SHELL_CMD_ARG(join, NULL, "Join a group: mcast join <group>", cmd_mcast_join, 2, 0),
+    SHELL_CMD_ARG(leave, NULL, "Leave a group: mcast leave <group>", cmd_mcast_leave, 2, 0),
+    SHELL_CMD(list, NULL, "List groups with their counters.", cmd_mcast_list),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(mcast, &sub_mcast_cmds, "UDP multicast group membership", NULL);
+#endif /* CONFIG_SHELL */
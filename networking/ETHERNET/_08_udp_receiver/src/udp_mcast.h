@@ -0,0 +1,74 @@
+/*
+ * Multicast and broadcast group subscription with per-group filtering
+ */
+
+#ifndef UDP_MCAST_H
+#define UDP_MCAST_H
+
+#include <stdint.h>
+
+/* Groups joined at start (the IPv6 one only with CONFIG_NET_IPV6) */
+#define MCAST_GROUP_V4 "239.1.2.3"
+#define MCAST_GROUP_V6 "ff05::1:3"
+
+/* Groups that can be joined at the same time, broadcast entry included.
+ * Keep CONFIG_NET_IF_MCAST_IPV4_ADDR_COUNT (and _IPV6_) at least as large */
+#define MCAST_MAX_GROUPS 4
+
+/* Also accept 255.255.255.255 and subnet broadcasts as the group
+ * "broadcast", and unicast datagrams to the board (counted, not filtered) */
+#define MCAST_ACCEPT_BROADCAST 1
+#define MCAST_ACCEPT_UNICAST 0
+
+/* A group silent this long starts a new telemetry stream at its next datagram */
+#define MCAST_IDLE_RESET_MS 2000
+
+/* Delivery reports are delayed by a random 0..MCAST_REPLY_JITTER_MS, so
+ * that many boards answering one publisher do not reply in the same instant */
+#define MCAST_REPLY_JITTER_MS 100
+
+/* Per-group counters are printed at this interval when they changed */
+#define MCAST_REPORT_MS 5000
+
+/* Delivery report sent back to the publisher, network byte order */
+#define MCAST_REPORT_MAGIC 0x5A52     /* "ZR" */
+
+struct mcast_report
+{
+    uint16_t magic;             /* MCAST_REPORT_MAGIC */
+    uint8_t version;            /* TELEM_VERSION */
+    uint8_t reserved;
+    uint32_t published;         /* seq of the report request: datagrams published */
+    uint32_t delivered;         /* Distinct datagrams received */
+    uint32_t duplicates;
+    uint32_t reordered;
+};
+
+/**
+ *  @brief Join a multicast group ("239.1.2.3", "ff05::1:3")
+ *
+ *  @return 0, -EALREADY when already joined, -ENOMEM when the table is
+ *          full, other negative errno from setsockopt()
+ */
+int mcast_join(const char *group);
+
+/**
+ *  @brief Leave a group joined with mcast_join()
+ *
+ *  @return 0, -ENOENT when the group is not joined, negative errno
+ */
+int mcast_leave(const char *group);
+
+/**
+ *  @brief Open the sockets, join the default groups and receive, never returns
+ *
+ *  Only datagrams addressed to a joined group (or broadcast/unicast when
+ *  enabled) are accepted. Telemetry datagrams are analyzed per group, and a
+ *  report request (TELEM_FLAG_REPORT) is answered with a struct
+ *  mcast_report to its sender.
+ *
+ *  @param port Local UDP port shared by all groups
+ */
+void udp_mcast_run(uint16_t port);
+
+#endif /* UDP_MCAST_H */
@@ -0,0 +1,316 @@
+/**
+ * Sharded multi-thread UDP receiver (sharded mode)
+ *
+ * The single-thread loops receive into one static buffer and process (or
+ * print) each datagram before the next recvfrom(). While they are busy,
+ * datagrams pile up in the stack until its net_buf pool runs dry and
+ * further ones are dropped. The sharded receiver splits the two jobs:
+ * - SHARD_COUNT receive threads do nothing but recvfrom(), either all on
+ *   one shared socket or each on its own SO_REUSEPORT socket
+ * - Every datagram is received straight into a buffer from a k_mem_slab
+ *   pool (no heap, static storage) and the buffer is queued by
+ *   pointer on a k_fifo, the payload is never copied
+ * - One processing thread, below the receivers in priority, takes the
+ *   buffers off the fifo, runs the telemetry analysis and frees them. A
+ *   burst is absorbed by the pool instead of the socket queue
+ * - When the pool is empty the datagram is still read, so the stack keeps
+ *   its buffers, but discarded and counted as a pool drop
+ *
+ * Nothing is logged per datagram. Every SHARD_REPORT_MS the processing
+ * thread prints packets/s per shard, pool use, pool drops and the UDP drops
+ * of the stack, followed by the same telemetry report as the single-thread
+ * RECEIVER_MODE_TELEMETRY loop, so both can be compared on the same stream.
+ *
+ * Shard counters are written by their shard only and read by the reporter.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/net_stats.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/unistd.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include "telemetry_rx.h"
+#include "udp_shards.h"
+
+/* One received datagram, one slab block */
+struct udp_pkt
+{
+    void *fifo_reserved;            /* k_fifo link, must be first */
+    struct sockaddr_in src;         /* Sender address (binary, never formatted) */
+    int64_t arrival_us;             /* Receive time, cycle counter */
+    uint16_t len;                   /* Bytes in data */
+    uint8_t shard;                  /* Shard that received it */
+    uint8_t data[PKT_BUF_SIZE];
+};
+
+/* One receive thread */
+struct shard
+{
+    int fd;                         /* Own socket, or the shared one */
+    uint32_t packets;               /* Datagrams queued for processing */
+    uint32_t bytes;                 /* Payload bytes queued */
+    uint32_t pool_drops;            /* Datagrams discarded, pool empty */
+    uint32_t errors;                /* recvfrom() failures */
+    uint32_t last_packets;          /* packets at the previous report [reporter] */
+};
+
+/* Buffer pool, initialized at run time so that other receiver modes do not
+ * keep the storage (the linker drops it together with udp_shards_run()) */
+static struct k_mem_slab pkt_slab;
+static uint8_t pkt_pool[PKT_POOL_COUNT * sizeof(struct udp_pkt)] __aligned(8);
+static K_FIFO_DEFINE(pkt_fifo);
+
+K_THREAD_STACK_ARRAY_DEFINE(shard_stacks, SHARD_COUNT, SHARD_STACK_SIZE);
+static K_THREAD_STACK_DEFINE(proc_stack, SHARD_PROC_STACK_SIZE);
+
+static struct k_thread shard_threads[SHARD_COUNT];
+static struct k_thread proc_thread;
+static struct shard shards[SHARD_COUNT];
+
+/* Owned by the processing thread */
+static struct telem_rx telem;
+
+/**
+ * Create and bind one UDP socket on port
+ */
+static int shard_socket(uint16_t port)
+{
+    struct sockaddr_in addr;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+
+#if SHARD_REUSEPORT
+    int optval = 1;
+
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)) < 0)
+    {
+        printk("SO_REUSEPORT failed: %d\n", -errno);
+    }
+#endif
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        int ret = -errno;
+
+        close(fd);
+        return ret;
+    }
+
+    return fd;
+}
+
+/**
+ * Receive thread - recvfrom() into pool buffers, queue them by pointer
+ */
+static void shard_thread(void *p1, void *p2, void *p3)
+{
+    struct shard *shard = p1;
+    struct udp_pkt *pkt;
+    socklen_t addr_len;
+    uint8_t discard;
+    int ret;
+
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1)
+    {
+        if (k_mem_slab_alloc(&pkt_slab, (void **)&pkt, K_NO_WAIT) != 0)
+        {
+            // Pool empty, processing is behind: a 1-byte read removes the
+            // whole datagram, so the stack gets its buffers back
+            if (recv(shard->fd, &discard, sizeof(discard), 0) >= 0)
+            {
+                shard->pool_drops++;
+            }
+            continue;
+        }
+
+        addr_len = sizeof(pkt->src);
+        ret = recvfrom(shard->fd, pkt->data, sizeof(pkt->data), 0,
+                       (struct sockaddr *)&pkt->src, &addr_len);
+        if (ret < 0)
+        {
+            k_mem_slab_free(&pkt_slab, pkt);
+            shard->errors++;
+            k_sleep(K_MSEC(10));
+            continue;
+        }
+
+        pkt->arrival_us = (int64_t)k_cyc_to_us_floor64(k_cycle_get_64());
+        pkt->len = ret;
+        pkt->shard = shard - shards;
+
+        shard->packets++;
+        shard->bytes += ret;
+        k_fifo_put(&pkt_fifo, pkt);
+    }
+}
+
+/**
+ * UDP datagrams dropped by the stack (no listener, no buffer, bad checksum)
+ */
+static uint32_t stack_udp_drops(void)
+{
+#if defined(CONFIG_NET_STATISTICS_UDP) && defined(CONFIG_NET_STATISTICS_USER_API)
+    struct net_stats_udp udp;
+
+    if (net_mgmt(NET_REQUEST_STATS_GET_UDP, NULL, &udp, sizeof(udp)) == 0)
+    {
+        return udp.drop;
+    }
+#endif
+
+    return 0;
+}
+
+/**
+ * Print packets/s per shard, pool use and drop counters
+ *
+ * @return Datagrams received by all shards in the interval
+ */
+static uint32_t shards_report(uint32_t elapsed_ms)
+{
+    uint32_t total = 0;
+    uint32_t pool_drops = 0;
+    uint32_t errors = 0;
+    uint32_t delta;
+    int i;
+
+    elapsed_ms = MAX(elapsed_ms, 1);
+
+    for (i = 0; i < SHARD_COUNT; i++)
+    {
+        total += shards[i].packets - shards[i].last_packets;
+        pool_drops += shards[i].pool_drops;
+        errors += shards[i].errors;
+    }
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    printk("Shards: %u pkt/s (", (uint32_t)((uint64_t)total * 1000 / elapsed_ms));
+    for (i = 0; i < SHARD_COUNT; i++)
+    {
+        delta = shards[i].packets - shards[i].last_packets;
+        shards[i].last_packets = shards[i].packets;
+        printk("%ss%d %u", i ? ", " : "", i, (uint32_t)((uint64_t)delta * 1000 / elapsed_ms));
+    }
+    printk("), pool %u/%d in use (peak %u)\n",
+           k_mem_slab_num_used_get(&pkt_slab), PKT_POOL_COUNT,
+           k_mem_slab_max_used_get(&pkt_slab));
+    printk("  %u pool drops, %u stack UDP drops, %u receive errors\n",
+           pool_drops, stack_udp_drops(), errors);
+
+    return total;
+}
+
+/**
+ * Processing thread - telemetry analysis of the queued buffers, reports
+ */
+static void proc_thread_fn(void *p1, void *p2, void *p3)
+{
+    int64_t next_report = k_uptime_get() + SHARD_REPORT_MS;
+    int64_t last_report = k_uptime_get();
+    struct udp_pkt *pkt;
+    int64_t now;
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    telem_rx_reset(&telem);
+
+    while (1)
+    {
+        now = k_uptime_get();
+        pkt = k_fifo_get(&pkt_fifo, K_MSEC(MAX(next_report - now, 0)));
+        if (pkt)
+        {
+            telem_rx_process(&telem, pkt->data, pkt->len, pkt->arrival_us);
+            k_mem_slab_free(&pkt_slab, pkt);
+        }
+
+        now = k_uptime_get();
+        if (now < next_report)
+        {
+            continue;
+        }
+        next_report += SHARD_REPORT_MS;
+
+        if (shards_report((uint32_t)(now - last_report)) > 0)
+        {
+            telem_rx_print(&telem, "Telemetry");
+        }
+        else if (telem.received > 0)
+        {
+            // Stream stopped: final report, then wait for the next stream
+            telem_rx_print(&telem, "Telemetry (final)");
+            telem_rx_reset(&telem);
+        }
+        last_report = now;
+    }
+}
+
+void udp_shards_run(uint16_t port)
+{
+    static char names[SHARD_COUNT][sizeof("udp_shard_00")];
+    int fd = -1;
+    int i;
+
+    printk("Sharded mode: %d receive threads on %s, pool of %d x %u-byte buffers\n",
+           SHARD_COUNT, SHARD_REUSEPORT ? "SO_REUSEPORT sockets" : "one shared socket",
+           PKT_POOL_COUNT, (uint32_t)sizeof(struct udp_pkt));
+
+    k_mem_slab_init(&pkt_slab, pkt_pool, sizeof(struct udp_pkt), PKT_POOL_COUNT);
+
+    for (i = 0; i < SHARD_COUNT; i++)
+    {
+        if (SHARD_REUSEPORT || fd < 0)
+        {
+            fd = shard_socket(port);
+            if (fd < 0)
+            {
+                printk("Failed to open socket for shard %d: %d\n", i, fd);
+                return;
+            }
+        }
+
+        memset(&shards[i], 0, sizeof(shards[i]));
+        shards[i].fd = fd;
+    }
+    printk("Listening on 0.0.0.0:%d\n", port);
+
+    k_thread_create(&proc_thread, proc_stack, K_THREAD_STACK_SIZEOF(proc_stack),
+                    proc_thread_fn, NULL, NULL, NULL, SHARD_PROC_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&proc_thread, "udp_proc");
+
+    for (i = 0; i < SHARD_COUNT; i++)
+    {
+        snprintk(names[i], sizeof(names[i]), "udp_shard_%d", i);
+
+        k_thread_create(&shard_threads[i], shard_stacks[i],
+                        K_THREAD_STACK_SIZEOF(shard_stacks[i]),
+                        shard_thread, &shards[i], NULL, NULL, SHARD_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&shard_threads[i], names[i]);
+    }
+
+    k_thread_join(&proc_thread, K_FOREVER);
+}
@@ -0,0 +1,46 @@
+/*
+ * Sharded multi-thread UDP receiver with a preallocated buffer pool
+ */
+
+#ifndef UDP_SHARDS_H
+#define UDP_SHARDS_H
+
+#include <stdint.h>
+
+/* Receive threads (shards) */
+#define SHARD_COUNT 2
+
+/* 0: every shard blocks in recvfrom() on one shared socket
+ * 1: one socket per shard, all bound to the same port with SO_REUSEPORT.
+ *    The stack picks the socket per datagram (the Linux host of native_sim
+ *    hashes the source address, so this needs several senders) */
+#define SHARD_REUSEPORT 0
+
+/* Receive threads run above the processing thread, so the socket queue is
+ * drained first and bursts wait in the buffer pool instead */
+#define SHARD_STACK_SIZE 1536
+#define SHARD_PRIORITY 5
+#define SHARD_PROC_STACK_SIZE 2048
+#define SHARD_PROC_PRIORITY 7
+
+/* Buffer pool: datagrams received but not processed yet. RAM used is
+ * PKT_POOL_COUNT * sizeof(struct udp_pkt), about 1.5 KB each */
+#define PKT_POOL_COUNT 32
+#define PKT_BUF_SIZE 1472
+
+/* Report interval of the processing thread */
+#define SHARD_REPORT_MS 1000
+
+/**
+ *  @brief Receive on SHARD_COUNT threads and process on one, never returns
+ *
+ *  Each shard takes a buffer from the pool, receives one datagram into it
+ *  and queues the buffer by pointer (no copy) to the processing thread,
+ *  which runs the telemetry analysis and gives the buffer back. When the
+ *  pool is empty a datagram is discarded and counted as a pool drop.
+ *
+ *  @param port Local UDP port, the sockets are created here
+ */
+void udp_shards_run(uint16_t port);
+
+#endif /* UDP_SHARDS_H */
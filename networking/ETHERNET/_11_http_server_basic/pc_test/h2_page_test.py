@@ -0,0 +1,512 @@
+#!/usr/bin/env python3
+"""
+HTTP/2 Page Load Test
+
+Loads every resource of the page, static and dynamic, the way a browser
+does on a cold load, and compares:
+
+    h1-serial       HTTP/1.1, one keep-alive connection, one request at a time
+    h1-parallel     HTTP/1.1, --h1-connections connections (browsers open 6)
+    h2 xN           HTTP/2 (h2c, prior knowledge), one connection, at most N
+                    streams in flight, for each N of --streams
+
+Every page load opens new connections, so the handshakes are counted. Page
+loads are --pause apart, which keeps /history under its rate limit (a 429
+would end the mode, see src/rate_limit.h). Then:
+
+Head-of-line test: GET /api/slow/{ms} blocks the handler for --slow-ms. The
+page is loaded again over HTTP/2 while the slow request is in flight, once
+on the same connection and once on another one. The delay it adds to the
+page shows whether a slow handler holds back only its own connection or
+the whole server (the server runs all clients in one thread). The slow
+endpoint is test only and off by default: build the firmware with
+CONFIG_APP_API_SLOW=y (west build ... -- -DCONFIG_APP_API_SLOW=y), otherwise
+the test is skipped.
+
+RAM per stream: the http_server_* gauges of /metrics give the size of a
+client slot and of an HTTP/2 stream slot. Every client slot holds a table of
+CONFIG_HTTP_SERVER_MAX_STREAMS streams, so the RAM of other stream and
+client limits is printed next to the page load times they buy.
+
+Usage:
+    python h2_page_test.py
+    python h2_page_test.py --ip 192.0.2.1                   # native_sim
+    python h2_page_test.py --repeat 20 --streams 1 2 4 8
+    python h2_page_test.py --slow-ms 500
+    python h2_page_test.py --csv page.csv --label "MAX_STREAMS=4"
+
+Needs the h2 package (pip install h2), the HTTP/1.1 client comes from
+load_test.py.
+"""
+
+import argparse
+import asyncio
+import csv
+import os
+import sys
+import time
+
+from load_test import ACCEPT_ENCODING, Http1Client, RequestError, percentile
+
+# Configuration
+SERVER_IP = "192.168.1.100"     # STM32 board IP
+SERVER_PORT = 8080
+PAGE = ["/", "/main.js", "/device-info", "/uptime", "/history", "/metrics",
+        "/api/system", "/api/cpu/load"]
+STREAMS = [1, 2, 4, 8]
+H1_CONNECTIONS = 4              # MAX_HTTP_CLIENTS in main.c
+REPEAT = 10
+SLOW_MS = 200
+SLOW_LEAD_SECONDS = 0.02        # Head start of the slow request
+TIMEOUT_SECONDS = 10
+PAUSE_SECONDS = 0.5             # Before each page load, keeps /history under its rate limit
+STREAM_LIMITS = [1, 2, 4, 8, 10, 16, 32]
+UNLIMITED = 2 ** 31
+
+
+# =============================================================================
+# HTTP/2, CONCURRENT STREAMS
+# =============================================================================
+
+class Http2Connection:
+    """One HTTP/2 connection, requests multiplexed on concurrent streams"""
+
+    def __init__(self, args):
+        import h2.config
+        import h2.connection
+        import h2.events
+
+        self.h2_config = h2.config
+        self.h2_connection = h2.connection
+        self.events = h2.events
+        self.args = args
+        self.reader = None
+        self.writer = None
+        self.conn = None
+        self.reader_task = None
+        self.settings = None
+        self.streams = {}           # stream id -> [future, status, body]
+
+    async def connect(self):
+        try:
+            self.reader, self.writer = await asyncio.wait_for(
+                asyncio.open_connection(self.args.ip, self.args.port), self.args.timeout)
+        except (OSError, asyncio.TimeoutError) as e:
+            raise RequestError("connect", str(e))
+
+        config = self.h2_config.H2Configuration(client_side=True, header_encoding="utf-8")
+        self.conn = self.h2_connection.H2Connection(config=config)
+        self.conn.initiate_connection()
+        self.settings = asyncio.Event()
+        self.reader_task = asyncio.ensure_future(self.read_loop())
+        await self.flush()
+
+        # The server's SETTINGS (stream limit) come first
+        try:
+            await asyncio.wait_for(self.settings.wait(), self.args.timeout)
+        except asyncio.TimeoutError:
+            raise RequestError("timeout", "no SETTINGS from the server")
+
+    def close(self):
+        if self.reader_task is not None:
+            self.reader_task.cancel()
+        if self.writer is not None:
+            self.writer.close()
+        self.fail_all(RequestError("closed", "connection closed"))
+
+    def max_streams(self):
+        """SETTINGS_MAX_CONCURRENT_STREAMS of the server, UNLIMITED if not sent"""
+        value = self.conn.remote_settings.max_concurrent_streams
+        return value if value < UNLIMITED else UNLIMITED
+
+    def fail_all(self, error):
+        for future, _, _ in self.streams.values():
+            if not future.done():
+                future.set_exception(error)
+        self.streams = {}
+
+    async def flush(self):
+        data = self.conn.data_to_send()
+        if data:
+            self.writer.write(data)
+            await self.writer.drain()
+
+    async def read_loop(self):
+        try:
+            while True:
+                data = await self.reader.read(65536)
+                if not data:
+                    self.fail_all(RequestError("closed", "connection closed"))
+                    return
+
+                for event in self.conn.receive_data(data):
+                    self.handle(event)
+                await self.flush()
+        except (ConnectionError, OSError) as e:
+            self.fail_all(RequestError("closed", str(e)))
+
+    def handle(self, event):
+        events = self.events
+        stream = self.streams.get(getattr(event, "stream_id", None))
+
+        if isinstance(event, events.RemoteSettingsChanged):
+            self.settings.set()
+        elif isinstance(event, events.ConnectionTerminated):
+            self.fail_all(RequestError("closed", f"GOAWAY ({event.error_code})"))
+        elif stream is None:
+            return
+        elif isinstance(event, events.ResponseReceived):
+            stream[1] = int(dict(event.headers).get(":status", "0"))
+        elif isinstance(event, events.DataReceived):
+            stream[2] += event.data
+            self.conn.acknowledge_received_data(event.flow_controlled_length, event.stream_id)
+        elif isinstance(event, events.StreamReset):
+            del self.streams[event.stream_id]
+            stream[0].set_exception(RequestError("closed", f"stream reset ({event.error_code})"))
+        elif isinstance(event, events.StreamEnded):
+            del self.streams[event.stream_id]
+            stream[0].set_result((stream[1], stream[2]))
+
+    async def request(self, path):
+        """GET path on a new stream, return (status, body)"""
+        stream_id = self.conn.get_next_available_stream_id()
+        future = asyncio.get_event_loop().create_future()
+        self.streams[stream_id] = [future, 0, b""]
+
+        self.conn.send_headers(stream_id, [
+            (":method", "GET"),
+            (":scheme", "http"),
+            (":authority", f"{self.args.ip}:{self.args.port}"),
+            (":path", path),
+            ("accept-encoding", ACCEPT_ENCODING),
+        ], end_stream=True)
+        await self.flush()
+
+        try:
+            return await asyncio.wait_for(future, self.args.timeout)
+        except asyncio.TimeoutError:
+            raise RequestError("timeout", path)
+
+
+# =============================================================================
+# PAGE LOADS
+# =============================================================================
+
+class PageLoad:
+    """Result of one page load"""
+
+    def __init__(self):
+        self.start = time.perf_counter()
+        self.done = {}              # path -> seconds since start
+        self.bytes = 0
+        self.errors = []
+
+    def finish(self, path, status, body):
+        self.done[path] = time.perf_counter() - self.start
+        self.bytes += len(body)
+        if not (200 <= status < 300 or status == 304):
+            self.errors.append(f"{path}: status {status}")
+
+    def elapsed(self):
+        return max(self.done.values()) if self.done else 0.0
+
+
+async def fetch_h1(client, path, page):
+    status, body = await client.request("GET", path, b"")
+    page.finish(path, status, body)
+
+
+async def load_h1(args, paths, connections):
+    """Page over HTTP/1.1 keep-alive connections, each fetches the next free path"""
+    page = PageLoad()
+    queue = list(paths)
+    clients = [Http1Client(args) for _ in range(connections)]
+
+    async def worker(client):
+        while queue:
+            await fetch_h1(client, queue.pop(0), page)
+
+    try:
+        await asyncio.gather(*(worker(c) for c in clients))
+    finally:
+        for client in clients:
+            client.close()
+    return page
+
+
+async def load_h2(args, paths, streams, conn=None):
+    """Page over one HTTP/2 connection, at most streams requests in flight"""
+    page = PageLoad()
+    own = conn is None
+    if own:
+        conn = Http2Connection(args)
+        await conn.connect()
+
+    limit = asyncio.Semaphore(min(streams, conn.max_streams()))
+
+    async def fetch(path):
+        async with limit:
+            status, body = await conn.request(path)
+            page.finish(path, status, body)
+
+    try:
+        await asyncio.gather(*(fetch(p) for p in paths))
+    finally:
+        if own:
+            conn.close()
+    return page
+
+
+async def run_mode(args, name, load, results):
+    """Repeat one mode, return the sorted page load times (seconds)"""
+    times = []
+    nbytes = 0
+    for _ in range(args.repeat):
+        await asyncio.sleep(args.pause)
+        try:
+            page = await load()
+        except RequestError as e:
+            print(f"[ERROR] {name}: {e}")
+            return None
+        if page.errors:
+            print(f"[ERROR] {name}: {', '.join(page.errors)}")
+            return None
+        times.append(page.elapsed())
+        nbytes = page.bytes
+
+    times.sort()
+    results.append((name, times, nbytes))
+    print(f"{name:<16}{percentile(times, 50) * 1000:>9.1f}{percentile(times, 90) * 1000:>9.1f}"
+          f"{times[0] * 1000:>9.1f}{nbytes:>10}")
+    return times
+
+
+# =============================================================================
+# HEAD-OF-LINE
+# =============================================================================
+
+async def slow_then_page(args, paths, same_connection):
+    """Start GET /api/slow/{ms}, then load the page"""
+    slow_path = f"/api/slow/{args.slow_ms}"
+    conn = Http2Connection(args)
+    await conn.connect()
+    other = None
+
+    try:
+        if same_connection:
+            slow = asyncio.ensure_future(conn.request(slow_path))
+        else:
+            other = Http1Client(args)
+            slow = asyncio.ensure_future(other.request("GET", slow_path, b""))
+
+        # Let the slow request reach the handler first
+        await asyncio.sleep(SLOW_LEAD_SECONDS)
+        page = await load_h2(args, paths, len(paths), conn)
+        await slow
+        return page
+    finally:
+        conn.close()
+        if other is not None:
+            other.close()
+
+
+async def slow_available(args):
+    """True if the firmware has GET /api/slow/{ms} (CONFIG_APP_API_SLOW)"""
+    conn = Http2Connection(args)
+    await conn.connect()
+    try:
+        status, _ = await conn.request("/api/slow/0")
+    finally:
+        conn.close()
+    return status == 200
+
+
+async def head_of_line(args, paths, baseline):
+    if not await slow_available(args):
+        print("[WARN] No GET /api/slow/{ms}, head-of-line test skipped (build the firmware")
+        print("       with CONFIG_APP_API_SLOW=y)")
+        return
+
+    print(f"[INFO] Head-of-line: page over HTTP/2 while GET /api/slow/{args.slow_ms} runs")
+    print(f"{'slow request on':<22}{'page ms':>9}{'added ms':>10}{'first done ms':>15}")
+    print(f"{'(none)':<22}{baseline * 1000:>9.1f}{0:>10.1f}")
+
+    added = {}
+    for same, name in ((True, "same h2 connection"), (False, "other connection")):
+        await asyncio.sleep(args.pause)
+        page = await slow_then_page(args, paths, same)
+        first = min(page.done.values())
+        added[same] = page.elapsed() - baseline
+        print(f"{name:<22}{page.elapsed() * 1000:>9.1f}{added[same] * 1000:>10.1f}"
+              f"{first * 1000:>15.1f}")
+
+    # Half of the slow delay added counts as blocked
+    blocked = args.slow_ms / 1000 / 2
+    if added[False] > blocked:
+        print("[INFO] The other connection waits too: the slow handler blocks the server")
+        print("       thread, every client waits (not an HTTP/2 effect)")
+    elif added[True] > blocked:
+        print("[INFO] Only the same connection waits: head-of-line blocking within the")
+        print("       HTTP/2 connection")
+    else:
+        print("[INFO] The slow handler does not hold back the page")
+
+
+# =============================================================================
+# RAM
+# =============================================================================
+
+async def read_metrics(args):
+    """http_server_* gauges and the peak stacks, from /metrics"""
+    client = Http1Client(args)
+    try:
+        status, body = await client.request("GET", "/metrics", b"")
+    finally:
+        client.close()
+    if status != 200:
+        raise RequestError("status", f"/metrics {status}")
+
+    values = {}
+    stacks = {}
+    for line in body.decode("utf-8", "replace").splitlines():
+        if line.startswith("#") or " " not in line:
+            continue
+        name, value = line.rsplit(" ", 1)
+        if name.startswith("http_server_"):
+            values[name] = int(float(value))
+        elif name.startswith("thread_stack_used_bytes{"):
+            stacks[name.split('"')[1]] = int(float(value))
+    return values, stacks
+
+
+def print_ram(values, stacks, page_streams):
+    clients = values["http_server_max_clients"]
+    streams = values["http_server_max_streams"]
+    client = values["http_server_client_bytes"]
+    stream = values["http_server_stream_bytes"]
+    base = client - streams * stream
+
+    print(f"[INFO] Server RAM: {clients} client slots x {client} bytes = {clients * client} bytes")
+    print(f"       per client: {base} bytes (receive buffer "
+          f"{values.get('http_server_client_buffer_bytes', '?')}) + {streams} streams x "
+          f"{stream} bytes")
+    print(f"{'MAX_STREAMS':>12}{'per client':>12}{'x' + str(clients) + ' clients':>14}"
+          f"{'vs now':>9}")
+    for limit in sorted(set(STREAM_LIMITS + [streams])):
+        per_client = base + limit * stream
+        note = "  <- current" if limit == streams else ""
+        if limit == page_streams:
+            note += "  <- page resources"
+        print(f"{limit:>12}{per_client:>12}{per_client * clients:>14}"
+              f"{(per_client - client) * clients:>+9}{note}")
+
+    if stacks:
+        name, used = max(stacks.items(), key=lambda item: item[1])
+        print(f"[INFO] Largest peak stack after the test: {name} {used} bytes")
+
+
+# =============================================================================
+# MAIN
+# =============================================================================
+
+def write_csv(args, rows):
+    new = not os.path.exists(args.csv)
+    with open(args.csv, "a", newline="") as f:
+        writer = csv.writer(f)
+        if new:
+            writer.writerow(["label", "mode", "p50_ms", "p90_ms", "min_ms", "bytes"])
+        for name, times, nbytes in rows:
+            writer.writerow([args.label, name, f"{percentile(times, 50) * 1000:.1f}",
+                             f"{percentile(times, 90) * 1000:.1f}", f"{times[0] * 1000:.1f}",
+                             nbytes])
+
+
+async def run(args):
+    paths = args.paths
+    results = []
+
+    probe = Http2Connection(args)
+    await probe.connect()
+    server_streams = probe.max_streams()
+    probe.close()
+
+    advertised = "not sent" if server_streams == UNLIMITED else server_streams
+    print(f"[INFO] Page load of {len(paths)} resources from http://{args.ip}:{args.port}, "
+          f"{args.repeat} loads per mode")
+    print(f"[INFO] Server SETTINGS_MAX_CONCURRENT_STREAMS: {advertised}")
+    print("-" * 70)
+    print(f"{'mode':<16}{'p50 ms':>9}{'p90 ms':>9}{'min ms':>9}{'bytes':>10}")
+
+    await run_mode(args, "h1-serial", lambda: load_h1(args, paths, 1), results)
+    await run_mode(args, f"h1-parallel x{args.h1_connections}",
+                   lambda: load_h1(args, paths, args.h1_connections), results)
+
+    h2_times = {}
+    for streams in args.streams:
+        times = await run_mode(args, f"h2 x{streams}",
+                               lambda s=streams: load_h2(args, paths, s), results)
+        if times:
+            h2_times[streams] = percentile(times, 50)
+    print("-" * 70)
+
+    if h2_times:
+        best = min(h2_times.values())
+        enough = min(s for s, t in h2_times.items() if t <= best * 1.1)
+        print(f"[INFO] HTTP/2: {enough} streams reach the best page load within 10% "
+              f"({best * 1000:.1f} ms)")
+
+        if args.slow_ms > 0:
+            print("-" * 70)
+            await head_of_line(args, paths, best)
+
+    print("-" * 70)
+    try:
+        values, stacks = await read_metrics(args)
+        print_ram(values, stacks, len(paths))
+    except (RequestError, KeyError) as e:
+        print(f"[WARN] No server RAM figures from /metrics ({e})")
+    print("-" * 70)
+
+    if args.csv:
+        write_csv(args, results)
+        print(f"[INFO] Results appended to {args.csv}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP/2 page load, stream RAM and head-of-line test")
+    parser.add_argument("--ip", default=SERVER_IP, help="Board IP address")
+    parser.add_argument("--port", type=int, default=SERVER_PORT, help="HTTP port")
+    parser.add_argument("--paths", nargs="+", default=PAGE, help="Resources of the page")
+    parser.add_argument("--repeat", type=int, default=REPEAT, help="Page loads per mode")
+    parser.add_argument("--streams", type=int, nargs="+", default=STREAMS,
+                        help="HTTP/2 streams in flight to compare")
+    parser.add_argument("--h1-connections", type=int, default=H1_CONNECTIONS,
+                        help="Connections of the h1-parallel mode")
+    parser.add_argument("--slow-ms", type=int, default=SLOW_MS,
+                        help="Delay of the slow handler, 0 to skip the head-of-line test")
+    parser.add_argument("--timeout", type=float, default=TIMEOUT_SECONDS,
+                        help="Seconds per request")
+    parser.add_argument("--pause", type=float, default=PAUSE_SECONDS,
+                        help="Seconds before each page load (rate limits, src/rate_limit.h)")
+    parser.add_argument("--csv", help="Append the page load times to this CSV file")
+    parser.add_argument("--label", default="", help="Label of this run in the CSV")
+    args = parser.parse_args()
+    args.no_keep_alive = False      # Http1Client option
+
+    try:
+        import h2  # noqa: F401
+    except ImportError:
+        print("[ERROR] HTTP/2 needs the h2 package: pip install h2")
+        sys.exit(1)
+
+    try:
+        asyncio.run(run(args))
+    except RequestError as e:
+        print(f"[ERROR] {e}")
+        sys.exit(1)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,601 @@
+#!/usr/bin/env python3
+"""
+HTTP Server Load Test
+
+Runs N concurrent clients against the board's endpoints for a fixed time
+and reports requests per second, latency percentiles and error rates, per
+path and in total. Run it again after changing CONFIG_HTTP_SERVER_MAX_CLIENTS,
+MAX_HTTP_CLIENTS or the buffer counts in prj.conf and compare.
+
+Usage:
+    python load_test.py                                 # board, keep-alive, 4 clients
+    python load_test.py --ip 127.0.0.1                  # native_sim (boards/native_sim.conf)
+    python load_test.py --concurrency 8 --duration 30
+    python load_test.py --no-keep-alive                 # new connection per request
+    python load_test.py --http2                         # h2c prior knowledge (pip install h2)
+    python load_test.py --csv results.csv --label "MAX_CLIENTS=8"
+    python load_test.py --rate 5 --abusers 4 --idle 2  # rate limits under abuse
+
+Each client sends the same fixed request sequence: the paths round-robin,
+client i starting at path i, and POST /echo with --echo-size bytes that
+must come back unchanged. Requests completed during --warmup are not
+counted, so every run measures the same steady state.
+
+Modes:
+    keep-alive      HTTP/1.1, one connection per client, reused
+    close           HTTP/1.1, "Connection: close", a new connection per
+                    request (latency includes the TCP handshake)
+    h2              HTTP/2 over cleartext (prior knowledge), one connection
+                    per client, one request at a time
+
+Errors:
+    connect         connection refused or timed out (all slots busy)
+    timeout         no complete response within --timeout
+    closed          connection closed or reset before the response ended
+    limited         429 Too Many Requests (rate limit, src/rate_limit.h)
+    status          other status than 2xx/304
+    mismatch        /echo body differs from the one sent
+
+Abuse (admission control test):
+    --rate          paces the measured clients (requests per second each),
+                    like dashboards polling the board
+    --abusers       extra clients requesting --abuse-paths without pause,
+                    reported apart. With --abuse-source (a second address
+                    of this PC) they come from another IP, as a separate
+                    misbehaving dashboard would
+    --idle          extra keep-alive connections that send one request and
+                    then stay open without sending anything, holding slots
+"""
+
+import argparse
+import asyncio
+import csv
+import math
+import os
+import sys
+import time
+
+# Configuration
+SERVER_IP = "192.168.1.100"     # STM32 board IP
+SERVER_PORT = 8080
+PATHS = ["/", "/main.js", "/device-info", "/echo"]
+CONCURRENCY = 4
+DURATION_SECONDS = 10
+WARMUP_SECONDS = 2
+TIMEOUT_SECONDS = 5
+ECHO_SIZE = 64
+ACCEPT_ENCODING = "gzip, deflate, br"
+
+ERRORS = ["connect", "timeout", "closed", "limited", "status", "mismatch"]
+
+
+class RequestError(Exception):
+    """A failed request, kind is one of ERRORS"""
+
+    def __init__(self, kind, detail=""):
+        super().__init__(f"{kind} {detail}".strip())
+        self.kind = kind
+
+
+class PathStats:
+    """Latencies and errors of one path"""
+
+    def __init__(self):
+        self.latencies = []         # Seconds, successful requests
+        self.errors = {kind: 0 for kind in ERRORS}
+
+    def error_count(self):
+        return sum(self.errors.values())
+
+
+def percentile(values, p):
+    """Nearest-rank percentile of sorted values"""
+    if not values:
+        return 0.0
+    rank = max(0, min(len(values) - 1, math.ceil(p / 100.0 * len(values)) - 1))
+    return values[rank]
+
+
+def echo_body(size):
+    """Fixed, recognizable /echo payload"""
+    pattern = b"0123456789abcdefghijklmnopqrstuvwxyz"
+    return (pattern * (size // len(pattern) + 1))[:size]
+
+
+def open_connection(args):
+    """TCP connection to the board, from args.source when set"""
+    local_addr = (args.source, 0) if getattr(args, "source", None) else None
+    return asyncio.open_connection(args.ip, args.port, local_addr=local_addr)
+
+
+# =============================================================================
+# HTTP/1.1
+# =============================================================================
+
+class Http1Client:
+    """One HTTP/1.1 client, keeps its connection with keep-alive"""
+
+    def __init__(self, args):
+        self.args = args
+        self.reader = None
+        self.writer = None
+        self.connections = 0
+
+    async def connect(self):
+        try:
+            self.reader, self.writer = await asyncio.wait_for(
+                open_connection(self.args), self.args.timeout)
+        except (OSError, asyncio.TimeoutError) as e:
+            raise RequestError("connect", str(e))
+        self.connections += 1
+
+    def close(self):
+        if self.writer is not None:
+            self.writer.close()
+        self.reader = None
+        self.writer = None
+
+    async def read_line(self):
+        line = await self.reader.readline()
+        if not line.endswith(b"\r\n"):
+            raise RequestError("closed", "in headers")
+        return line[:-2]
+
+    async def read_exactly(self, n):
+        try:
+            return await self.reader.readexactly(n)
+        except asyncio.IncompleteReadError:
+            raise RequestError("closed", "in body")
+
+    async def read_response(self):
+        """Return (status, body, server keeps the connection)"""
+        status_line = await self.read_line()
+        try:
+            status = int(status_line.split()[1])
+        except (IndexError, ValueError):
+            raise RequestError("closed", f"bad status line {status_line!r}")
+
+        headers = {}
+        while True:
+            line = await self.read_line()
+            if not line:
+                break
+            name, _, value = line.decode("latin-1").partition(":")
+            headers[name.strip().lower()] = value.strip()
+
+        keep = headers.get("connection", "").lower() != "close"
+
+        if status in (204, 304):
+            body = b""
+        elif headers.get("transfer-encoding", "").lower() == "chunked":
+            body = b""
+            while True:
+                size = int((await self.read_line()).split(b";")[0], 16)
+                chunk = await self.read_exactly(size + 2)
+                body += chunk[:size]
+                if size == 0:
+                    break
+        elif "content-length" in headers:
+            body = await self.read_exactly(int(headers["content-length"]))
+        else:
+            body = await self.reader.read()
+            keep = False
+
+        return status, body, keep
+
+    async def request(self, method, path, body):
+        keep_alive = not self.args.no_keep_alive
+
+        if self.writer is None:
+            await self.connect()
+
+        request = (f"{method} {path} HTTP/1.1\r\n"
+                   f"Host: {self.args.ip}:{self.args.port}\r\n"
+                   f"Accept-Encoding: {ACCEPT_ENCODING}\r\n")
+        if body:
+            request += f"Content-Type: application/octet-stream\r\nContent-Length: {len(body)}\r\n"
+        if not keep_alive:
+            request += "Connection: close\r\n"
+        request = request.encode() + b"\r\n" + body
+
+        try:
+            self.writer.write(request)
+            await self.writer.drain()
+            status, rsp_body, keep = await self.read_response()
+        except (ConnectionError, OSError) as e:
+            self.close()
+            raise RequestError("closed", str(e))
+        except RequestError:
+            self.close()
+            raise
+
+        if not (keep and keep_alive):
+            self.close()
+
+        return status, rsp_body
+
+
+# =============================================================================
+# HTTP/2 (h2c, prior knowledge)
+# =============================================================================
+
+class Http2Client:
+    """One HTTP/2 client: one connection, one stream at a time"""
+
+    def __init__(self, args):
+        import h2.config
+        import h2.connection
+        import h2.events
+
+        self.h2_config = h2.config
+        self.h2_connection = h2.connection
+        self.events = h2.events
+        self.args = args
+        self.reader = None
+        self.writer = None
+        self.conn = None
+        self.connections = 0
+
+    async def connect(self):
+        try:
+            self.reader, self.writer = await asyncio.wait_for(
+                open_connection(self.args), self.args.timeout)
+        except (OSError, asyncio.TimeoutError) as e:
+            raise RequestError("connect", str(e))
+        self.connections += 1
+
+        config = self.h2_config.H2Configuration(client_side=True, header_encoding="utf-8")
+        self.conn = self.h2_connection.H2Connection(config=config)
+        self.conn.initiate_connection()
+        await self.flush()
+
+    def close(self):
+        if self.writer is not None:
+            self.writer.close()
+        self.reader = None
+        self.writer = None
+        self.conn = None
+
+    async def flush(self):
+        data = self.conn.data_to_send()
+        if data:
+            self.writer.write(data)
+            await self.writer.drain()
+
+    async def request(self, method, path, body):
+        if self.conn is None:
+            await self.connect()
+
+        stream_id = self.conn.get_next_available_stream_id()
+        headers = [
+            (":method", method),
+            (":scheme", "http"),
+            (":authority", f"{self.args.ip}:{self.args.port}"),
+            (":path", path),
+            ("accept-encoding", ACCEPT_ENCODING),
+        ]
+        if body:
+            headers.append(("content-length", str(len(body))))
+
+        status = 0
+        rsp_body = b""
+
+        try:
+            self.conn.send_headers(stream_id, headers, end_stream=not body)
+            if body:
+                self.conn.send_data(stream_id, body, end_stream=True)
+            await self.flush()
+
+            while True:
+                data = await self.reader.read(65536)
+                if not data:
+                    raise RequestError("closed", "connection closed")
+
+                for event in self.conn.receive_data(data):
+                    if isinstance(event, self.events.ResponseReceived) and event.stream_id == stream_id:
+                        status = int(dict(event.headers).get(":status", "0"))
+                    elif isinstance(event, self.events.DataReceived) and event.stream_id == stream_id:
+                        rsp_body += event.data
+                        self.conn.acknowledge_received_data(event.flow_controlled_length, stream_id)
+                    elif isinstance(event, self.events.StreamReset) and event.stream_id == stream_id:
+                        raise RequestError("closed", f"stream reset ({event.error_code})")
+                    elif isinstance(event, self.events.ConnectionTerminated):
+                        raise RequestError("closed", f"GOAWAY ({event.error_code})")
+                    elif isinstance(event, self.events.StreamEnded) and event.stream_id == stream_id:
+                        await self.flush()
+                        return status, rsp_body
+
+                await self.flush()
+        except (ConnectionError, OSError) as e:
+            self.close()
+            raise RequestError("closed", str(e))
+        except RequestError:
+            self.close()
+            raise
+
+
+# =============================================================================
+# LOAD GENERATION
+# =============================================================================
+
+async def run_client(args, index, stats, state):
+    """Send the fixed request sequence until the test ends"""
+    client = Http2Client(args) if args.http2 else Http1Client(args)
+    echo = echo_body(args.echo_size)
+    n = index
+
+    next_time = time.perf_counter()
+
+    while not state["stop"]:
+        if args.rate:
+            # Paced client: one request every 1/rate s, not one after the other
+            next_time += 1 / args.rate
+            await asyncio.sleep(max(next_time - time.perf_counter(), 0))
+            if state["stop"]:
+                break
+
+        path = args.paths[n % len(args.paths)]
+        n += 1
+        body = echo if path == "/echo" else b""
+        method = "POST" if body else "GET"
+
+        start = time.perf_counter()
+        kind = None
+        try:
+            status, rsp_body = await asyncio.wait_for(client.request(method, path, body),
+                                                      args.timeout)
+            if status == 429:
+                kind = "limited"
+            elif not (200 <= status < 300 or status == 304):
+                kind = "status"
+            elif body and rsp_body != body:
+                kind = "mismatch"
+        except asyncio.TimeoutError:
+            client.close()
+            kind = "timeout"
+        except RequestError as e:
+            kind = e.kind
+        latency = time.perf_counter() - start
+
+        if not state["counting"] or state["stop"]:
+            continue
+        if kind is None:
+            stats[path].latencies.append(latency)
+        else:
+            stats[path].errors[kind] += 1
+            if kind == "connect":
+                # Do not spin on a refused connection
+                await asyncio.sleep(0.05)
+
+    client.close()
+    state["connections"] += client.connections
+
+
+async def run_abuser(args, index, abuse, state):
+    """Request --abuse-paths without pause, count answers and 429s"""
+    abuser_args = argparse.Namespace(**vars(args))
+    abuser_args.source = args.abuse_source
+    client = Http2Client(abuser_args) if args.http2 else Http1Client(abuser_args)
+    n = index
+
+    while not state["stop"]:
+        path = args.abuse_paths[n % len(args.abuse_paths)]
+        n += 1
+        try:
+            status, _ = await asyncio.wait_for(client.request("GET", path, b""), args.timeout)
+            kind = "limited" if status == 429 else "ok"
+        except asyncio.TimeoutError:
+            client.close()
+            kind = "error"
+        except RequestError as e:
+            kind = "error"
+            if e.kind == "connect":
+                await asyncio.sleep(0.05)
+        if state["counting"] and not state["stop"]:
+            abuse[kind] += 1
+
+    client.close()
+
+
+async def run_idle(args, idle, state):
+    """One request, then keep the connection open and silent until the end"""
+    try:
+        reader, writer = await asyncio.wait_for(open_connection(args), args.timeout)
+    except (OSError, asyncio.TimeoutError):
+        return
+    idle["opened"] += 1
+
+    writer.write(f"GET /uptime HTTP/1.1\r\nHost: {args.ip}:{args.port}\r\n\r\n".encode())
+    try:
+        await writer.drain()
+        while not state["stop"]:
+            try:
+                # Only the response, then nothing until the board closes it
+                data = await asyncio.wait_for(reader.read(4096), 0.2)
+            except asyncio.TimeoutError:
+                continue
+            if not data:
+                idle["closed"] += 1
+                break
+    except (ConnectionError, OSError):
+        idle["closed"] += 1
+    writer.close()
+
+
+async def run_test(args):
+    stats = {path: PathStats() for path in args.paths}
+    state = {"stop": False, "counting": args.warmup == 0, "connections": 0}
+    abuse = {"ok": 0, "limited": 0, "error": 0}
+    idle = {"opened": 0, "closed": 0}
+
+    # Idle connections first, so they hold slots when the others arrive
+    others = [asyncio.create_task(run_idle(args, idle, state)) for _ in range(args.idle)]
+    if args.idle:
+        await asyncio.sleep(0.5)
+    others += [asyncio.create_task(run_abuser(args, i, abuse, state))
+               for i in range(args.abusers)]
+
+    clients = [asyncio.create_task(run_client(args, i, stats, state))
+               for i in range(args.concurrency)]
+
+    if args.warmup > 0:
+        await asyncio.sleep(args.warmup)
+        state["counting"] = True
+    start = time.perf_counter()
+    await asyncio.sleep(args.duration)
+    state["stop"] = True
+    elapsed = time.perf_counter() - start
+
+    await asyncio.gather(*clients, *others)
+    state["abuse"] = abuse
+    state["idle"] = idle
+    return stats, elapsed, state
+
+
+def mode_name(args):
+    if args.http2:
+        return "h2"
+    return "close" if args.no_keep_alive else "keep-alive"
+
+
+def print_report(args, stats, elapsed, state):
+    print("-" * 86)
+    print(f"{'path':<14}{'requests':>9}{'errors':>8}{'err %':>7}{'req/s':>9}"
+          f"{'p50 ms':>9}{'p90 ms':>9}{'p99 ms':>9}{'max ms':>9}")
+
+    all_latencies = []
+    total_errors = 0
+    rows = []
+
+    for path in args.paths + ["total"]:
+        if path == "total":
+            latencies = sorted(all_latencies)
+            errors = total_errors
+        else:
+            latencies = sorted(stats[path].latencies)
+            errors = stats[path].error_count()
+            all_latencies.extend(latencies)
+            total_errors += errors
+
+        requests = len(latencies) + errors
+        row = {
+            "path": path,
+            "requests": requests,
+            "errors": errors,
+            "error_pct": 100.0 * errors / requests if requests else 0.0,
+            "req_s": len(latencies) / elapsed,
+            "p50_ms": percentile(latencies, 50) * 1000,
+            "p90_ms": percentile(latencies, 90) * 1000,
+            "p99_ms": percentile(latencies, 99) * 1000,
+            "max_ms": (latencies[-1] if latencies else 0.0) * 1000,
+        }
+        rows.append(row)
+
+        if path == "total":
+            print("-" * 86)
+        print(f"{path:<14}{row['requests']:>9}{row['errors']:>8}{row['error_pct']:>7.1f}"
+              f"{row['req_s']:>9.1f}{row['p50_ms']:>9.1f}{row['p90_ms']:>9.1f}"
+              f"{row['p99_ms']:>9.1f}{row['max_ms']:>9.1f}")
+
+    print("-" * 86)
+    kinds = {kind: sum(stats[path].errors[kind] for path in args.paths) for kind in ERRORS}
+    print("[INFO] Errors: " + ", ".join(f"{kind} {count}" for kind, count in kinds.items()))
+    print(f"[INFO] Connections opened: {state['connections']}")
+
+    if args.abusers:
+        abuse = state["abuse"]
+        answered = abuse["ok"] + abuse["limited"]
+        print(f"[INFO] Abusers: {args.abusers} on {' '.join(args.abuse_paths)}, "
+              f"{abuse['ok'] / elapsed:.1f} req/s served, {abuse['limited'] / elapsed:.1f} req/s "
+              f"limited ({100.0 * abuse['limited'] / answered if answered else 0:.0f}% 429), "
+              f"{abuse['error']} errors")
+    if args.idle:
+        idle = state["idle"]
+        print(f"[INFO] Idle connections: {idle['opened']} opened, "
+              f"{idle['closed']} closed by the board to free their slot")
+
+    return rows
+
+
+def write_csv(args, rows):
+    """Append the run to --csv, one line per path, for comparing configurations"""
+    new_file = not os.path.exists(args.csv)
+    with open(args.csv, "a", newline="") as f:
+        writer = csv.writer(f)
+        if new_file:
+            writer.writerow(["label", "mode", "concurrency", "duration_s", "path", "requests",
+                             "errors", "error_pct", "req_s", "p50_ms", "p90_ms", "p99_ms",
+                             "max_ms"])
+        for row in rows:
+            writer.writerow([args.label, mode_name(args), args.concurrency, args.duration,
+                             row["path"], row["requests"], row["errors"],
+                             f"{row['error_pct']:.2f}", f"{row['req_s']:.1f}",
+                             f"{row['p50_ms']:.2f}", f"{row['p90_ms']:.2f}",
+                             f"{row['p99_ms']:.2f}", f"{row['max_ms']:.2f}"])
+    print(f"[INFO] Results appended to {args.csv}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP server load test: req/s, latency, errors")
+    parser.add_argument("--ip", default=SERVER_IP, help="Board IP address")
+    parser.add_argument("--port", type=int, default=SERVER_PORT, help="HTTP port")
+    parser.add_argument("--paths", nargs="+", default=PATHS, help="Resources, round-robin")
+    parser.add_argument("--concurrency", "-c", type=int, default=CONCURRENCY,
+                        help="Concurrent clients")
+    parser.add_argument("--duration", "-d", type=float, default=DURATION_SECONDS,
+                        help="Measured seconds")
+    parser.add_argument("--warmup", type=float, default=WARMUP_SECONDS,
+                        help="Seconds run before measuring")
+    parser.add_argument("--timeout", type=float, default=TIMEOUT_SECONDS,
+                        help="Seconds per request")
+    parser.add_argument("--echo-size", type=int, default=ECHO_SIZE, help="POST /echo body bytes")
+    mode = parser.add_mutually_exclusive_group()
+    mode.add_argument("--no-keep-alive", action="store_true",
+                      help="New connection per request")
+    mode.add_argument("--http2", action="store_true", help="HTTP/2, prior knowledge")
+    parser.add_argument("--rate", type=float, default=0,
+                        help="Requests per second of each client, 0 = back to back")
+    parser.add_argument("--abusers", type=int, default=0,
+                        help="Extra clients requesting --abuse-paths without pause")
+    parser.add_argument("--abuse-paths", nargs="+", default=["/history"],
+                        help="Resources of the abusers")
+    parser.add_argument("--abuse-source", help="Local address of the abusers (another IP)")
+    parser.add_argument("--idle", type=int, default=0,
+                        help="Extra keep-alive connections left idle after one request")
+    parser.add_argument("--csv", help="Append the results to this CSV file")
+    parser.add_argument("--label", default="", help="Configuration name for the CSV")
+    args = parser.parse_args()
+
+    if args.http2:
+        try:
+            import h2  # noqa: F401
+        except ImportError:
+            print("[ERROR] --http2 needs the h2 module (pip install h2)")
+            sys.exit(1)
+
+    print(f"[INFO] Load test against http://{args.ip}:{args.port}")
+    print(f"[INFO] Mode {mode_name(args)}, {args.concurrency} clients, "
+          f"{args.warmup:g} s warmup + {args.duration:g} s, paths {' '.join(args.paths)}")
+    if args.rate or args.abusers or args.idle:
+        print(f"[INFO] Clients at {args.rate:g} req/s each (0 = back to back), "
+              f"{args.abusers} abusers, {args.idle} idle connections")
+
+    try:
+        stats, elapsed, state = asyncio.run(run_test(args))
+    except KeyboardInterrupt:
+        sys.exit(1)
+
+    rows = print_report(args, stats, elapsed, state)
+    if args.csv:
+        write_csv(args, rows)
+
+    total = rows[-1]
+    if total["requests"] == 0 or total["errors"] == total["requests"]:
+        print("[FAIL] No successful request")
+        sys.exit(1)
+    print(f"[OK] {total['req_s']:.1f} req/s, p99 {total['p99_ms']:.1f} ms, "
+          f"{total['error_pct']:.1f}% errors")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+Upload Test
+
+Uploads bodies of several sizes to POST /upload, checks the CRC32 the board
+computed while streaming against the local one, and reports the upload
+throughput. Then checks the size limit: a Content-Length over the limit
+must get 413 before the body is sent, a chunked body over the limit must
+get 413 once it passes the limit.
+
+Usage:
+    python upload_test.py
+    python upload_test.py --ip 192.0.2.1                    # native_sim
+    python upload_test.py --sizes 1024 65536 1048576 --max-size 1048576
+    python upload_test.py --chunked                         # no Content-Length
+
+Columns: mode (length or chunked), body bytes, status, upload time seen by
+the PC, PC throughput, the board's fragment count and throughput, and the
+CRC check.
+"""
+
+import argparse
+import json
+import os
+import socket
+import sys
+import time
+import zlib
+
+# Configuration
+SERVER_IP = "192.168.1.100"     # STM32 board IP
+SERVER_PORT = 8080
+PATH = "/upload"
+SIZES = [1024, 16384, 262144, 1048576]
+MAX_SIZE = 1024 * 1024          # UPLOAD_MAX_SIZE in main.c
+TIMEOUT_SECONDS = 30
+SEND_BLOCK = 4096               # Bytes per send() and per chunk
+
+
+def read_response(sock):
+    """Read one response, return (status, body)"""
+    buf = b""
+    while b"\r\n\r\n" not in buf:
+        data = sock.recv(4096)
+        if not data:
+            raise ConnectionError("connection closed before the response")
+        buf += data
+
+    head, buf = buf.split(b"\r\n\r\n", 1)
+    lines = head.decode("latin-1").split("\r\n")
+    status = int(lines[0].split()[1])
+    headers = {}
+    for line in lines[1:]:
+        name, _, value = line.partition(":")
+        headers[name.strip().lower()] = value.strip()
+
+    if headers.get("transfer-encoding", "").lower() == "chunked":
+        body = b""
+        while True:
+            while b"\r\n" not in buf:
+                buf += sock.recv(4096)
+            line, buf = buf.split(b"\r\n", 1)
+            size = int(line.split(b";")[0], 16)
+            while len(buf) < size + 2:
+                buf += sock.recv(4096)
+            body += buf[:size]
+            buf = buf[size + 2:]
+            if size == 0:
+                return status, body
+
+    length = int(headers.get("content-length", "0"))
+    while len(buf) < length:
+        buf += sock.recv(4096)
+    return status, buf[:length]
+
+
+def response_ready(sock):
+    """True when the server has already answered (early 413)"""
+    sock.setblocking(False)
+    try:
+        return len(sock.recv(1, socket.MSG_PEEK)) > 0
+    except BlockingIOError:
+        return False
+    finally:
+        sock.setblocking(True)
+
+
+def upload(args, body, chunked):
+    """POST body, return (status, json body, seconds, bytes sent before the answer)"""
+    request = f"POST {PATH} HTTP/1.1\r\nHost: {args.ip}:{args.port}\r\n"
+    request += "Content-Type: application/octet-stream\r\n"
+    if chunked:
+        request += "Transfer-Encoding: chunked\r\n"
+    else:
+        request += f"Content-Length: {len(body)}\r\n"
+    request += "Connection: close\r\n\r\n"
+
+    sent = 0
+    with socket.create_connection((args.ip, args.port), timeout=TIMEOUT_SECONDS) as sock:
+        start = time.perf_counter()
+        sock.sendall(request.encode())
+
+        try:
+            while sent < len(body):
+                # Stop sending once the board has answered (413)
+                if response_ready(sock):
+                    break
+                block = body[sent:sent + SEND_BLOCK]
+                if chunked:
+                    sock.sendall(b"%x\r\n" % len(block) + block + b"\r\n")
+                else:
+                    sock.sendall(block)
+                sent += len(block)
+            else:
+                if chunked:
+                    sock.sendall(b"0\r\n\r\n")
+        except (BrokenPipeError, ConnectionResetError):
+            # The board closed after its answer, read it below
+            pass
+
+        status, rsp = read_response(sock)
+        elapsed = time.perf_counter() - start
+
+    try:
+        result = json.loads(rsp) if rsp else {}
+    except ValueError:
+        result = {"raw": rsp.decode("latin-1")}
+    return status, result, elapsed, sent
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Streamed upload test: CRC32, throughput, limits")
+    parser.add_argument("--ip", default=SERVER_IP, help="Board IP address")
+    parser.add_argument("--port", type=int, default=SERVER_PORT, help="HTTP port")
+    parser.add_argument("--sizes", type=int, nargs="+", default=SIZES, help="Body sizes, bytes")
+    parser.add_argument("--max-size", type=int, default=MAX_SIZE,
+                        help="Upload limit of the board (UPLOAD_MAX_SIZE)")
+    parser.add_argument("--chunked", action="store_true",
+                        help="Send chunked bodies (no Content-Length)")
+    args = parser.parse_args()
+
+    mode = "chunked" if args.chunked else "length"
+    print(f"[INFO] Upload test against http://{args.ip}:{args.port}{PATH}")
+    print("-" * 80)
+    print(f"{'mode':<8}{'bytes':>9}{'status':>7}{'ms':>8}{'PC KiB/s':>10}"
+          f"{'frags':>7}{'board KiB/s':>12}  {'crc32':<10}{'check':<5}")
+
+    failures = 0
+    try:
+        for size in args.sizes:
+            body = os.urandom(size)
+            status, result, elapsed, _ = upload(args, body, args.chunked)
+
+            expected = f"{zlib.crc32(body) & 0xffffffff:08x}"
+            sink = result.get("sink") or {}
+            crc = sink.get("crc32", "-")
+            if size > args.max_size:
+                check = "ok" if status == 413 else "FAIL"
+            else:
+                ok = status == 200 and crc == expected and result.get("bytes") == size
+                check = "ok" if ok else "FAIL"
+            if check == "FAIL":
+                failures += 1
+
+            kib_s = size / 1024 / elapsed if elapsed > 0 else 0
+            print(f"{mode:<8}{size:>9}{status:>7}{elapsed * 1000:>8.0f}{kib_s:>10.0f}"
+                  f"{result.get('fragments', '-'):>7}{result.get('kib_s', '-'):>12}"
+                  f"  {crc:<10}{check:<5}")
+
+        print("-" * 80)
+
+        # Limits: announced too large (early 413), then chunked past the limit
+        over = args.max_size + 1
+        status, result, elapsed, sent = upload(args, b"\0" * over, False)
+        early = sent < over
+        print(f"[INFO] Content-Length {over}: {status} after {elapsed * 1000:.0f} ms, "
+              f"{sent} of {over} bytes sent ({'early' if early else 'after the body'})")
+        if status != 413:
+            failures += 1
+
+        status, result, elapsed, sent = upload(args, b"\0" * over, True)
+        print(f"[INFO] Chunked {over}: {status} after {elapsed * 1000:.0f} ms, {sent} bytes sent")
+        if status != 413:
+            failures += 1
+    except (OSError, ConnectionError, ValueError) as e:
+        print(f"[ERROR] {e}")
+        sys.exit(1)
+
+    if failures:
+        print(f"[FAIL] {failures} checks failed")
+        sys.exit(1)
+    print("[OK] CRCs match, oversized bodies refused with 413")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+Route lookup benchmark: route trie against a linear pattern scan.
+
+For each route count, generates a synthetic endpoint table (4 routes per
+resource, with {id} parameters), compiles its trie with route_trie.py and
+builds src/route_trie.c on the host with a timing loop. Both lookups run
+on the same requests (every route once with a concrete id, plus misses),
+their results are checked to be identical, then each is timed.
+
+Usage:
+    python route_bench.py
+    python route_bench.py --routes 10 100 500 1000 --iterations 200000
+    python route_bench.py --cc clang
+
+Columns: routes, trie nodes, ROM of the trie tables (32-bit pointers),
+ns per lookup for the trie and the linear scan, and the speedup. The
+figures are for the build host: on the MCU both are slower, the ratio is
+what carries over.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+import route_trie
+
+ROUTES = [10, 100, 500]
+ITERATIONS = 100000             # Lookups per route count and method
+SUBRESOURCES = ["samples", "config"]
+SRC_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src")
+
+BENCH_MAIN = r"""
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "route_trie.h"
+
+#include "bench_routes.inc"
+
+#define ROUTE_COUNT (sizeof(bench_route_patterns) / sizeof(bench_route_patterns[0]))
+#define REQUEST_COUNT (sizeof(requests) / sizeof(requests[0]))
+
+static volatile unsigned sink;
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int same_match(const struct route_match *a, const struct route_match *b)
+{
+	unsigned i;
+
+	if (a->route != b->route || a->param_count != b->param_count)
+	{
+		return 0;
+	}
+	for (i = 0; i < a->param_count; i++)
+	{
+		if (a->params[i].value != b->params[i].value || a->params[i].len != b->params[i].len)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	struct route_match trie_match;
+	struct route_match linear_match;
+	unsigned long iterations = strtoul(argv[1], NULL, 10);
+	unsigned long n;
+	unsigned i;
+	int trie_ret;
+	int linear_ret;
+	double start;
+	double trie_ns;
+	double linear_ns;
+
+	for (i = 0; i < REQUEST_COUNT; i++)
+	{
+		trie_ret = route_trie_lookup(&bench_route_trie, requests[i], strlen(requests[i]),
+					     &trie_match);
+		linear_ret = route_linear_lookup(bench_route_patterns, ROUTE_COUNT, requests[i],
+						 strlen(requests[i]), &linear_match);
+		if (trie_ret != linear_ret || (trie_ret == 0 && !same_match(&trie_match, &linear_match)))
+		{
+			printf("MISMATCH %s: trie %d route %u, linear %d route %u\n", requests[i],
+			       trie_ret, trie_match.route, linear_ret, linear_match.route);
+			return 1;
+		}
+	}
+
+	start = now_ns();
+	for (n = 0; n < iterations; n++)
+	{
+		for (i = 0; i < REQUEST_COUNT; i++)
+		{
+			route_trie_lookup(&bench_route_trie, requests[i], request_lens[i], &trie_match);
+			sink += trie_match.route;
+		}
+	}
+	trie_ns = (now_ns() - start) / ((double)iterations * REQUEST_COUNT);
+
+	start = now_ns();
+	for (n = 0; n < iterations; n++)
+	{
+		for (i = 0; i < REQUEST_COUNT; i++)
+		{
+			route_linear_lookup(bench_route_patterns, ROUTE_COUNT, requests[i], request_lens[i],
+					    &linear_match);
+			sink += linear_match.route;
+		}
+	}
+	linear_ns = (now_ns() - start) / ((double)iterations * REQUEST_COUNT);
+
+	printf("%.1f %.1f\n", trie_ns, linear_ns);
+	return 0;
+}
+"""
+
+
+def synthetic_routes(count):
+    """count patterns: /api/v1/resN, /api/v1/resN/{id} and its subresources"""
+    patterns = []
+    resource = 0
+    while len(patterns) < count:
+        base = f"/api/v1/res{resource}"
+        patterns.append(base)
+        patterns.append(base + "/{id}")
+        for sub in SUBRESOURCES:
+            patterns.append(base + "/{id}/" + sub)
+        resource += 1
+    return patterns[:count]
+
+
+def requests_for(patterns):
+    """One request per route (ids filled in), then misses"""
+    requests = [p.replace("{id}", str(1000 + i)) for i, p in enumerate(patterns)]
+    requests += ["/api/v1/unknown", "/api/v1/res0/7/unknown", "/api/v2/res0", "/"]
+    return requests
+
+
+def run(args, count, work_dir):
+    patterns = synthetic_routes(count)
+    requests = requests_for(patterns)
+    # The linear lookup needs the patterns table too
+    trie, rom, node_count, _ = route_trie.emit_trie("bench", patterns, with_patterns=True)
+
+    with open(os.path.join(work_dir, "bench_routes.inc"), "w") as f:
+        f.write(trie + "\n\n")
+        f.write("static const char *const requests[] = {\n")
+        f.writelines(f'\t"{r}",\n' for r in requests)
+        f.write("};\n\n")
+        f.write("static const size_t request_lens[] = {\n")
+        f.writelines(f"\t{len(r)},\n" for r in requests)
+        f.write("};\n")
+
+    main_c = os.path.join(work_dir, "bench_main.c")
+    with open(main_c, "w") as f:
+        f.write(BENCH_MAIN)
+
+    binary = os.path.join(work_dir, f"bench_{count}")
+    subprocess.run([args.cc, "-O2", "-I", SRC_DIR, "-I", work_dir, "-o", binary,
+                    os.path.join(SRC_DIR, "route_trie.c"), main_c], check=True)
+
+    result = subprocess.run([binary, str(max(1, args.iterations // len(requests)))],
+                            capture_output=True, text=True)
+    if result.returncode != 0:
+        sys.exit(f"[ERROR] {count} routes: {result.stdout.strip()}")
+
+    trie_ns, linear_ns = (float(v) for v in result.stdout.split())
+    return node_count, rom, trie_ns, linear_ns
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark the route trie against linear matching")
+    parser.add_argument("--routes", type=int, nargs="+", default=ROUTES, help="Route counts")
+    parser.add_argument("--iterations", type=int, default=ITERATIONS,
+                        help="Lookups per route count and method (approximate)")
+    parser.add_argument("--cc", default=os.environ.get("CC", "cc"), help="Host C compiler")
+    args = parser.parse_args()
+
+    print(f"[INFO] Route lookup, {args.cc} -O2 on the build host, results checked equal")
+    print("-" * 60)
+    print(f"{'routes':>7}{'nodes':>7}{'ROM':>9}{'trie ns':>10}{'linear ns':>11}{'speedup':>9}")
+
+    with tempfile.TemporaryDirectory() as work_dir:
+        for count in args.routes:
+            node_count, rom, trie_ns, linear_ns = run(args, count, work_dir)
+            print(f"{count:>7}{node_count:>7}{rom:>9}{trie_ns:>10.1f}{linear_ns:>11.1f}"
+                  f"{linear_ns / trie_ns:>8.1f}x")
+
+    print("-" * 60)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+"""
+Generate the ROM route trie of an endpoint table at build time.
+
+The table has one endpoint per line, "#" starts a comment:
+
+    # Method  Path                        Handler
+    GET       /api/sensors                api_sensors_list
+    GET       /api/sensors/{id}/samples   api_sensor_samples
+
+A {name} segment is a path parameter, it matches any non-empty segment.
+An endpoint followed by "if SYMBOL" is only compiled in when the build
+passes --enable SYMBOL (a Kconfig option, without CONFIG_):
+
+    GET       /api/slow/{ms}              api_slow_get    if APP_API_SLOW
+
+Writes <name>_routes.inc with (see src/route_trie.h and src/api.h):
+
+    <name>_route_patterns[]   the paths, index = route_match.route (only with
+                              --with-patterns, the firmware does not need them)
+    <name>_route_edges[]      static segments, sorted per node
+    <name>_route_nodes[]      one node per distinct prefix, node 0 is "/"
+    <name>_route_trie         the trie for route_trie_lookup()
+    <name>_routes[]           methods and handlers of each route
+                              (API_HANDLER() declarations included)
+
+The sizes of the tables are printed.
+
+Usage:
+    python route_trie.py --name api --out-dir build/zephyr/include/generated \\
+        [--enable APP_API_SLOW] src/api_routes.txt
+"""
+
+import argparse
+import os
+import sys
+
+METHODS = ["DELETE", "GET", "HEAD", "OPTIONS", "PATCH", "POST", "PUT"]
+ROUTE_NONE = 0xffff
+ROUTE_MAX_PARAMS = 4            # ROUTE_MAX_PARAMS in src/route_trie.h
+
+
+class Node:
+    """One path prefix"""
+
+    def __init__(self):
+        self.children = {}      # segment (bytes) -> Node
+        self.param = None       # Node of a {param} segment
+        self.route = ROUTE_NONE
+        self.index = None
+
+
+def segments(pattern):
+    return [s for s in pattern.strip("/").split("/") if s]
+
+
+def is_param(segment):
+    return segment.startswith("{") and segment.endswith("}")
+
+
+def parse_table(path, enabled=()):
+    """Read the endpoint table, return [(pattern, [(method, handler)])] in table order
+
+    Endpoints with "if SYMBOL" are left out unless SYMBOL is in enabled.
+    """
+    routes = {}
+    order = []
+
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+
+            fields = line.split()
+            if len(fields) == 5 and fields[3] == "if":
+                if fields[4] not in enabled:
+                    continue
+                fields = fields[:3]
+            if len(fields) != 3:
+                sys.exit(f"{path}:{number}: expected 'METHOD /path handler [if SYMBOL]'")
+            method, pattern, handler = fields
+            method = method.upper()
+
+            if method not in METHODS:
+                sys.exit(f"{path}:{number}: unknown method {method}")
+            if not pattern.startswith("/"):
+                sys.exit(f"{path}:{number}: path must start with '/'")
+            if sum(is_param(s) for s in segments(pattern)) > ROUTE_MAX_PARAMS:
+                sys.exit(f"{path}:{number}: more than {ROUTE_MAX_PARAMS} parameters")
+
+            # Same route whatever the parameter names are
+            key = "/" + "/".join("{}" if is_param(s) else s for s in segments(pattern))
+            if key not in routes:
+                routes[key] = (pattern, [])
+                order.append(key)
+            if any(m == method for m, _ in routes[key][1]):
+                sys.exit(f"{path}:{number}: {method} {pattern} defined twice")
+            routes[key][1].append((method, handler))
+
+    return [routes[key] for key in order]
+
+
+def build_trie(patterns):
+    """Return (nodes, edges): nodes in breadth-first order, edges contiguous per node"""
+    root = Node()
+
+    for index, pattern in enumerate(patterns):
+        node = root
+        for segment in segments(pattern):
+            if is_param(segment):
+                if node.param is None:
+                    node.param = Node()
+                node = node.param
+            else:
+                node = node.children.setdefault(segment.encode(), Node())
+        node.route = index
+
+    # Breadth-first numbering, so the edges of a node are contiguous
+    nodes = [root]
+    for node in nodes:
+        node.index = None
+        for segment in sorted(node.children):
+            nodes.append(node.children[segment])
+        if node.param is not None:
+            nodes.append(node.param)
+    for index, node in enumerate(nodes):
+        node.index = index
+
+    edges = []
+    table = []
+    for node in nodes:
+        first_edge = len(edges)
+        # bytes order = route_trie.c segment_compare() order
+        for segment in sorted(node.children):
+            edges.append((segment, node.children[segment].index))
+        param = node.param.index if node.param is not None else ROUTE_NONE
+        table.append((first_edge, len(edges) - first_edge, param, node.route))
+
+    if len(nodes) >= ROUTE_NONE or len(edges) >= ROUTE_NONE:
+        sys.exit("route_trie.py: more than 65534 nodes or edges")
+
+    return table, edges
+
+
+def c_string(data):
+    return '"' + data.decode().replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def c_index(value):
+    return "ROUTE_NONE" if value == ROUTE_NONE else str(value)
+
+
+def emit_trie(name, patterns, with_patterns=False):
+    """C tables of the trie (and of the patterns), return (text, ROM estimate in bytes)"""
+    nodes, edges = build_trie(patterns)
+
+    out = []
+    if with_patterns:
+        out.append(f"/* Routes, index = route_match.route */")
+        out.append(f"static const char *const {name}_route_patterns[] = {{")
+        for pattern in patterns:
+            out.append(f"\t{c_string(pattern.encode())},")
+        out.append("};")
+        out.append("")
+
+    out.append(f"/* {len(edges)} static segments */")
+    out.append(f"static const struct route_edge {name}_route_edges[] = {{")
+    for segment, node in edges:
+        out.append(f"\t{{ {c_string(segment)}, {len(segment)}, {node} }},")
+    if not edges:
+        out.append("\t{ \"\", 0, ROUTE_NONE },")
+    out.append("};")
+    out.append("")
+
+    out.append(f"/* {len(nodes)} nodes: first edge, edges, {{param}} node, route */")
+    out.append(f"static const struct route_node {name}_route_nodes[] = {{")
+    for index, (first_edge, edge_count, param, route) in enumerate(nodes):
+        comment = f"  /* {patterns[route]} */" if route != ROUTE_NONE else ""
+        out.append(f"\t{{ {first_edge}, {edge_count}, {c_index(param)}, {c_index(route)} }},"
+                   f"{comment}")
+    out.append("};")
+    out.append("")
+
+    out.append(f"static const struct route_trie {name}_route_trie = {{")
+    out.append(f"\t.nodes = {name}_route_nodes,")
+    out.append(f"\t.edges = {name}_route_edges,")
+    out.append("};")
+
+    # Pointers counted as 4 bytes (32-bit target)
+    rom = len(nodes) * 8 + len(edges) * 8 + sum(len(s) + 1 for s, _ in edges)
+    if with_patterns:
+        rom += len(patterns) * 4 + sum(len(p) + 1 for p in patterns)
+    return "\n".join(out), rom, len(nodes), len(edges)
+
+
+def emit_handlers(name, routes):
+    """API_HANDLER() declarations and the method table of each route"""
+    handlers = []
+    for _, methods in routes:
+        for _, handler in methods:
+            if handler not in handlers:
+                handlers.append(handler)
+
+    out = [f"API_HANDLER({handler});" for handler in handlers]
+    out.append("")
+
+    for index, (pattern, methods) in enumerate(routes):
+        out.append(f"static const struct api_method {name}_route_{index}_methods[] = {{")
+        for method, handler in methods:
+            out.append(f"\t{{ HTTP_{method}, {handler} }},")
+        out.append("};")
+    out.append("")
+
+    out.append(f"static const struct api_route {name}_routes[] = {{")
+    for index, (pattern, methods) in enumerate(routes):
+        out.append(f"\t{{ {name}_route_{index}_methods, {len(methods)} }},  /* {pattern} */")
+    out.append("};")
+
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a ROM route trie from an endpoint table")
+    parser.add_argument("table", help="Endpoint table (METHOD /path handler per line)")
+    parser.add_argument("--name", required=True, help="Prefix of the generated tables")
+    parser.add_argument("--out-dir", required=True, help="Directory for <name>_routes.inc")
+    parser.add_argument("--enable", action="append", default=[], metavar="SYMBOL",
+                        help="Keep the endpoints marked 'if SYMBOL' (repeatable)")
+    parser.add_argument("--with-patterns", action="store_true",
+                        help="Also emit <name>_route_patterns[] (host tests, linear lookup)")
+    args = parser.parse_args()
+
+    routes = parse_table(args.table, args.enable)
+    patterns = [pattern for pattern, _ in routes]
+    trie, rom, node_count, edge_count = emit_trie(args.name, patterns, args.with_patterns)
+
+    out = [f"/* Generated by route_trie.py from {os.path.basename(args.table)}, do not edit */",
+           "",
+           trie,
+           "",
+           emit_handlers(args.name, routes)]
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    with open(os.path.join(args.out_dir, f"{args.name}_routes.inc"), "w") as f:
+        f.write("\n".join(out) + "\n")
+
+    print(f"Route trie {args.name}: {len(routes)} routes, {node_count} nodes, "
+          f"{edge_count} edges, ~{rom} bytes of ROM (without the handler tables)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,80 @@
+/*
+ * Access log: one binary record per HTTP response, written without locks by
+ * the server thread and drained by a low-priority thread
+ */
+
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+/* Records the ring holds until the drain thread runs (power of 2, 16 bytes
+ * each). When it is full, new records are counted as dropped */
+#define ACCESS_LOG_RING_SIZE 64
+
+/* Newest drained records kept for /logs */
+#define ACCESS_LOG_HISTORY 32
+
+/* Resources with their own id, the others share the last one */
+#define ACCESS_LOG_MAX_RESOURCES 16
+
+/* Drain thread: lowest application priority, so it only runs when the
+ * server and the other threads are idle */
+#define ACCESS_LOG_DRAIN_MS 250
+#define ACCESS_LOG_STACK_SIZE 1024
+#define ACCESS_LOG_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+
+/* One response */
+struct access_log_record
+{
+	uint32_t time_ms;                   /* Uptime when the last chunk was handed over */
+	uint32_t latency_us;                /* First handler call to final_chunk, send excluded */
+	uint32_t bytes;                     /* Body bytes sent */
+	uint16_t status;
+	uint8_t method;                     /* enum http_method */
+	uint8_t resource;                   /* Id of the resource name */
+};
+
+/**
+ *  @brief Start time of a request, in the handler's first call
+ */
+static inline uint32_t access_log_timestamp(void)
+{
+	return k_cycle_get_32();
+}
+
+/**
+ *  @brief Log a response
+ *
+ *  A few stores and no lock: safe to call on every request. Called by the
+ *  handlers (server thread only, a single writer) in the call that sets
+ *  final_chunk. The server sends that chunk after the handler returns, so
+ *  the latency stops before the last send.
+ *
+ *  @param resource Resource name (compared by pointer first, then by value)
+ *  @param method enum http_method of the request
+ *  @param status HTTP status code sent
+ *  @param bytes Body bytes sent
+ *  @param start access_log_timestamp() at the start of the request
+ */
+void access_log_write(const char *resource, uint8_t method, uint16_t status, size_t bytes,
+		      uint32_t start);
+
+/**
+ *  @brief Record callback for HTTP_STREAM_DEFINE(), the newest records as JSON
+ *
+ *  {"dropped":0,"records":[{"t":1234,"method":"GET","resource":"...",
+ *  "status":200,"bytes":512,"us":830},...]}, oldest first. Record 0 takes a
+ *  snapshot of the history.
+ */
+int access_log_json_record(uint32_t index, char *buf, size_t len, void *user_data);
+
+/**
+ *  @brief Start the drain thread
+ */
+void access_log_start(void);
+
+#endif /* ACCESS_LOG_H */
@@ -0,0 +1,600 @@
+/**
+ * REST API
+ *
+ * Every HTTP_RESOURCE_DEFINE() is one more entry the server compares a
+ * request path with, in turn, and a path with an id in it needs its own
+ * wildcard resource anyway. The API routes are written in one table
+ * instead (src/api_routes.txt); scripts/route_trie.py compiles it at build
+ * time into a ROM route trie and the method tables (api_routes.inc), and
+ * a single wildcard resource, /api/..., dispatches every request:
+ *
+ *   GET /api/threads/3   ->  route_trie_lookup()  ->  api_thread_get(), {id} = "3"
+ *
+ * The lookup cost depends on the path, not on the number of routes (see
+ * route_trie.c and scripts/route_bench.py). Unknown paths get 404, known
+ * paths with another method 405 with an Allow header, both once the
+ * request body (ignored) is received.
+ *
+ * The fragments of request bodies from different clients interleave on the
+ * server thread. The request state belongs to the client whose request is
+ * in progress; another client's request meanwhile has its body dropped and
+ * gets 409 Conflict, as for http_upload.
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/led.h>
+#include <zephyr/kernel.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "access_log.h"
+#include "api.h"
+#include "history.h"
+#include "http_stream.h"
+#include "metrics.h"
+#include "route_trie.h"
+
+// Route trie, method tables and handler declarations (scripts/route_trie.py)
+#include "api_routes.inc"
+
+#define API_ROUTE_COUNT ARRAY_SIZE(api_routes)
+
+// LEDs of the board (gpio-leds node of the devicetree), none on native_sim
+#if DT_HAS_COMPAT_STATUS_OKAY(gpio_leds)
+#define API_LED_COUNT DT_CHILD_NUM_STATUS_OKAY(DT_INST(0, gpio_leds))
+static const struct device *const leds = DEVICE_DT_GET_ONE(gpio_leds);
+#else
+#define API_LED_COUNT 0
+static const struct device *const leds;
+#endif
+
+// PUT /api/leds/{id} body: "on", "off", "1" or "0"
+#define API_LED_BODY_SIZE 8
+
+#ifdef CONFIG_APP_API_SLOW
+// Longest sleep of GET /api/slow/{ms}
+#define API_SLOW_MAX_MS 2000
+#endif
+
+/* State of the request being dispatched */
+static struct
+{
+	const struct http_client_ctx *client; /* Owner of the request in progress */
+	bool active;                        /* Route looked up, request in progress */
+	bool answered;                      /* Response sent, rest of the body ignored */
+	api_handler_t handler;              /* NULL: error answered at the end of the body */
+	enum http_status error;
+	struct route_match match;
+	size_t bytes;
+	uint32_t start;                     /* access_log_timestamp() */
+} api_request;
+
+static char api_response[API_RESPONSE_SIZE];
+static char api_allow[48];
+static const struct http_header api_allow_header[] = {
+	{ .name = "Allow", .value = api_allow },
+};
+
+static bool led_state[MAX(API_LED_COUNT, 1)];
+
+// =============================================================================
+// RESPONSES
+// =============================================================================
+
+/**
+ * Send api_response (len bytes from http_stream_printf()) as the whole body
+ */
+static int api_reply(struct http_response_ctx *response_ctx, enum http_status code, int len)
+{
+	if (len < 0)
+	{
+		return len;
+	}
+
+	response_ctx->status = code;
+	response_ctx->body = (const uint8_t *)api_response;
+	response_ctx->body_len = len;
+	response_ctx->final_chunk = true;
+	return 0;
+}
+
+static int api_error(struct http_response_ctx *response_ctx, enum http_status code,
+		     const char *reason)
+{
+	return api_reply(response_ctx, code,
+			 http_stream_printf(api_response, sizeof(api_response),
+					    "{\"error\":\"%s\"}", reason));
+}
+
+/**
+ * Request of another client while one is in progress: drop its body, 409
+ * once it is complete. The body is a constant, api_response is the owner's
+ */
+static void api_busy(struct http_client_ctx *client, enum http_data_status status,
+		     struct http_response_ctx *response_ctx)
+{
+	static const char busy[] = "{\"error\":\"request in progress\"}";
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return;
+	}
+
+	response_ctx->status = HTTP_409_CONFLICT;
+	response_ctx->body = (const uint8_t *)busy;
+	response_ctx->body_len = sizeof(busy) - 1;
+	response_ctx->final_chunk = true;
+
+	metrics_http_response("api_resource_detail", HTTP_409_CONFLICT, response_ctx->body_len);
+	access_log_write("api_resource_detail", client->method, HTTP_409_CONFLICT,
+			 response_ctx->body_len, access_log_timestamp());
+}
+
+/**
+ * Methods of a route for the Allow header of a 405
+ */
+static void api_allow_format(const struct api_route *route)
+{
+	size_t len = 0;
+	uint8_t i;
+	int ret;
+
+	api_allow[0] = '\0';
+	for (i = 0; i < route->method_count; i++)
+	{
+		ret = http_stream_printf(api_allow + len, sizeof(api_allow) - len, "%s%s",
+					 (i > 0) ? ", " : "",
+					 http_method_str(route->methods[i].method));
+		if (ret < 0)
+		{
+			break;
+		}
+		len += ret;
+	}
+}
+
+// =============================================================================
+// DISPATCHER
+// =============================================================================
+
+/**
+ * Find the route and the handler of a new request
+ */
+static void api_dispatch(struct http_client_ctx *client)
+{
+	const char *path = (const char *)client->url_buffer;
+	const struct api_route *route;
+	uint8_t i;
+
+	api_request.handler = NULL;
+	api_request.error = HTTP_404_NOT_FOUND;
+	api_request.answered = false;
+	api_request.bytes = 0;
+	api_request.start = access_log_timestamp();
+
+	// The query string is not part of the route
+	if (route_trie_lookup(&api_route_trie, path, strcspn(path, "?"), &api_request.match) != 0)
+	{
+		return;
+	}
+
+	route = &api_routes[api_request.match.route];
+	for (i = 0; i < route->method_count; i++)
+	{
+		if (route->methods[i].method == client->method)
+		{
+			api_request.handler = route->methods[i].handler;
+			return;
+		}
+	}
+
+	api_request.error = HTTP_405_METHOD_NOT_ALLOWED;
+	api_allow_format(route);
+}
+
+static int api_resource_handler(struct http_client_ctx *client, enum http_data_status status,
+				const struct http_request_ctx *request_ctx,
+				struct http_response_ctx *response_ctx, void *user_data)
+{
+	uint16_t code;
+	int ret;
+
+	if (api_request.active && client != api_request.client)
+	{
+		// Not the owner: never touches the request in progress
+		if (status != HTTP_SERVER_DATA_ABORTED)
+		{
+			api_busy(client, status, response_ctx);
+		}
+		return 0;
+	}
+
+	if (status == HTTP_SERVER_DATA_ABORTED)
+	{
+		if (api_request.active && !api_request.answered && api_request.handler != NULL)
+		{
+			api_request.handler(client, status, request_ctx, response_ctx,
+					    &api_request.match);
+		}
+		api_request.active = false;
+		return 0;
+	}
+
+	if (!api_request.active)
+	{
+		api_dispatch(client);
+		api_request.client = client;
+		api_request.active = true;
+	}
+
+	if (api_request.answered)
+	{
+		// Drop the rest of the body, the next request starts after FINAL
+		api_request.active = (status != HTTP_SERVER_DATA_FINAL);
+		return 0;
+	}
+
+	if (api_request.handler == NULL)
+	{
+		if (status != HTTP_SERVER_DATA_FINAL)
+		{
+			return 0;
+		}
+
+		if (api_request.error == HTTP_405_METHOD_NOT_ALLOWED)
+		{
+			response_ctx->headers = api_allow_header;
+			response_ctx->header_count = ARRAY_SIZE(api_allow_header);
+			ret = api_error(response_ctx, api_request.error, "method not allowed");
+		}
+		else
+		{
+			ret = api_error(response_ctx, api_request.error, "not found");
+		}
+	}
+	else
+	{
+		ret = api_request.handler(client, status, request_ctx, response_ctx,
+					  &api_request.match);
+	}
+
+	if (ret < 0)
+	{
+		api_request.active = false;
+		return ret;
+	}
+
+	api_request.bytes += response_ctx->body_len;
+	if (response_ctx->final_chunk)
+	{
+		code = (response_ctx->status != 0) ? response_ctx->status : HTTP_200_OK;
+		api_request.answered = (status != HTTP_SERVER_DATA_FINAL);
+		api_request.active = api_request.answered;
+		metrics_http_response("api_resource_detail", code, api_request.bytes);
+		access_log_write("api_resource_detail", client->method, code, api_request.bytes,
+				 api_request.start);
+	}
+
+	return 0;
+}
+
+struct http_resource_detail_dynamic api_resource_detail = {
+	.common = {
+		.type = HTTP_RESOURCE_TYPE_DYNAMIC,
+		.bitmask_of_supported_http_methods =
+			BIT(HTTP_GET) | BIT(HTTP_POST) | BIT(HTTP_PUT) | BIT(HTTP_DELETE),
+		.content_type = "application/json",
+	},
+	.cb = api_resource_handler,
+	.user_data = NULL,
+};
+
+// =============================================================================
+// HANDLERS (routes in src/api_routes.txt)
+// =============================================================================
+
+// GET /api/system -> {"board":"STM32H573I-DK","arch":"ARM Cortex-M33","uptime":1234,"routes":7}
+API_HANDLER(api_system_get)
+{
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	return api_reply(response_ctx, HTTP_200_OK,
+			 http_stream_printf(api_response, sizeof(api_response),
+					    "{\"board\":\"STM32H573I-DK\",\"arch\":\"ARM Cortex-M33\","
+					    "\"uptime\":%" PRId64 ",\"routes\":%zu}",
+					    k_uptime_get(), API_ROUTE_COUNT));
+}
+
+// GET /api/cpu/load -> {"load":153} (permille, newest /history sample)
+API_HANDLER(api_cpu_load_get)
+{
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	return api_reply(response_ctx, HTTP_200_OK,
+			 http_stream_printf(api_response, sizeof(api_response), "{\"load\":%u}",
+					    history_last_load()));
+}
+
+/* Thread walk: the names of all threads, or one thread by index */
+struct api_thread_walk
+{
+	uint32_t index;
+	uint32_t wanted;                    /* Thread index, UINT32_MAX for the list */
+	size_t len;                         /* api_response used by the list */
+	bool truncated;
+	const struct k_thread *found;
+};
+
+static const char *api_thread_name(const struct k_thread *thread)
+{
+	const char *name = k_thread_name_get((k_tid_t)thread);
+
+	return (name != NULL) ? name : "";
+}
+
+static void api_thread_visit(const struct k_thread *thread, void *user_data)
+{
+	struct api_thread_walk *walk = user_data;
+	int ret;
+
+	if (walk->wanted == UINT32_MAX && !walk->truncated)
+	{
+		// Room for the closing "]}"
+		ret = http_stream_printf(api_response + walk->len,
+					 sizeof(api_response) - walk->len - 2, "%s\"%s\"",
+					 (walk->index > 0) ? "," : "", api_thread_name(thread));
+		if (ret < 0)
+		{
+			walk->truncated = true;
+		}
+		else
+		{
+			walk->len += ret;
+		}
+	}
+	else if (walk->index == walk->wanted)
+	{
+		walk->found = thread;
+	}
+
+	walk->index++;
+}
+
+// GET /api/threads -> {"threads":["main","sysworkq",...]}, id = position in the list
+API_HANDLER(api_threads_list)
+{
+	struct api_thread_walk walk = { .wanted = UINT32_MAX };
+	int ret;
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	ret = http_stream_printf(api_response, sizeof(api_response), "{\"threads\":[");
+	if (ret < 0)
+	{
+		return ret;
+	}
+	walk.len = ret;
+
+	k_thread_foreach_unlocked(api_thread_visit, &walk);
+
+	api_response[walk.len++] = ']';
+	api_response[walk.len++] = '}';
+	return api_reply(response_ctx, HTTP_200_OK, walk.len);
+}
+
+// GET /api/threads/{id} -> {"id":2,"name":"main","priority":0,"stack_size":3072,"stack_used":1100}
+API_HANDLER(api_thread_get)
+{
+	struct api_thread_walk walk = { .found = NULL };
+	size_t unused = 0;
+	size_t size;
+	uint32_t id;
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	if (route_param_u32(&match->params[0], &id) != 0)
+	{
+		return api_error(response_ctx, HTTP_400_BAD_REQUEST, "id must be a number");
+	}
+
+	walk.wanted = id;
+	k_thread_foreach_unlocked(api_thread_visit, &walk);
+	if (walk.found == NULL)
+	{
+		return api_error(response_ctx, HTTP_404_NOT_FOUND, "no such thread");
+	}
+
+	size = walk.found->stack_info.size;
+	if (k_thread_stack_space_get(walk.found, &unused) != 0)
+	{
+		unused = size;
+	}
+
+	return api_reply(response_ctx, HTTP_200_OK,
+			 http_stream_printf(api_response, sizeof(api_response),
+					    "{\"id\":%u,\"name\":\"%s\",\"priority\":%d,"
+					    "\"stack_size\":%zu,\"stack_used\":%zu}",
+					    id, api_thread_name(walk.found),
+					    k_thread_priority_get((k_tid_t)walk.found), size,
+					    size - unused));
+}
+
+/**
+ * LED of a {id} parameter, -1 (and the error answered) if there is none
+ */
+static int api_led_index(const struct route_match *match, struct http_response_ctx *response_ctx)
+{
+	uint32_t id;
+
+	if (route_param_u32(&match->params[0], &id) != 0 || id >= API_LED_COUNT)
+	{
+		api_error(response_ctx, HTTP_404_NOT_FOUND, "no such led");
+		return -1;
+	}
+
+	return (int)id;
+}
+
+// GET /api/leds -> {"leds":[false,true,...]}
+API_HANDLER(api_leds_list)
+{
+	size_t len;
+	int ret;
+	int i;
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	ret = http_stream_printf(api_response, sizeof(api_response), "{\"leds\":[");
+	if (ret < 0)
+	{
+		return ret;
+	}
+	len = ret;
+
+	for (i = 0; i < API_LED_COUNT; i++)
+	{
+		ret = http_stream_printf(api_response + len, sizeof(api_response) - len - 2, "%s%s",
+					 (i > 0) ? "," : "", led_state[i] ? "true" : "false");
+		if (ret < 0)
+		{
+			break;
+		}
+		len += ret;
+	}
+
+	api_response[len++] = ']';
+	api_response[len++] = '}';
+	return api_reply(response_ctx, HTTP_200_OK, len);
+}
+
+// GET /api/leds/{id} -> {"id":0,"on":false}
+API_HANDLER(api_led_get)
+{
+	int id;
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	id = api_led_index(match, response_ctx);
+	if (id < 0)
+	{
+		return 0;
+	}
+
+	return api_reply(response_ctx, HTTP_200_OK,
+			 http_stream_printf(api_response, sizeof(api_response),
+					    "{\"id\":%d,\"on\":%s}", id,
+					    led_state[id] ? "true" : "false"));
+}
+
+// PUT /api/leds/{id} with body "on" or "off" ("1" or "0") -> {"id":0,"on":true}
+API_HANDLER(api_led_put)
+{
+	static char body[API_LED_BODY_SIZE];
+	static size_t body_len;
+	bool on;
+	int ret;
+	int id;
+
+	if (status == HTTP_SERVER_DATA_ABORTED)
+	{
+		body_len = 0;
+		return 0;
+	}
+
+	// The body may arrive in several fragments
+	if (body_len + request_ctx->data_len >= sizeof(body))
+	{
+		body_len = 0;
+		return api_error(response_ctx, HTTP_400_BAD_REQUEST, "expected on or off");
+	}
+	memcpy(body + body_len, request_ctx->data, request_ctx->data_len);
+	body_len += request_ctx->data_len;
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	body[body_len] = '\0';
+	body_len = 0;
+
+	id = api_led_index(match, response_ctx);
+	if (id < 0)
+	{
+		return 0;
+	}
+
+	if (strcmp(body, "on") == 0 || strcmp(body, "1") == 0)
+	{
+		on = true;
+	}
+	else if (strcmp(body, "off") == 0 || strcmp(body, "0") == 0)
+	{
+		on = false;
+	}
+	else
+	{
+		return api_error(response_ctx, HTTP_400_BAD_REQUEST, "expected on or off");
+	}
+
+	ret = on ? led_on(leds, id) : led_off(leds, id);
+	if (ret < 0)
+	{
+		printk("[ERR] LED %d: %d\n", id, ret);
+		return api_error(response_ctx, HTTP_500_INTERNAL_SERVER_ERROR, "led driver");
+	}
+	led_state[id] = on;
+
+	return api_reply(response_ctx, HTTP_200_OK,
+			 http_stream_printf(api_response, sizeof(api_response),
+					    "{\"id\":%d,\"on\":%s}", id, on ? "true" : "false"));
+}
+
+#ifdef CONFIG_APP_API_SLOW
+// GET /api/slow/{ms} -> {"slept_ms":200}, after blocking the server thread for ms
+// A stand-in for a slow handler (sensor read, flash access): every stream
+// and every client waits meanwhile, which pc_test/h2_page_test.py measures.
+// Test only (CONFIG_APP_API_SLOW): any client could stall the server with it
+API_HANDLER(api_slow_get)
+{
+	uint32_t ms;
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	if (route_param_u32(&match->params[0], &ms) != 0 || ms > API_SLOW_MAX_MS)
+	{
+		return api_error(response_ctx, HTTP_400_BAD_REQUEST, "ms must be 0 to 2000");
+	}
+
+	k_msleep(ms);
+
+	return api_reply(response_ctx, HTTP_200_OK,
+			 http_stream_printf(api_response, sizeof(api_response),
+					    "{\"slept_ms\":%u}", ms));
+}
+#endif /* CONFIG_APP_API_SLOW */
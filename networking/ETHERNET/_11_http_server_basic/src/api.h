@@ -0,0 +1,56 @@
+/*
+ * REST API: the routes of src/api_routes.txt behind one wildcard resource
+ * (/api/...), dispatched through a ROM route trie
+ */
+
+#ifndef API_H
+#define API_H
+
+#include <stdint.h>
+
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/http/service.h>
+
+#include "route_trie.h"
+
+/* Response body buffer shared by the API handlers */
+#define API_RESPONSE_SIZE 256
+
+/**
+ *  @brief API handler, called like a dynamic resource callback
+ *
+ *  Called for every fragment of the request until it sets final_chunk,
+ *  as a dynamic resource callback is. The route and its {param} segments
+ *  are in match, the parameters point into the request URL.
+ *
+ *  @return 0, or a negative errno to close the connection
+ */
+typedef int (*api_handler_t)(struct http_client_ctx *client, enum http_data_status status,
+			     const struct http_request_ctx *request_ctx,
+			     struct http_response_ctx *response_ctx,
+			     const struct route_match *match);
+
+/* Declare or define an API handler (the generated table declares them) */
+#define API_HANDLER(_name)                                                         \
+	int _name(struct http_client_ctx *client, enum http_data_status status,    \
+		  const struct http_request_ctx *request_ctx,                      \
+		  struct http_response_ctx *response_ctx, const struct route_match *match)
+
+/* One method of a route */
+struct api_method
+{
+	enum http_method method;
+	api_handler_t handler;
+};
+
+/* A route of the table, index = route_match.route */
+struct api_route
+{
+	const struct api_method *methods;
+	uint8_t method_count;
+};
+
+/* Dynamic resource of the API routes (/api/...), used with HTTP_RESOURCE_DEFINE() */
+extern struct http_resource_detail_dynamic api_resource_detail;
+
+#endif /* API_H */
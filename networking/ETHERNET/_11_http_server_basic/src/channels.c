@@ -0,0 +1,102 @@
+/**
+ * zbus channels of the application
+ *
+ *   history sampler  ->  load_chan  ->  alarm_listener  ->  alarm_chan
+ *                                           ^
+ *   POST /chan/alarm_config_chan  ->  alarm_config_chan
+ *
+ * Every channel is also bridged to HTTP (zbus_http.c): its observers list
+ * zbus_http_listener, and app_channels[] gives the json_obj_descr of its
+ * message. Only alarm_config_chan may be published over HTTP, its
+ * validator keeps the threshold within 0..1000.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "channels.h"
+
+#define ALARM_THRESHOLD 800
+
+static const struct json_obj_descr load_msg_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct load_msg, uptime_s, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct load_msg, load, JSON_TOK_NUMBER),
+};
+
+static const struct json_obj_descr alarm_config_msg_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct alarm_config_msg, threshold, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct alarm_config_msg, enabled, JSON_TOK_TRUE),
+};
+
+static const struct json_obj_descr alarm_msg_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct alarm_msg, active, JSON_TOK_TRUE),
+	JSON_OBJ_DESCR_PRIM(struct alarm_msg, load, JSON_TOK_NUMBER),
+};
+
+const struct zbus_http_channel app_channels[] = {
+	ZBUS_HTTP_CHANNEL(load_chan, load_msg_descr, false),
+	ZBUS_HTTP_CHANNEL(alarm_config_chan, alarm_config_msg_descr, true),
+	ZBUS_HTTP_CHANNEL(alarm_chan, alarm_msg_descr, false),
+};
+
+const size_t app_channel_count = ARRAY_SIZE(app_channels);
+
+static bool alarm_config_valid(const void *msg, size_t msg_size)
+{
+	const struct alarm_config_msg *config = msg;
+
+	return config->threshold >= 0 && config->threshold <= 1000;
+}
+
+static void alarm_listener_cb(const struct zbus_channel *chan);
+
+ZBUS_LISTENER_DEFINE(alarm_listener, alarm_listener_cb);
+
+ZBUS_CHAN_DEFINE(load_chan,
+		 struct load_msg,
+		 NULL,
+		 NULL,
+		 ZBUS_OBSERVERS(alarm_listener, zbus_http_listener),
+		 ZBUS_MSG_INIT(0));
+
+ZBUS_CHAN_DEFINE(alarm_config_chan,
+		 struct alarm_config_msg,
+		 alarm_config_valid,
+		 NULL,
+		 ZBUS_OBSERVERS(zbus_http_listener),
+		 ZBUS_MSG_INIT(.threshold = ALARM_THRESHOLD, .enabled = true));
+
+ZBUS_CHAN_DEFINE(alarm_chan,
+		 struct alarm_msg,
+		 NULL,
+		 NULL,
+		 ZBUS_OBSERVERS(zbus_http_listener),
+		 ZBUS_MSG_INIT(0));
+
+/**
+ * Compare every load sample with the threshold, publish the changes only
+ */
+static void alarm_listener_cb(const struct zbus_channel *chan)
+{
+	static bool active;
+	const struct load_msg *load = zbus_chan_const_msg(chan);
+	struct alarm_config_msg config;
+	struct alarm_msg alarm;
+
+	if (zbus_chan_read(&alarm_config_chan, &config, K_NO_WAIT) != 0)
+	{
+		return;
+	}
+
+	alarm.active = config.enabled && load->load >= config.threshold;
+	if (alarm.active == active)
+	{
+		return;
+	}
+
+	active = alarm.active;
+	alarm.load = load->load;
+	printk("[ALARM] CPU load %d.%d%% %s\n", load->load / 10, load->load % 10,
+	       active ? "over the threshold" : "back to normal");
+	zbus_chan_pub(&alarm_chan, &alarm, K_NO_WAIT);
+}
@@ -0,0 +1,46 @@
+/*
+ * zbus channels of the application, bridged to HTTP at /chan/<name>
+ */
+
+#ifndef CHANNELS_H
+#define CHANNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/zbus/zbus.h>
+
+#include "zbus_http.h"
+
+/* JSON numbers are int32_t for json_obj_descr, the fields that the bridge
+ * encodes are int32_t or bool */
+
+/* CPU load, published by the history sampler every HISTORY_PERIOD_MS */
+struct load_msg
+{
+	int32_t uptime_s;
+	int32_t load;                       /* Permille */
+};
+
+/* Load alarm settings, written with POST /chan/alarm_config_chan */
+struct alarm_config_msg
+{
+	int32_t threshold;                  /* Permille, 0..1000 */
+	bool enabled;
+};
+
+/* Load alarm, published when it goes on or off */
+struct alarm_msg
+{
+	bool active;
+	int32_t load;                       /* Load that changed the state */
+};
+
+ZBUS_CHAN_DECLARE(load_chan, alarm_config_chan, alarm_chan);
+
+/* Bridge table of the channels above, for zbus_http_start() */
+extern const struct zbus_http_channel app_channels[];
+extern const size_t app_channel_count;
+
+#endif /* CHANNELS_H */
@@ -0,0 +1,133 @@
+/**
+ * CPU load history
+ *
+ * A delayable work item samples the CPU load every HISTORY_PERIOD_MS into a
+ * ring of HISTORY_SAMPLES values. /history streams the whole ring as JSON
+ * through http_stream: about 25 bytes per sample, 90 KB for the default
+ * hour, sent from a HTTP_STREAM_CHUNK_SIZE buffer.
+ *
+ * The ring position is captured when a response starts. Samples taken
+ * while it is being sent are left for the next request (with a very slow
+ * client the oldest ones may already have been overwritten by then).
+ *
+ * Every sample is also published on load_chan (zbus), for the load alarm
+ * and /chan/load_chan.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+
+#include "channels.h"
+#include "history.h"
+#include "http_stream.h"
+
+static uint16_t samples[HISTORY_SAMPLES];     /* CPU load, permille */
+static uint32_t head;                         /* Next slot written */
+static uint32_t count;                        /* Valid samples */
+static int64_t newest_ms;                     /* Uptime of the newest sample */
+static struct k_spinlock lock;
+
+static uint64_t last_execution;
+static uint64_t last_idle;
+static struct k_work_delayable sample_work;
+
+// Ring position of the response being streamed
+static uint32_t snap_first;
+static uint32_t snap_count;
+static int64_t snap_newest_ms;
+
+static void sample_handler(struct k_work *work)
+{
+	k_thread_runtime_stats_t stats;
+	struct load_msg msg;
+	uint64_t execution;
+	uint64_t idle;
+	k_spinlock_key_t key;
+	uint16_t load = 0;
+
+	// All CPU cycles (busy and idle) and idle cycles since the last sample
+	k_thread_runtime_stats_all_get(&stats);
+	execution = stats.execution_cycles - last_execution;
+	idle = stats.idle_cycles - last_idle;
+	last_execution = stats.execution_cycles;
+	last_idle = stats.idle_cycles;
+
+	if (execution > 0)
+	{
+		load = (uint16_t)((execution - MIN(idle, execution)) * 1000 / execution);
+	}
+
+	key = k_spin_lock(&lock);
+	samples[head] = load;
+	head = (head + 1) % HISTORY_SAMPLES;
+	count = MIN(count + 1, HISTORY_SAMPLES);
+	newest_ms = k_uptime_get();
+	k_spin_unlock(&lock, key);
+
+	msg.uptime_s = (int32_t)(k_uptime_get() / 1000);
+	msg.load = load;
+	zbus_chan_pub(&load_chan, &msg, K_NO_WAIT);
+
+	k_work_schedule(&sample_work, K_MSEC(HISTORY_PERIOD_MS));
+}
+
+void history_start(void)
+{
+	k_thread_runtime_stats_t stats;
+
+	k_thread_runtime_stats_all_get(&stats);
+	last_execution = stats.execution_cycles;
+	last_idle = stats.idle_cycles;
+
+	k_work_init_delayable(&sample_work, sample_handler);
+	k_work_schedule(&sample_work, K_MSEC(HISTORY_PERIOD_MS));
+}
+
+uint16_t history_last_load(void)
+{
+	k_spinlock_key_t key;
+	uint16_t load = 0;
+
+	key = k_spin_lock(&lock);
+	if (count > 0)
+	{
+		load = samples[(head + HISTORY_SAMPLES - 1) % HISTORY_SAMPLES];
+	}
+	k_spin_unlock(&lock, key);
+
+	return load;
+}
+
+int history_record(uint32_t index, char *buf, size_t len, void *user_data)
+{
+	k_spinlock_key_t key;
+	uint32_t n;
+	int64_t t_ms;
+
+	if (index == 0)
+	{
+		key = k_spin_lock(&lock);
+		snap_count = count;
+		snap_first = (head + HISTORY_SAMPLES - count) % HISTORY_SAMPLES;
+		snap_newest_ms = newest_ms;
+		k_spin_unlock(&lock, key);
+
+		return http_stream_printf(buf, len, "{\"period_ms\":%d,\"samples\":[",
+					  HISTORY_PERIOD_MS);
+	}
+
+	n = index - 1;
+	if (n < snap_count)
+	{
+		t_ms = snap_newest_ms - (int64_t)(snap_count - 1 - n) * HISTORY_PERIOD_MS;
+		return http_stream_printf(buf, len, "%s{\"t\":%u,\"load\":%u}", (n > 0) ? "," : "",
+					  (uint32_t)(t_ms / 1000),
+					  samples[(snap_first + n) % HISTORY_SAMPLES]);
+	}
+	if (n == snap_count)
+	{
+		return http_stream_printf(buf, len, "]}");
+	}
+
+	return 0;
+}
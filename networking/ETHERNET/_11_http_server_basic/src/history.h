@@ -0,0 +1,34 @@
+/*
+ * CPU load history, sampled in the background and streamed at /history
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* One sample every HISTORY_PERIOD_MS, the last HISTORY_SAMPLES are kept
+ * (2 bytes each: 3600 samples = 1 hour = 7 KB of RAM) */
+#define HISTORY_PERIOD_MS 1000
+#define HISTORY_SAMPLES 3600
+
+/**
+ *  @brief Start sampling (CPU load from CONFIG_SCHED_THREAD_USAGE_ALL)
+ */
+void history_start(void);
+
+/**
+ *  @brief CPU load of the newest sample, permille (0 before the first one)
+ */
+uint16_t history_last_load(void);
+
+/**
+ *  @brief Record callback for HTTP_STREAM_DEFINE(), formats the history as JSON
+ *
+ *  {"period_ms":1000,"samples":[{"t":12,"load":153},...]}, t is the uptime
+ *  in seconds and load the CPU load in permille, oldest sample first.
+ */
+int history_record(uint32_t index, char *buf, size_t len, void *user_data);
+
+#endif /* HISTORY_H */
@@ -0,0 +1,129 @@
+/**
+ * Streamed dynamic responses
+ *
+ * A dynamic resource that sets response_ctx->final_chunk = false is called
+ * again by the server as soon as the chunk has been sent, until a call
+ * sets final_chunk. Over HTTP/1.1 every call becomes one chunk of a
+ * "Transfer-Encoding: chunked" body, over HTTP/2 one DATA frame.
+ *
+ * http_stream_handler() builds on that: the body is produced by a record
+ * callback (one JSON element, one log line...), and each call packs as many
+ * records as fit into the resource's chunk buffer. The chunk is sent before
+ * the next call, so the same buffer is reused, and the RAM used stays
+ * HTTP_STREAM_CHUNK_SIZE whether the body is 100 bytes or 1 MB.
+ *
+ * The server thread runs one response to completion before the next, so a
+ * single state per resource is enough.
+ */
+
+#include <zephyr/kernel.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "access_log.h"
+#include "http_stream.h"
+#include "metrics.h"
+
+int http_stream_printf(char *buf, size_t len, const char *fmt, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, fmt);
+	ret = vsnprintf(buf, len, fmt, args);
+	va_end(args);
+
+	if (ret < 0)
+	{
+		return -EINVAL;
+	}
+	if ((size_t)ret >= len)
+	{
+		return -ENOSPC;
+	}
+
+	return ret;
+}
+
+int http_stream_handler(struct http_client_ctx *client, enum http_data_status status,
+			const struct http_request_ctx *request_ctx,
+			struct http_response_ctx *response_ctx, void *user_data)
+{
+	struct http_stream *stream = user_data;
+	bool done = false;
+	size_t len = 0;
+	int ret;
+
+	if (status == HTTP_SERVER_DATA_ABORTED)
+	{
+		printk("[HTTP] %s: aborted after %zu bytes\n", stream->name, stream->bytes);
+		stream->active = false;
+		return 0;
+	}
+
+	// A GET has no body, start once the request is complete
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	if (!stream->active)
+	{
+		stream->active = true;
+		stream->index = 0;
+		stream->chunks = 0;
+		stream->bytes = 0;
+		stream->method = client->method;
+		stream->start = access_log_timestamp();
+	}
+
+	// Pack records until the chunk is full or the body is complete
+	while (len < sizeof(stream->buf))
+	{
+		ret = stream->record(stream->index, (char *)stream->buf + len,
+				     sizeof(stream->buf) - len, stream->user_data);
+		if (ret == 0)
+		{
+			done = true;
+			break;
+		}
+		if (ret == -ENOSPC && len > 0)
+		{
+			// Retried at the start of the next chunk
+			break;
+		}
+		if (ret < 0)
+		{
+			// Also -ENOSPC in an empty chunk: the record can never fit
+			printk("[ERR] %s: record %u failed: %d\n", stream->name, stream->index, ret);
+			metrics_http_response(stream->name, HTTP_500_INTERNAL_SERVER_ERROR,
+					      stream->bytes);
+			access_log_write(stream->name, stream->method, HTTP_500_INTERNAL_SERVER_ERROR,
+					 stream->bytes, stream->start);
+			stream->active = false;
+			return ret;
+		}
+
+		len += ret;
+		stream->index++;
+	}
+
+	stream->chunks++;
+	stream->bytes += len;
+
+	response_ctx->body = stream->buf;
+	response_ctx->body_len = len;
+	response_ctx->final_chunk = done;
+
+	if (done)
+	{
+		metrics_http_response(stream->name, HTTP_200_OK, stream->bytes);
+		access_log_write(stream->name, stream->method, HTTP_200_OK, stream->bytes,
+				 stream->start);
+		stream->active = false;
+	}
+
+	return 0;
+}
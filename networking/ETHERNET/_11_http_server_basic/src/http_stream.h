@@ -0,0 +1,92 @@
+/*
+ * Streamed dynamic responses: a body of any size from one fixed chunk buffer
+ */
+
+#ifndef HTTP_STREAM_H
+#define HTTP_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/http/service.h>
+
+/* Bytes sent per chunk (HTTP/1.1 chunk or HTTP/2 DATA frame). This buffer
+ * is all the RAM a streamed response uses, whatever its total size */
+#define HTTP_STREAM_CHUNK_SIZE 512
+
+/**
+ *  @brief Format one record of a streamed body
+ *
+ *  Records are numbered from 0 for each response. A record must fit in
+ *  one chunk, several records are packed into each chunk.
+ *
+ *  @param index Record number
+ *  @param buf Free space of the current chunk
+ *  @param len Size of buf
+ *  @param user_data user_data of HTTP_STREAM_DEFINE()
+ *
+ *  @return Bytes written, 0 when there are no more records, -ENOSPC when
+ *          the record does not fit in len (it is asked again for the next
+ *          chunk), other negative errno to abort the response
+ */
+typedef int (*http_stream_record_cb_t)(uint32_t index, char *buf, size_t len, void *user_data);
+
+/* State of a streamed resource, one response at a time */
+struct http_stream
+{
+	const char *name;                   /* For the log */
+	http_stream_record_cb_t record;
+	void *user_data;
+	bool active;                        /* A response is in progress */
+	uint32_t index;                     /* Next record */
+	uint32_t chunks;
+	size_t bytes;
+	uint8_t method;                     /* Of the request, for the access log */
+	uint32_t start;                     /* access_log_timestamp() */
+	uint8_t buf[HTTP_STREAM_CHUNK_SIZE];
+};
+
+/**
+ *  @brief Define a dynamic resource detail whose body is streamed record by record
+ *
+ *  @param _name Resource detail variable, used with HTTP_RESOURCE_DEFINE()
+ *  @param _record Record callback (http_stream_record_cb_t)
+ *  @param _user_data Passed to the record callback
+ *  @param _type Content-Type
+ */
+#define HTTP_STREAM_DEFINE(_name, _record, _user_data, _type)               \
+	static struct http_stream _name##_stream = {                        \
+		.name = #_name,                                             \
+		.record = _record,                                          \
+		.user_data = _user_data,                                    \
+	};                                                                  \
+	static struct http_resource_detail_dynamic _name = {                \
+		.common = {                                                 \
+			.type = HTTP_RESOURCE_TYPE_DYNAMIC,                 \
+			.bitmask_of_supported_http_methods = BIT(HTTP_GET), \
+			.content_type = _type,                              \
+		},                                                          \
+		.cb = http_stream_handler,                                  \
+		.user_data = &_name##_stream,                               \
+	}
+
+/**
+ *  @brief Dynamic resource callback, user_data is the struct http_stream
+ *
+ *  The server calls it again after every chunk until final_chunk is set.
+ *  Each call packs the next records into the chunk buffer.
+ */
+int http_stream_handler(struct http_client_ctx *client, enum http_data_status status,
+			const struct http_request_ctx *request_ctx,
+			struct http_response_ctx *response_ctx, void *user_data);
+
+/**
+ *  @brief snprintf() for record callbacks
+ *
+ *  @return Bytes written, -ENOSPC when the text does not fit in len
+ */
+int http_stream_printf(char *buf, size_t len, const char *fmt, ...);
+
+#endif /* HTTP_STREAM_H */
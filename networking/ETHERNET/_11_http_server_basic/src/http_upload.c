@@ -0,0 +1,260 @@
+/**
+ * Streamed uploads
+ *
+ * The server hands a request body to a dynamic resource in fragments, one
+ * callback per received buffer, the last one with HTTP_SERVER_DATA_FINAL.
+ * http_upload_handler() passes every fragment straight to a sink (a CRC,
+ * a flash write...) and only answers once the body is complete, so an
+ * upload of any size needs no more RAM than the server's receive buffer
+ * and HTTP_UPLOAD_RESPONSE_SIZE.
+ *
+ * Oversized bodies are refused with 413 Payload Too Large:
+ * - Content-Length above max_size: on the first fragment, before the sink
+ *   sees any byte, so the client gets the answer while it is still sending
+ * - Chunked body (no Content-Length): as soon as the received bytes pass
+ *   max_size, the sink is told the upload failed
+ *
+ * The server keeps calling the handler until the end of the request, the
+ * rest of a refused body is dropped.
+ *
+ * Request bodies are not received one at a time: the server thread reads
+ * whichever client has data, so the fragments of two POSTs interleave.
+ * The resource has one state, owned by the client whose body it receives.
+ * A second client's body meanwhile is dropped and answered with 409
+ * Conflict, it never reaches the sink.
+ */
+
+#include <zephyr/kernel.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "access_log.h"
+#include "http_stream.h"
+#include "http_upload.h"
+#include "metrics.h"
+
+HTTP_SERVER_REGISTER_HEADER_CAPTURE(capture_content_length, "Content-Length");
+
+ssize_t http_upload_content_length(const struct http_request_ctx *request_ctx)
+{
+	const char *value = NULL;
+	char *end;
+	unsigned long length;
+	size_t i;
+
+	if (request_ctx->headers_status != HTTP_HEADER_STATUS_OK)
+	{
+		return -1;
+	}
+
+	for (i = 0; i < request_ctx->header_count; i++)
+	{
+		if (strcasecmp(request_ctx->headers[i].name, "Content-Length") == 0)
+		{
+			value = request_ctx->headers[i].value;
+			break;
+		}
+	}
+
+	if (value == NULL || *value == '\0')
+	{
+		return -1;
+	}
+
+	length = strtoul(value, &end, 10);
+	if (*end != '\0' || length > INT32_MAX)
+	{
+		return -1;
+	}
+
+	return (ssize_t)length;
+}
+
+/**
+ * Answer the request with an error, the rest of the body is dropped
+ */
+static void upload_reject(struct http_upload *upload, enum http_data_status status,
+			  enum http_status code, const char *reason,
+			  struct http_response_ctx *response_ctx)
+{
+	int len;
+
+	if (upload->active)
+	{
+		upload->sink->end(false, NULL, 0, upload->user_data);
+		upload->active = false;
+	}
+
+	// More fragments of this request follow unless this is the last one
+	upload->rejected = (status != HTTP_SERVER_DATA_FINAL);
+
+	len = http_stream_printf(upload->response, sizeof(upload->response),
+				 "{\"error\":\"%s\",\"max_size\":%zu}", reason, upload->max_size);
+
+	response_ctx->status = code;
+	response_ctx->body = (const uint8_t *)upload->response;
+	response_ctx->body_len = (len > 0) ? len : 0;
+	response_ctx->final_chunk = true;
+
+	metrics_http_response(upload->name, code, response_ctx->body_len);
+	access_log_write(upload->name, upload->method, code, response_ctx->body_len,
+			 upload->timestamp);
+}
+
+/**
+ * Request of another client while an upload is in progress: drop its body,
+ * 409 once it is complete
+ */
+static void upload_busy(struct http_upload *upload, const struct http_client_ctx *client,
+			enum http_data_status status, struct http_response_ctx *response_ctx)
+{
+	static const char busy[] = "{\"error\":\"upload in progress\"}";
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return;
+	}
+
+	response_ctx->status = HTTP_409_CONFLICT;
+	response_ctx->body = (const uint8_t *)busy;
+	response_ctx->body_len = sizeof(busy) - 1;
+	response_ctx->final_chunk = true;
+
+	metrics_http_response(upload->name, HTTP_409_CONFLICT, response_ctx->body_len);
+	access_log_write(upload->name, client->method, HTTP_409_CONFLICT, response_ctx->body_len,
+			 access_log_timestamp());
+}
+
+/**
+ * Summary of a complete upload: size, time, throughput and the sink's result
+ */
+static void upload_complete(struct http_upload *upload, struct http_response_ctx *response_ctx)
+{
+	uint32_t ms = (uint32_t)(k_uptime_get() - upload->start);
+	uint32_t kib_s = (uint32_t)((uint64_t)upload->bytes * 1000 / 1024 / MAX(ms, 1));
+	size_t len;
+	int ret;
+
+	ret = http_stream_printf(upload->response, sizeof(upload->response),
+				 "{\"bytes\":%zu,\"fragments\":%u,\"ms\":%u,\"kib_s\":%u,\"sink\":",
+				 upload->bytes, upload->fragments, ms, kib_s);
+	len = (ret > 0) ? ret : 0;
+
+	// Room for the closing brace
+	ret = upload->sink->end(true, upload->response + len, sizeof(upload->response) - len - 1,
+				upload->user_data);
+	if (ret <= 0)
+	{
+		ret = http_stream_printf(upload->response + len,
+					 sizeof(upload->response) - len - 1, "null");
+	}
+	len += MAX(ret, 0);
+	upload->response[len++] = '}';
+
+	response_ctx->status = HTTP_200_OK;
+	response_ctx->body = (const uint8_t *)upload->response;
+	response_ctx->body_len = len;
+	response_ctx->final_chunk = true;
+
+	metrics_http_response(upload->name, HTTP_200_OK, len);
+	access_log_write(upload->name, upload->method, HTTP_200_OK, len, upload->timestamp);
+}
+
+int http_upload_handler(struct http_client_ctx *client, enum http_data_status status,
+			const struct http_request_ctx *request_ctx,
+			struct http_response_ctx *response_ctx, void *user_data)
+{
+	struct http_upload *upload = user_data;
+	ssize_t content_length;
+	int ret;
+
+	if ((upload->active || upload->rejected) && client != upload->client)
+	{
+		// Not the owner: never touches the upload in progress
+		if (status != HTTP_SERVER_DATA_ABORTED)
+		{
+			upload_busy(upload, client, status, response_ctx);
+		}
+		return 0;
+	}
+
+	if (status == HTTP_SERVER_DATA_ABORTED)
+	{
+		if (upload->active)
+		{
+			printk("[HTTP] %s: aborted after %zu bytes\n", upload->name, upload->bytes);
+			upload->sink->end(false, NULL, 0, upload->user_data);
+		}
+		upload->active = false;
+		upload->rejected = false;
+		return 0;
+	}
+
+	if (upload->rejected)
+	{
+		// Drop the rest of a refused body, the next request starts after FINAL
+		upload->rejected = (status != HTTP_SERVER_DATA_FINAL);
+		return 0;
+	}
+
+	// First fragment of a new request
+	if (!upload->active)
+	{
+		upload->client = client;
+		upload->bytes = 0;
+		upload->fragments = 0;
+		upload->start = k_uptime_get();
+		upload->method = client->method;
+		upload->timestamp = access_log_timestamp();
+
+		content_length = http_upload_content_length(request_ctx);
+		if (content_length > (ssize_t)upload->max_size)
+		{
+			upload_reject(upload, status, HTTP_413_PAYLOAD_TOO_LARGE,
+				      "Content-Length too large", response_ctx);
+			return 0;
+		}
+
+		ret = upload->sink->begin(content_length, upload->user_data);
+		if (ret < 0)
+		{
+			upload_reject(upload, status, HTTP_500_INTERNAL_SERVER_ERROR, "sink refused",
+				      response_ctx);
+			return 0;
+		}
+		upload->active = true;
+	}
+
+	if (request_ctx->data_len > 0)
+	{
+		if (upload->bytes + request_ctx->data_len > upload->max_size)
+		{
+			upload_reject(upload, status, HTTP_413_PAYLOAD_TOO_LARGE, "body too large",
+				      response_ctx);
+			return 0;
+		}
+
+		ret = upload->sink->write(request_ctx->data, request_ctx->data_len,
+					  upload->user_data);
+		if (ret < 0)
+		{
+			upload_reject(upload, status, HTTP_500_INTERNAL_SERVER_ERROR,
+				      "sink write failed", response_ctx);
+			return 0;
+		}
+
+		upload->bytes += request_ctx->data_len;
+		upload->fragments++;
+	}
+
+	if (status == HTTP_SERVER_DATA_FINAL)
+	{
+		upload_complete(upload, response_ctx);
+		upload->active = false;
+	}
+
+	return 0;
+}
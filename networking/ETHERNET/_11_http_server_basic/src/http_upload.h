@@ -0,0 +1,115 @@
+/*
+ * Streamed uploads: a request body of bounded size consumed by a sink, fixed RAM
+ */
+
+#ifndef HTTP_UPLOAD_H
+#define HTTP_UPLOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/http/service.h>
+
+/* Response body buffer (upload summary or error) */
+#define HTTP_UPLOAD_RESPONSE_SIZE 160
+
+/* Consumer of an upload body. The data pointers are only valid during the
+ * call, the sink keeps what it needs (a running CRC, a flash write
+ * offset...), never the body */
+struct http_upload_sink
+{
+	/**
+	 *  @brief A new body starts
+	 *
+	 *  @param content_length Announced size, -1 when unknown (chunked)
+	 *  @return 0, or a negative errno to refuse the upload (500)
+	 */
+	int (*begin)(ssize_t content_length, void *user_data);
+
+	/**
+	 *  @brief Next fragment of the body, in order
+	 *
+	 *  @return 0, or a negative errno to stop the upload (500)
+	 */
+	int (*write)(const uint8_t *data, size_t len, void *user_data);
+
+	/**
+	 *  @brief The body is complete (complete = true) or the upload failed
+	 *
+	 *  On success, format the sink's result as a JSON value in buf, it is
+	 *  sent in the response as "sink".
+	 *
+	 *  @return Bytes written to buf (0 for null), ignored when !complete
+	 */
+	int (*end)(bool complete, char *buf, size_t len, void *user_data);
+};
+
+/* State of an upload resource, one upload at a time */
+struct http_upload
+{
+	const char *name;                   /* For the log */
+	const struct http_upload_sink *sink;
+	void *user_data;
+	size_t max_size;                    /* Larger bodies get 413 */
+	const struct http_client_ctx *client; /* Owner of the body being received */
+	bool active;                        /* Body being received */
+	bool rejected;                      /* Answered, rest of the body ignored */
+	size_t bytes;
+	uint32_t fragments;
+	int64_t start;
+	uint8_t method;                     /* Of the request, for the access log */
+	uint32_t timestamp;                 /* access_log_timestamp() */
+	char response[HTTP_UPLOAD_RESPONSE_SIZE];
+};
+
+/**
+ *  @brief Define a dynamic resource detail that streams POST bodies into a sink
+ *
+ *  @param _name Resource detail variable, used with HTTP_RESOURCE_DEFINE()
+ *  @param _sink struct http_upload_sink
+ *  @param _user_data Passed to the sink callbacks
+ *  @param _max_size Largest body accepted, bytes
+ */
+#define HTTP_UPLOAD_DEFINE(_name, _sink, _user_data, _max_size)             \
+	static struct http_upload _name##_upload = {                        \
+		.name = #_name,                                             \
+		.sink = _sink,                                              \
+		.user_data = _user_data,                                    \
+		.max_size = _max_size,                                      \
+	};                                                                  \
+	static struct http_resource_detail_dynamic _name = {                \
+		.common = {                                                 \
+			.type = HTTP_RESOURCE_TYPE_DYNAMIC,                 \
+			.bitmask_of_supported_http_methods = BIT(HTTP_POST) \
+				| BIT(HTTP_PUT),                            \
+			.content_type = "application/json",                 \
+		},                                                          \
+		.cb = http_upload_handler,                                  \
+		.user_data = &_name##_upload,                               \
+	}
+
+/**
+ *  @brief Dynamic resource callback, user_data is the struct http_upload
+ *
+ *  A Content-Length above max_size is answered with 413 on the first
+ *  fragment, before the sink sees any data. A chunked body is cut off
+ *  with 413 as soon as it grows past max_size. The rest of a rejected
+ *  body is received and dropped. A body from another client while one is
+ *  in progress is dropped too and answered with 409 Conflict at its end.
+ */
+int http_upload_handler(struct http_client_ctx *client, enum http_data_status status,
+			const struct http_request_ctx *request_ctx,
+			struct http_response_ctx *response_ctx, void *user_data);
+
+/**
+ *  @brief Content-Length of the request, -1 when absent or invalid
+ *
+ *  Needs the header capture (CONFIG_HTTP_SERVER_CAPTURE_HEADERS), see
+ *  http_upload.c.
+ */
+ssize_t http_upload_content_length(const struct http_request_ctx *request_ctx);
+
+#endif /* HTTP_UPLOAD_H */
@@ -0,0 +1,334 @@
+/**
+ * Live device updates pushed over WebSocket
+ *
+ * The web UI used to poll /device-info every 2 s. Every poll is a full
+ * request and response (about 400 bytes of headers and JSON) and takes one
+ * of the MAX_HTTP_CLIENTS server slots while it runs. /live replaces that:
+ * - The browser opens one WebSocket. The HTTP server hands the upgraded
+ *   socket over to live_ws_setup() and frees its client slot
+ * - The first frame carries the whole device info, the following ones only
+ *   what changes: {"uptime":12345,"load":153}, about 30 bytes plus the
+ *   2-byte frame header
+ * - One push thread serves all clients, each at its own period (the client
+ *   may send "period <ms>"). It sleeps in poll() until the next update is
+ *   due, and an eventfd in the poll set wakes it when a client connects
+ *
+ * Updates are coalesced, never queued. The frame is built from the current
+ * state at the moment it is sent, and it is only sent when the client's
+ * socket can take it without blocking. A slow client or a full TCP window
+ * skips the tick (counted as coalesced) and gets the latest state at the
+ * next one, so a slow browser costs no RAM and never stalls the others.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/websocket.h>
+#include <zephyr/posix/sys/eventfd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "history.h"
+#include "http_stream.h"
+#include "live.h"
+
+/* Send timeout once the socket reported it is writable */
+#define LIVE_SEND_TIMEOUT_MS 100
+
+/* One connected browser */
+struct live_client
+{
+	int ws;                             /* WebSocket, -1 when the slot is free */
+	uint32_t period_ms;
+	int64_t next_ms;                    /* Next update due */
+	uint32_t frames;
+	uint32_t bytes;                     /* Payload bytes pushed */
+	uint32_t coalesced;                 /* Ticks skipped, socket not writable */
+};
+
+static struct live_client clients[LIVE_MAX_CLIENTS] = {
+	[0 ... LIVE_MAX_CLIENTS - 1] = { .ws = -1 },
+};
+static K_MUTEX_DEFINE(clients_lock);
+
+// Written by live_ws_setup() for a new client
+static int wake_fd = -1;
+
+static K_THREAD_STACK_DEFINE(live_stack, LIVE_STACK_SIZE);
+static struct k_thread live_thread;
+
+static uint8_t ws_buffer[LIVE_MSG_SIZE];
+
+/**
+ * Format an update: the full device info for the first frame, the changing
+ * fields after that
+ */
+static int live_format(char *buf, size_t len, bool full)
+{
+	if (full)
+	{
+		return http_stream_printf(buf, len,
+					  "{\"board\":\"STM32H573I-DK\",\"arch\":\"ARM Cortex-M33\","
+					  "\"status\":\"Running\",\"uptime\":%" PRId64 ",\"load\":%u}",
+					  k_uptime_get(), history_last_load());
+	}
+
+	return http_stream_printf(buf, len, "{\"uptime\":%" PRId64 ",\"load\":%u}",
+				  k_uptime_get(), history_last_load());
+}
+
+static int live_send(struct live_client *client, bool full)
+{
+	char msg[LIVE_MSG_SIZE];
+	int len;
+	int ret;
+
+	len = live_format(msg, sizeof(msg), full);
+	if (len < 0)
+	{
+		return len;
+	}
+
+	ret = websocket_send_msg(client->ws, (uint8_t *)msg, len, WEBSOCKET_OPCODE_DATA_TEXT,
+				 false, true, LIVE_SEND_TIMEOUT_MS);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	client->frames++;
+	client->bytes += len;
+	return 0;
+}
+
+static void live_close(struct live_client *client, const char *reason)
+{
+	printk("[LIVE] Client %d closed (%s): %u frames, %u bytes (%u per frame), %u coalesced\n",
+	       (int)(client - clients), reason, client->frames, client->bytes,
+	       client->frames ? client->bytes / client->frames : 0, client->coalesced);
+
+	websocket_unregister(client->ws);
+
+	k_mutex_lock(&clients_lock, K_FOREVER);
+	client->ws = -1;
+	k_mutex_unlock(&clients_lock);
+}
+
+/**
+ * Handle a message from the client: a close, or "period <ms>"
+ *
+ * @return false when the client is gone
+ */
+static bool live_receive(struct live_client *client)
+{
+	char msg[LIVE_MSG_SIZE];
+	uint32_t message_type;
+	uint64_t remaining;
+	int ret;
+
+	ret = websocket_recv_msg(client->ws, (uint8_t *)msg, sizeof(msg) - 1, &message_type,
+				 &remaining, 0);
+	if (ret == -EAGAIN)
+	{
+		return true;
+	}
+	if (ret < 0 || (message_type & WEBSOCKET_FLAG_CLOSE))
+	{
+		live_close(client, (ret < 0) ? "error" : "by client");
+		return false;
+	}
+
+	msg[ret] = '\0';
+	if ((message_type & WEBSOCKET_FLAG_TEXT) && strncmp(msg, "period ", 7) == 0)
+	{
+		client->period_ms = CLAMP(strtoul(msg + 7, NULL, 10), LIVE_MIN_PERIOD_MS,
+					  LIVE_MAX_PERIOD_MS);
+		client->next_ms = MIN(client->next_ms, k_uptime_get() + client->period_ms);
+		printk("[LIVE] Client %d: period %u ms\n", (int)(client - clients),
+		       client->period_ms);
+	}
+
+	return true;
+}
+
+/**
+ * Check if a frame can be sent without blocking
+ */
+static bool live_writable(int ws)
+{
+	struct zsock_pollfd pfd = {
+		.fd = ws,
+		.events = ZSOCK_POLLOUT,
+	};
+
+	return zsock_poll(&pfd, 1, 0) > 0 && (pfd.revents & ZSOCK_POLLOUT);
+}
+
+static void live_thread_fn(void *p1, void *p2, void *p3)
+{
+	// Slot 0 is the eventfd, slot i + 1 belongs to active[i]
+	struct zsock_pollfd fds[LIVE_MAX_CLIENTS + 1];
+	struct live_client *active[LIVE_MAX_CLIENTS];
+	struct live_client *client;
+	eventfd_t value;
+	int64_t next_ms;
+	int64_t now;
+	int count;
+	int i;
+
+	while (1)
+	{
+		// Snapshot of the connected clients and the earliest update due
+		count = 0;
+		next_ms = INT64_MAX;
+
+		k_mutex_lock(&clients_lock, K_FOREVER);
+		for (i = 0; i < LIVE_MAX_CLIENTS; i++)
+		{
+			if (clients[i].ws >= 0)
+			{
+				active[count] = &clients[i];
+				fds[count + 1].fd = clients[i].ws;
+				fds[count + 1].events = ZSOCK_POLLIN;
+				fds[count + 1].revents = 0;
+				next_ms = MIN(next_ms, clients[i].next_ms);
+				count++;
+			}
+		}
+		k_mutex_unlock(&clients_lock);
+
+		fds[0].fd = wake_fd;
+		fds[0].events = ZSOCK_POLLIN;
+		fds[0].revents = 0;
+
+		// Wait for client messages until the next update is due, or for a
+		// new client (its period may be shorter than the current wait)
+		now = k_uptime_get();
+		zsock_poll(fds, count + 1,
+			   (count == 0) ? -1 : (int)CLAMP(next_ms - now, 0, LIVE_MAX_PERIOD_MS));
+
+		if (fds[0].revents & ZSOCK_POLLIN)
+		{
+			eventfd_read(wake_fd, &value);
+		}
+
+		now = k_uptime_get();
+		for (i = 0; i < count; i++)
+		{
+			client = active[i];
+
+			if (fds[i + 1].revents & (ZSOCK_POLLERR | ZSOCK_POLLHUP | ZSOCK_POLLNVAL))
+			{
+				live_close(client, "connection lost");
+				continue;
+			}
+			if ((fds[i + 1].revents & ZSOCK_POLLIN) && !live_receive(client))
+			{
+				continue;
+			}
+			if (now < client->next_ms)
+			{
+				continue;
+			}
+
+			client->next_ms += client->period_ms;
+			if (client->next_ms <= now)
+			{
+				// Fell behind (slow socket), realign instead of bursting
+				client->next_ms = now + client->period_ms;
+			}
+
+			if (!live_writable(client->ws))
+			{
+				client->coalesced++;
+				continue;
+			}
+			if (live_send(client, false) < 0)
+			{
+				live_close(client, "send failed");
+			}
+		}
+	}
+}
+
+/**
+ * Called by the HTTP server after the WebSocket upgrade, the socket is ours
+ */
+static int live_ws_setup(int ws_socket, struct http_request_ctx *request_ctx, void *user_data)
+{
+	struct live_client client = {
+		.ws = ws_socket,
+		.period_ms = LIVE_PERIOD_MS,
+	};
+	int slot = -1;
+	int i;
+
+	if (wake_fd < 0)
+	{
+		// No push thread
+		return -ENOENT;
+	}
+
+	// Only the server thread fills slots, a free one stays free until then
+	k_mutex_lock(&clients_lock, K_FOREVER);
+	for (i = 0; i < LIVE_MAX_CLIENTS; i++)
+	{
+		if (clients[i].ws < 0)
+		{
+			slot = i;
+			break;
+		}
+	}
+	k_mutex_unlock(&clients_lock);
+
+	if (slot < 0)
+	{
+		printk("[LIVE] No free slot (%d clients)\n", LIVE_MAX_CLIENTS);
+		return -ENOENT;
+	}
+
+	// Whole state right away, before the push thread sees the client
+	if (live_send(&client, true) < 0)
+	{
+		printk("[LIVE] First update failed\n");
+		websocket_unregister(ws_socket);
+		return 0;
+	}
+
+	client.next_ms = k_uptime_get() + client.period_ms;
+
+	k_mutex_lock(&clients_lock, K_FOREVER);
+	clients[slot] = client;
+	k_mutex_unlock(&clients_lock);
+
+	printk("[LIVE] Client %d connected\n", slot);
+	eventfd_write(wake_fd, 1);
+	return 0;
+}
+
+struct http_resource_detail_websocket live_resource_detail = {
+	.common = {
+		.type = HTTP_RESOURCE_TYPE_WEBSOCKET,
+		.bitmask_of_supported_http_methods = BIT(HTTP_GET),
+	},
+	.cb = live_ws_setup,
+	.data_buffer = ws_buffer,
+	.data_buffer_len = sizeof(ws_buffer),
+	.user_data = NULL,
+};
+
+void live_start(void)
+{
+	wake_fd = eventfd(0, EFD_NONBLOCK);
+	if (wake_fd < 0)
+	{
+		printk("[LIVE] Failed to create eventfd: %d\n", -errno);
+		return;
+	}
+
+	k_thread_create(&live_thread, live_stack, K_THREAD_STACK_SIZEOF(live_stack),
+			live_thread_fn, NULL, NULL, NULL, LIVE_PRIORITY, 0, K_NO_WAIT);
+	k_thread_name_set(&live_thread, "live");
+}
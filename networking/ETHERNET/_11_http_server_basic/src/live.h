@@ -0,0 +1,36 @@
+/*
+ * Live device updates pushed over WebSocket (/live)
+ */
+
+#ifndef LIVE_H
+#define LIVE_H
+
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/http/service.h>
+
+/* Browsers connected at the same time. Keep CONFIG_WEBSOCKET_MAX_CONTEXTS
+ * at least as large */
+#define LIVE_MAX_CLIENTS 2
+
+/* Update interval, a client can ask for another one within the limits by
+ * sending "period <ms>" */
+#define LIVE_PERIOD_MS 1000
+#define LIVE_MIN_PERIOD_MS 100
+#define LIVE_MAX_PERIOD_MS 60000
+
+/* Push thread, below the HTTP server so pushes never delay requests */
+#define LIVE_STACK_SIZE 2048
+#define LIVE_PRIORITY 8
+
+/* Text frame payloads (sent and received) */
+#define LIVE_MSG_SIZE 128
+
+/* WebSocket resource detail, used with HTTP_RESOURCE_DEFINE() */
+extern struct http_resource_detail_websocket live_resource_detail;
+
+/**
+ *  @brief Start the push thread
+ */
+void live_start(void);
+
+#endif /* LIVE_H */
@@ -3,6 +3,7 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <errno.h>
 #include <stdio.h>
 #include <inttypes.h>
 #include <string.h>
@@ -13,108 +14,98 @@
 #include <zephyr/net/net_ip.h>
 #include <zephyr/net/socket.h>
 #include <zephyr/net/net_config.h>
+#include <zephyr/sys/crc.h>
+
+#include "access_log.h"
+#include "api.h"
+#include "channels.h"
+#include "history.h"
+#include "http_stream.h"
+#include "http_upload.h"
+#include "live.h"
+#include "metrics.h"
+#include "rate_limit.h"
+#include "web_assets.h"
+#include "zbus_http.h"
 
 // HTTP server configuration
 #define HTTP_SERVER_PORT 8080
 #define MAX_HTTP_CLIENTS 4
 
+// Request body limits (larger bodies get 413 Payload Too Large)
+#define ECHO_MAX_SIZE 4096
+#define UPLOAD_MAX_SIZE (1024 * 1024)
+
 // =============================================================================
-// STATIC RESOURCES (Compressed with gzip)
+// STATIC RESOURCES (identity, gzip and brotli variants)
 // =============================================================================
 
-// HTML content - compressed at build time
-static const uint8_t index_html_gz[] = {
-#include "index.html.gz.inc"
-};
+// HTML content - encoded at build time (scripts/web_variants.py)
+#include "index.html.variants.inc"
 
-// JavaScript content - compressed at build time
-static const uint8_t main_js_gz[] = {
-#include "main.js.gz.inc"
-};
+// JavaScript content - encoded at build time
+#include "main.js.variants.inc"
 
 // =============================================================================
 // RESOURCE DEFINITIONS
 // =============================================================================
 
 // Index.html resource - served at "/" endpoint
-// Client sends: GET /
-// Server responds: HTML page (gzipped)
-static struct http_resource_detail_static index_html_resource_detail = {
-	.common = {
-		.type = HTTP_RESOURCE_TYPE_STATIC,
-		.bitmask_of_supported_http_methods = BIT(HTTP_GET),
-		.content_encoding = "gzip",
-		.content_type = "text/html",
-	},
-	.static_data = index_html_gz,
-	.static_data_len = sizeof(index_html_gz),
-};
+// Client sends: GET / (Accept-Encoding, If-None-Match: "<etag>" on a repeat load)
+// Server responds: HTML page (smallest accepted encoding), or 304 Not Modified
+WEB_ASSET_DEFINE(index_html_resource_detail, index_html_variants, "text/html");
 
 // Main.js resource - served at "/main.js" endpoint
-// Client sends: GET /main.js
-// Server responds: JavaScript file (gzipped)
-static struct http_resource_detail_static main_js_resource_detail = {
-	.common = {
-		.type = HTTP_RESOURCE_TYPE_STATIC,
-		.bitmask_of_supported_http_methods = BIT(HTTP_GET),
-		.content_encoding = "gzip",
-		.content_type = "text/javascript",
-	},
-	.static_data = main_js_gz,
-	.static_data_len = sizeof(main_js_gz),
-};
+// Client sends: GET /main.js (Accept-Encoding, If-None-Match: "<etag>" on a repeat load)
+// Server responds: JavaScript file (smallest accepted encoding), or 304 Not Modified
+WEB_ASSET_DEFINE(main_js_resource_detail, main_js_variants, "text/javascript");
 
 // =============================================================================
 // DYNAMIC RESOURCE HANDLERS
 // =============================================================================
 
-// Device info handler - returns device information as JSON
+// Device info - returns device information as JSON, streamed one field at a time
 // Client sends: GET /device-info
 // Server responds: JSON with board, architecture, uptime, status
-static int device_info_handler(struct http_client_ctx *client, enum http_data_status status,
-							   const struct http_request_ctx *request_ctx,
-							   struct http_response_ctx *response_ctx, void *user_data)
+// Each call of the record callback formats one field, so adding fields never
+// overflows a buffer (see http_stream.h)
+static int device_info_record(uint32_t index, char *buf, size_t len, void *user_data)
 {
-	// Buffer for JSON response
-	static char info_buf[256];
-	int len;
-
-	printk("[HTTP] Device info handler called, status: %d\n", status);
-
-	// Wait for all request data to be received before responding
-	if (status == HTTP_SERVER_DATA_FINAL)
+	switch (index)
 	{
-		// Build JSON response with device information
-		len = snprintf(info_buf, sizeof(info_buf),
-					   "{\"board\":\"STM32H573I-DK\","
-					   "\"arch\":\"ARM Cortex-M33\","
-					   "\"uptime\":%" PRId64 ","
-					   "\"status\":\"Running\"}",
-					   k_uptime_get());
-
-		if (len < 0 || len >= (int)sizeof(info_buf))
-		{
-			printk("[ERR] Failed to format device info\n");
-			return -ENOMEM;
-		}
-
-		// Set response body and mark as complete
-		response_ctx->body = (uint8_t *)info_buf;
-		response_ctx->body_len = len;
-		response_ctx->final_chunk = true;
+	case 0:
+		return http_stream_printf(buf, len, "{\"board\":\"STM32H573I-DK\",");
+	case 1:
+		return http_stream_printf(buf, len, "\"arch\":\"ARM Cortex-M33\",");
+	case 2:
+		return http_stream_printf(buf, len, "\"uptime\":%" PRId64 ",", k_uptime_get());
+	case 3:
+		return http_stream_printf(buf, len, "\"status\":\"Running\"}");
+	default:
+		return 0;
 	}
-
-	return 0;
 }
 
-static struct http_resource_detail_dynamic device_info_resource_detail = {
-	.common = {
-		.type = HTTP_RESOURCE_TYPE_DYNAMIC,
-		.bitmask_of_supported_http_methods = BIT(HTTP_GET),
-	},
-	.cb = device_info_handler,
-	.user_data = NULL,
-};
+HTTP_STREAM_DEFINE(device_info_resource_detail, device_info_record, NULL, "application/json");
+
+// History - CPU load samples of the last hour as JSON (about 90 KB)
+// Client sends: GET /history
+// Server responds: {"period_ms":1000,"samples":[{"t":12,"load":153},...]}
+// Streamed in HTTP_STREAM_CHUNK_SIZE chunks, see history.c
+HTTP_STREAM_DEFINE(history_resource_detail, history_record, NULL, "application/json");
+
+// Metrics - network, buffer, thread and HTTP counters in Prometheus text format
+// Client sends: GET /metrics (Prometheus scrape)
+// Server responds: "# HELP ...", "# TYPE ...", "net_rx_bytes_total 123456"...
+// Streamed one family header or sample per record, see metrics.c
+HTTP_STREAM_DEFINE(metrics_resource_detail, metrics_record, NULL,
+		   "text/plain; version=0.0.4");
+
+// Access log - the newest requests, one binary record each (see access_log.c)
+// Client sends: GET /logs
+// Server responds: {"dropped":0,"records":[{"t":1234,"method":"GET","resource":"..",
+// "status":200,"bytes":512,"us":830},...]}
+HTTP_STREAM_DEFINE(logs_resource_detail, access_log_json_record, NULL, "application/json");
 
 // Uptime handler - returns device uptime in milliseconds
 // Client sends: GET /uptime
@@ -125,8 +116,7 @@ static int uptime_handler(struct http_client_ctx *client, enum http_data_status
 {
 	int ret;
 	static uint8_t uptime_buf[sizeof(STRINGIFY(INT64_MAX))];
-
-	printk("[HTTP] Uptime handler called, status: %d\n", status);
+	uint32_t start = access_log_timestamp();
 
 	// Wait for all request data to be received before responding
 	// This is important for large requests that arrive in chunks
@@ -142,38 +132,91 @@ static int uptime_handler(struct http_client_ctx *client, enum http_data_status
 		response_ctx->body = uptime_buf;
 		response_ctx->body_len = ret;
 		response_ctx->final_chunk = true;
+		metrics_http_response("uptime_resource_detail", HTTP_200_OK, ret);
+		access_log_write("uptime_resource_detail", client->method, HTTP_200_OK, ret, start);
 	}
 
 	return 0;
 }
 
-static struct http_resource_detail_dynamic device_info_resource_detail = {
+static struct http_resource_detail_dynamic uptime_resource_detail = {
 	.common = {
 		.type = HTTP_RESOURCE_TYPE_DYNAMIC,
 		.bitmask_of_supported_http_methods = BIT(HTTP_GET),
 	},
-	.cb = device_info_handler,
+	.cb = uptime_handler,
 	.user_data = NULL,
 };
 
 // Echo handler - echoes back the received data
 // Client sends: GET /echo or POST /echo with body
 // Server responds: Same body data back to client
+// The fragments of two clients' bodies interleave on the server thread: the
+// echo belongs to one client at a time, another one meanwhile gets 409
 static int echo_handler(struct http_client_ctx *client, enum http_data_status status,
 			const struct http_request_ctx *request_ctx,
 			struct http_response_ctx *response_ctx, void *user_data)
 {
 	enum http_method method = client->method;
+	// Client of the echo in progress, NULL when there is none
+	static const struct http_client_ctx *echo_client;
+	static size_t echo_bytes;
+	static bool echo_rejected;
+	static uint32_t echo_start;
+
+	// Another client's request: body dropped, 409 once it is complete
+	if (echo_client != NULL && client != echo_client) {
+		if (status == HTTP_SERVER_DATA_FINAL) {
+			response_ctx->status = HTTP_409_CONFLICT;
+			response_ctx->final_chunk = true;
+			metrics_http_response("echo_resource_detail", HTTP_409_CONFLICT, 0);
+			access_log_write("echo_resource_detail", method, HTTP_409_CONFLICT, 0,
+					 access_log_timestamp());
+		}
+		return 0;
+	}
 
 	// Handle aborted transactions (connection closed by client)
 	if (status == HTTP_SERVER_DATA_ABORTED) {
 		printk("[HTTP] Echo transaction aborted\n");
+		echo_client = NULL;
+		echo_bytes = 0;
+		echo_rejected = false;
 		return 0;
 	}
 
-	// Log received data
-	if (request_ctx->data_len > 0) {
-		printk("[HTTP] %s received %zd bytes\n", http_method_str(method), request_ctx->data_len);
+	// Rest of a refused body, dropped until the end of the request
+	if (echo_rejected) {
+		echo_rejected = (status != HTTP_SERVER_DATA_FINAL);
+		echo_client = echo_rejected ? client : NULL;
+		return 0;
+	}
+
+	// First fragment of a new request
+	if (echo_client == NULL) {
+		echo_client = client;
+		echo_bytes = 0;
+		echo_start = access_log_timestamp();
+
+		// Announced body over the limit: 413 before echoing anything
+		if (http_upload_content_length(request_ctx) > ECHO_MAX_SIZE) {
+			response_ctx->status = HTTP_413_PAYLOAD_TOO_LARGE;
+			response_ctx->final_chunk = true;
+			echo_rejected = (status != HTTP_SERVER_DATA_FINAL);
+			echo_client = echo_rejected ? client : NULL;
+			metrics_http_response("echo_resource_detail", HTTP_413_PAYLOAD_TOO_LARGE, 0);
+			access_log_write("echo_resource_detail", method, HTTP_413_PAYLOAD_TOO_LARGE, 0,
+					 echo_start);
+			return 0;
+		}
+	}
+
+	// Chunked body over the limit: the echo has started, close the connection
+	if (echo_bytes + request_ctx->data_len > ECHO_MAX_SIZE) {
+		printk("[HTTP] Echo body over %d bytes, closing\n", ECHO_MAX_SIZE);
+		echo_client = NULL;
+		echo_bytes = 0;
+		return -EFBIG;
 	}
 
 	// Echo data back to client
@@ -182,6 +225,14 @@ static int echo_handler(struct http_client_ctx *client, enum http_data_status st
 	// Mark as final chunk if all data received
 	response_ctx->final_chunk = (status == HTTP_SERVER_DATA_FINAL);
 
+	echo_bytes += request_ctx->data_len;
+	if (response_ctx->final_chunk) {
+		metrics_http_response("echo_resource_detail", HTTP_200_OK, echo_bytes);
+		access_log_write("echo_resource_detail", method, HTTP_200_OK, echo_bytes, echo_start);
+		echo_client = NULL;
+		echo_bytes = 0;
+	}
+
 	return 0;
 }
 
@@ -194,6 +245,41 @@ static struct http_resource_detail_dynamic echo_resource_detail = {
 	.user_data = NULL,
 };
 
+// Upload sink - CRC32 of the body, computed fragment by fragment as it arrives
+// Client sends: POST /upload with any body up to UPLOAD_MAX_SIZE
+// Server responds: {"bytes":..,"fragments":..,"ms":..,"kib_s":..,"sink":{"crc32":"..."}}
+// The body is never stored, only the running CRC (see http_upload.h)
+static uint32_t upload_crc;
+
+static int crc_sink_begin(ssize_t content_length, void *user_data)
+{
+	upload_crc = 0;
+	return 0;
+}
+
+static int crc_sink_write(const uint8_t *data, size_t len, void *user_data)
+{
+	upload_crc = crc32_ieee_update(upload_crc, data, len);
+	return 0;
+}
+
+static int crc_sink_end(bool complete, char *buf, size_t len, void *user_data)
+{
+	if (!complete) {
+		return 0;
+	}
+
+	return http_stream_printf(buf, len, "{\"crc32\":\"%08x\"}", upload_crc);
+}
+
+static const struct http_upload_sink crc_sink = {
+	.begin = crc_sink_begin,
+	.write = crc_sink_write,
+	.end = crc_sink_end,
+};
+
+HTTP_UPLOAD_DEFINE(upload_resource_detail, &crc_sink, NULL, UPLOAD_MAX_SIZE);
+
 // =============================================================================
 // HTTP SERVICE CONFIGURATION
 // =============================================================================
@@ -201,8 +287,9 @@ static struct http_resource_detail_dynamic echo_resource_detail = {
 // Define the HTTP service
 // - Listens on all interfaces (NULL = bind to all)
 // - Port: 8080
-// - Max 4 simultaneous clients
-// - Max 10 streams per client
+// - Max 4 simultaneous clients (within CONFIG_HTTP_SERVER_MAX_CLIENTS)
+// - Listen backlog of 10 pending connections. The HTTP/2 streams per
+//   client are CONFIG_HTTP_SERVER_MAX_STREAMS (prj.conf)
 static uint16_t http_service_port = HTTP_SERVER_PORT;
 HTTP_SERVICE_DEFINE(http_service, NULL, &http_service_port,
 		    MAX_HTTP_CLIENTS, 10, NULL, NULL, NULL);
@@ -211,18 +298,66 @@ HTTP_SERVICE_DEFINE(http_service, NULL, &http_service_port,
 // RESOURCE ROUTING
 // =============================================================================
 
-// Route "/" -> static HTML
+// Route "/" -> HTML (encoding negotiated, ETag)
 HTTP_RESOURCE_DEFINE(index_resource, http_service, "/", &index_html_resource_detail);
 
-// Route "/main.js" -> static JavaScript
+// Route "/main.js" -> JavaScript (encoding negotiated, ETag)
 HTTP_RESOURCE_DEFINE(main_js_resource, http_service, "/main.js", &main_js_resource_detail);
 
-// Route "/device-info" -> dynamic endpoint (calls device_info_handler)
+// Route "/device-info" -> streamed endpoint (calls device_info_record)
 HTTP_RESOURCE_DEFINE(device_info_resource, http_service, "/device-info", &device_info_resource_detail);
 
+// Route "/history" -> streamed endpoint (calls history_record)
+HTTP_RESOURCE_DEFINE(history_resource, http_service, "/history", &history_resource_detail);
+
+// Route "/live" -> WebSocket, device updates pushed to the browser (see live.c)
+HTTP_RESOURCE_DEFINE(live_resource, http_service, "/live", &live_resource_detail);
+
+// Route "/metrics" -> streamed endpoint (calls metrics_record)
+HTTP_RESOURCE_DEFINE(metrics_resource, http_service, "/metrics", &metrics_resource_detail);
+
+// Route "/logs" -> streamed endpoint (calls access_log_json_record)
+HTTP_RESOURCE_DEFINE(logs_resource, http_service, "/logs", &logs_resource_detail);
+
+// Route "/uptime" -> dynamic endpoint (calls uptime_handler)
+HTTP_RESOURCE_DEFINE(uptime_resource, http_service, "/uptime", &uptime_resource_detail);
+
 // Route "/echo" -> dynamic endpoint (echoes back data)
 HTTP_RESOURCE_DEFINE(echo_resource, http_service, "/echo", &echo_resource_detail);
 
+// Route "/upload" -> streamed upload into the CRC32 sink
+HTTP_RESOURCE_DEFINE(upload_resource, http_service, "/upload", &upload_resource_detail);
+
+// Route "/api/*" -> REST API, one resource for every route of src/api_routes.txt
+// (ROM route trie, see api.c)
+HTTP_RESOURCE_DEFINE(api_resource, http_service, "/api/*", &api_resource_detail);
+
+// Route "/chan/*" -> zbus channels of src/channels.c, JSON from their
+// json_obj_descr (see zbus_http.c)
+HTTP_RESOURCE_DEFINE(chan_resource, http_service, "/chan/*", &zbus_http_resource_detail);
+
+// =============================================================================
+// RATE LIMITS
+// =============================================================================
+
+// Every client IP has RATE_LIMIT_IP_RATE requests per second for all of
+// these (see rate_limit.h). The expensive resources also have a limit of
+// their own, shared by all clients: requests per second, burst. 0 = only the
+// client's limit. /live is not limited, its socket leaves the server
+static struct rate_limit rate_limits[] = {
+	RATE_LIMIT(index_html_resource_detail, 0, 0),
+	RATE_LIMIT(main_js_resource_detail, 0, 0),
+	RATE_LIMIT(device_info_resource_detail, 0, 0),
+	RATE_LIMIT(history_resource_detail, 2, 4),
+	RATE_LIMIT(metrics_resource_detail, 5, 10),
+	RATE_LIMIT(logs_resource_detail, 5, 10),
+	RATE_LIMIT(uptime_resource_detail, 0, 0),
+	RATE_LIMIT(echo_resource_detail, 0, 0),
+	RATE_LIMIT(upload_resource_detail, 2, 5),
+	RATE_LIMIT(api_resource_detail, 0, 0),
+	RATE_LIMIT(zbus_http_resource_detail, 0, 0),
+};
+
 // =============================================================================
 // MAIN APPLICATION
 // =============================================================================
@@ -234,8 +369,36 @@ int main(void)
 	printk("[HTTP]   GET  /              -> HTML page\n");
 	printk("[HTTP]   GET  /main.js       -> JavaScript\n");
 	printk("[HTTP]   GET  /device-info   -> Device information (JSON)\n");
-	printk("[HTTP]   GET/POST /echo      -> Echo server\n");
-	
+	printk("[HTTP]   GET  /uptime        -> Uptime in milliseconds\n");
+	printk("[HTTP]   GET  /history       -> CPU load history (JSON, streamed)\n");
+	printk("[HTTP]   GET  /metrics       -> Prometheus metrics (streamed)\n");
+	printk("[HTTP]   GET  /logs          -> Access log, newest %d requests (JSON)\n",
+	       ACCESS_LOG_HISTORY);
+	printk("[HTTP]   WS   /live          -> Live device updates (WebSocket)\n");
+	printk("[HTTP]   GET/POST /echo      -> Echo server (max %d bytes)\n", ECHO_MAX_SIZE);
+	printk("[HTTP]   POST /upload        -> Streamed upload, CRC32 (max %d bytes)\n",
+	       UPLOAD_MAX_SIZE);
+	printk("[HTTP]   *    /api/...       -> REST API (routes in src/api_routes.txt)\n");
+	printk("[HTTP]   GET/POST /chan/<name> -> zbus channel as JSON, ?wait=<ms> long-polls "
+	       "(port %d)\n", ZBUS_HTTP_WAIT_PORT);
+	printk("[HTTP] Rate limit: %d requests/s per client IP, burst %d\n", RATE_LIMIT_IP_RATE,
+	       RATE_LIMIT_IP_BURST);
+
+	// 429 before the handlers when a client or a resource is over its limit
+	rate_limit_install(rate_limits, ARRAY_SIZE(rate_limits));
+
+	// Drain thread of the access log
+	access_log_start();
+
+	// zbus channels at /chan/..., long-poll thread
+	zbus_http_start(app_channels, app_channel_count);
+
+	// Sample the CPU load for /history (and load_chan)
+	history_start();
+
+	// Push thread of the /live WebSocket
+	live_start();
+
 	// Start the HTTP server (blocking call)
 	http_server_start();
 	
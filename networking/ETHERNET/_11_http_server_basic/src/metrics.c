@@ -0,0 +1,403 @@
+/**
+ * Prometheus metrics
+ *
+ * /metrics renders the device's counters in the Prometheus text format
+ * (version 0.0.4), so the fleet monitoring can scrape every board like any
+ * other target:
+ * - Network: bytes, IPv4 packets and drops, TCP segments, retransmits and
+ *   dropped connections (net_stats, CONFIG_NET_STATISTICS_USER_API)
+ * - Buffers: used and total net_pkt and net_buf of the RX and TX pools
+ *   (CONFIG_NET_BUF_POOL_USAGE)
+ * - Threads: CPU cycles and stack usage of each thread
+ *   (CONFIG_THREAD_MONITOR, CONFIG_SCHED_THREAD_USAGE, CONFIG_INIT_STACKS)
+ * - HTTP: responses per resource and status class, body bytes sent, and
+ *   the RAM of the server's client slots and HTTP/2 stream tables
+ *
+ * The body is streamed through http_stream, one record per family header or
+ * sample, so adding metrics never overflows a buffer. Record 0 takes a
+ * snapshot of everything, the whole scrape then reports the same instant
+ * even if a counter moves while the chunks are sent.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/net_buf.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/net_pkt.h>
+#include <zephyr/net/net_stats.h>
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "history.h"
+#include "http_stream.h"
+#include "metrics.h"
+
+/* Responses of one resource, by status class (2xx to 5xx) */
+struct metrics_resource
+{
+	const char *name;
+	uint32_t responses[4];
+	uint64_t bytes;
+};
+
+/* One thread, copied by the snapshot */
+struct metrics_thread
+{
+	char name[CONFIG_THREAD_MAX_NAME_LEN];
+	uint64_t cycles;
+	size_t stack_size;
+	size_t stack_used;
+};
+
+/* One net_pkt slab or net_buf pool */
+struct metrics_pool
+{
+	const char *name;
+	uint32_t used;
+	uint32_t total;
+};
+
+/* One metric family: HELP and TYPE lines, then its samples */
+struct metrics_family
+{
+	const char *name;
+	const char *help;
+	const char *type;                   /* "counter" or "gauge" */
+	uint32_t (*count)(void);            /* Samples, NULL for a single one */
+	int (*sample)(const struct metrics_family *family, uint32_t n, char *buf, size_t len);
+	size_t offset;                      /* Value in struct net_stats (net families) */
+	size_t value;                       /* Value of the build-time families */
+};
+
+static struct metrics_resource resources[METRICS_MAX_RESOURCES];
+
+// Snapshot of the scrape being streamed
+static struct net_stats snap_net;
+static struct metrics_thread snap_threads[METRICS_MAX_THREADS];
+static uint32_t snap_thread_count;
+static struct metrics_pool snap_pools[4];
+static struct metrics_resource snap_resources[METRICS_MAX_RESOURCES];
+static uint32_t snap_resource_count;
+static int64_t snap_uptime_ms;
+
+void metrics_http_response(const char *resource, uint16_t status, size_t bytes)
+{
+	struct metrics_resource *entry = NULL;
+	int i;
+
+	for (i = 0; i < METRICS_MAX_RESOURCES; i++)
+	{
+		if (resources[i].name == NULL || resources[i].name == resource ||
+		    strcmp(resources[i].name, resource) == 0)
+		{
+			entry = &resources[i];
+			break;
+		}
+	}
+
+	if (entry == NULL || status < 200 || status > 599)
+	{
+		return;
+	}
+
+	entry->name = resource;
+	entry->responses[status / 100 - 2]++;
+	entry->bytes += bytes;
+}
+
+// =============================================================================
+// SNAPSHOT
+// =============================================================================
+
+static void snapshot_thread(const struct k_thread *thread, void *user_data)
+{
+	struct metrics_thread *entry;
+	k_thread_runtime_stats_t stats;
+	const char *name;
+	size_t unused = 0;
+
+	if (snap_thread_count >= METRICS_MAX_THREADS)
+	{
+		return;
+	}
+	entry = &snap_threads[snap_thread_count++];
+
+	name = k_thread_name_get((k_tid_t)thread);
+	if (name != NULL && name[0] != '\0')
+	{
+		strncpy(entry->name, name, sizeof(entry->name) - 1);
+		entry->name[sizeof(entry->name) - 1] = '\0';
+	}
+	else
+	{
+		snprintk(entry->name, sizeof(entry->name), "%p", thread);
+	}
+
+	k_thread_runtime_stats_get((k_tid_t)thread, &stats);
+	entry->cycles = stats.execution_cycles;
+
+	// Unused = never written since the thread started (CONFIG_INIT_STACKS)
+	entry->stack_size = thread->stack_info.size;
+	if (k_thread_stack_space_get(thread, &unused) != 0)
+	{
+		unused = entry->stack_size;
+	}
+	entry->stack_used = entry->stack_size - unused;
+}
+
+static void snapshot_slab(struct metrics_pool *pool, const char *name, struct k_mem_slab *slab)
+{
+	pool->name = name;
+	pool->used = k_mem_slab_num_used_get(slab);
+	pool->total = pool->used + k_mem_slab_num_free_get(slab);
+}
+
+static void snapshot_buf_pool(struct metrics_pool *pool, const char *name,
+			      struct net_buf_pool *buf_pool)
+{
+	pool->name = name;
+	pool->total = buf_pool->buf_count;
+	pool->used = buf_pool->buf_count - atomic_get(&buf_pool->avail_count);
+}
+
+static void snapshot(void)
+{
+	struct k_mem_slab *rx_pkt;
+	struct k_mem_slab *tx_pkt;
+	struct net_buf_pool *rx_data;
+	struct net_buf_pool *tx_data;
+	int i;
+
+	snap_uptime_ms = k_uptime_get();
+
+	// Totals of all interfaces
+	if (net_mgmt(NET_REQUEST_STATS_GET_ALL, NULL, &snap_net, sizeof(snap_net)) != 0)
+	{
+		memset(&snap_net, 0, sizeof(snap_net));
+	}
+
+	net_pkt_get_info(&rx_pkt, &tx_pkt, &rx_data, &tx_data);
+	snapshot_slab(&snap_pools[0], "rx_pkt", rx_pkt);
+	snapshot_slab(&snap_pools[1], "tx_pkt", tx_pkt);
+	snapshot_buf_pool(&snap_pools[2], "rx_data", rx_data);
+	snapshot_buf_pool(&snap_pools[3], "tx_data", tx_data);
+
+	// Stack scans are slow, keep the scheduler unlocked while they run
+	snap_thread_count = 0;
+	k_thread_foreach_unlocked(snapshot_thread, NULL);
+
+	// Handlers run in the server thread, like this one, no lock needed
+	snap_resource_count = 0;
+	for (i = 0; i < METRICS_MAX_RESOURCES && resources[i].name != NULL; i++)
+	{
+		snap_resources[snap_resource_count++] = resources[i];
+	}
+}
+
+// =============================================================================
+// FAMILIES
+// =============================================================================
+
+static uint32_t thread_count(void)
+{
+	return snap_thread_count;
+}
+
+static uint32_t pool_count(void)
+{
+	return ARRAY_SIZE(snap_pools);
+}
+
+static uint32_t resource_count(void)
+{
+	return snap_resource_count;
+}
+
+static uint32_t response_count(void)
+{
+	return snap_resource_count * ARRAY_SIZE(snap_resources[0].responses);
+}
+
+static int net_sample(const struct metrics_family *family, uint32_t n, char *buf, size_t len)
+{
+	net_stats_t value = *(const net_stats_t *)((const uint8_t *)&snap_net + family->offset);
+
+	return http_stream_printf(buf, len, "%s %u\n", family->name, (uint32_t)value);
+}
+
+static int const_sample(const struct metrics_family *family, uint32_t n, char *buf, size_t len)
+{
+	return http_stream_printf(buf, len, "%s %zu\n", family->name, family->value);
+}
+
+static int uptime_sample(const struct metrics_family *family, uint32_t n, char *buf, size_t len)
+{
+	return http_stream_printf(buf, len, "%s %" PRId64 ".%03u\n", family->name,
+				  snap_uptime_ms / 1000, (uint32_t)(snap_uptime_ms % 1000));
+}
+
+static int cpu_hz_sample(const struct metrics_family *family, uint32_t n, char *buf, size_t len)
+{
+	return http_stream_printf(buf, len, "%s %u\n", family->name,
+				  (uint32_t)sys_clock_hw_cycles_per_sec());
+}
+
+static int cpu_load_sample(const struct metrics_family *family, uint32_t n, char *buf,
+			   size_t len)
+{
+	uint16_t load = history_last_load();
+
+	return http_stream_printf(buf, len, "%s %u.%03u\n", family->name, load / 1000,
+				  load % 1000);
+}
+
+static int thread_cycles_sample(const struct metrics_family *family, uint32_t n, char *buf,
+				size_t len)
+{
+	return http_stream_printf(buf, len, "%s{thread=\"%s\"} %" PRIu64 "\n", family->name,
+				  snap_threads[n].name, snap_threads[n].cycles);
+}
+
+static int thread_stack_size_sample(const struct metrics_family *family, uint32_t n,
+				    char *buf, size_t len)
+{
+	return http_stream_printf(buf, len, "%s{thread=\"%s\"} %zu\n", family->name,
+				  snap_threads[n].name, snap_threads[n].stack_size);
+}
+
+static int thread_stack_used_sample(const struct metrics_family *family, uint32_t n,
+				    char *buf, size_t len)
+{
+	return http_stream_printf(buf, len, "%s{thread=\"%s\"} %zu\n", family->name,
+				  snap_threads[n].name, snap_threads[n].stack_used);
+}
+
+static int pool_used_sample(const struct metrics_family *family, uint32_t n, char *buf,
+			    size_t len)
+{
+	return http_stream_printf(buf, len, "%s{pool=\"%s\"} %u\n", family->name,
+				  snap_pools[n].name, snap_pools[n].used);
+}
+
+static int pool_total_sample(const struct metrics_family *family, uint32_t n, char *buf,
+			     size_t len)
+{
+	return http_stream_printf(buf, len, "%s{pool=\"%s\"} %u\n", family->name,
+				  snap_pools[n].name, snap_pools[n].total);
+}
+
+static int responses_sample(const struct metrics_family *family, uint32_t n, char *buf,
+			    size_t len)
+{
+	const struct metrics_resource *resource = &snap_resources[n / 4];
+
+	return http_stream_printf(buf, len, "%s{resource=\"%s\",code=\"%uxx\"} %u\n",
+				  family->name, resource->name, n % 4 + 2,
+				  resource->responses[n % 4]);
+}
+
+static int response_bytes_sample(const struct metrics_family *family, uint32_t n, char *buf,
+				 size_t len)
+{
+	return http_stream_printf(buf, len, "%s{resource=\"%s\"} %" PRIu64 "\n", family->name,
+				  snap_resources[n].name, snap_resources[n].bytes);
+}
+
+#define NET_COUNTER(_name, _help, _field)                                   \
+	{                                                                   \
+		.name = _name, .help = _help, .type = "counter",            \
+		.sample = net_sample,                                       \
+		.offset = offsetof(struct net_stats, _field),               \
+	}
+
+// Build-time value (sizes, limits)
+#define CONST_GAUGE(_name, _help, _value)                                   \
+	{                                                                   \
+		.name = _name, .help = _help, .type = "gauge",              \
+		.sample = const_sample, .value = (_value),                  \
+	}
+
+static const struct metrics_family families[] = {
+	{ "uptime_seconds", "Time since boot", "gauge", NULL, uptime_sample },
+
+	NET_COUNTER("net_rx_bytes_total", "Bytes received", bytes.received),
+	NET_COUNTER("net_tx_bytes_total", "Bytes sent", bytes.sent),
+	NET_COUNTER("net_ipv4_rx_packets_total", "IPv4 packets received", ipv4.recv),
+	NET_COUNTER("net_ipv4_tx_packets_total", "IPv4 packets sent", ipv4.sent),
+	NET_COUNTER("net_ipv4_dropped_total", "IPv4 packets dropped", ipv4.drop),
+	NET_COUNTER("net_tcp_rx_segments_total", "TCP segments received", tcp.recv),
+	NET_COUNTER("net_tcp_tx_segments_total", "TCP segments sent", tcp.sent),
+	NET_COUNTER("net_tcp_retransmits_total", "TCP segments retransmitted", tcp.rexmit),
+	NET_COUNTER("net_tcp_dropped_total", "TCP segments dropped", tcp.drop),
+	NET_COUNTER("net_tcp_connections_dropped_total", "TCP connections dropped",
+		    tcp.conndrop),
+	NET_COUNTER("net_processing_errors_total", "Packets the stack failed to process",
+		    processing_error),
+
+	{ "net_buffers_used", "Buffers in use per pool", "gauge", pool_count,
+	  pool_used_sample },
+	{ "net_buffers", "Buffers per pool", "gauge", pool_count, pool_total_sample },
+
+	{ "cpu_cycles_per_second", "Cycle counter frequency", "gauge", NULL, cpu_hz_sample },
+	{ "cpu_load_ratio", "CPU load of the last second (0 to 1)", "gauge", NULL,
+	  cpu_load_sample },
+	{ "thread_cpu_cycles_total", "CPU cycles used per thread", "counter", thread_count,
+	  thread_cycles_sample },
+	{ "thread_stack_bytes", "Stack size per thread", "gauge", thread_count,
+	  thread_stack_size_sample },
+	{ "thread_stack_used_bytes", "Peak stack usage per thread", "gauge", thread_count,
+	  thread_stack_used_sample },
+
+	{ "http_responses_total", "HTTP responses per resource and status class", "counter",
+	  response_count, responses_sample },
+	{ "http_response_bytes_total", "HTTP body bytes sent per resource", "counter",
+	  resource_count, response_bytes_sample },
+
+	// Server RAM: every client slot holds its receive buffer and a table of
+	// CONFIG_HTTP_SERVER_MAX_STREAMS HTTP/2 streams, used or not
+	CONST_GAUGE("http_server_max_clients", "Client slots (CONFIG_HTTP_SERVER_MAX_CLIENTS)",
+		    CONFIG_HTTP_SERVER_MAX_CLIENTS),
+	CONST_GAUGE("http_server_max_streams",
+		    "HTTP/2 streams per client (CONFIG_HTTP_SERVER_MAX_STREAMS)",
+		    CONFIG_HTTP_SERVER_MAX_STREAMS),
+	CONST_GAUGE("http_server_client_bytes", "RAM of one client slot, streams included",
+		    sizeof(struct http_client_ctx)),
+	CONST_GAUGE("http_server_stream_bytes", "RAM of one HTTP/2 stream slot",
+		    sizeof(struct http2_stream_ctx)),
+	CONST_GAUGE("http_server_client_buffer_bytes",
+		    "Receive buffer of a client (CONFIG_HTTP_SERVER_CLIENT_BUFFER_SIZE)",
+		    CONFIG_HTTP_SERVER_CLIENT_BUFFER_SIZE),
+};
+
+int metrics_record(uint32_t index, char *buf, size_t len, void *user_data)
+{
+	const struct metrics_family *family;
+	uint32_t samples;
+
+	if (index == 0)
+	{
+		snapshot();
+	}
+
+	// Record index -> family header or sample: header, samples, next header...
+	for (family = families; family < families + ARRAY_SIZE(families); family++)
+	{
+		samples = (family->count != NULL) ? family->count() : 1;
+
+		if (index == 0)
+		{
+			return http_stream_printf(buf, len, "# HELP %s %s\n# TYPE %s %s\n",
+						  family->name, family->help, family->name,
+						  family->type);
+		}
+		if (index <= samples)
+		{
+			return family->sample(family, index - 1, buf, len);
+		}
+		index -= samples + 1;
+	}
+
+	return 0;
+}
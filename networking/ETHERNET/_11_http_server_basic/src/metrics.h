@@ -0,0 +1,35 @@
+/*
+ * Prometheus metrics: network, buffer, thread and HTTP counters at /metrics
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Threads and HTTP resources reported, the others are left out */
+#define METRICS_MAX_THREADS 16
+#define METRICS_MAX_RESOURCES 12
+
+/**
+ *  @brief Count a response of a HTTP resource
+ *
+ *  Called by the handlers (server thread only) once the response is
+ *  complete.
+ *
+ *  @param resource Resource name (compared by pointer first, then by value)
+ *  @param status HTTP status code sent
+ *  @param bytes Body bytes sent
+ */
+void metrics_http_response(const char *resource, uint16_t status, size_t bytes);
+
+/**
+ *  @brief Record callback for HTTP_STREAM_DEFINE(), Prometheus text format
+ *
+ *  Record 0 takes a snapshot of all counters, the following records format
+ *  one metric family header or one sample each.
+ */
+int metrics_record(uint32_t index, char *buf, size_t len, void *user_data);
+
+#endif /* METRICS_H */
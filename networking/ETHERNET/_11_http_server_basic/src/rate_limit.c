@@ -0,0 +1,514 @@
+/**
+ * Rate limiting and admission control
+ *
+ * The server has CONFIG_HTTP_SERVER_MAX_CLIENTS slots and one thread, so a
+ * single dashboard polling in a loop (or a script fetching /history
+ * non-stop) takes the time of every other client. The limiter sits in
+ * front of the dynamic resources:
+ *
+ *   first call of a request  ->  client IP bucket  ->  resource bucket
+ *                                 empty: 429 + Retry-After, handler not called
+ *
+ * - Every client IP has a token bucket (RATE_LIMIT_IP_RATE requests per
+ *   second, RATE_LIMIT_IP_BURST at once) for all resources together
+ * - A resource can have its own bucket, shared by all clients, for the
+ *   expensive ones (/history streams 90 KB)
+ * - The check is a few comparisons on the first fragment of a request,
+ *   the 429 has no body and the rest of the request body is dropped
+ * - The fragments of request bodies from different clients interleave on
+ *   the server thread. The state of a resource belongs to the client whose
+ *   request is in progress, another client's request meanwhile gets 409
+ *   Conflict at the end of its body, as from the resources themselves
+ *
+ * Keep-alive connections hold their slot between requests. The limiter
+ * remembers the last request of each connection, and once every slot holds
+ * a connection, the one idle the longest (over RATE_LIMIT_IDLE_MS) is
+ * closed the way the server closes inactive clients: a read shutdown that
+ * its poll() picks up. The shutdown is done under the lock of the fd, the
+ * one close() takes, so a connection the server closed meanwhile (and an
+ * fd already reused by another socket) is left alone. The next client gets
+ * the slot instead of being refused. Connections that never sent a request to a limited resource are
+ * not known to the limiter and keep the server's own inactivity timeout.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/fdtable.h>
+#include <zephyr/sys/util.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "access_log.h"
+#include "metrics.h"
+#include "rate_limit.h"
+
+LOG_MODULE_REGISTER(rate_limit, LOG_LEVEL_INF);
+
+/* Tokens of one request, buckets count in thousandths */
+#define TOKEN 1000U
+
+/* Bucket of a client IP */
+struct rate_ip
+{
+	uint8_t addr[16];                   /* IPv4 or IPv6 address */
+	uint8_t len;                        /* 0 = free */
+	uint32_t seen_ms;                   /* Last request, for the replacement */
+	struct rate_bucket bucket;
+};
+
+/* A connection seen by the limiter, for the idle reclaim */
+struct rate_conn
+{
+	const struct http_client_ctx *client;
+	int fd;                             /* -1 = free */
+	struct sockaddr peer;               /* Tells a reused fd from the same connection */
+	socklen_t peer_len;
+	uint32_t last_ms;                   /* Last handler call */
+};
+
+// Server thread only
+static struct rate_ip ips[RATE_LIMIT_MAX_IPS];
+
+// Server thread and the idle check (system workqueue)
+static struct rate_conn conns[RATE_LIMIT_MAX_CONNECTIONS];
+static struct k_spinlock conn_lock;
+
+static struct k_work_delayable idle_work;
+static uint32_t reclaimed;
+
+static char retry_after[12];
+static const struct http_header retry_after_header[] = {
+	{ .name = "Retry-After", .value = retry_after },
+};
+
+// =============================================================================
+// TOKEN BUCKETS
+// =============================================================================
+
+/**
+ * Take a token, false when the bucket is empty
+ */
+static bool bucket_take(struct rate_bucket *bucket, uint16_t rate, uint16_t burst, uint32_t now)
+{
+	// rate requests per second = rate thousandths of a token per ms
+	uint64_t tokens = bucket->tokens + (uint64_t)(now - bucket->last_ms) * rate;
+
+	bucket->tokens = (uint32_t)MIN(tokens, (uint64_t)burst * TOKEN);
+	bucket->last_ms = now;
+
+	if (bucket->tokens < TOKEN)
+	{
+		return false;
+	}
+
+	bucket->tokens -= TOKEN;
+	return true;
+}
+
+/**
+ * Seconds until the bucket has a token again, at least 1
+ */
+static uint32_t bucket_wait_s(const struct rate_bucket *bucket, uint16_t rate)
+{
+	uint32_t ms = (TOKEN - MIN(bucket->tokens, TOKEN)) / MAX(rate, 1);
+
+	return MAX(DIV_ROUND_UP(ms, 1000), 1);
+}
+
+/**
+ * Address bytes of a peer, 0 for an unknown family
+ */
+static uint8_t peer_addr(const struct sockaddr *peer, const uint8_t **addr)
+{
+	if (peer->sa_family == AF_INET)
+	{
+		*addr = (const uint8_t *)&net_sin(peer)->sin_addr;
+		return sizeof(struct in_addr);
+	}
+
+	if (peer->sa_family == AF_INET6)
+	{
+		*addr = (const uint8_t *)&net_sin6(peer)->sin6_addr;
+		return sizeof(struct in6_addr);
+	}
+
+	return 0;
+}
+
+/**
+ * Bucket of a client IP, the least recently seen one is replaced when the
+ * table is full. NULL for an unknown address family
+ */
+static struct rate_ip *ip_bucket(const struct sockaddr *peer, uint32_t now)
+{
+	struct rate_ip *oldest = &ips[0];
+	const uint8_t *addr;
+	uint8_t len = peer_addr(peer, &addr);
+	int i;
+
+	if (len == 0)
+	{
+		return NULL;
+	}
+
+	for (i = 0; i < RATE_LIMIT_MAX_IPS; i++)
+	{
+		if (ips[i].len == len && memcmp(ips[i].addr, addr, len) == 0)
+		{
+			ips[i].seen_ms = now;
+			return &ips[i];
+		}
+
+		if (ips[i].len == 0 ||
+		    (oldest->len != 0 && now - ips[i].seen_ms > now - oldest->seen_ms))
+		{
+			oldest = &ips[i];
+		}
+	}
+
+	memcpy(oldest->addr, addr, len);
+	oldest->len = len;
+	oldest->seen_ms = now;
+	oldest->bucket.tokens = RATE_LIMIT_IP_BURST * TOKEN;
+	oldest->bucket.last_ms = now;
+
+	return oldest;
+}
+
+// =============================================================================
+// CONNECTIONS
+// =============================================================================
+
+/**
+ * Note a request of a connection. A new connection takes the entry of its
+ * slot, of a closed connection that had the same fd, or the oldest one
+ */
+static void conn_request(const struct http_client_ctx *client, const struct sockaddr *peer,
+			 socklen_t peer_len, uint32_t now)
+{
+	struct rate_conn *entry = NULL;
+	k_spinlock_key_t key;
+	int i;
+
+	key = k_spin_lock(&conn_lock);
+	for (i = 0; i < RATE_LIMIT_MAX_CONNECTIONS; i++)
+	{
+		if (conns[i].client == client || conns[i].fd == client->fd)
+		{
+			// Same slot, or a closed connection whose fd was reused
+			if (entry == NULL)
+			{
+				entry = &conns[i];
+			}
+			else
+			{
+				conns[i].fd = -1;
+				conns[i].client = NULL;
+			}
+		}
+	}
+
+	for (i = 0; entry == NULL && i < RATE_LIMIT_MAX_CONNECTIONS; i++)
+	{
+		if (conns[i].fd < 0)
+		{
+			entry = &conns[i];
+		}
+	}
+
+	if (entry == NULL)
+	{
+		entry = &conns[0];
+		for (i = 1; i < RATE_LIMIT_MAX_CONNECTIONS; i++)
+		{
+			if (now - conns[i].last_ms > now - entry->last_ms)
+			{
+				entry = &conns[i];
+			}
+		}
+	}
+
+	entry->client = client;
+	entry->fd = client->fd;
+	memcpy(&entry->peer, peer, MIN(peer_len, sizeof(entry->peer)));
+	entry->peer_len = peer_len;
+	entry->last_ms = now;
+	k_spin_unlock(&conn_lock, key);
+}
+
+/**
+ * Note activity (a fragment or a chunk) of a known connection
+ */
+static void conn_touch(const struct http_client_ctx *client, uint32_t now)
+{
+	k_spinlock_key_t key;
+	int i;
+
+	key = k_spin_lock(&conn_lock);
+	for (i = 0; i < RATE_LIMIT_MAX_CONNECTIONS; i++)
+	{
+		if (conns[i].client == client)
+		{
+			conns[i].last_ms = now;
+			break;
+		}
+	}
+	k_spin_unlock(&conn_lock, key);
+}
+
+/**
+ * True while the socket still belongs to the connection of the entry
+ */
+static bool conn_open(int fd, const struct sockaddr *peer, socklen_t peer_len)
+{
+	struct sockaddr addr;
+	socklen_t len = sizeof(addr);
+
+	return zsock_getpeername(fd, &addr, &len) == 0 && len == peer_len &&
+	       memcmp(&addr, peer, MIN(len, sizeof(addr))) == 0;
+}
+
+/**
+ * Shut the connection of an entry down for reading. The fd's lock is held
+ * across the check and the shutdown: close() takes it too, so the fd
+ * cannot be closed and handed to another socket in between. False when the
+ * connection is already gone
+ */
+static bool conn_shutdown(const struct rate_conn *entry)
+{
+	const struct fd_op_vtable *vtable;
+	struct k_mutex *lock;
+	struct k_mutex *held;
+	bool open = false;
+
+	if (zvfs_get_fd_obj_and_vtable(entry->fd, &vtable, &lock) == NULL || lock == NULL)
+	{
+		return false;
+	}
+
+	(void)k_mutex_lock(lock, K_FOREVER);
+	// Still the socket whose lock is held, and still the same peer
+	if (zvfs_get_fd_obj_and_vtable(entry->fd, &vtable, &held) != NULL && held == lock &&
+	    conn_open(entry->fd, &entry->peer, entry->peer_len))
+	{
+		(void)zsock_shutdown(entry->fd, ZSOCK_SHUT_RD);
+		open = true;
+	}
+	k_mutex_unlock(lock);
+
+	return open;
+}
+
+/**
+ * Idle check: when every slot holds a connection, close the one idle the
+ * longest if it is over RATE_LIMIT_IDLE_MS
+ */
+static void idle_handler(struct k_work *work)
+{
+	struct rate_conn copy[RATE_LIMIT_MAX_CONNECTIONS];
+	uint32_t now = k_uptime_get_32();
+	k_spinlock_key_t key;
+	bool closed = false;
+	int open = 0;
+	int idlest = -1;
+	int i;
+
+	key = k_spin_lock(&conn_lock);
+	memcpy(copy, conns, sizeof(copy));
+	k_spin_unlock(&conn_lock, key);
+
+	// getpeername() outside of the lock
+	for (i = 0; i < RATE_LIMIT_MAX_CONNECTIONS; i++)
+	{
+		if (copy[i].fd < 0 || !conn_open(copy[i].fd, &copy[i].peer, copy[i].peer_len))
+		{
+			continue;
+		}
+
+		open++;
+		if (idlest < 0 || now - copy[i].last_ms > now - copy[idlest].last_ms)
+		{
+			idlest = i;
+		}
+	}
+
+	if (open == RATE_LIMIT_MAX_CONNECTIONS && now - copy[idlest].last_ms >= RATE_LIMIT_IDLE_MS)
+	{
+		key = k_spin_lock(&conn_lock);
+		// Skip it if it sent a request meanwhile
+		if (conns[idlest].fd == copy[idlest].fd && conns[idlest].last_ms == copy[idlest].last_ms)
+		{
+			conns[idlest].fd = -1;
+			conns[idlest].client = NULL;
+			closed = true;
+		}
+		k_spin_unlock(&conn_lock, key);
+	}
+
+	if (closed && conn_shutdown(&copy[idlest]))
+	{
+		reclaimed++;
+		LOG_DBG("All %d slots busy, closed a connection idle for %u ms (%u so far)",
+			RATE_LIMIT_MAX_CONNECTIONS, now - copy[idlest].last_ms, reclaimed);
+	}
+
+	k_work_schedule(&idle_work, K_MSEC(RATE_LIMIT_CHECK_MS));
+}
+
+// =============================================================================
+// ADMISSION
+// =============================================================================
+
+/**
+ * Check the buckets on the first call of a request. 0 when admitted, else
+ * the seconds for Retry-After
+ */
+static uint32_t rate_limit_admit(struct rate_limit *limit, const struct http_client_ctx *client,
+				 uint32_t now)
+{
+	struct sockaddr peer;
+	socklen_t peer_len = sizeof(peer);
+	struct rate_ip *ip;
+
+	if (zsock_getpeername(client->fd, &peer, &peer_len) == 0)
+	{
+		conn_request(client, &peer, peer_len, now);
+
+		ip = ip_bucket(&peer, now);
+		if (ip != NULL && !bucket_take(&ip->bucket, RATE_LIMIT_IP_RATE, RATE_LIMIT_IP_BURST, now))
+		{
+			return bucket_wait_s(&ip->bucket, RATE_LIMIT_IP_RATE);
+		}
+	}
+
+	if (limit->rate != 0 && !bucket_take(&limit->bucket, limit->rate, limit->burst, now))
+	{
+		return bucket_wait_s(&limit->bucket, limit->rate);
+	}
+
+	return 0;
+}
+
+/**
+ * Request of another client while one is in progress: drop its body, 409
+ * once it is complete, the resource is not called
+ */
+static void rate_limit_busy(struct rate_limit *limit, const struct http_client_ctx *client,
+			    enum http_data_status status, struct http_response_ctx *response_ctx)
+{
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return;
+	}
+
+	response_ctx->status = HTTP_409_CONFLICT;
+	response_ctx->final_chunk = true;
+	metrics_http_response(limit->name, HTTP_409_CONFLICT, 0);
+	access_log_write(limit->name, client->method, HTTP_409_CONFLICT, 0, access_log_timestamp());
+}
+
+static int rate_limit_handler(struct http_client_ctx *client, enum http_data_status status,
+			      const struct http_request_ctx *request_ctx,
+			      struct http_response_ctx *response_ctx, void *user_data)
+{
+	struct rate_limit *limit = user_data;
+	uint32_t now = k_uptime_get_32();
+	uint32_t wait_s;
+	int ret;
+
+	if ((limit->active || limit->rejected) && client != limit->client)
+	{
+		// Not the owner: neither admitted nor passed to the resource
+		if (status != HTTP_SERVER_DATA_ABORTED)
+		{
+			rate_limit_busy(limit, client, status, response_ctx);
+		}
+		return 0;
+	}
+
+	if (status == HTTP_SERVER_DATA_ABORTED)
+	{
+		limit->active = false;
+		if (limit->rejected)
+		{
+			// The resource never saw this request
+			limit->rejected = false;
+			return 0;
+		}
+		return limit->cb(client, status, request_ctx, response_ctx, limit->user_data);
+	}
+
+	if (limit->rejected)
+	{
+		// Drop the rest of the body, the next request starts after FINAL
+		limit->rejected = (status != HTTP_SERVER_DATA_FINAL);
+		return 0;
+	}
+
+	if (!limit->active)
+	{
+		limit->client = client;
+		wait_s = rate_limit_admit(limit, client, now);
+		if (wait_s != 0)
+		{
+			snprintf(retry_after, sizeof(retry_after), "%u", wait_s);
+			response_ctx->status = HTTP_429_TOO_MANY_REQUESTS;
+			response_ctx->headers = retry_after_header;
+			response_ctx->header_count = ARRAY_SIZE(retry_after_header);
+			response_ctx->final_chunk = true;
+			limit->rejected = (status != HTTP_SERVER_DATA_FINAL);
+			metrics_http_response(limit->name, HTTP_429_TOO_MANY_REQUESTS, 0);
+			access_log_write(limit->name, client->method, HTTP_429_TOO_MANY_REQUESTS, 0,
+					 access_log_timestamp());
+			return 0;
+		}
+
+		limit->active = true;
+		limit->request_done = false;
+		limit->response_done = false;
+	}
+	else
+	{
+		conn_touch(client, now);
+	}
+
+	ret = limit->cb(client, status, request_ctx, response_ctx, limit->user_data);
+
+	// A request ends once both the body was received and the response sent,
+	// in either order (early answers, streamed responses)
+	limit->request_done |= (status == HTTP_SERVER_DATA_FINAL);
+	limit->response_done |= response_ctx->final_chunk;
+	if (ret < 0 || (limit->request_done && limit->response_done))
+	{
+		limit->active = false;
+	}
+
+	return ret;
+}
+
+void rate_limit_install(struct rate_limit *limits, size_t count)
+{
+	uint32_t now = k_uptime_get_32();
+	size_t i;
+
+	for (i = 0; i < RATE_LIMIT_MAX_CONNECTIONS; i++)
+	{
+		conns[i].fd = -1;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		limits[i].cb = limits[i].detail->cb;
+		limits[i].user_data = limits[i].detail->user_data;
+		limits[i].bucket.tokens = limits[i].burst * TOKEN;
+		limits[i].bucket.last_ms = now;
+
+		limits[i].detail->cb = rate_limit_handler;
+		limits[i].detail->user_data = &limits[i];
+	}
+
+	k_work_init_delayable(&idle_work, idle_handler);
+	k_work_schedule(&idle_work, K_MSEC(RATE_LIMIT_CHECK_MS));
+}
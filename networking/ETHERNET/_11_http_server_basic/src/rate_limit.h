@@ -0,0 +1,90 @@
+/*
+ * Rate limiting and admission control: token buckets per client IP and
+ * per resource, a 429 before the handler runs, idle connection reclaim
+ */
+
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/http/service.h>
+
+/* Bucket of each client IP: requests per second and burst, all resources
+ * together. A browser loading the page sends about 10 requests at once */
+#define RATE_LIMIT_IP_RATE 20
+#define RATE_LIMIT_IP_BURST 40
+
+/* Client IPs with their own bucket. A new IP takes the bucket of the one
+ * seen least recently */
+#define RATE_LIMIT_MAX_IPS 8
+
+/* Connections tracked for the idle reclaim, one per server client slot */
+#define RATE_LIMIT_MAX_CONNECTIONS CONFIG_HTTP_SERVER_MAX_CLIENTS
+
+/* Once every slot holds a connection, the one idle the longest is closed
+ * if it has sent nothing for this long, so a new client can connect */
+#define RATE_LIMIT_IDLE_MS 2000
+
+/* Period of the idle check when no request comes in (system workqueue) */
+#define RATE_LIMIT_CHECK_MS 500
+
+/* Token bucket, tokens in thousandths */
+struct rate_bucket
+{
+	uint32_t tokens;
+	uint32_t last_ms;                   /* Uptime of the last refill */
+};
+
+/* Limit of one dynamic resource, wraps its callback */
+struct rate_limit
+{
+	struct http_resource_detail_dynamic *detail;
+	const char *name;                   /* For metrics and the access log */
+	uint16_t rate;                      /* Requests per second, 0 = no resource limit */
+	uint16_t burst;
+	struct rate_bucket bucket;
+	http_resource_dynamic_cb_t cb;      /* The resource's own callback */
+	void *user_data;
+	const struct http_client_ctx *client; /* Owner of the request in progress */
+	bool active;                        /* A request is in progress */
+	bool rejected;                      /* Answered 429, the rest of the body is dropped */
+	bool request_done;                  /* FINAL received */
+	bool response_done;                 /* final_chunk sent */
+};
+
+/**
+ *  @brief Limit of a dynamic resource, an entry of the rate_limit_install() table
+ *
+ *  @param _detail Resource detail (struct http_resource_detail_dynamic)
+ *  @param _rate Requests per second for all clients together, 0 for none
+ *  @param _burst Requests accepted at once
+ */
+#define RATE_LIMIT(_detail, _rate, _burst)                                         \
+	{                                                                          \
+		.detail = &(_detail),                                              \
+		.name = #_detail,                                                  \
+		.rate = (_rate),                                                   \
+		.burst = (_burst),                                                 \
+	}
+
+/**
+ *  @brief Put the resources of the table behind the rate limiter
+ *
+ *  Replaces the callback of every resource by the limiter, which checks the
+ *  client's and the resource's bucket on the first call of each request
+ *  and answers 429 Too Many Requests without calling the resource when one
+ *  of them is empty. A request of another client while one is in progress
+ *  on the resource gets 409 Conflict at the end of its body, without
+ *  calling the resource. Also starts the idle connection check. Call before
+ *  http_server_start().
+ *
+ *  @param limits Table of RATE_LIMIT() entries, kept for the server's lifetime
+ *  @param count Entries in the table
+ */
+void rate_limit_install(struct rate_limit *limits, size_t count);
+
+#endif /* RATE_LIMIT_H */
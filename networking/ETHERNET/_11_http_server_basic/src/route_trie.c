@@ -0,0 +1,257 @@
+/**
+ * Route trie
+ *
+ * Matching a request against N HTTP_RESOURCE_DEFINE() paths, or against a
+ * table of patterns, compares the path with every entry: the cost grows
+ * with the number of routes. scripts/route_trie.py turns the route table
+ * into a trie of path segments instead, as const tables (ROM):
+ *
+ *   /api/sensors                node 2
+ *   /api/sensors/{id}           node 3 (param child of node 2)
+ *   /api/sensors/{id}/samples   node 4
+ *
+ * A lookup walks one node per path segment and finds the static segment by
+ * binary search among that node's children, so its cost depends on the
+ * path length (and log2 of the children), not on the number of routes.
+ * Parameters are returned as pointer and length into the path, nothing is
+ * copied.
+ *
+ * Only this file and the generated tables are needed, there is no Zephyr
+ * dependency: scripts/route_bench.py builds it on the host for the
+ * benchmark.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "route_trie.h"
+
+/**
+ * Compare a path segment with an edge, in the order the generator sorts
+ * them (bytewise, a prefix before the longer segment)
+ */
+static int segment_compare(const char *segment, size_t len, const struct route_edge *edge)
+{
+	int ret = memcmp(segment, edge->segment, (len < edge->len) ? len : edge->len);
+
+	if (ret != 0)
+	{
+		return ret;
+	}
+
+	return (int)len - (int)edge->len;
+}
+
+static const struct route_edge *find_edge(const struct route_trie *trie,
+					  const struct route_node *node, const char *segment,
+					  size_t len)
+{
+	size_t low = node->first_edge;
+	size_t high = node->first_edge + node->edge_count;
+	size_t mid;
+	int ret;
+
+	while (low < high)
+	{
+		mid = (low + high) / 2;
+		ret = segment_compare(segment, len, &trie->edges[mid]);
+		if (ret == 0)
+		{
+			return &trie->edges[mid];
+		}
+		if (ret < 0)
+		{
+			high = mid;
+		}
+		else
+		{
+			low = mid + 1;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Match the rest of the path (starting after a '/') from a node. The
+ * recursion depth is bounded by the depth of the trie
+ */
+static bool lookup_node(const struct route_trie *trie, uint16_t index, const char *path,
+			const char *end, struct route_match *match)
+{
+	const struct route_node *node = &trie->nodes[index];
+	const struct route_edge *edge;
+	const char *segment_end;
+	const char *next;
+	size_t len;
+
+	if (path == end)
+	{
+		match->route = node->route;
+		return node->route != ROUTE_NONE;
+	}
+
+	segment_end = memchr(path, '/', end - path);
+	if (segment_end == NULL)
+	{
+		segment_end = end;
+	}
+	len = segment_end - path;
+	next = (segment_end < end) ? segment_end + 1 : end;
+
+	// Static segment first
+	edge = find_edge(trie, node, path, len);
+	if (edge != NULL && lookup_node(trie, edge->node, next, end, match))
+	{
+		return true;
+	}
+
+	// Then {param}, which needs a non-empty segment
+	if (node->param_node != ROUTE_NONE && len > 0 && match->param_count < ROUTE_MAX_PARAMS)
+	{
+		match->params[match->param_count].value = path;
+		match->params[match->param_count].len = len;
+		match->param_count++;
+
+		if (lookup_node(trie, node->param_node, next, end, match))
+		{
+			return true;
+		}
+		match->param_count--;
+	}
+
+	return false;
+}
+
+int route_trie_lookup(const struct route_trie *trie, const char *path, size_t len,
+		      struct route_match *match)
+{
+	match->route = ROUTE_NONE;
+	match->param_count = 0;
+
+	if (len == 0 || path[0] != '/')
+	{
+		return -ENOENT;
+	}
+
+	return lookup_node(trie, 0, path + 1, path + len, match) ? 0 : -ENOENT;
+}
+
+/**
+ * Match one pattern segment by segment, {name} takes any non-empty segment
+ */
+static bool pattern_match(const char *pattern, const char *path, const char *end,
+			  struct route_match *match)
+{
+	const char *pattern_end;
+	const char *segment_end;
+	size_t pattern_len;
+	size_t len;
+
+	match->param_count = 0;
+
+	// Both start after their leading '/'
+	pattern++;
+	path++;
+
+	while (true)
+	{
+		if (*pattern == '\0' || path == end)
+		{
+			return *pattern == '\0' && path == end;
+		}
+
+		pattern_end = strchr(pattern, '/');
+		if (pattern_end == NULL)
+		{
+			pattern_end = pattern + strlen(pattern);
+		}
+		pattern_len = pattern_end - pattern;
+
+		segment_end = memchr(path, '/', end - path);
+		if (segment_end == NULL)
+		{
+			segment_end = end;
+		}
+		len = segment_end - path;
+
+		if (pattern[0] == '{')
+		{
+			if (len == 0 || match->param_count >= ROUTE_MAX_PARAMS)
+			{
+				return false;
+			}
+			match->params[match->param_count].value = path;
+			match->params[match->param_count].len = len;
+			match->param_count++;
+		}
+		else if (len != pattern_len || memcmp(path, pattern, len) != 0)
+		{
+			return false;
+		}
+
+		pattern = (*pattern_end == '/') ? pattern_end + 1 : pattern_end;
+		path = (segment_end < end) ? segment_end + 1 : end;
+	}
+}
+
+int route_linear_lookup(const char *const *patterns, size_t count, const char *path, size_t len,
+			struct route_match *match)
+{
+	size_t i;
+
+	match->route = ROUTE_NONE;
+	match->param_count = 0;
+
+	if (len == 0 || path[0] != '/')
+	{
+		return -ENOENT;
+	}
+
+	// Same as the trie: a trailing '/' is ignored
+	if (len > 1 && path[len - 1] == '/')
+	{
+		len--;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (pattern_match(patterns[i], path, path + len, match))
+		{
+			match->route = (uint16_t)i;
+			return 0;
+		}
+	}
+
+	match->param_count = 0;
+	return -ENOENT;
+}
+
+int route_param_u32(const struct route_param *param, uint32_t *value)
+{
+	uint64_t result = 0;
+	uint16_t i;
+
+	if (param->len == 0 || param->len > 10)
+	{
+		return -EINVAL;
+	}
+
+	for (i = 0; i < param->len; i++)
+	{
+		if (param->value[i] < '0' || param->value[i] > '9')
+		{
+			return -EINVAL;
+		}
+		result = result * 10 + (param->value[i] - '0');
+	}
+
+	if (result > UINT32_MAX)
+	{
+		return -EINVAL;
+	}
+
+	*value = (uint32_t)result;
+	return 0;
+}
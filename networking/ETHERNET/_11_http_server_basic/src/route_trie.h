@@ -0,0 +1,91 @@
+/*
+ * Route trie: path lookup with {param} segments in ROM tables generated by
+ * scripts/route_trie.py
+ */
+
+#ifndef ROUTE_TRIE_H
+#define ROUTE_TRIE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Path parameters per route ({id} segments) */
+#define ROUTE_MAX_PARAMS 4
+
+/* No node / no route */
+#define ROUTE_NONE 0xffff
+
+/* Static child of a node: one path segment. The edges of a node are
+ * contiguous and sorted by segment (bytewise, shorter prefix first) */
+struct route_edge
+{
+	const char *segment;
+	uint16_t len;
+	uint16_t node;
+};
+
+/* One node per distinct path prefix, node 0 is "/" */
+struct route_node
+{
+	uint16_t first_edge;                /* edges[first_edge..+edge_count) */
+	uint16_t edge_count;
+	uint16_t param_node;                /* {param} child, ROUTE_NONE if none */
+	uint16_t route;                     /* Route ending here, ROUTE_NONE if none */
+};
+
+struct route_trie
+{
+	const struct route_node *nodes;
+	const struct route_edge *edges;
+};
+
+/* A path parameter, pointing into the looked up path (not copied, not
+ * NUL-terminated) */
+struct route_param
+{
+	const char *value;
+	uint16_t len;
+};
+
+struct route_match
+{
+	uint16_t route;                     /* Index in the generated route table */
+	uint8_t param_count;
+	struct route_param params[ROUTE_MAX_PARAMS];
+};
+
+/**
+ *  @brief Find the route of a path
+ *
+ *  Walks one node per path segment, a static segment is found by binary
+ *  search among the node's edges. A static segment wins over {param}; if
+ *  the static branch fails further down, the {param} branch is tried.
+ *  A trailing '/' is ignored.
+ *
+ *  @param trie Generated trie
+ *  @param path Path, starting with '/', without the query string
+ *  @param len Length of path
+ *  @param match Route and parameters found
+ *
+ *  @return 0 on a match, -ENOENT otherwise
+ */
+int route_trie_lookup(const struct route_trie *trie, const char *path, size_t len,
+		      struct route_match *match);
+
+/**
+ *  @brief Same result by matching every pattern in turn, for comparison
+ *
+ *  @param patterns Route patterns ("/sensors/{id}/samples"), in priority order
+ *  @param count Number of patterns
+ */
+int route_linear_lookup(const char *const *patterns, size_t count, const char *path, size_t len,
+			struct route_match *match);
+
+/**
+ *  @brief Parse a parameter as a decimal number
+ *
+ *  @return 0, or -EINVAL if it is not a number that fits in 32 bits
+ */
+int route_param_u32(const struct route_param *param, uint32_t *value);
+
+#endif /* ROUTE_TRIE_H */
@@ -1,3 +1,26 @@
+// Polling interval when the WebSocket is not available
+const POLL_INTERVAL_MS = 2000;
+
+let pollTimer = null;
+
+// Display device information (all fields, or only the ones that changed)
+function showDeviceInfo(data) {
+	if (data.board !== undefined) {
+		document.getElementById("board").textContent = data.board;
+	}
+	if (data.arch !== undefined) {
+		document.getElementById("arch").textContent = data.arch;
+	}
+	if (data.uptime !== undefined) {
+		document.getElementById("uptime").textContent = formatUptime(data.uptime);
+	}
+	if (data.status !== undefined) {
+		document.getElementById("status").textContent = data.status;
+	}
+	document.getElementById("lastUpdate").textContent =
+		"Last updated: " + new Date().toLocaleTimeString();
+}
+
 // Fetch device information and display it
 async function fetchDeviceInfo() {
 	try {
@@ -6,15 +29,7 @@ async function fetchDeviceInfo() {
 			throw new Error(`HTTP error! status: ${response.status}`);
 		}
 
-		const data = await response.json();
-
-		// Update device info elements
-		document.getElementById("board").textContent = data.board || "STM32H573I-DK";
-		document.getElementById("arch").textContent = data.arch || "ARM Cortex-M33";
-		document.getElementById("uptime").textContent = formatUptime(data.uptime);
-		document.getElementById("status").textContent = data.status || "Running";
-		document.getElementById("lastUpdate").textContent =
-			"Last updated: " + new Date().toLocaleTimeString();
+		showDeviceInfo(await response.json());
 
 	} catch (error) {
 		console.error("Failed to fetch device info:", error);
@@ -22,6 +37,37 @@ async function fetchDeviceInfo() {
 	}
 }
 
+// Fall back to polling /device-info
+function startPolling() {
+	if (pollTimer === null) {
+		fetchDeviceInfo();
+		pollTimer = setInterval(fetchDeviceInfo, POLL_INTERVAL_MS);
+	}
+}
+
+// Receive device updates pushed by the board on /live. The first message
+// has every field, the following ones only uptime and load
+function startLive() {
+	const ws = new WebSocket(`ws://${window.location.host}/live`);
+
+	ws.onopen = () => {
+		if (pollTimer !== null) {
+			clearInterval(pollTimer);
+			pollTimer = null;
+		}
+	};
+
+	ws.onmessage = (event) => {
+		showDeviceInfo(JSON.parse(event.data));
+	};
+
+	// Board busy (all live slots taken) or connection lost: poll, retry later
+	ws.onclose = () => {
+		startPolling();
+		setTimeout(startLive, 10 * POLL_INTERVAL_MS);
+	};
+}
+
 // Format uptime from milliseconds to readable format
 function formatUptime(milliseconds) {
 	const seconds = Math.floor(milliseconds / 1000);
@@ -66,9 +112,8 @@ async function sendEcho(message) {
 
 // Initialize on page load
 window.addEventListener("DOMContentLoaded", () => {
-	// Fetch device info immediately and every 2 seconds
-	fetchDeviceInfo();
-	setInterval(fetchDeviceInfo, 2000);
+	// Device info pushed over the WebSocket, polling if that fails
+	startLive();
 
 	// Setup echo input handler
 	const echoInput = document.getElementById("echoInput");
@@ -0,0 +1,860 @@
+/**
+ * zbus channels over HTTP
+ *
+ * Each channel of the bridge table is one path, with no handler of its own.
+ * The JSON of its message struct comes from the table's json_obj_descr:
+ *
+ *   GET  /chan/load_chan                      ->  {"uptime_s":12,"load":153}
+ *   POST /chan/alarm_config_chan {"threshold":500}  ->  zbus_chan_pub()
+ *   GET  /chan/load_chan?wait=10000&seq=12    ->  307 to the long-poll port
+ *   GET  /chan/                               ->  {"channels":["load_chan",...]}
+ *
+ * A POST body only needs the fields it changes, the others keep the
+ * channel's current value. Every response carries X-Zbus-Seq, the number
+ * of publications of the channel so far.
+ *
+ * Long-poll: the HTTP server calls all handlers from one thread, a handler
+ * that waits for a publication stops every other client meanwhile. ?wait=
+ * is answered by a thread of its own on ZBUS_HTTP_WAIT_PORT instead, the
+ * HTTP server only redirects (307) there. The thread polls its listener,
+ * its clients and an eventfd, which zbus_http_listener writes on every
+ * publication of a bridged channel:
+ *
+ *   publisher  ->  zbus_http_listener  ->  seq[i]++, eventfd_write()
+ *   long-poll thread  ->  wakes up  ->  answers the clients whose channel's
+ *                                       seq changed
+ *
+ * A client that passes the seq of its last response (&seq=) gets an answer
+ * right away if it missed a publication meanwhile, nothing is lost between
+ * two polls. A wait that ends without a publication gets 204 No Content.
+ *
+ * The fragments of POST bodies from different clients interleave on the
+ * server thread. The request state and json_buf belong to the client whose
+ * request is in progress; another client's request meanwhile has its body
+ * dropped and gets 409 Conflict, as for http_upload.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/eventfd.h>
+#include <zephyr/sys/atomic.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "access_log.h"
+#include "http_stream.h"
+#include "metrics.h"
+#include "zbus_http.h"
+
+#define ZBUS_HTTP_PATH "/chan/"
+
+/* One long-poll client */
+struct zbus_http_waiter
+{
+	int fd;                             /* -1 when the slot is free */
+	bool waiting;                       /* Request received, waiting for a publication */
+	uint8_t channel;                    /* Index in the bridge table */
+	uint32_t seq;                       /* Answer once the channel's seq differs */
+	int64_t deadline_ms;                /* Request timeout, then wait timeout */
+	size_t len;
+	char request[ZBUS_HTTP_REQUEST_SIZE];
+};
+
+static const struct zbus_http_channel *channels;
+static size_t channel_count;
+
+// Publications of each channel, counted by zbus_http_listener
+static atomic_t seqs[ZBUS_HTTP_MAX_CHANNELS];
+
+static int wake_fd = -1;
+static int wait_fd = -1;
+
+// =============================================================================
+// CHANNELS
+// =============================================================================
+
+static const struct zbus_http_channel *zbus_http_find(const char *name, size_t len)
+{
+	const char *chan_name;
+	size_t i;
+
+	for (i = 0; i < channel_count; i++)
+	{
+		chan_name = zbus_chan_name(channels[i].chan);
+		if (strlen(chan_name) == len && strncmp(chan_name, name, len) == 0)
+		{
+			return &channels[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Value of a query parameter (?key=123&...), false if absent or not a number
+ */
+static bool zbus_http_query(const char *query, const char *key, uint32_t *value)
+{
+	size_t key_len = strlen(key);
+	const char *param = query;
+	char *end;
+
+	while (param != NULL && *param != '\0')
+	{
+		if (strncmp(param, key, key_len) == 0 && param[key_len] == '=')
+		{
+			*value = strtoul(param + key_len + 1, &end, 10);
+			return end != param + key_len + 1;
+		}
+
+		param = strchr(param, '&');
+		if (param != NULL)
+		{
+			param++;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Read a channel and encode its message into buf
+ *
+ * @return Length of the JSON, or a negative error
+ */
+static int zbus_http_encode(const struct zbus_http_channel *entry, void *msg, char *buf,
+			    size_t len, uint32_t *seq)
+{
+	int ret;
+
+	// Sequence first: the message read after it is at least that recent
+	*seq = (uint32_t)atomic_get(&seqs[entry - channels]);
+
+	ret = zbus_chan_read(entry->chan, msg, K_MSEC(ZBUS_HTTP_CHAN_TIMEOUT_MS));
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	ret = json_obj_encode_buf(entry->descr, entry->descr_len, msg, buf, len);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	return strlen(buf);
+}
+
+static void zbus_http_listener_cb(const struct zbus_channel *chan)
+{
+	size_t i;
+
+	for (i = 0; i < channel_count; i++)
+	{
+		if (channels[i].chan == chan)
+		{
+			atomic_inc(&seqs[i]);
+			if (wake_fd >= 0)
+			{
+				eventfd_write(wake_fd, 1);
+			}
+			return;
+		}
+	}
+}
+
+ZBUS_LISTENER_DEFINE(zbus_http_listener, zbus_http_listener_cb);
+
+// =============================================================================
+// HTTP SERVER RESOURCE (server thread)
+// =============================================================================
+
+/* State of the request being received */
+static struct
+{
+	const struct http_client_ctx *client; /* Owner of the request in progress */
+	bool active;
+	bool list;                          /* GET /chan/ */
+	bool wait;                          /* ?wait= given */
+	bool too_large;                     /* Body over ZBUS_HTTP_JSON_SIZE */
+	const struct zbus_http_channel *entry;
+	size_t len;                         /* Body bytes in json_buf */
+	uint32_t start;                     /* access_log_timestamp() */
+} request;
+
+// POST body, then the response body
+static char json_buf[ZBUS_HTTP_JSON_SIZE];
+static uint8_t msg_buf[ZBUS_HTTP_MSG_SIZE] __aligned(8);
+
+static char seq_value[12];
+static char location[80];
+static const struct http_header seq_header[] = {
+	{ .name = "X-Zbus-Seq", .value = seq_value },
+};
+static const struct http_header location_header[] = {
+	{ .name = "Location", .value = location },
+};
+static const struct http_header allow_header[] = {
+	{ .name = "Allow", .value = "GET" },
+};
+
+static int zbus_http_reply(struct http_response_ctx *response_ctx, enum http_status code, int len)
+{
+	if (len < 0)
+	{
+		return len;
+	}
+
+	response_ctx->status = code;
+	response_ctx->body = (const uint8_t *)json_buf;
+	response_ctx->body_len = len;
+	response_ctx->final_chunk = true;
+	return 0;
+}
+
+static int zbus_http_error(struct http_response_ctx *response_ctx, enum http_status code,
+			   const char *reason)
+{
+	return zbus_http_reply(response_ctx, code,
+			       http_stream_printf(json_buf, sizeof(json_buf), "{\"error\":\"%s\"}",
+						  reason));
+}
+
+static int zbus_http_message(struct http_response_ctx *response_ctx,
+			     const struct zbus_http_channel *entry)
+{
+	uint32_t seq;
+	int len;
+
+	len = zbus_http_encode(entry, msg_buf, json_buf, sizeof(json_buf), &seq);
+	if (len < 0)
+	{
+		return zbus_http_error(response_ctx, HTTP_503_SERVICE_UNAVAILABLE, "channel busy");
+	}
+
+	snprintf(seq_value, sizeof(seq_value), "%u", seq);
+	response_ctx->headers = seq_header;
+	response_ctx->header_count = ARRAY_SIZE(seq_header);
+	return zbus_http_reply(response_ctx, HTTP_200_OK, len);
+}
+
+// GET /chan/ -> {"channels":["load_chan","alarm_chan"]}
+static int zbus_http_list(struct http_response_ctx *response_ctx)
+{
+	size_t len;
+	size_t i;
+	int ret;
+
+	len = http_stream_printf(json_buf, sizeof(json_buf), "{\"channels\":[");
+	for (i = 0; i < channel_count; i++)
+	{
+		ret = http_stream_printf(json_buf + len, sizeof(json_buf) - len, "%s\"%s\"",
+					 (i > 0) ? "," : "", zbus_chan_name(channels[i].chan));
+		if (ret < 0)
+		{
+			return zbus_http_error(response_ctx, HTTP_500_INTERNAL_SERVER_ERROR,
+					       "too many channels");
+		}
+		len += ret;
+	}
+
+	ret = http_stream_printf(json_buf + len, sizeof(json_buf) - len, "]}");
+	return zbus_http_reply(response_ctx, HTTP_200_OK, (ret < 0) ? ret : (int)len + ret);
+}
+
+/**
+ * Publish the POST body. Fields missing from it keep the current value of
+ * the channel (read, update, publish: a publication in between is
+ * overwritten)
+ */
+static int zbus_http_publish(struct http_response_ctx *response_ctx,
+			     const struct zbus_http_channel *entry)
+{
+	int64_t fields;
+	int ret;
+
+	ret = zbus_chan_read(entry->chan, msg_buf, K_MSEC(ZBUS_HTTP_CHAN_TIMEOUT_MS));
+	if (ret < 0)
+	{
+		return zbus_http_error(response_ctx, HTTP_503_SERVICE_UNAVAILABLE, "channel busy");
+	}
+
+	// Bitmask of the fields decoded, none is an error too
+	fields = json_obj_parse(json_buf, request.len, entry->descr, entry->descr_len, msg_buf);
+	if (fields <= 0)
+	{
+		return zbus_http_error(response_ctx, HTTP_400_BAD_REQUEST, "invalid message");
+	}
+
+	ret = zbus_chan_pub(entry->chan, msg_buf, K_MSEC(ZBUS_HTTP_CHAN_TIMEOUT_MS));
+	if (ret == -ENOMSG)
+	{
+		// Refused by the channel's validator
+		return zbus_http_error(response_ctx, HTTP_400_BAD_REQUEST, "message refused");
+	}
+	if (ret < 0)
+	{
+		return zbus_http_error(response_ctx, HTTP_503_SERVICE_UNAVAILABLE, "channel busy");
+	}
+
+	return zbus_http_message(response_ctx, entry);
+}
+
+/**
+ * Redirect a ?wait= request to the long-poll port of the address the
+ * client connected to
+ */
+static int zbus_http_redirect(struct http_client_ctx *client,
+			      struct http_response_ctx *response_ctx)
+{
+	struct sockaddr addr;
+	socklen_t addr_len = sizeof(addr);
+	char host[NET_IPV6_ADDR_LEN];
+	int ret;
+
+	if (zsock_getsockname(client->fd, &addr, &addr_len) < 0 ||
+	    net_addr_ntop(addr.sa_family,
+			  (addr.sa_family == AF_INET6) ? (void *)&net_sin6(&addr)->sin6_addr
+						       : (void *)&net_sin(&addr)->sin_addr,
+			  host, sizeof(host)) == NULL)
+	{
+		return zbus_http_error(response_ctx, HTTP_500_INTERNAL_SERVER_ERROR,
+				       "no local address");
+	}
+
+	ret = snprintf(location, sizeof(location),
+		       (addr.sa_family == AF_INET6) ? "http://[%s]:%d%s" : "http://%s:%d%s", host,
+		       ZBUS_HTTP_WAIT_PORT, (const char *)client->url_buffer);
+	if (ret < 0 || (size_t)ret >= sizeof(location))
+	{
+		return zbus_http_error(response_ctx, HTTP_414_URI_TOO_LONG, "path too long");
+	}
+
+	response_ctx->headers = location_header;
+	response_ctx->header_count = ARRAY_SIZE(location_header);
+	return zbus_http_reply(response_ctx, HTTP_307_TEMPORARY_REDIRECT, 0);
+}
+
+/**
+ * Find the channel of a new request
+ */
+static void zbus_http_dispatch(struct http_client_ctx *client)
+{
+	const char *path = (const char *)client->url_buffer + strlen(ZBUS_HTTP_PATH);
+	size_t name_len = strcspn(path, "?");
+	uint32_t wait;
+
+	request.entry = zbus_http_find(path, name_len);
+	request.list = (name_len == 0);
+	request.wait = (path[name_len] == '?' &&
+			zbus_http_query(path + name_len + 1, "wait", &wait));
+	request.too_large = false;
+	request.len = 0;
+	request.start = access_log_timestamp();
+}
+
+static int zbus_http_respond(struct http_client_ctx *client,
+			     struct http_response_ctx *response_ctx)
+{
+	if (request.too_large)
+	{
+		return zbus_http_error(response_ctx, HTTP_413_PAYLOAD_TOO_LARGE, "body too large");
+	}
+
+	if (request.list && client->method == HTTP_GET)
+	{
+		return zbus_http_list(response_ctx);
+	}
+
+	if (request.entry == NULL)
+	{
+		return zbus_http_error(response_ctx, HTTP_404_NOT_FOUND, "no such channel");
+	}
+
+	if (client->method == HTTP_GET)
+	{
+		return request.wait ? zbus_http_redirect(client, response_ctx)
+				    : zbus_http_message(response_ctx, request.entry);
+	}
+
+	if (!request.entry->writable)
+	{
+		response_ctx->headers = allow_header;
+		response_ctx->header_count = ARRAY_SIZE(allow_header);
+		return zbus_http_error(response_ctx, HTTP_405_METHOD_NOT_ALLOWED, "read only");
+	}
+
+	return zbus_http_publish(response_ctx, request.entry);
+}
+
+/**
+ * Request of another client while one is in progress: drop its body, 409
+ * once it is complete. The body is a constant, json_buf is the owner's
+ */
+static void zbus_http_busy(struct http_client_ctx *client, enum http_data_status status,
+			   struct http_response_ctx *response_ctx)
+{
+	static const char busy[] = "{\"error\":\"request in progress\"}";
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return;
+	}
+
+	response_ctx->status = HTTP_409_CONFLICT;
+	response_ctx->body = (const uint8_t *)busy;
+	response_ctx->body_len = sizeof(busy) - 1;
+	response_ctx->final_chunk = true;
+
+	metrics_http_response("zbus_http_resource_detail", HTTP_409_CONFLICT,
+			      response_ctx->body_len);
+	access_log_write("zbus_http_resource_detail", client->method, HTTP_409_CONFLICT,
+			 response_ctx->body_len, access_log_timestamp());
+}
+
+static int zbus_http_handler(struct http_client_ctx *client, enum http_data_status status,
+			     const struct http_request_ctx *request_ctx,
+			     struct http_response_ctx *response_ctx, void *user_data)
+{
+	uint16_t code;
+	int ret;
+
+	if (request.active && client != request.client)
+	{
+		// Not the owner: never touches the request in progress
+		if (status != HTTP_SERVER_DATA_ABORTED)
+		{
+			zbus_http_busy(client, status, response_ctx);
+		}
+		return 0;
+	}
+
+	if (status == HTTP_SERVER_DATA_ABORTED)
+	{
+		request.active = false;
+		return 0;
+	}
+
+	if (!request.active)
+	{
+		zbus_http_dispatch(client);
+		request.client = client;
+		request.active = true;
+	}
+
+	// Keep the body (POST) for the end, the rest of a larger one is dropped
+	if (request_ctx->data_len > 0 && !request.too_large)
+	{
+		if (request_ctx->data_len > sizeof(json_buf) - request.len)
+		{
+			request.too_large = true;
+		}
+		else
+		{
+			memcpy(json_buf + request.len, request_ctx->data, request_ctx->data_len);
+			request.len += request_ctx->data_len;
+		}
+	}
+
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	request.active = false;
+
+	ret = zbus_http_respond(client, response_ctx);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	code = (response_ctx->status != 0) ? response_ctx->status : HTTP_200_OK;
+	metrics_http_response("zbus_http_resource_detail", code, response_ctx->body_len);
+	access_log_write("zbus_http_resource_detail", client->method, code,
+			 response_ctx->body_len, request.start);
+	return 0;
+}
+
+struct http_resource_detail_dynamic zbus_http_resource_detail = {
+	.common = {
+		.type = HTTP_RESOURCE_TYPE_DYNAMIC,
+		.bitmask_of_supported_http_methods = BIT(HTTP_GET) | BIT(HTTP_POST),
+		.content_type = "application/json",
+	},
+	.cb = zbus_http_handler,
+	.user_data = NULL,
+};
+
+// =============================================================================
+// LONG-POLL THREAD
+// =============================================================================
+
+static struct zbus_http_waiter waiters[ZBUS_HTTP_MAX_WAITERS] = {
+	[0 ... ZBUS_HTTP_MAX_WAITERS - 1] = { .fd = -1 },
+};
+
+// Response of the long-poll thread, its own buffers
+static char wait_json[ZBUS_HTTP_JSON_SIZE];
+static char wait_response[ZBUS_HTTP_JSON_SIZE + 256];
+static uint8_t wait_msg[ZBUS_HTTP_MSG_SIZE] __aligned(8);
+
+static K_THREAD_STACK_DEFINE(wait_stack, ZBUS_HTTP_STACK_SIZE);
+static struct k_thread wait_thread;
+
+static void waiter_close(struct zbus_http_waiter *waiter)
+{
+	zsock_close(waiter->fd);
+	waiter->fd = -1;
+}
+
+/**
+ * Send a whole response and close. It is a few hundred bytes on a fresh
+ * connection, it fits in the TCP window: the thread never blocks on a
+ * client, one that cannot take it is dropped
+ */
+static void waiter_reply(struct zbus_http_waiter *waiter, const char *status, uint32_t seq,
+			 const char *body, int body_len)
+{
+	int len;
+
+	len = snprintf(wait_response, sizeof(wait_response),
+		       "HTTP/1.1 %s\r\n"
+		       "Content-Type: application/json\r\n"
+		       "Content-Length: %d\r\n"
+		       "X-Zbus-Seq: %u\r\n"
+		       "Access-Control-Allow-Origin: *\r\n"
+		       "Access-Control-Expose-Headers: X-Zbus-Seq\r\n"
+		       "Cache-Control: no-store\r\n"
+		       "Connection: close\r\n"
+		       "\r\n"
+		       "%.*s",
+		       status, body_len, seq, body_len, body);
+
+	if (len > 0 && (size_t)len < sizeof(wait_response))
+	{
+		zsock_send(waiter->fd, wait_response, len, ZSOCK_MSG_DONTWAIT);
+	}
+
+	waiter_close(waiter);
+}
+
+static void waiter_error(struct zbus_http_waiter *waiter, const char *status, const char *reason)
+{
+	int len = snprintf(wait_json, sizeof(wait_json), "{\"error\":\"%s\"}", reason);
+
+	waiter_reply(waiter, status, 0, wait_json, len);
+}
+
+static void waiter_message(struct zbus_http_waiter *waiter)
+{
+	uint32_t seq;
+	int len;
+
+	len = zbus_http_encode(&channels[waiter->channel], wait_msg, wait_json, sizeof(wait_json),
+			       &seq);
+	if (len < 0)
+	{
+		waiter_error(waiter, "503 Service Unavailable", "channel busy");
+		return;
+	}
+
+	waiter_reply(waiter, "200 OK", seq, wait_json, len);
+}
+
+/**
+ * Parse the request head: GET /chan/<name>?wait=<ms>[&seq=<n>] HTTP/1.1
+ */
+static void waiter_request(struct zbus_http_waiter *waiter, int64_t now)
+{
+	const struct zbus_http_channel *entry;
+	char *path;
+	char *name;
+	size_t name_len;
+	uint32_t wait = 0;
+	uint32_t seq;
+
+	if (strncmp(waiter->request, "GET ", 4) != 0)
+	{
+		waiter_error(waiter, "405 Method Not Allowed", "GET only");
+		return;
+	}
+
+	// The path ends at the space before the HTTP version
+	path = waiter->request + 4;
+	path[strcspn(path, " \r\n")] = '\0';
+
+	if (strncmp(path, ZBUS_HTTP_PATH, strlen(ZBUS_HTTP_PATH)) != 0)
+	{
+		waiter_error(waiter, "404 Not Found", "no such channel");
+		return;
+	}
+
+	name = path + strlen(ZBUS_HTTP_PATH);
+	name_len = strcspn(name, "?");
+	entry = zbus_http_find(name, name_len);
+	if (entry == NULL)
+	{
+		waiter_error(waiter, "404 Not Found", "no such channel");
+		return;
+	}
+
+	waiter->channel = entry - channels;
+	waiter->seq = (uint32_t)atomic_get(&seqs[waiter->channel]);
+	if (name[name_len] == '?')
+	{
+		zbus_http_query(name + name_len + 1, "wait", &wait);
+
+		// Publications since the client's last response are not missed
+		if (zbus_http_query(name + name_len + 1, "seq", &seq) && seq != waiter->seq)
+		{
+			waiter_message(waiter);
+			return;
+		}
+	}
+
+	waiter->waiting = true;
+	waiter->deadline_ms = now + MIN(wait, ZBUS_HTTP_MAX_WAIT_MS);
+}
+
+static void waiter_receive(struct zbus_http_waiter *waiter, int64_t now)
+{
+	ssize_t ret;
+
+	if (waiter->waiting)
+	{
+		// Nothing more is expected, only the end of the connection
+		ret = zsock_recv(waiter->fd, waiter->request, sizeof(waiter->request),
+				 ZSOCK_MSG_DONTWAIT);
+		if (ret == 0 || (ret < 0 && errno != EAGAIN))
+		{
+			waiter_close(waiter);
+		}
+		return;
+	}
+
+	ret = zsock_recv(waiter->fd, waiter->request + waiter->len,
+			 sizeof(waiter->request) - 1 - waiter->len, ZSOCK_MSG_DONTWAIT);
+	if (ret == 0 || (ret < 0 && errno != EAGAIN))
+	{
+		waiter_close(waiter);
+		return;
+	}
+	if (ret < 0)
+	{
+		return;
+	}
+
+	waiter->len += ret;
+	waiter->request[waiter->len] = '\0';
+
+	if (strstr(waiter->request, "\r\n\r\n") != NULL)
+	{
+		waiter_request(waiter, now);
+	}
+	else if (waiter->len == sizeof(waiter->request) - 1)
+	{
+		waiter_error(waiter, "431 Request Header Fields Too Large", "request too large");
+	}
+}
+
+static void waiter_accept(int64_t now)
+{
+	struct zbus_http_waiter *waiter = NULL;
+	int fd;
+	int i;
+
+	fd = zsock_accept(wait_fd, NULL, NULL);
+	if (fd < 0)
+	{
+		return;
+	}
+
+	for (i = 0; i < ZBUS_HTTP_MAX_WAITERS; i++)
+	{
+		if (waiters[i].fd < 0)
+		{
+			waiter = &waiters[i];
+			break;
+		}
+	}
+
+	// The listener is only polled with a free slot
+	if (waiter == NULL)
+	{
+		zsock_close(fd);
+		return;
+	}
+
+	waiter->fd = fd;
+	waiter->waiting = false;
+	waiter->len = 0;
+	waiter->deadline_ms = now + ZBUS_HTTP_REQUEST_MS;
+}
+
+static void wait_thread_fn(void *p1, void *p2, void *p3)
+{
+	// Slot 0 is the listener, slot 1 the eventfd, slot i + 2 belongs to waiters[i]
+	struct zsock_pollfd fds[ZBUS_HTTP_MAX_WAITERS + 2];
+	struct zbus_http_waiter *waiter;
+	eventfd_t value;
+	int64_t next_ms;
+	int64_t now;
+	bool full;
+	int i;
+
+	while (1)
+	{
+		full = true;
+		next_ms = INT64_MAX;
+		for (i = 0; i < ZBUS_HTTP_MAX_WAITERS; i++)
+		{
+			waiter = &waiters[i];
+			fds[i + 2].fd = waiter->fd;
+			fds[i + 2].events = ZSOCK_POLLIN;
+			fds[i + 2].revents = 0;
+			if (waiter->fd < 0)
+			{
+				full = false;
+				continue;
+			}
+			next_ms = MIN(next_ms, waiter->deadline_ms);
+		}
+
+		// A negative fd is not polled
+		fds[0].fd = full ? -1 : wait_fd;
+		fds[0].events = ZSOCK_POLLIN;
+		fds[0].revents = 0;
+		fds[1].fd = wake_fd;
+		fds[1].events = ZSOCK_POLLIN;
+		fds[1].revents = 0;
+
+		now = k_uptime_get();
+		zsock_poll(fds, ARRAY_SIZE(fds),
+			   (next_ms == INT64_MAX) ? -1
+						  : (int)CLAMP(next_ms - now, 0, ZBUS_HTTP_MAX_WAIT_MS));
+
+		now = k_uptime_get();
+		if (fds[1].revents & ZSOCK_POLLIN)
+		{
+			eventfd_read(wake_fd, &value);
+		}
+
+		for (i = 0; i < ZBUS_HTTP_MAX_WAITERS; i++)
+		{
+			waiter = &waiters[i];
+			if (waiter->fd < 0 || fds[i + 2].fd < 0)
+			{
+				continue;
+			}
+
+			if (fds[i + 2].revents & (ZSOCK_POLLERR | ZSOCK_POLLHUP | ZSOCK_POLLNVAL))
+			{
+				waiter_close(waiter);
+				continue;
+			}
+			if (fds[i + 2].revents & ZSOCK_POLLIN)
+			{
+				waiter_receive(waiter, now);
+				if (waiter->fd < 0)
+				{
+					continue;
+				}
+			}
+
+			if (!waiter->waiting)
+			{
+				if (now >= waiter->deadline_ms)
+				{
+					waiter_close(waiter);
+				}
+			}
+			else if ((uint32_t)atomic_get(&seqs[waiter->channel]) != waiter->seq)
+			{
+				waiter_message(waiter);
+			}
+			else if (now >= waiter->deadline_ms)
+			{
+				waiter_reply(waiter, "204 No Content", waiter->seq, "", 0);
+			}
+		}
+
+		// Accept after the clients, the new one gets its slot in the next poll
+		if (fds[0].revents & ZSOCK_POLLIN)
+		{
+			waiter_accept(now);
+		}
+	}
+}
+
+// =============================================================================
+// START
+// =============================================================================
+
+int zbus_http_start(const struct zbus_http_channel *table, size_t count)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(ZBUS_HTTP_WAIT_PORT),
+		.sin_addr.s_addr = htonl(INADDR_ANY),
+	};
+	int opt = 1;
+	size_t i;
+	int ret;
+
+	if (count > ZBUS_HTTP_MAX_CHANNELS)
+	{
+		printk("[ZBUS] %u channels, at most %d\n", (unsigned int)count,
+		       ZBUS_HTTP_MAX_CHANNELS);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (zbus_chan_msg_size(table[i].chan) > ZBUS_HTTP_MSG_SIZE)
+		{
+			printk("[ZBUS] %s: message over %d bytes\n", zbus_chan_name(table[i].chan),
+			       ZBUS_HTTP_MSG_SIZE);
+			return -ENOMEM;
+		}
+	}
+
+	wake_fd = eventfd(0, EFD_NONBLOCK);
+	if (wake_fd < 0)
+	{
+		ret = -errno;
+		printk("[ZBUS] Failed to create eventfd: %d\n", ret);
+		return ret;
+	}
+
+	wait_fd = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (wait_fd < 0)
+	{
+		ret = -errno;
+		printk("[ZBUS] Failed to create socket: %d\n", ret);
+		return ret;
+	}
+
+	zsock_setsockopt(wait_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+	if (zsock_bind(wait_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_listen(wait_fd, ZBUS_HTTP_MAX_WAITERS) < 0)
+	{
+		ret = -errno;
+		printk("[ZBUS] Failed to listen on port %d: %d\n", ZBUS_HTTP_WAIT_PORT, ret);
+		zsock_close(wait_fd);
+		wait_fd = -1;
+		return ret;
+	}
+
+	// Publications count from here on
+	channels = table;
+	channel_count = count;
+
+	k_thread_create(&wait_thread, wait_stack, K_THREAD_STACK_SIZEOF(wait_stack),
+			wait_thread_fn, NULL, NULL, NULL, ZBUS_HTTP_PRIORITY, 0, K_NO_WAIT);
+	k_thread_name_set(&wait_thread, "zbus_http");
+	return 0;
+}
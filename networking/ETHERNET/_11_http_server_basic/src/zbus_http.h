@@ -0,0 +1,95 @@
+/*
+ * zbus channels over HTTP: GET reads a channel, POST publishes to it (JSON
+ * from the json_obj_descr of its message), ?wait= long-polls the next
+ * publication on a port of its own
+ */
+
+#ifndef ZBUS_HTTP_H
+#define ZBUS_HTTP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <zephyr/data/json.h>
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/http/service.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/zbus/zbus.h>
+
+/* Channels of the bridge table */
+#define ZBUS_HTTP_MAX_CHANNELS 8
+
+/* Largest message struct of a bridged channel */
+#define ZBUS_HTTP_MSG_SIZE 64
+
+/* JSON of one message, POST body or response body */
+#define ZBUS_HTTP_JSON_SIZE 256
+
+/* Long-poll port. A ?wait= request to the HTTP server is redirected there,
+ * the server thread never waits for a publication */
+#define ZBUS_HTTP_WAIT_PORT 8081
+
+/* Long-poll clients waiting at the same time, one socket each */
+#define ZBUS_HTTP_MAX_WAITERS 4
+
+/* Longest ?wait=, and the time a long-poll client has to send its request */
+#define ZBUS_HTTP_MAX_WAIT_MS 30000
+#define ZBUS_HTTP_REQUEST_MS 2000
+
+/* Request head of a long-poll client (request line and headers) */
+#define ZBUS_HTTP_REQUEST_SIZE 512
+
+/* Channel read and publish timeout */
+#define ZBUS_HTTP_CHAN_TIMEOUT_MS 100
+
+/* Long-poll thread, below the HTTP server like the /live push thread */
+#define ZBUS_HTTP_STACK_SIZE 2048
+#define ZBUS_HTTP_PRIORITY 8
+
+/* One bridged channel, /chan/<channel name> */
+struct zbus_http_channel
+{
+	const struct zbus_channel *chan;
+	const struct json_obj_descr *descr; /* Fields of the message struct */
+	size_t descr_len;
+	bool writable;                      /* POST publishes, otherwise 405 */
+};
+
+/**
+ *  @brief Entry of the zbus_http_start() table
+ *
+ *  The channel must list zbus_http_listener in its observers, the long-poll
+ *  port learns about its publications through it.
+ *
+ *  @param _chan Channel (ZBUS_CHAN_DEFINE() name), CONFIG_ZBUS_CHANNEL_NAME
+ *               gives the name of its path
+ *  @param _descr json_obj_descr array of the message struct
+ *  @param _writable true if POST may publish to the channel
+ */
+#define ZBUS_HTTP_CHANNEL(_chan, _descr, _writable)                                \
+	{                                                                          \
+		.chan = &(_chan),                                                  \
+		.descr = (_descr),                                                 \
+		.descr_len = ARRAY_SIZE(_descr),                                   \
+		.writable = (_writable),                                           \
+	}
+
+/* Observer of the bridged channels, for ZBUS_OBSERVERS() */
+ZBUS_OBS_DECLARE(zbus_http_listener);
+
+/* Dynamic resource detail of /chan/..., used with HTTP_RESOURCE_DEFINE() */
+extern struct http_resource_detail_dynamic zbus_http_resource_detail;
+
+/**
+ *  @brief Bridge the channels of the table and start the long-poll thread
+ *
+ *  @param channels Table of ZBUS_HTTP_CHANNEL() entries, kept for the
+ *                  bridge's lifetime
+ *  @param count Entries in the table, at most ZBUS_HTTP_MAX_CHANNELS
+ *
+ *  @return 0 on success, negative errno if a channel does not fit or the
+ *          long-poll socket cannot be opened
+ */
+int zbus_http_start(const struct zbus_http_channel *channels, size_t count);
+
+#endif /* ZBUS_HTTP_H */
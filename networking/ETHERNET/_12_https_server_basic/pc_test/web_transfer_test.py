@@ -0,0 +1,348 @@
+#!/usr/bin/env python3
+"""
+Web Transfer Size Test
+
+Measures the bytes on the wire for the board's web resources, for each
+Accept-Encoding a client may send, and for a revalidation with the ETag.
+
+Usage:
+    python web_transfer_test.py
+    python web_transfer_test.py --ip 192.0.2.1          # native_sim
+    python web_transfer_test.py --paths / /main.js --src ../src/static_web_resources
+    python web_transfer_test.py --tls --port 4443       # _12_https_server_basic
+
+For every path, one request per case, each on a new connection:
+    none        no Accept-Encoding (curl without --compressed)
+    gzip        Accept-Encoding: gzip
+    br          Accept-Encoding: br
+    browser     Accept-Encoding: gzip, deflate, br, zstd
+    304         browser case again, with If-None-Match: <its ETag>
+    304+GET     the 304 request without Connection: close, then a plain GET
+                on the same keep-alive connection. Fails when bytes follow
+                the 304 on a connection the server keeps open, or when the
+                GET does not parse. With "Connection: close" on the 304 the
+                GET goes out on a new connection, as a browser sends it
+
+Columns: status, Content-Encoding sent, header bytes, body bytes on the
+wire (chunk framing included), total bytes, and whether the decoded body
+matches the source file (--src) or the identity response. Decoding br
+needs the brotli module (pip install brotli), otherwise "n/a".
+"""
+
+import argparse
+import gzip
+import os
+import socket
+import ssl
+import sys
+
+# Configuration
+SERVER_IP = "192.168.1.100"     # STM32 board IP
+SERVER_PORT = 8080
+PATHS = ["/", "/main.js"]
+TIMEOUT_SECONDS = 5
+DRAIN_SECONDS = 0.2             # Wait for stray bytes after a complete response
+
+CASES = [
+    ("none", None),
+    ("gzip", "gzip"),
+    ("br", "br"),
+    ("browser", "gzip, deflate, br, zstd"),
+]
+
+# Source file of each path, for --src
+SOURCE_FILES = {
+    "/": "index.html",
+    "/main.js": "main.js",
+}
+
+
+class Response:
+    """One HTTP/1.1 response as received"""
+
+    def __init__(self):
+        self.status = 0
+        self.headers = {}
+        self.header_bytes = 0
+        self.body_bytes = 0         # On the wire, chunk framing included
+        self.body = b""             # De-chunked, still encoded
+
+
+def read_chunked(sock, buf):
+    """Read a chunked body from buf + sock, return (body, wire bytes)"""
+    body = b""
+    pos = 0
+
+    while True:
+        while b"\r\n" not in buf[pos:]:
+            buf += recv_some(sock)
+        line_end = buf.index(b"\r\n", pos)
+        size = int(buf[pos:line_end].split(b";")[0], 16)
+        pos = line_end + 2
+
+        while len(buf) < pos + size + 2:
+            buf += recv_some(sock)
+        body += buf[pos:pos + size]
+        pos += size + 2
+
+        if size == 0:
+            return body, pos
+
+
+def recv_some(sock):
+    data = sock.recv(4096)
+    if not data:
+        raise ConnectionError("connection closed mid-response")
+    return data
+
+
+def connect(args):
+    """TCP connection to the board, wrapped in TLS with --tls (certificate not checked)"""
+    sock = socket.create_connection((args.ip, args.port), timeout=TIMEOUT_SECONDS)
+    if not args.tls:
+        return sock
+
+    context = ssl.create_default_context()
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    return context.wrap_socket(sock, server_hostname=args.ip)
+
+
+def build_request(args, path, headers, close=True):
+    """GET request bytes, Connection: close unless the connection is kept"""
+    request = f"GET {path} HTTP/1.1\r\nHost: {args.ip}:{args.port}\r\n"
+    for name, value in headers.items():
+        request += f"{name}: {value}\r\n"
+    if close:
+        request += "Connection: close\r\n"
+    return (request + "\r\n").encode()
+
+
+def read_response(sock, buf=b""):
+    """Read one response from buf + sock, return (Response, bytes after it)
+
+    A status line that does not parse (stray bytes of the previous response
+    on a keep-alive connection) raises ValueError.
+    """
+    rsp = Response()
+
+    while b"\r\n\r\n" not in buf:
+        buf += recv_some(sock)
+
+    head, buf = buf.split(b"\r\n\r\n", 1)
+    rsp.header_bytes = len(head) + 4
+    lines = head.decode("latin-1").split("\r\n")
+    status = lines[0].split()
+    if len(status) < 2 or not status[0].startswith("HTTP/") or not status[1].isdigit():
+        raise ValueError(f"bad status line {lines[0]!r}")
+    rsp.status = int(status[1])
+    for line in lines[1:]:
+        name, _, value = line.partition(":")
+        rsp.headers[name.strip().lower()] = value.strip()
+
+    if rsp.status == 304 or rsp.status == 204:
+        consumed = 0
+    elif rsp.headers.get("transfer-encoding", "").lower() == "chunked":
+        rsp.body, consumed = read_chunked(sock, buf)
+    elif "content-length" in rsp.headers:
+        length = int(rsp.headers["content-length"])
+        while len(buf) < length:
+            buf += recv_some(sock)
+        rsp.body = buf[:length]
+        consumed = length
+    else:
+        sock.settimeout(TIMEOUT_SECONDS)
+        while True:
+            data = sock.recv(4096)
+            if not data:
+                break
+            buf += data
+        rsp.body = buf
+        consumed = len(buf)
+
+    rsp.body_bytes = consumed
+    return rsp, buf[consumed:]
+
+
+def drain(sock):
+    """Bytes the server still sends within DRAIN_SECONDS"""
+    extra = 0
+    sock.settimeout(DRAIN_SECONDS)
+    try:
+        while True:
+            data = sock.recv(4096)
+            if not data:
+                break
+            extra += len(data)
+    except (socket.timeout, ssl.SSLError, ConnectionError):
+        pass
+    sock.settimeout(TIMEOUT_SECONDS)
+    return extra
+
+
+def fetch(args, path, headers):
+    """GET path on a new connection, return a Response"""
+    with connect(args) as sock:
+        sock.sendall(build_request(args, path, headers))
+        rsp, rest = read_response(sock)
+
+        # Count whatever else the server sends for this response
+        rsp.body_bytes += len(rest) + drain(sock)
+
+    return rsp
+
+
+def fetch_after_304(args, path, headers):
+    """Revalidate on a keep-alive connection, then GET path without
+    If-None-Match the way a browser does. Return (GET Response, error)"""
+    get_headers = {k: v for k, v in headers.items() if k != "If-None-Match"}
+
+    with connect(args) as sock:
+        sock.sendall(build_request(args, path, headers, close=False))
+        first, rest = read_response(sock)
+        if first.status != 304:
+            return first, f"revalidation got {first.status}"
+
+        if first.headers.get("connection", "").lower() == "close":
+            # The client must not reuse the connection, stray bytes are dropped
+            return fetch(args, path, get_headers), None
+
+        stray = len(rest) + drain(sock)
+        if stray:
+            return first, f"{stray} bytes after the 304 on a kept connection"
+
+        sock.sendall(build_request(args, path, get_headers))
+        try:
+            rsp, rest = read_response(sock)
+        except ValueError as e:
+            return first, str(e)
+        rsp.body_bytes += len(rest) + drain(sock)
+
+    return rsp, None
+
+
+def decode(rsp):
+    """Decoded body, None when the encoding cannot be decoded here"""
+    encoding = rsp.headers.get("content-encoding", "identity")
+    if encoding == "identity":
+        return rsp.body
+    if encoding == "gzip":
+        return gzip.decompress(rsp.body)
+    if encoding == "br":
+        try:
+            import brotli
+            return brotli.decompress(rsp.body)
+        except ImportError:
+            return None
+    return None
+
+
+def test_path(args, path):
+    """Run every case on one path, return the rows and the failure count"""
+    reference = None
+    if args.src and path in SOURCE_FILES:
+        with open(os.path.join(args.src, SOURCE_FILES[path]), "rb") as f:
+            reference = f.read()
+
+    rows = []
+    failures = 0
+    browser_etag = None
+
+    for name, accept in CASES + [("304", "gzip, deflate, br, zstd")]:
+        headers = {}
+        if accept is not None:
+            headers["Accept-Encoding"] = accept
+        if name == "304":
+            if browser_etag is None:
+                continue
+            headers["If-None-Match"] = browser_etag
+
+        rsp = fetch(args, path, headers)
+
+        if name == "browser":
+            browser_etag = rsp.headers.get("etag")
+
+        if rsp.status == 304:
+            check = "ok" if name == "304" else "FAIL"
+        else:
+            body = decode(rsp)
+            if reference is None and name == "none":
+                reference = body
+            if body is None:
+                check = "n/a"
+            elif reference is None:
+                check = "-"
+            else:
+                check = "ok" if body == reference else "FAIL"
+            if name == "304":
+                check = "FAIL"
+
+        if check == "FAIL":
+            failures += 1
+
+        rows.append((path, name, rsp.status, rsp.headers.get("content-encoding", "-"),
+                     rsp.header_bytes, rsp.body_bytes, rsp.header_bytes + rsp.body_bytes, check))
+
+    # The revalidation on a keep-alive connection, then a GET
+    if browser_etag is not None:
+        headers = {"Accept-Encoding": CASES[-1][1], "If-None-Match": browser_etag}
+        rsp, error = fetch_after_304(args, path, headers)
+        if error is not None:
+            print(f"[FAIL] {path} 304+GET: {error}")
+            check = "FAIL"
+        elif rsp.status != 200:
+            check = "FAIL"
+        else:
+            body = decode(rsp)
+            if body is None:
+                check = "n/a"
+            elif reference is None:
+                check = "-"
+            else:
+                check = "ok" if body == reference else "FAIL"
+
+        if check == "FAIL":
+            failures += 1
+
+        rows.append((path, "304+GET", rsp.status, rsp.headers.get("content-encoding", "-"),
+                     rsp.header_bytes, rsp.body_bytes, rsp.header_bytes + rsp.body_bytes, check))
+
+    return rows, failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure web resource transfer sizes per encoding")
+    parser.add_argument("--ip", default=SERVER_IP, help="Board IP address")
+    parser.add_argument("--port", type=int, default=SERVER_PORT, help="HTTP port")
+    parser.add_argument("--paths", nargs="+", default=PATHS, help="Resources to fetch")
+    parser.add_argument("--src", help="static_web_resources directory, to check decoded bodies")
+    parser.add_argument("--tls", action="store_true", help="HTTPS (certificate not checked)")
+    args = parser.parse_args()
+
+    scheme = "https" if args.tls else "http"
+    print(f"[INFO] Web transfer test against {scheme}://{args.ip}:{args.port}")
+    print("-" * 78)
+    print(f"{'path':<12}{'case':<9}{'status':>7}  {'encoding':<9}{'headers':>8}{'body':>8}"
+          f"{'total':>8}  {'check':<5}")
+
+    failures = 0
+    try:
+        for path in args.paths:
+            rows, path_failures = test_path(args, path)
+            failures += path_failures
+            for row in rows:
+                print(f"{row[0]:<12}{row[1]:<9}{row[2]:>7}  {row[3]:<9}{row[4]:>8}{row[5]:>8}"
+                      f"{row[6]:>8}  {row[7]:<5}")
+    except (OSError, ConnectionError) as e:
+        print(f"[ERROR] {e}")
+        sys.exit(1)
+
+    print("-" * 78)
+    if failures:
+        print(f"[FAIL] {failures} responses did not match")
+        sys.exit(1)
+    print("[OK] All responses decoded to the same content")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+Generate the encoded variants of the web resources at build time.
+
+For every input file, writes <file>.variants.inc into --out-dir. It holds
+one C array per encoding and a struct web_variant table (see
+src/web_assets.h), sorted smallest first:
+
+    identity  the file as is
+    gzip      gzip at level 9 (mtime 0, so builds are reproducible)
+    br        brotli at quality 11, when the brotli Python module or the
+              brotli command line tool is installed, skipped otherwise
+
+Each variant gets its own strong ETag: the first 16 hex digits of the
+SHA-256 of the source file, plus "-gz" or "-br".
+
+The ROM used by each variant is printed and written to --report.
+
+Usage:
+    python web_variants.py --out-dir build/zephyr/include/generated \\
+        --report web_variants.txt src/static_web_resources/index.html ...
+    python web_variants.py --encodings gzip br --out-dir gen index.html
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import shutil
+import subprocess
+import sys
+
+ETAG_DIGITS = 16
+BYTES_PER_LINE = 8
+
+# Encoding name -> ETag suffix
+ETAG_SUFFIX = {
+    "identity": "",
+    "gzip": "-gz",
+    "br": "-br",
+}
+
+
+def brotli_compress(data):
+    """Brotli at max quality, None when no brotli encoder is installed"""
+    try:
+        import brotli
+        return brotli.compress(data, quality=11)
+    except ImportError:
+        pass
+
+    tool = shutil.which("brotli")
+    if tool is None:
+        return None
+
+    result = subprocess.run([tool, "-c", "-q", "11"], input=data,
+                            stdout=subprocess.PIPE, check=True)
+    return result.stdout
+
+
+def encode(data, encoding):
+    if encoding == "identity":
+        return data
+    if encoding == "gzip":
+        return gzip.compress(data, compresslevel=9, mtime=0)
+    if encoding == "br":
+        return brotli_compress(data)
+    raise ValueError("unknown encoding " + encoding)
+
+
+def c_array(name, data):
+    lines = ["static const uint8_t %s[] = {" % name]
+    for i in range(0, len(data), BYTES_PER_LINE):
+        chunk = data[i:i + BYTES_PER_LINE]
+        lines.append("\t" + " ".join("0x%02x," % b for b in chunk))
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def generate(path, encodings, out_dir):
+    """Write <file>.variants.inc, return {encoding: size}"""
+    name = os.path.basename(path)
+    ident = "".join(c if c.isalnum() else "_" for c in name)
+
+    with open(path, "rb") as f:
+        data = f.read()
+
+    digest = hashlib.sha256(data).hexdigest()[:ETAG_DIGITS]
+
+    variants = []
+    for encoding in encodings:
+        encoded = encode(data, encoding)
+        if encoded is not None:
+            variants.append((encoding, encoded))
+
+    # Smallest first: the handler sends the first one the client accepts
+    variants.sort(key=lambda v: len(v[1]))
+
+    out = ["/* Generated by web_variants.py from %s, do not edit */" % name, ""]
+    for encoding, encoded in variants:
+        out.append(c_array("%s_%s" % (ident, encoding), encoded))
+        out.append("")
+
+    out.append("static const struct web_variant %s_variants[] = {" % ident)
+    for encoding, encoded in variants:
+        content_encoding = "NULL" if encoding == "identity" else '"%s"' % encoding
+        etag = '"\\"%s%s\\""' % (digest, ETAG_SUFFIX[encoding])
+        out.append("\tWEB_VARIANT(%s_%s, %s, %s)," % (ident, encoding, content_encoding, etag))
+    out.append("};")
+
+    with open(os.path.join(out_dir, name + ".variants.inc"), "w") as f:
+        f.write("\n".join(out) + "\n")
+
+    return {encoding: len(encoded) for encoding, encoded in variants}
+
+
+def report(sizes, encodings):
+    """ROM size table, one row per resource and one column per encoding"""
+    lines = ["Web resources in ROM (bytes):",
+             "  %-16s" % "resource" + "".join("%10s" % e for e in encodings) + "%10s" % "total"]
+
+    totals = dict.fromkeys(encodings, 0)
+    for name, variant_sizes in sizes.items():
+        row = "  %-16s" % name
+        for encoding in encodings:
+            size = variant_sizes.get(encoding)
+            row += "%10s" % ("-" if size is None else size)
+            totals[encoding] += size or 0
+        row += "%10d" % sum(variant_sizes.values())
+        lines.append(row)
+
+    lines.append("  %-16s" % "total" + "".join("%10d" % totals[e] for e in encodings)
+                 + "%10d" % sum(totals.values()))
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate encoded variants of web resources")
+    parser.add_argument("inputs", nargs="+", help="Web resources (html, js, css...)")
+    parser.add_argument("--out-dir", required=True, help="Directory for the .variants.inc files")
+    parser.add_argument("--report", help="Write the ROM size table to this file")
+    parser.add_argument("--encodings", nargs="+", default=["identity", "gzip", "br"],
+                        choices=sorted(ETAG_SUFFIX), help="Variants to generate")
+    args = parser.parse_args()
+
+    if "br" in args.encodings and brotli_compress(b"") is None:
+        print("web_variants.py: no brotli encoder (pip install brotli), br variants skipped",
+              file=sys.stderr)
+
+    os.makedirs(args.out_dir, exist_ok=True)
+
+    sizes = {}
+    for path in args.inputs:
+        sizes[os.path.basename(path)] = generate(path, args.encodings, args.out_dir)
+
+    table = report(sizes, args.encodings)
+    print(table)
+
+    if args.report:
+        with open(args.report, "w") as f:
+            f.write(table + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,137 @@
+/**
+ * Access log (the one of _11_http_server_basic without /logs)
+ *
+ * A printk per request holds the server thread until the console UART has
+ * sent the line, so every logged request gets slower by the time of the
+ * line at 115200 baud (about 90 us per character). Handlers write a 16-byte
+ * binary record instead, into a single-producer single-consumer ring:
+ *
+ *   server thread   access_log_write()  ->  ring[head++]    (no lock, no wait)
+ *   drain thread    ring[tail++]  ->  LOG_INF()
+ *
+ * Only the server thread writes (the handlers) and only the drain thread
+ * reads, so head and tail each have a single writer and an atomic store is
+ * enough to hand over a record. A full ring drops the new record and
+ * counts it, the server never waits for the log.
+ *
+ * The drain thread runs at the lowest application priority every
+ * ACCESS_LOG_DRAIN_MS and formats the records for the log backend.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/http/server.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include "access_log.h"
+
+LOG_MODULE_REGISTER(access_log, LOG_LEVEL_INF);
+
+BUILD_ASSERT(IS_POWER_OF_TWO(ACCESS_LOG_RING_SIZE), "ACCESS_LOG_RING_SIZE must be a power of 2");
+
+static struct access_log_record ring[ACCESS_LOG_RING_SIZE];
+static atomic_t ring_head;                  /* Records written, server thread only */
+static atomic_t ring_tail;                  /* Records drained, drain thread only */
+static atomic_t dropped;
+
+// Resource names by id, added by the server thread before the first record
+// that uses them. The last id is shared by the resources that do not fit
+static const char *resources[ACCESS_LOG_MAX_RESOURCES];
+static atomic_t resource_count;
+
+static K_THREAD_STACK_DEFINE(drain_stack, ACCESS_LOG_STACK_SIZE);
+static struct k_thread drain_thread;
+
+static uint8_t resource_id(const char *resource)
+{
+	uint32_t count = (uint32_t)atomic_get(&resource_count);
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (resources[i] == resource)
+		{
+			return i;
+		}
+	}
+
+	if (count < ACCESS_LOG_MAX_RESOURCES - 1)
+	{
+		resources[count] = resource;
+		atomic_set(&resource_count, count + 1);
+		return count;
+	}
+
+	return ACCESS_LOG_MAX_RESOURCES - 1;
+}
+
+static const char *resource_name(uint8_t id)
+{
+	return (id < (uint32_t)atomic_get(&resource_count)) ? resources[id] : "other";
+}
+
+void access_log_write(const char *resource, uint8_t method, uint16_t status, size_t bytes,
+		      uint32_t start)
+{
+	uint32_t head = (uint32_t)atomic_get(&ring_head);
+	struct access_log_record *record;
+
+	if (head - (uint32_t)atomic_get(&ring_tail) >= ACCESS_LOG_RING_SIZE)
+	{
+		atomic_inc(&dropped);
+		return;
+	}
+
+	record = &ring[head & (ACCESS_LOG_RING_SIZE - 1)];
+	record->time_ms = k_uptime_get_32();
+	record->latency_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+	record->bytes = (uint32_t)MIN(bytes, UINT32_MAX);
+	record->status = status;
+	record->method = method;
+	record->resource = resource_id(resource);
+
+	// Publish: the drain thread reads the slot only once it sees the new head
+	atomic_set(&ring_head, head + 1);
+}
+
+static void drain_thread_fn(void *p1, void *p2, void *p3)
+{
+	struct access_log_record record;
+	uint32_t reported = 0;
+	uint32_t count;
+	uint32_t tail;
+
+	while (true)
+	{
+		k_msleep(ACCESS_LOG_DRAIN_MS);
+
+		tail = (uint32_t)atomic_get(&ring_tail);
+		while (tail != (uint32_t)atomic_get(&ring_head))
+		{
+			record = ring[tail & (ACCESS_LOG_RING_SIZE - 1)];
+
+			// Free the slot before the slow part
+			tail++;
+			atomic_set(&ring_tail, tail);
+
+			LOG_INF("%s %s %u, %u bytes, %u us", http_method_str(record.method),
+				resource_name(record.resource), record.status, record.bytes,
+				record.latency_us);
+		}
+
+		count = (uint32_t)atomic_get(&dropped);
+		if (count != reported)
+		{
+			LOG_WRN("%u records dropped, ring full", count - reported);
+			reported = count;
+		}
+	}
+}
+
+void access_log_start(void)
+{
+	k_thread_create(&drain_thread, drain_stack, K_THREAD_STACK_SIZEOF(drain_stack),
+			drain_thread_fn, NULL, NULL, NULL, ACCESS_LOG_PRIORITY, 0, K_NO_WAIT);
+	k_thread_name_set(&drain_thread, "access_log");
+}
@@ -15,55 +15,36 @@
 #include <zephyr/net/socket.h>
 #include <zephyr/net/net_config.h>
 
+#include "access_log.h"
+#include "web_assets.h"
+
 // HTTPS server configuration
 #define HTTPS_SERVER_PORT 4443
 #define MAX_HTTPS_CLIENTS 4
 
 // =============================================================================
-// STATIC RESOURCES (Compressed with gzip)
+// STATIC RESOURCES (identity, gzip and brotli variants)
 // =============================================================================
 
-// HTML content - compressed at build time
-static const uint8_t index_html_gz[] = {
-#include "index.html.gz.inc"
-};
+// HTML content - encoded at build time (scripts/web_variants.py)
+#include "index.html.variants.inc"
 
-// JavaScript content - compressed at build time
-static const uint8_t main_js_gz[] = {
-#include "main.js.gz.inc"
-};
+// JavaScript content - encoded at build time
+#include "main.js.variants.inc"
 
 // =============================================================================
 // RESOURCE DEFINITIONS
 // =============================================================================
 
 // Index.html resource - served at "/" endpoint
-// Client sends: GET /
-// Server responds: HTML page (gzipped)
-static struct http_resource_detail_static index_html_resource_detail = {
-	.common = {
-		.type = HTTP_RESOURCE_TYPE_STATIC,
-		.bitmask_of_supported_http_methods = BIT(HTTP_GET),
-		.content_encoding = "gzip",
-		.content_type = "text/html",
-	},
-	.static_data = index_html_gz,
-	.static_data_len = sizeof(index_html_gz),
-};
+// Client sends: GET / (Accept-Encoding, If-None-Match: "<etag>" on a repeat load)
+// Server responds: HTML page (smallest accepted encoding), or 304 Not Modified
+WEB_ASSET_DEFINE(index_html_resource_detail, index_html_variants, "text/html");
 
 // Main.js resource - served at "/main.js" endpoint
-// Client sends: GET /main.js
-// Server responds: JavaScript file (gzipped)
-static struct http_resource_detail_static main_js_resource_detail = {
-	.common = {
-		.type = HTTP_RESOURCE_TYPE_STATIC,
-		.bitmask_of_supported_http_methods = BIT(HTTP_GET),
-		.content_encoding = "gzip",
-		.content_type = "text/javascript",
-	},
-	.static_data = main_js_gz,
-	.static_data_len = sizeof(main_js_gz),
-};
+// Client sends: GET /main.js (Accept-Encoding, If-None-Match: "<etag>" on a repeat load)
+// Server responds: JavaScript file (smallest accepted encoding), or 304 Not Modified
+WEB_ASSET_DEFINE(main_js_resource_detail, main_js_variants, "text/javascript");
 
 // =============================================================================
 // DYNAMIC RESOURCE HANDLERS
@@ -78,10 +59,9 @@ static int device_info_handler(struct http_client_ctx *client, enum http_data_st
 {
 	// Buffer for JSON response
 	static char info_buf[256];
+	uint32_t start = access_log_timestamp();
 	int len;
 
-	printk("[HTTPS] Device info handler called, status: %d\n", status);
-
 	// Wait for all request data to be received before responding
 	if (status == HTTP_SERVER_DATA_FINAL)
 	{
@@ -103,6 +83,8 @@ static int device_info_handler(struct http_client_ctx *client, enum http_data_st
 		response_ctx->body = (uint8_t *)info_buf;
 		response_ctx->body_len = len;
 		response_ctx->final_chunk = true;
+		access_log_write("device_info_resource_detail", client->method, HTTP_200_OK, len,
+						 start);
 	}
 
 	return 0;
@@ -120,23 +102,45 @@ static struct http_resource_detail_dynamic device_info_resource_detail = {
 // Echo handler - echoes back the received data
 // Client sends: GET /echo or POST /echo with body
 // Server responds: Same body data back to client
+// The fragments of two clients' bodies interleave on the server thread: the
+// echo belongs to one client at a time, another one meanwhile gets 409
 static int echo_handler(struct http_client_ctx *client, enum http_data_status status,
 						const struct http_request_ctx *request_ctx,
 						struct http_response_ctx *response_ctx, void *user_data)
 {
 	enum http_method method = client->method;
+	// Client of the echo in progress, NULL when there is none
+	static const struct http_client_ctx *echo_client;
+	static size_t echo_bytes;
+	static uint32_t echo_start;
+
+	// Another client's request: body dropped, 409 once it is complete
+	if (echo_client != NULL && client != echo_client)
+	{
+		if (status == HTTP_SERVER_DATA_FINAL)
+		{
+			response_ctx->status = HTTP_409_CONFLICT;
+			response_ctx->final_chunk = true;
+			access_log_write("echo_resource_detail", method, HTTP_409_CONFLICT, 0,
+					 access_log_timestamp());
+		}
+		return 0;
+	}
 
 	// Handle aborted transactions (connection closed by client)
 	if (status == HTTP_SERVER_DATA_ABORTED)
 	{
 		printk("[HTTPS] Echo transaction aborted\n");
+		echo_client = NULL;
+		echo_bytes = 0;
 		return 0;
 	}
 
-	// Log received data
-	if (request_ctx->data_len > 0)
+	if (echo_client == NULL)
 	{
-		printk("[HTTPS] %s received %zd bytes\n", http_method_str(method), request_ctx->data_len);
+		echo_client = client;
+		echo_bytes = 0;
+		echo_start = access_log_timestamp();
 	}
 
 	// Echo data back to client
@@ -145,6 +149,14 @@ static int echo_handler(struct http_client_ctx *client, enum http_data_status st
 	// Mark as final chunk if all data received
 	response_ctx->final_chunk = (status == HTTP_SERVER_DATA_FINAL);
 
+	echo_bytes += request_ctx->data_len;
+	if (response_ctx->final_chunk)
+	{
+		access_log_write("echo_resource_detail", method, HTTP_200_OK, echo_bytes, echo_start);
+		echo_client = NULL;
+		echo_bytes = 0;
+	}
+
 	return 0;
 }
 
@@ -228,10 +240,10 @@ HTTPS_SERVICE_DEFINE(https_service, NULL, &https_service_port,
 // RESOURCE ROUTING
 // =============================================================================
 
-// Route "/" -> static HTML
+// Route "/" -> HTML (encoding negotiated, ETag)
 HTTP_RESOURCE_DEFINE(index_resource, https_service, "/", &index_html_resource_detail);
 
-// Route "/main.js" -> static JavaScript
+// Route "/main.js" -> JavaScript (encoding negotiated, ETag)
 HTTP_RESOURCE_DEFINE(main_js_resource, https_service, "/main.js", &main_js_resource_detail);
 
 // Route "/device-info" -> dynamic endpoint (calls device_info_handler)
@@ -256,6 +268,9 @@ int main(void)
 	// Setup TLS credentials before starting the server
 	setup_tls();
 
+	// Drain thread of the access log
+	access_log_start();
+
 	// Start the HTTPS server (blocking call)
 	http_server_start();
 
@@ -0,0 +1,281 @@
+/**
+ * Static web assets with encoding negotiation and ETag validation
+ *
+ * scripts/web_variants.py stores every asset in ROM in several encodings
+ * (identity, gzip, brotli when the build host has it) and sorts them
+ * smallest first. For each request the handler sends the first variant the
+ * client's Accept-Encoding allows, so a browser gets brotli, curl without
+ * --compressed gets the plain file, and nobody gets an encoding it cannot
+ * decode.
+ *
+ * Every variant has its own ETag (a hash of the source file plus the
+ * encoding). Responses carry the ETag, Cache-Control and Vary:
+ * Accept-Encoding. A browser or dashboard that already has the asset sends
+ * the ETag back in If-None-Match and gets a 304 with no body, so a repeat
+ * page load costs a few hundred bytes of headers instead of the whole
+ * bundle.
+ *
+ * The server frames every dynamic response as chunked, a 304 included, and
+ * its 5-byte terminator would be read by a keep-alive client as the start
+ * of the next response. Over HTTP/1.1 the 304 therefore carries
+ * "Connection: close": the client drops the connection after the headers
+ * and sends its next request on a new one.
+ *
+ * Accept-Encoding and If-None-Match are kept by the server's header capture
+ * (CONFIG_HTTP_SERVER_CAPTURE_HEADERS), which is why the assets are dynamic
+ * resources: static resources cannot see request headers.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/http/service.h>
+
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+#include "access_log.h"
+#include "web_assets.h"
+
+// Accept-Encoding weights are kept in thousandths (q=0.5 is 500)
+#define Q_MAX 1000
+
+// Headers of a 304: those of the variant, then Connection (server thread only)
+static struct http_header not_modified_headers[WEB_VARIANT_HEADERS_304 + 1];
+
+HTTP_SERVER_REGISTER_HEADER_CAPTURE(capture_accept_encoding, "Accept-Encoding");
+HTTP_SERVER_REGISTER_HEADER_CAPTURE(capture_if_none_match, "If-None-Match");
+
+/**
+ * Value of a captured request header, NULL when not present
+ */
+static const char *request_header(const struct http_request_ctx *request_ctx, const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < request_ctx->header_count; i++)
+	{
+		if (strcasecmp(request_ctx->headers[i].name, name) == 0)
+		{
+			return request_ctx->headers[i].value;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Check if an If-None-Match value ("*" or a list of ETags) matches etag.
+ * If-None-Match uses the weak comparison, so a W/ prefix is ignored
+ */
+static bool etag_listed(const char *list, const char *etag)
+{
+	size_t len = strlen(etag);
+	const char *p = list;
+
+	while (p != NULL)
+	{
+		while (*p == ' ' || *p == '\t' || *p == ',')
+		{
+			p++;
+		}
+
+		if (*p == '\0')
+		{
+			break;
+		}
+		if (*p == '*')
+		{
+			return true;
+		}
+		if (strncmp(p, "W/", 2) == 0)
+		{
+			p += 2;
+		}
+
+		if (strncmp(p, etag, len) == 0 &&
+		    (p[len] == '\0' || p[len] == ',' || p[len] == ' ' || p[len] == '\t'))
+		{
+			return true;
+		}
+
+		p = strchr(p, ',');
+	}
+
+	return false;
+}
+
+/**
+ * Parse a qvalue ("1", "0.5", "0.125") into thousandths
+ */
+static int parse_q(const char *p)
+{
+	int weight = 0;
+	int scale = Q_MAX / 10;
+
+	if (*p != '0')
+	{
+		return Q_MAX;
+	}
+
+	p++;
+	if (*p == '.')
+	{
+		for (p++; isdigit((unsigned char)*p) && scale > 0; p++)
+		{
+			weight += (*p - '0') * scale;
+			scale /= 10;
+		}
+	}
+
+	return weight;
+}
+
+/**
+ * Weight of a content coding in an Accept-Encoding value, 0..Q_MAX, or -1
+ * when the coding is not listed
+ */
+static int coding_weight(const char *list, const char *coding)
+{
+	size_t len = strlen(coding);
+	const char *p = list;
+	const char *end;
+	const char *param;
+
+	while (*p != '\0')
+	{
+		while (*p == ' ' || *p == '\t' || *p == ',')
+		{
+			p++;
+		}
+
+		end = p + strcspn(p, ",");
+
+		if (strncasecmp(p, coding, len) == 0 &&
+		    (p + len == end || p[len] == ';' || p[len] == ' ' || p[len] == '\t'))
+		{
+			// Listed, look for a q parameter ("gzip;q=0.5")
+			for (param = p + len; param < end; param++)
+			{
+				if (*param != ';')
+				{
+					continue;
+				}
+				do
+				{
+					param++;
+				} while (*param == ' ' || *param == '\t');
+
+				if ((*param == 'q' || *param == 'Q') && param[1] == '=')
+				{
+					return parse_q(param + 2);
+				}
+			}
+			return Q_MAX;
+		}
+
+		p = end;
+	}
+
+	return -1;
+}
+
+/**
+ * Check if the client accepts a variant (encoding NULL for identity)
+ */
+static bool encoding_accepted(const char *accept_encoding, const char *encoding)
+{
+	int weight;
+
+	// Without Accept-Encoding, send the file as is
+	if (accept_encoding == NULL)
+	{
+		return encoding == NULL;
+	}
+
+	weight = coding_weight(accept_encoding, (encoding != NULL) ? encoding : "identity");
+	if (weight < 0)
+	{
+		weight = coding_weight(accept_encoding, "*");
+	}
+	if (weight < 0)
+	{
+		// Not listed: identity is still fine unless excluded, others are not
+		weight = (encoding == NULL) ? Q_MAX : 0;
+	}
+
+	return weight > 0;
+}
+
+int web_asset_handler(struct http_client_ctx *client, enum http_data_status status,
+		      const struct http_request_ctx *request_ctx,
+		      struct http_response_ctx *response_ctx, void *user_data)
+{
+	const struct web_asset *asset = user_data;
+	const struct web_variant *variant = NULL;
+	const char *accept_encoding = NULL;
+	const char *if_none_match = NULL;
+	uint32_t start = access_log_timestamp();
+	size_t i;
+
+	// A GET has no body, answer once the request is complete
+	if (status != HTTP_SERVER_DATA_FINAL)
+	{
+		return 0;
+	}
+
+	// With dropped headers (capture buffer full) the identity body is the safe answer
+	if (request_ctx->headers_status == HTTP_HEADER_STATUS_OK)
+	{
+		accept_encoding = request_header(request_ctx, "Accept-Encoding");
+		if_none_match = request_header(request_ctx, "If-None-Match");
+	}
+
+	// Variants are sorted smallest first, take the first one accepted
+	for (i = 0; i < asset->variant_count; i++)
+	{
+		if (encoding_accepted(accept_encoding, asset->variants[i].encoding))
+		{
+			variant = &asset->variants[i];
+			break;
+		}
+	}
+
+	response_ctx->final_chunk = true;
+
+	if (variant == NULL)
+	{
+		response_ctx->status = HTTP_406_NOT_ACCEPTABLE;
+		access_log_write(asset->name, client->method, HTTP_406_NOT_ACCEPTABLE, 0, start);
+		return 0;
+	}
+
+	response_ctx->headers = variant->headers;
+
+	if (if_none_match != NULL && etag_listed(if_none_match, variant->headers[0].value))
+	{
+		response_ctx->status = HTTP_304_NOT_MODIFIED;
+		response_ctx->header_count = WEB_VARIANT_HEADERS_304;
+
+		// HTTP/1.1 only, HTTP/2 forbids the header and ends the stream itself
+		if (client->current_stream == NULL)
+		{
+			memcpy(not_modified_headers, variant->headers,
+			       WEB_VARIANT_HEADERS_304 * sizeof(struct http_header));
+			not_modified_headers[WEB_VARIANT_HEADERS_304].name = "Connection";
+			not_modified_headers[WEB_VARIANT_HEADERS_304].value = "close";
+			response_ctx->headers = not_modified_headers;
+			response_ctx->header_count = WEB_VARIANT_HEADERS_304 + 1;
+		}
+		access_log_write(asset->name, client->method, HTTP_304_NOT_MODIFIED, 0, start);
+		return 0;
+	}
+
+	response_ctx->status = HTTP_200_OK;
+	response_ctx->header_count = variant->header_count;
+	response_ctx->body = variant->data;
+	response_ctx->body_len = variant->len;
+	access_log_write(asset->name, client->method, HTTP_200_OK, variant->len, start);
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * Static web assets: encoding negotiation and ETag validation (304 Not Modified)
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/net/http/server.h>
+#include <zephyr/net/http/service.h>
+
+/* Sent with every asset. "no-cache" lets the browser keep its copy but
+ * revalidate it on each load, so a firmware update is picked up at once and
+ * an unchanged asset costs one 304 (headers only) */
+#define WEB_ASSET_CACHE_CONTROL "no-cache"
+
+/* Headers sent with a 304: ETag, Cache-Control and Vary */
+#define WEB_VARIANT_HEADERS_304 3
+
+/* One encoding of an asset, kept in ROM (generated by scripts/web_variants.py) */
+struct web_variant
+{
+	const char *encoding;               /* Content-Encoding, NULL for identity */
+	const uint8_t *data;                /* Body as sent */
+	size_t len;
+	struct http_header headers[4];      /* ETag, Cache-Control, Vary, Content-Encoding */
+	uint8_t header_count;
+};
+
+/**
+ *  @brief Entry of a generated variant table
+ *
+ *  @param _data Encoded data array
+ *  @param _encoding Content-Encoding ("gzip", "br"), NULL for identity
+ *  @param _etag Quoted ETag string, different for every encoding
+ */
+#define WEB_VARIANT(_data, _encoding, _etag)                                \
+	{                                                                   \
+		.encoding = _encoding,                                      \
+		.data = _data,                                              \
+		.len = sizeof(_data),                                       \
+		.headers = {                                                \
+			{ .name = "ETag", .value = _etag },                 \
+			{ .name = "Cache-Control",                          \
+			  .value = WEB_ASSET_CACHE_CONTROL },               \
+			{ .name = "Vary", .value = "Accept-Encoding" },     \
+			{ .name = "Content-Encoding", .value = _encoding }, \
+		},                                                          \
+		.header_count = (_encoding) != NULL ? 4 : 3,                \
+	}
+
+/* A file with its variants, smallest first */
+struct web_asset
+{
+	const char *name;                   /* For the log */
+	const struct web_variant *variants;
+	size_t variant_count;
+};
+
+/**
+ *  @brief Define a dynamic resource detail serving one asset
+ *
+ *  @param _name Resource detail variable, used with HTTP_RESOURCE_DEFINE()
+ *  @param _variants Variant table (from a .variants.inc file)
+ *  @param _type Content-Type
+ */
+#define WEB_ASSET_DEFINE(_name, _variants, _type)                           \
+	static const struct web_asset _name##_asset = {                     \
+		.name = #_name,                                             \
+		.variants = _variants,                                      \
+		.variant_count = ARRAY_SIZE(_variants),                     \
+	};                                                                  \
+	static struct http_resource_detail_dynamic _name = {                \
+		.common = {                                                 \
+			.type = HTTP_RESOURCE_TYPE_DYNAMIC,                 \
+			.bitmask_of_supported_http_methods = BIT(HTTP_GET), \
+			.content_type = _type,                              \
+		},                                                          \
+		.cb = web_asset_handler,                                    \
+		.user_data = (void *)&_name##_asset,                        \
+	}
+
+/**
+ *  @brief Dynamic resource callback, user_data is the struct web_asset
+ *
+ *  Picks the smallest variant the Accept-Encoding request header allows
+ *  (identity when the header is missing). Answers with 304 and no body when
+ *  If-None-Match lists that variant's ETag, with 406 when no variant is
+ *  acceptable, otherwise with the variant's body.
+ */
+int web_asset_handler(struct http_client_ctx *client, enum http_data_status status,
+		      const struct http_request_ctx *request_ctx,
+		      struct http_response_ctx *response_ctx, void *user_data);
+
+#endif /* WEB_ASSETS_H */